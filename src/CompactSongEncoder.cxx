@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "CompactSongEncoder.hxx"
+#include "protocol/CompactSong.hxx"
+#include "song/LightSong.hxx"
+#include "tag/Tag.hxx"
+#include "tag/Mask.hxx"
+#include "tag/Names.hxx"
+#include "fs/Traits.hxx"
+#include "time/ChronoUtil.hxx"
+#include "util/StringBuffer.hxx"
+#include "util/UriUtil.hxx"
+
+#include <fmt/format.h>
+
+using namespace CompactSong;
+
+static_assert(unsigned(KEY_TAG_BASE) + unsigned(TAG_NUM_OF_ITEM_TYPES) <= 256);
+
+static void
+AppendVarint(std::string &dest, uint_least64_t value) noexcept
+{
+	while (value >= 0x80) {
+		dest.push_back(char((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+
+	dest.push_back(char(value));
+}
+
+static void
+AppendRecord(std::string &dest, Record record) noexcept
+{
+	dest.push_back(char(record));
+}
+
+/**
+ * Shall values of this tag be added to the string table?  This is
+ * worth it only if they are likely to be repeated in other songs.
+ */
+static constexpr bool
+IsRepetitive(TagType type) noexcept
+{
+	switch (type) {
+	case TAG_TITLE:
+	case TAG_MUSICBRAINZ_TRACKID:
+	case TAG_MUSICBRAINZ_RELEASETRACKID:
+		return false;
+
+	default:
+		return true;
+	}
+}
+
+void
+CompactSongEncoder::DefineKey(uint8_t key, uint8_t type,
+			      std::string_view name) noexcept
+{
+	if (defined_keys.test(key))
+		return;
+
+	defined_keys.set(key);
+
+	AppendRecord(output, Record::DEFINE_KEY);
+	output.push_back(char(key));
+	output.push_back(char(type));
+	AppendVarint(output, name.size());
+	output.append(name);
+}
+
+void
+CompactSongEncoder::AddString(uint8_t key,
+			      std::string_view name, std::string_view value,
+			      bool store) noexcept
+{
+	DefineKey(key, uint8_t(ValueType::STRING), name);
+
+	fields.push_back(char(key));
+	++n_fields;
+
+	if (store) {
+		if (auto i = strings.find(value); i != strings.end()) {
+			AppendVarint(fields, (uint_least64_t(i->second) << 2) |
+				     uint8_t(StringMode::REFERENCE));
+			return;
+		}
+
+		const unsigned index = strings.size();
+		strings.emplace(value, index);
+		string_bytes += value.size();
+	}
+
+	AppendVarint(fields, (uint_least64_t(value.size()) << 2) |
+		     uint8_t(store ? StringMode::STORE : StringMode::LITERAL));
+	fields.append(value);
+}
+
+void
+CompactSongEncoder::AddUnsigned(uint8_t key,
+				std::string_view name,
+				uint_least64_t value) noexcept
+{
+	DefineKey(key, uint8_t(ValueType::UNSIGNED), name);
+
+	fields.push_back(char(key));
+	++n_fields;
+	AppendVarint(fields, value);
+}
+
+std::string_view
+CompactSongEncoder::Encode(const LightSong &song, bool base,
+			   TagMask tag_mask) noexcept
+{
+	output.clear();
+	fields.clear();
+	n_fields = 0;
+
+	if (string_bytes >= MAX_STRING_BYTES) {
+		/* the string table is full: start over (this must
+		   not be done in the middle of a song, because the
+		   song's earlier fields may refer to old strings) */
+		AppendRecord(output, Record::RESET_STRINGS);
+		strings.clear();
+		string_bytes = 0;
+	}
+
+	/* same as song_print_uri() */
+	if (base) {
+		AddString(KEY_FILE, "file",
+			  PathTraitsUTF8::GetBase(song.uri), false);
+	} else if (song.directory != nullptr) {
+		AddString(KEY_FILE, "file",
+			  fmt::format("{}/{}", song.directory, song.uri),
+			  false);
+	} else {
+		const auto allocated = uri_remove_auth(song.uri);
+		AddString(KEY_FILE, "file",
+			  allocated.empty() ? song.uri : allocated.c_str(),
+			  false);
+	}
+
+	/* same as PrintRange() */
+	const unsigned start_ms = song.start_time.ToMS();
+	const unsigned end_ms = song.end_time.ToMS();
+	if (end_ms > 0)
+		AddString(KEY_RANGE, "Range",
+			  fmt::format("{}.{:03}-{}.{:03}",
+				      start_ms / 1000, start_ms % 1000,
+				      end_ms / 1000, end_ms % 1000),
+			  false);
+	else if (start_ms > 0)
+		AddString(KEY_RANGE, "Range",
+			  fmt::format("{}.{:03}-",
+				      start_ms / 1000, start_ms % 1000),
+			  false);
+
+	if (!IsNegative(song.mtime))
+		AddUnsigned(KEY_LAST_MODIFIED, "Last-Modified",
+			    std::chrono::system_clock::to_time_t(song.mtime));
+
+	if (song.audio_format.IsDefined())
+		AddString(KEY_FORMAT, "Format",
+			  ToString(song.audio_format).c_str(), true);
+
+	for (const auto &i : song.tag)
+		if (tag_mask.Test(i.type))
+			AddString(KEY_TAG_BASE + unsigned(i.type),
+				  tag_item_names[i.type], i.value,
+				  IsRepetitive(i.type));
+
+	const auto duration = song.GetDuration();
+	if (!duration.IsNegative())
+		AddUnsigned(KEY_DURATION, "duration", duration.ToMS());
+
+	AppendRecord(output, Record::SONG);
+	AppendVarint(output, n_fields);
+	output.append(fields);
+	return output;
+}
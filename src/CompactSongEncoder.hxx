@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_COMPACT_SONG_ENCODER_HXX
+#define MPD_COMPACT_SONG_ENCODER_HXX
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+struct LightSong;
+class TagMask;
+
+/**
+ * Encodes songs in the "compact" format (see
+ * protocol/CompactSong.hxx).  One instance exists per connection; it
+ * remembers which keys and strings the client has already received.
+ *
+ * This class is not thread-safe, but it may be used by a worker
+ * thread while the client's input is paused.
+ */
+class CompactSongEncoder {
+	/**
+	 * Start over with an empty string table before the next song
+	 * when the strings in #strings have reached this size.
+	 */
+	static constexpr std::size_t MAX_STRING_BYTES = 1024 * 1024;
+
+	struct StringHash {
+		using is_transparent = void;
+
+		std::size_t operator()(std::string_view s) const noexcept {
+			return std::hash<std::string_view>{}(s);
+		}
+	};
+
+	/**
+	 * Which keys have been defined already?
+	 */
+	std::bitset<256> defined_keys;
+
+	/**
+	 * The string table, mapping strings sent with
+	 * StringMode::STORE to their index.
+	 */
+	std::unordered_map<std::string, unsigned,
+			   StringHash, std::equal_to<>> strings;
+
+	/**
+	 * The total size of all strings in #strings.
+	 */
+	std::size_t string_bytes = 0;
+
+	/**
+	 * The encoded song returned by Encode(); a member to avoid
+	 * reallocation.
+	 */
+	std::string output;
+
+	/**
+	 * The fields of the song being encoded.
+	 */
+	std::string fields;
+
+	unsigned n_fields;
+
+public:
+	/**
+	 * Encode a song (including preceding key definitions).
+	 *
+	 * @return the encoded data, valid until the next call
+	 */
+	std::string_view Encode(const LightSong &song, bool base,
+				TagMask tag_mask) noexcept;
+
+private:
+	void DefineKey(uint8_t key, uint8_t type,
+		       std::string_view name) noexcept;
+
+	void AddString(uint8_t key, std::string_view name,
+		       std::string_view value, bool store) noexcept;
+
+	void AddUnsigned(uint8_t key, std::string_view name,
+			 uint_least64_t value) noexcept;
+};
+
+#endif
@@ -8,6 +8,8 @@
 #include "StateFile.hxx"
 #include "Stats.hxx"
 #include "client/List.hxx"
+#include "client/BackgroundThreadPool.hxx"
+#include "client/ResponseCache.hxx"
 #include "input/cache/Manager.hxx"
 
 #ifdef ENABLE_CURL
@@ -22,6 +24,7 @@
 #include "storage/StorageInterface.hxx"
 
 #ifdef ENABLE_INOTIFY
+#include "db/update/InotifyQueue.hxx"
 #include "db/update/InotifyUpdate.hxx"
 #endif
 
@@ -46,6 +49,12 @@ Instance::Instance()
 
 Instance::~Instance() noexcept
 {
+	/* cancel all background commands, because they may be
+	   using the database and the #BackgroundThreadPool */
+	if (client_list)
+		for (auto &client : *client_list)
+			client.SetExpired();
+
 #ifdef ENABLE_DATABASE
 	delete update;
 
@@ -110,6 +119,9 @@ Instance::OnDatabaseModified() noexcept
 
 	stats_invalidate();
 
+	if (response_cache)
+		response_cache->Clear();
+
 	for (auto &partition : partitions)
 		partition.DatabaseModified(*database);
 }
@@ -182,6 +194,12 @@ Instance::OnRemoteTag(const char *uri, const Tag &tag) noexcept
 void
 Instance::OnIdle(unsigned flags) noexcept
 {
+#ifdef ENABLE_DATABASE
+	if ((flags & IDLE_DATABASE) && response_cache)
+		/* e.g. a storage has been mounted or unmounted */
+		response_cache->Clear();
+#endif
+
 	/* broadcast to all partitions */
 	for (auto &partition : partitions)
 		partition.EmitIdle(flags);
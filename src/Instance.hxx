@@ -28,6 +28,7 @@ class NeighborGlue;
 class Storage;
 class UpdateService;
 #ifdef ENABLE_INOTIFY
+class InotifyQueue;
 class InotifyUpdate;
 #endif
 #endif
@@ -36,6 +37,8 @@ class InotifyUpdate;
 #include <list>
 
 class ClientList;
+class BackgroundThreadPool;
+class ResponseCache;
 struct Partition;
 class StateFile;
 class RemoteTagCache;
@@ -109,6 +112,7 @@ struct Instance final
 	UpdateService *update = nullptr;
 
 #ifdef ENABLE_INOTIFY
+	std::unique_ptr<InotifyQueue> inotify_queue;
 	std::unique_ptr<InotifyUpdate> inotify_update;
 #endif
 #endif
@@ -117,6 +121,28 @@ struct Instance final
 	std::unique_ptr<RemoteTagCache> remote_tag_cache;
 #endif
 
+	/**
+	 * Runs #ThreadBackgroundCommand instances.  This is declared
+	 * before #client_list, because the clients' commands must be
+	 * cancelled before it is destroyed.
+	 */
+	std::unique_ptr<BackgroundThreadPool> background_pool;
+
+	/**
+	 * The number of #StreamBackgroundCommand instances, each of
+	 * which has a thread.  Only accessed in the main thread.
+	 */
+	unsigned n_stream_commands = 0;
+
+#ifdef ENABLE_DATABASE
+	/**
+	 * Caches responses of database queries; nullptr if disabled.
+	 * This is declared before #client_list for the same reason as
+	 * #background_pool.
+	 */
+	std::unique_ptr<ResponseCache> response_cache;
+#endif
+
 	std::unique_ptr<ClientList> client_list;
 
 	std::list<Partition> partitions;
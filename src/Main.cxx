@@ -13,6 +13,8 @@
 #include "Listen.hxx"
 #include "client/Config.hxx"
 #include "client/List.hxx"
+#include "client/BackgroundThreadPool.hxx"
+#include "client/ResponseCache.hxx"
 #include "command/AllCommands.hxx"
 #include "Partition.hxx"
 #include "tag/Config.hxx"
@@ -57,6 +59,7 @@
 #include "storage/Configured.hxx"
 #include "storage/CompositeStorage.hxx"
 #ifdef ENABLE_INOTIFY
+#include "db/update/InotifyQueue.hxx"
 #include "db/update/InotifyUpdate.hxx"
 #endif
 #endif
@@ -279,6 +282,7 @@ Instance::BeginShutdownUpdate() noexcept
 #ifdef ENABLE_DATABASE
 #ifdef ENABLE_INOTIFY
 	inotify_update.reset();
+	inotify_queue.reset();
 #endif
 
 	if (update != nullptr)
@@ -424,6 +428,20 @@ MainConfigured(const CommandLineOptions &options,
 	instance.io_thread.Start();
 	instance.rtio_thread.Start();
 
+	const unsigned background_threads =
+		raw_config.GetPositive(ConfigOption::BACKGROUND_THREADS, 2U);
+	instance.background_pool =
+		std::make_unique<BackgroundThreadPool>(background_threads);
+
+#ifdef ENABLE_DATABASE
+	const std::size_t response_cache_size =
+		raw_config.GetUnsigned(ConfigOption::RESPONSE_CACHE_SIZE, 4096U)
+		* 1024;
+	if (response_cache_size > 0)
+		instance.response_cache =
+			std::make_unique<ResponseCache>(response_cache_size);
+#endif
+
 #ifdef ENABLE_NEIGHBOR_PLUGINS
 	if (instance.neighbors != nullptr)
 		instance.neighbors->Open();
@@ -471,13 +489,25 @@ MainConfigured(const CommandLineOptions &options,
 #ifdef ENABLE_INOTIFY
 		if (instance.storage != nullptr &&
 		    instance.update != nullptr) {
+			/* look for directories which were modified
+			   while MPD was not running (unless the whole
+			   database gets rebuilt anyway) */
+			Directory *db_root = nullptr;
+			if (!create_db)
+				if (auto *sdb = dynamic_cast<SimpleDatabase *>(instance.database.get()))
+					db_root = &sdb->GetRoot();
+
 			try {
+				instance.inotify_queue =
+					std::make_unique<InotifyQueue>(instance.event_loop,
+								       *instance.update);
 				instance.inotify_update =
 					mpd_inotify_init(instance.event_loop,
 							 *instance.storage,
-							 *instance.update,
+							 *instance.inotify_queue,
 							 raw_config.GetUnsigned(ConfigOption::AUTO_UPDATE_DEPTH,
-										INT_MAX));
+										INT_MAX),
+							 db_root);
 			} catch (...) {
 				LogError(std::current_exception());
 			}
@@ -6,17 +6,19 @@
 
 #include <cassert>
 
-MusicBuffer::MusicBuffer(unsigned num_chunks)
-	:buffer(num_chunks)
+MusicBuffer::MusicBuffer(unsigned num_chunks, std::size_t chunk_size)
+	:buffer(num_chunks, chunk_size)
 {
+	assert(chunk_size >= DEFAULT_CHUNK_SIZE);
+	assert(chunk_size <= MAX_CHUNK_SIZE);
+
 	buffer.SetName("MusicBuffer");
 }
 
 MusicChunkPtr
 MusicBuffer::Allocate() noexcept
 {
-	const std::scoped_lock<Mutex> protect(mutex);
-	return {buffer.Allocate(), MusicChunkDeleter(*this)};
+	return {buffer.Allocate(GetChunkCapacity()), MusicChunkDeleter(*this)};
 }
 
 void
@@ -24,15 +26,11 @@ MusicBuffer::Return(MusicChunk *chunk) noexcept
 {
 	assert(chunk != nullptr);
 
-	/* these attributes need to be cleared before locking the
-	   mutex, because they might recursively call this method,
-	   causing a deadlock */
-	chunk->next.reset();
-	chunk->other.reset();
-
-	const std::scoped_lock<Mutex> protect(mutex);
+	/* the #MusicPipe must have unlinked this chunk already */
+	assert(chunk->next.load(std::memory_order_relaxed) == nullptr);
 
-	assert(!chunk->other || !chunk->other->other);
+	/* this may recursively call this method */
+	chunk->other.reset();
 
 	buffer.Free(chunk);
 }
@@ -6,17 +6,15 @@
 
 #include "MusicChunk.hxx"
 #include "MusicChunkPtr.hxx"
-#include "util/SliceBuffer.hxx"
-#include "thread/Mutex.hxx"
+#include "pcm/AudioFormat.hxx"
+#include "util/AtomicSliceBuffer.hxx"
 
 /**
- * An allocator for #MusicChunk objects.
+ * An allocator for #MusicChunk objects.  All methods are
+ * thread-safe and lock-free.
  */
 class MusicBuffer {
-	/** a mutex which protects #buffer */
-	mutable Mutex mutex;
-
-	SliceBuffer<MusicChunk> buffer;
+	AtomicSliceBuffer<MusicChunk> buffer;
 
 public:
 	/**
@@ -24,22 +22,21 @@ public:
 	 *
 	 * @param num_chunks the number of #MusicChunk reserved in
 	 * this buffer
+	 * @param chunk_size the size of each #MusicChunk in bytes
+	 * (including its header)
 	 */
-	explicit MusicBuffer(unsigned num_chunks);
+	explicit MusicBuffer(unsigned num_chunks,
+			     std::size_t chunk_size=DEFAULT_CHUNK_SIZE);
 
-#ifndef NDEBUG
 	/**
-	 * Check whether the buffer is empty.  This call is not
-	 * protected with the mutex, and may only be used while this
-	 * object is inaccessible to other threads.
+	 * Check whether all chunks have been returned.  The result
+	 * may be outdated if other threads use this object.
 	 */
-	bool IsEmptyUnsafe() const {
+	bool IsEmpty() const noexcept {
 		return buffer.empty();
 	}
-#endif
 
 	bool IsFull() const noexcept {
-		const std::scoped_lock<Mutex> protect(mutex);
 		return buffer.IsFull();
 	}
 
@@ -53,6 +50,24 @@ public:
 		return buffer.GetCapacity();
 	}
 
+	/**
+	 * Returns the number of data bytes each #MusicChunk can hold.
+	 */
+	[[gnu::pure]]
+	std::size_t GetChunkCapacity() const noexcept {
+		return buffer.GetSliceSize() - sizeof(MusicChunk);
+	}
+
+	/**
+	 * Returns the number of bytes of the specified audio format
+	 * the decoder puts into each #MusicChunk.  Use this to convert
+	 * between durations and numbers of chunks.
+	 */
+	[[gnu::pure]]
+	std::size_t GetChunkFillSize(AudioFormat af) const noexcept {
+		return MusicChunk::GetFillSize(GetChunkCapacity(), af);
+	}
+
 	/**
 	 * Allocates a chunk from the buffer.  When it is not used anymore,
 	 * call Return().
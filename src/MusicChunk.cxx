@@ -5,6 +5,7 @@
 #include "pcm/AudioFormat.hxx"
 #include "tag/Tag.hxx"
 
+#include <algorithm>
 #include <cassert>
 
 MusicChunkInfo::MusicChunkInfo() noexcept = default;
@@ -20,6 +21,18 @@ MusicChunkInfo::CheckFormat(const AudioFormat other_format) const noexcept
 }
 #endif
 
+std::size_t
+MusicChunk::GetFillSize(std::size_t capacity, const AudioFormat af) noexcept
+{
+	/* never fill less than a chunk of the default size would
+	   hold, or else a large chunk size would cost buffer space
+	   (and add overhead) for low-rate formats */
+	constexpr std::size_t min_size = DEFAULT_CHUNK_SIZE - sizeof(MusicChunk);
+
+	return std::min(capacity,
+			std::max(af.TimeToSize(FILL_DURATION), min_size));
+}
+
 std::span<std::byte>
 MusicChunk::Write(const AudioFormat af,
 		  SongTime data_time, uint16_t _bit_rate) noexcept
@@ -39,9 +52,13 @@ MusicChunk::Write(const AudioFormat af,
 #endif
 	}
 
+	const size_t fill_size = GetFillSize(capacity, af);
+	if (length >= fill_size)
+		return {};
+
 	const size_t frame_size = af.GetFrameSize();
-	size_t num_frames = (sizeof(data) - length) / frame_size;
-	return { data + length, num_frames * frame_size };
+	size_t num_frames = (fill_size - length) / frame_size;
+	return { GetBuffer() + length, num_frames * frame_size };
 }
 
 bool
@@ -49,10 +66,10 @@ MusicChunk::Expand(const AudioFormat af, size_t _length) noexcept
 {
 	const size_t frame_size = af.GetFrameSize();
 
-	assert(length + _length <= sizeof(data));
+	assert(length + _length <= capacity);
 	assert(audio_format == af);
 
 	length += _length;
 
-	return length + frame_size > sizeof(data);
+	return length + frame_size > GetFillSize(capacity, af);
 }
@@ -12,12 +12,22 @@
 #include "pcm/AudioFormat.hxx"
 #endif
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <span>
 
-static constexpr size_t CHUNK_SIZE = 4096;
+/**
+ * The default size of a #MusicChunk including its header.
+ */
+static constexpr size_t DEFAULT_CHUNK_SIZE = 4096;
+
+/**
+ * The largest allowed (configured) size of a #MusicChunk.
+ */
+static constexpr size_t MAX_CHUNK_SIZE = 256 * 1024;
 
 struct AudioFormat;
 struct Tag;
@@ -27,8 +37,12 @@ struct MusicChunk;
  * Meta information for #MusicChunk.
  */
 struct MusicChunkInfo {
-	/** the next chunk in a linked list */
-	MusicChunkPtr next;
+	/**
+	 * The next chunk in a linked list.  This is owned by the
+	 * #MusicPipe which contains this chunk; consumers may follow
+	 * it without a lock, see GetNext().
+	 */
+	std::atomic<MusicChunk *> next{nullptr};
 
 	/**
 	 * An optional chunk which should be mixed into this chunk.
@@ -49,7 +63,7 @@ struct MusicChunkInfo {
 	float mix_ratio;
 
 	/** number of bytes stored in this chunk */
-	uint16_t length = 0;
+	uint32_t length = 0;
 
 	/** current bit rate of the source file */
 	uint16_t bit_rate;
@@ -84,6 +98,16 @@ struct MusicChunkInfo {
 		return length == 0 && tag == nullptr;
 	}
 
+	/**
+	 * Returns the next chunk in the #MusicPipe or nullptr if
+	 * this is (currently) the tail.  May be called from any
+	 * thread while this chunk is in the pipe.
+	 */
+	[[gnu::pure]]
+	MusicChunk *GetNext() const noexcept {
+		return next.load(std::memory_order_acquire);
+	}
+
 #ifndef NDEBUG
 	/**
 	 * Checks if the audio format if the chunk is equal to the
@@ -97,10 +121,40 @@ struct MusicChunkInfo {
 /**
  * A chunk of music data.  Its format is defined by the
  * MusicPipe::Push() caller.
+ *
+ * The data (probably PCM) follows this object in memory; the
+ * #MusicBuffer which allocates the chunk reserves enough room.
  */
 struct MusicChunk : MusicChunkInfo {
-	/** the data (probably PCM) */
-	std::byte data[CHUNK_SIZE - sizeof(MusicChunkInfo)];
+	/**
+	 * Write() fills a chunk only up to this duration of audio (but
+	 * at least as much as fits into a chunk of the default size).
+	 * Large chunks thus reduce the per-chunk overhead of
+	 * high-bandwidth formats without adding latency to low-rate
+	 * streams.
+	 */
+	static constexpr std::chrono::milliseconds FILL_DURATION{20};
+
+	/** the size of the data buffer in bytes */
+	const std::size_t capacity;
+
+	explicit MusicChunk(std::size_t _capacity) noexcept
+		:capacity(_capacity) {}
+
+	/**
+	 * Returns the data which has been written to this chunk.
+	 */
+	std::span<const std::byte> GetData() const noexcept {
+		return {GetBuffer(), length};
+	}
+
+	/**
+	 * Calculate how many bytes of the specified audio format
+	 * Write() puts into a chunk with the given capacity.
+	 */
+	[[gnu::const]]
+	static std::size_t GetFillSize(std::size_t capacity,
+				       AudioFormat af) noexcept;
 
 	/**
 	 * Prepares appending to the music chunk.  Returns a buffer
@@ -127,8 +181,17 @@ struct MusicChunk : MusicChunkInfo {
 	 * @return true if the chunk is full
 	 */
 	bool Expand(AudioFormat af, size_t length) noexcept;
+
+private:
+	std::byte *GetBuffer() noexcept {
+		return reinterpret_cast<std::byte *>(this + 1);
+	}
+
+	const std::byte *GetBuffer() const noexcept {
+		return reinterpret_cast<const std::byte *>(this + 1);
+	}
 };
 
-static_assert(sizeof(MusicChunk) == CHUNK_SIZE, "Wrong size");
+static_assert(sizeof(MusicChunk) < DEFAULT_CHUNK_SIZE / 8);
 
 #endif
@@ -5,15 +5,14 @@
 #include "MusicChunk.hxx"
 
 #include <cassert>
+#include <thread>
 
 #ifndef NDEBUG
 
 bool
 MusicPipe::Contains(const MusicChunk *chunk) const noexcept
 {
-	const std::scoped_lock<Mutex> protect(mutex);
-
-	for (const MusicChunk *i = head.get(); i != nullptr; i = i->next.get())
+	for (const MusicChunk *i = Peek(); i != nullptr; i = i->GetNext())
 		if (i == chunk)
 			return true;
 
@@ -25,38 +24,50 @@ MusicPipe::Contains(const MusicChunk *chunk) const noexcept
 MusicChunkPtr
 MusicPipe::Shift() noexcept
 {
-	const std::scoped_lock<Mutex> protect(mutex);
-
-	auto chunk = std::move(head);
-	if (chunk != nullptr) {
-		assert(!chunk->IsEmpty());
+	MusicChunk *chunk = head.load(std::memory_order_acquire);
+	if (chunk == nullptr)
+		return nullptr;
 
-		head = std::move(chunk->next);
-		--size;
-
-		if (head == nullptr) {
-			assert(size == 0);
-			assert(tail_r == &chunk->next);
+	assert(!chunk->IsEmpty());
 
-			tail_r = &head;
-		} else {
-			assert(size > 0);
-			assert(tail_r != &chunk->next);
+	MusicChunk *next = chunk->GetNext();
+	if (next == nullptr) {
+		/* this looks like the last chunk: point the tail
+		   back to the head, unless Push() has already
+		   claimed our "next" field */
+		head.store(nullptr, std::memory_order_relaxed);
+
+		auto *expected = &chunk->next;
+		if (!tail_r.compare_exchange_strong(expected, &head,
+						    std::memory_order_acq_rel,
+						    std::memory_order_acquire)) {
+			/* a concurrent Push() is about to link a new
+			   chunk; this is a tiny window, so just wait
+			   for it */
+			while ((next = chunk->GetNext()) == nullptr)
+				std::this_thread::yield();
+
+			head.store(next, std::memory_order_release);
 		}
+	} else
+		head.store(next, std::memory_order_release);
 
-#ifndef NDEBUG
-		if (size == 0)
-			audio_format.Clear();
-#endif
-	}
+	chunk->next.store(nullptr, std::memory_order_relaxed);
+	size.fetch_sub(1, std::memory_order_release);
 
-	return chunk;
+	return {chunk, deleter.load(std::memory_order_relaxed)};
 }
 
 void
 MusicPipe::Clear() noexcept
 {
 	while (Shift()) {}
+
+	assert(size.load(std::memory_order_relaxed) == 0);
+
+#ifndef NDEBUG
+	audio_format.Clear();
+#endif
 }
 
 void
@@ -65,9 +76,11 @@ MusicPipe::Push(MusicChunkPtr chunk) noexcept
 	assert(!chunk->IsEmpty());
 	assert(chunk->length == 0 || chunk->audio_format.IsValid());
 
-	const std::scoped_lock<Mutex> protect(mutex);
+#ifndef NDEBUG
+	if (IsEmpty())
+		audio_format.Clear();
+#endif
 
-	assert(size > 0 || !audio_format.IsDefined());
 	assert(!audio_format.IsDefined() ||
 	       chunk->CheckFormat(audio_format));
 
@@ -76,9 +89,19 @@ MusicPipe::Push(MusicChunkPtr chunk) noexcept
 		audio_format = chunk->audio_format;
 #endif
 
-	chunk->next.reset();
-	*tail_r = std::move(chunk);
-	tail_r = &(*tail_r)->next;
+	/* all chunks in one pipe must come from the same buffer */
+	assert(IsEmpty() ||
+	       deleter.load(std::memory_order_relaxed) == chunk.get_deleter());
+	deleter.store(chunk.get_deleter(), std::memory_order_relaxed);
+
+	MusicChunk *const c = chunk.release();
+	c->next.store(nullptr, std::memory_order_relaxed);
+
+	/* claim the tail, then link the new chunk to the previous
+	   one (or to the head) */
+	auto *const prev = tail_r.exchange(&c->next,
+					   std::memory_order_acq_rel);
+	prev->store(c, std::memory_order_release);
 
-	++size;
+	size.fetch_add(1, std::memory_order_release);
 }
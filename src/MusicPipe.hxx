@@ -5,38 +5,65 @@
 #define MPD_PIPE_H
 
 #include "MusicChunkPtr.hxx"
-#include "thread/Mutex.hxx"
 
 #ifndef NDEBUG
 #include "pcm/AudioFormat.hxx"
 #endif
 
+#include <atomic>
+
 /**
  * A queue of #MusicChunk objects.  One party appends chunks at the
  * tail, and the other consumes them from the head.
+ *
+ * This class is lock-free: there may be one producer thread calling
+ * Push() and one consumer thread calling Shift() at the same time.
+ * Any number of threads may call Peek() and follow
+ * MusicChunk::GetNext() concurrently, as long as they make sure the
+ * consumer doesn't remove (and free) the chunks they are looking at.
  */
 class MusicPipe {
 	/** the first chunk */
-	MusicChunkPtr head;
+	std::atomic<MusicChunk *> head{nullptr};
 
-	/** a pointer to the tail of the chunk */
-	MusicChunkPtr *tail_r = &head;
+	/**
+	 * A pointer to the "next" field of the last chunk (or to
+	 * #head if the pipe is empty).  Push() swaps it atomically
+	 * and then links the new chunk.
+	 */
+	std::atomic<std::atomic<MusicChunk *> *> tail_r{&head};
 
-	/** the current number of chunks */
-	unsigned size = 0;
+	/**
+	 * The current number of chunks.  This is incremented after
+	 * a chunk has been linked, which means it may be negative
+	 * for a short time if the consumer has been faster.
+	 */
+	std::atomic<int> size{0};
 
-	/** a mutex which protects #head and #tail_r */
-	mutable Mutex mutex;
+	/**
+	 * The deleter of the chunks in this pipe, used to construct
+	 * a new #MusicChunkPtr in Shift().
+	 */
+	std::atomic<MusicChunkDeleter> deleter{};
 
 #ifndef NDEBUG
+	/**
+	 * The audio format of the chunks in this pipe.  Only the
+	 * producer accesses this field.
+	 */
 	AudioFormat audio_format = AudioFormat::Undefined();
 #endif
 
 public:
+	MusicPipe() noexcept = default;
+
 	~MusicPipe() noexcept {
 		Clear();
 	}
 
+	MusicPipe(const MusicPipe &) = delete;
+	MusicPipe &operator=(const MusicPipe &) = delete;
+
 #ifndef NDEBUG
 	/**
 	 * Checks if the audio format if the chunk is equal to the specified
@@ -44,12 +71,13 @@ public:
 	 */
 	[[gnu::pure]]
 	bool CheckFormat(AudioFormat other) const noexcept {
-		return !audio_format.IsDefined() ||
+		return IsEmpty() || !audio_format.IsDefined() ||
 			audio_format == other;
 	}
 
 	/**
-	 * Checks if the specified chunk is enqueued in the music pipe.
+	 * Checks if the specified chunk is enqueued in the music
+	 * pipe.  May only be called by the consumer.
 	 */
 	[[gnu::pure]]
 	bool Contains(const MusicChunk *chunk) const noexcept;
@@ -61,22 +89,24 @@ public:
 	 */
 	[[gnu::pure]]
 	const MusicChunk *Peek() const noexcept {
-		const std::scoped_lock<Mutex> protect(mutex);
-		return head.get();
+		return head.load(std::memory_order_acquire);
 	}
 
 	/**
 	 * Removes the first chunk from the head, and returns it.
+	 * May only be called by the consumer.
 	 */
 	MusicChunkPtr Shift() noexcept;
 
 	/**
 	 * Clears the whole pipe and returns the chunks to the buffer.
+	 * The caller must ensure that no Push() call is in progress.
 	 */
 	void Clear() noexcept;
 
 	/**
-	 * Pushes a chunk to the tail of the pipe.
+	 * Pushes a chunk to the tail of the pipe.  May only be called
+	 * by the producer.
 	 */
 	void Push(MusicChunkPtr chunk) noexcept;
 
@@ -85,8 +115,8 @@ public:
 	 */
 	[[gnu::pure]]
 	unsigned GetSize() const noexcept {
-		const std::scoped_lock<Mutex> protect(mutex);
-		return size;
+		const int value = size.load(std::memory_order_acquire);
+		return value > 0 ? value : 0;
 	}
 
 	[[gnu::pure]]
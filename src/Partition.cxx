@@ -227,8 +227,7 @@ Partition::OnIdleMonitor(unsigned mask) noexcept
 {
 	/* send "idle" notifications to all subscribed
 	   clients */
-	for (auto &client : clients)
-		client.IdleAdd(mask);
+	idle_waiters.Broadcast(mask);
 
 	if (mask & (IDLE_PLAYLIST|IDLE_PLAYER|IDLE_MIXER|IDLE_OUTPUT))
 		instance.OnStateModified();
@@ -13,6 +13,7 @@
 #include "player/Control.hxx"
 #include "player/Listener.hxx"
 #include "protocol/RangeArg.hxx"
+#include "client/IdleWaiterList.hxx"
 #include "util/IntrusiveList.hxx"
 #include "ReplayGainMode.hxx"
 #include "SingleMode.hxx"
@@ -51,6 +52,11 @@ struct Partition final : QueueListener, PlayerListener, MixerListener {
 
 	IntrusiveList<Client, ClientPerPartitionListHook, false> clients;
 
+	/**
+	 * Those #clients which are waiting in the "idle" command.
+	 */
+	IdleWaiterList idle_waiters;
+
 	/**
 	 * Monitor for idle events local to this partition.
 	 */
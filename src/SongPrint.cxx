@@ -6,7 +6,9 @@
 #include "song/DetachedSong.hxx"
 #include "TimePrint.hxx"
 #include "TagPrint.hxx"
+#include "CompactSongEncoder.hxx"
 #include "client/Response.hxx"
+#include "tag/Mask.hxx"
 #include "fs/Traits.hxx"
 #include "time/ChronoUtil.hxx"
 #include "util/StringBuffer.hxx"
@@ -14,6 +16,8 @@
 
 #include <fmt/format.h>
 
+#include <span>
+
 #define SONG_FILE "file: "
 
 static void
@@ -111,3 +115,15 @@ song_print_info(Response &r, const DetachedSong &song, bool base) noexcept
 		      duration.RoundS(),
 		      duration.ToDoubleS());
 }
+
+bool
+song_print_compact(Response &r, const LightSong &song, bool base) noexcept
+{
+	auto *encoder = r.GetCompactSongEncoder();
+	if (encoder == nullptr)
+		return false;
+
+	const auto data = encoder->Encode(song, base, r.GetTagMask());
+	r.WriteBinaryChunks(std::as_bytes(std::span{data}));
+	return true;
+}
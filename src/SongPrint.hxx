@@ -15,6 +15,17 @@ song_print_info(Response &r, const DetachedSong &song,
 void
 song_print_info(Response &r, const LightSong &song, bool base=false) noexcept;
 
+/**
+ * Send the song in the "compact" format (see command "songformat")
+ * if the client has enabled it.
+ *
+ * @return true if the song has been sent, false if the caller shall
+ * use song_print_info() instead
+ */
+bool
+song_print_compact(Response &r, const LightSong &song,
+		   bool base=false) noexcept;
+
 void
 song_print_uri(Response &r, const LightSong &song, bool base=false) noexcept;
 
@@ -36,7 +36,7 @@ range_save(BufferedOutputStream &os, unsigned start_ms, unsigned end_ms)
 void
 song_save(BufferedOutputStream &os, const Song &song)
 {
-	os.Fmt(FMT_STRING(SONG_BEGIN "{}\n"), song.filename);
+	os.Fmt(FMT_STRING(SONG_BEGIN "{}\n"), song.filename.c_str());
 
 	if (!song.target.empty())
 		os.Fmt(FMT_STRING("Target: {}\n"), song.target);
@@ -39,7 +39,7 @@ Song::LoadFile(Storage &storage, std::string_view path_utf8, Directory &parent)
 	assert(!uri_has_scheme(path_utf8));
 	assert(path_utf8.find('\n') == path_utf8.npos);
 
-	auto song = std::make_unique<Song>(path_utf8, parent);
+	auto song = Song::New(path_utf8, parent);
 	if (!song->UpdateFile(storage))
 		return nullptr;
 
@@ -95,7 +95,7 @@ Song::LoadFromArchive(ArchiveFile &archive, std::string_view name_utf8,
 	assert(!uri_has_scheme(name_utf8));
 	assert(name_utf8.find('\n') == name_utf8.npos);
 
-	auto song = std::make_unique<Song>(name_utf8, parent);
+	auto song = Song::New(name_utf8, parent);
 	if (!song->UpdateFileInArchive(archive))
 		return nullptr;
 
@@ -8,6 +8,7 @@
 #include "fs/io/TextFile.hxx"
 #include "io/FileOutputStream.hxx"
 #include "io/BufferedOutputStream.hxx"
+#include "io/StringOutputStream.hxx"
 #include "storage/StorageState.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
@@ -15,6 +16,7 @@
 #include "util/Domain.hxx"
 #include "Log.hxx"
 
+#include <chrono>
 #include <exception>
 
 static constexpr Domain state_file_domain("state_file");
@@ -53,7 +55,7 @@ StateFile::IsModified() const noexcept
 }
 
 inline void
-StateFile::Write(BufferedOutputStream &os)
+StateFile::WriteHead(BufferedOutputStream &os)
 {
 	partition.mixer_memento.SaveSoftwareVolumeState(os);
 	audio_output_state_save(os, partition.outputs);
@@ -62,30 +64,66 @@ StateFile::Write(BufferedOutputStream &os)
 	storage_state_save(os, partition.instance);
 #endif
 
-	playlist_state_save(os, partition.playlist, partition.pc);
+	playlist_state_save_head(os, partition.playlist, partition.pc);
 }
 
-inline void
-StateFile::Write(OutputStream &os)
+StateFileSnapshot
+StateFile::MakeSnapshot()
 {
-	BufferedOutputStream bos(os);
-	Write(bos);
-	bos.Flush();
+	const auto start_time = std::chrono::steady_clock::now();
+
+	StateFileSnapshot snapshot;
+
+	{
+		StringOutputStream sos;
+		BufferedOutputStream bos(sos);
+		WriteHead(bos);
+		bos.Flush();
+		snapshot.head = sos.Steal();
+	}
+
+	snapshot.queue = queue_cache.Get(partition.playlist.queue.version, [this]{
+		StringOutputStream sos;
+		BufferedOutputStream bos(sos);
+		playlist_state_save_queue(bos, partition.playlist);
+		bos.Flush();
+		return sos.Steal();
+	});
+
+	const std::chrono::duration<double> duration =
+		std::chrono::steady_clock::now() - start_time;
+	FmtDebug(state_file_domain, "Serialized state in {:.3f} ms",
+		 duration.count() * 1e3);
+
+	return snapshot;
 }
 
 void
-StateFile::Write()
+StateFile::WriteStateFile(const StateFileSnapshot &snapshot) noexcept
 {
 	FmtDebug(state_file_domain,
 		 "Saving state file {}", path_utf8);
 
 	try {
+		/* FileOutputStream writes to a temporary file and
+		   renames it in Commit() */
 		FileOutputStream fos(config.path);
-		Write(fos);
+		fos.Write(snapshot.head.data(), snapshot.head.size());
+		fos.Write(snapshot.queue->data(), snapshot.queue->size());
 		fos.Commit();
 	} catch (...) {
 		LogError(std::current_exception());
 	}
+}
+
+void
+StateFile::Write()
+{
+	try {
+		writer.Write(MakeSnapshot());
+	} catch (...) {
+		LogError(std::current_exception());
+	}
 
 	RememberVersions();
 }
@@ -138,5 +176,19 @@ StateFile::CheckModified() noexcept
 void
 StateFile::OnTimeout() noexcept
 {
-	Write();
+	try {
+		auto snapshot = MakeSnapshot();
+
+		try {
+			writer.Submit(std::move(snapshot));
+		} catch (...) {
+			/* the writer thread could not be started */
+			LogError(std::current_exception());
+			writer.Write(snapshot);
+		}
+	} catch (...) {
+		LogError(std::current_exception());
+	}
+
+	RememberVersions();
 }
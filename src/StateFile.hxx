@@ -5,16 +5,16 @@
 #define MPD_STATE_FILE_HXX
 
 #include "StateFileConfig.hxx"
+#include "StateFileWriter.hxx"
 #include "event/FarTimerEvent.hxx"
 #include "config.h"
 
 #include <string>
 
 struct Partition;
-class OutputStream;
 class BufferedOutputStream;
 
-class StateFile final {
+class StateFile final : StateFileWriterHandler {
 	const StateFileConfig config;
 
 	const std::string path_utf8;
@@ -34,11 +34,32 @@ class StateFile final {
 	unsigned prev_storage_version = 0;
 #endif
 
+	/**
+	 * The queue serialized by the last MakeSnapshot() call.
+	 */
+	StateFileQueueCache queue_cache;
+
+	/**
+	 * Writes the snapshots submitted by OnTimeout().  This is
+	 * declared last, so its thread is stopped before the other
+	 * fields are destroyed.
+	 */
+	StateFileWriter writer{*this};
+
 public:
 	StateFile(StateFileConfig &&_config,
 		  Partition &partition, EventLoop &loop);
 
+	StateFile(const StateFile &) = delete;
+	StateFile &operator=(const StateFile &) = delete;
+
 	void Read();
+
+	/**
+	 * Write the state file synchronously, e.g. during shutdown.
+	 * A write scheduled by the timer which has not yet been
+	 * started is discarded.
+	 */
 	void Write();
 
 	/**
@@ -47,8 +68,19 @@ public:
 	void CheckModified() noexcept;
 
 private:
-	void Write(OutputStream &os);
-	void Write(BufferedOutputStream &os);
+	/**
+	 * Write everything but the queue.
+	 */
+	void WriteHead(BufferedOutputStream &os);
+
+	/**
+	 * Serialize the current state into memory.  This is the only
+	 * part of saving the state file which happens in the main
+	 * thread.
+	 *
+	 * Throws on error.
+	 */
+	StateFileSnapshot MakeSnapshot();
 
 	/**
 	 * Save the current state versions for use with IsModified().
@@ -64,6 +96,9 @@ private:
 
 	/* callback for #timer_event */
 	void OnTimeout() noexcept;
+
+	/* virtual methods from class StateFileWriterHandler */
+	void WriteStateFile(const StateFileSnapshot &snapshot) noexcept override;
 };
 
 #endif /* STATE_FILE_H */
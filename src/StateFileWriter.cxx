@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "StateFileWriter.hxx"
+#include "thread/Name.hxx"
+
+StateFileWriter::~StateFileWriter() noexcept
+{
+	if (!thread.IsDefined())
+		return;
+
+	{
+		const std::scoped_lock lock{mutex};
+		quit = true;
+		cond.notify_all();
+	}
+
+	thread.Join();
+}
+
+void
+StateFileWriter::Submit(StateFileSnapshot &&snapshot)
+{
+	if (!thread.IsDefined())
+		thread.Start();
+
+	const std::scoped_lock lock{mutex};
+	pending = std::move(snapshot);
+	cond.notify_all();
+}
+
+void
+StateFileWriter::Write(const StateFileSnapshot &snapshot) noexcept
+{
+	{
+		std::unique_lock lock{mutex};
+
+		/* this snapshot is newer than the pending one */
+		pending.reset();
+
+		/* wait for the thread to finish, so it does not
+		   overwrite the file with an older snapshot */
+		cond.wait(lock, [this]{ return !busy; });
+	}
+
+	handler.WriteStateFile(snapshot);
+}
+
+void
+StateFileWriter::RunThread() noexcept
+{
+	SetThreadName("state_file");
+
+	std::unique_lock lock{mutex};
+
+	while (true) {
+		cond.wait(lock, [this]{ return quit || pending; });
+		if (!pending)
+			break;
+
+		const auto snapshot = std::move(*pending);
+		pending.reset();
+		busy = true;
+
+		{
+			const ScopeUnlock unlock(mutex);
+			handler.WriteStateFile(snapshot);
+		}
+
+		busy = false;
+		cond.notify_all();
+	}
+}
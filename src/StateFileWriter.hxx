@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_STATE_FILE_WRITER_HXX
+#define MPD_STATE_FILE_WRITER_HXX
+
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+#include "thread/Thread.hxx"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+/**
+ * A serialized copy of MPD's state, ready to be written to the state
+ * file.
+ */
+struct StateFileSnapshot {
+	/**
+	 * Everything but the queue.
+	 */
+	std::string head;
+
+	/**
+	 * The queue; this is shared with #StateFileQueueCache.
+	 */
+	std::shared_ptr<const std::string> queue;
+};
+
+/**
+ * Remembers the last serialized queue, so it can be reused as long
+ * as the queue version stays the same, e.g. when only the elapsed
+ * time has changed.
+ */
+class StateFileQueueCache {
+	std::shared_ptr<const std::string> text;
+
+	uint32_t version;
+
+public:
+	/**
+	 * Return the cached text if it was serialized from the given
+	 * queue version, or else invoke the given function (which
+	 * returns a std::string) and cache its result.
+	 */
+	template<typename F>
+	const std::shared_ptr<const std::string> &Get(uint32_t _version,
+						      F &&serialize) {
+		if (!text || version != _version) {
+			text = std::make_shared<const std::string>(serialize());
+			version = _version;
+		}
+
+		return text;
+	}
+};
+
+class StateFileWriterHandler {
+public:
+	/**
+	 * Write the snapshot to the file, replacing it atomically.
+	 * Errors shall be logged.  This is called in the writer
+	 * thread or (from StateFileWriter::Write()) in the calling
+	 * thread, but never concurrently.
+	 */
+	virtual void WriteStateFile(const StateFileSnapshot &snapshot) noexcept = 0;
+};
+
+/**
+ * A thread which writes #StateFileSnapshot instances, so the disk I/O
+ * does not block the main thread.
+ */
+class StateFileWriter final {
+	StateFileWriterHandler &handler;
+
+	/**
+	 * This thread writes snapshots submitted by Submit().  It is
+	 * started on demand.
+	 */
+	Thread thread{BIND_THIS_METHOD(RunThread)};
+
+	Mutex mutex;
+
+	/**
+	 * Signalled when #pending or #quit has been set, and when
+	 * #busy has been cleared.
+	 */
+	Cond cond;
+
+	/**
+	 * The next snapshot to be written by the #thread.  A newer
+	 * snapshot replaces an older one which has not yet been
+	 * written.  Protected by #mutex.
+	 */
+	std::optional<StateFileSnapshot> pending;
+
+	/**
+	 * Is the #thread currently writing the file?  Protected by
+	 * #mutex.
+	 */
+	bool busy = false;
+
+	/**
+	 * Shall the #thread exit?  Protected by #mutex.
+	 */
+	bool quit = false;
+
+public:
+	explicit StateFileWriter(StateFileWriterHandler &_handler) noexcept
+		:handler(_handler) {}
+
+	/**
+	 * Waits for the #thread to write the pending snapshot.
+	 */
+	~StateFileWriter() noexcept;
+
+	StateFileWriter(const StateFileWriter &) = delete;
+	StateFileWriter &operator=(const StateFileWriter &) = delete;
+
+	/**
+	 * Schedule the snapshot to be written by the #thread.  It
+	 * replaces a pending snapshot.
+	 *
+	 * Throws if the #thread could not be started; the snapshot
+	 * is not consumed then.
+	 */
+	void Submit(StateFileSnapshot &&snapshot);
+
+	/**
+	 * Write the snapshot synchronously, e.g. during shutdown.  A
+	 * pending snapshot is discarded, and a snapshot which is
+	 * currently being written by the #thread is finished first,
+	 * so it does not overwrite this newer one.
+	 */
+	void Write(const StateFileSnapshot &snapshot) noexcept;
+
+private:
+	void RunThread() noexcept;
+};
+
+#endif
@@ -7,6 +7,7 @@
 #include "client/Response.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
+#include "client/ResponseCache.hxx"
 #include "db/Selection.hxx"
 #include "db/Interface.hxx"
 #include "db/Stats.hxx"
@@ -92,6 +93,9 @@ db_stats_print(Response &r, const Database &db)
 	      stats.song_count,
 	      total_duration_s);
 
+	if (stats.memory_size > 0)
+		r.Fmt(FMT_STRING("db_memory: {}\n"), stats.memory_size);
+
 	const auto update_stamp = db.GetUpdateStamp();
 	if (!IsNegative(update_stamp))
 		r.Fmt(FMT_STRING("db_update: {}\n"),
@@ -110,13 +114,20 @@ stats_print(Response &r, const Partition &partition)
 #endif
 
 	r.Fmt(FMT_STRING("uptime: {}\n"
-			 "playtime: {}\n"),
+			 "playtime: {}\n"
+			 "queue_memory: {}\n"),
 	      std::chrono::duration_cast<std::chrono::seconds>(uptime).count(),
-	      lround(partition.pc.GetTotalPlayTime().count()));
+	      lround(partition.pc.GetTotalPlayTime().count()),
+	      partition.playlist.queue.GetMemorySize());
 
 #ifdef ENABLE_DATABASE
 	const Database *db = partition.instance.GetDatabase();
 	if (db != nullptr)
 		db_stats_print(r, *db);
+
+	if (const auto *cache = partition.instance.response_cache.get())
+		r.Fmt(FMT_STRING("response_cache_hits: {}\n"
+				 "response_cache_misses: {}\n"),
+		      cache->GetHits(), cache->GetMisses());
 #endif
 }
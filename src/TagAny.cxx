@@ -86,8 +86,8 @@ GetRealSongUri(Client &client, std::string_view uri)
 
 #endif
 
-static void
-TagScanDatabase(Client &client, const char *uri, TagHandler &handler)
+static TagScanLocation
+TagLocateDatabase(Client &client, const char *uri)
 {
 #ifdef ENABLE_DATABASE
 	const auto real_uri = GetRealSongUri(client, uri);
@@ -97,7 +97,7 @@ TagScanDatabase(Client &client, const char *uri, TagHandler &handler)
 
 		// TODO: support absolute paths?
 		if (uri_has_scheme(uri))
-			return TagScanStream(uri, handler);
+			return {nullptr, real_uri};
 	}
 
 	const Storage *storage = client.GetStorage();
@@ -105,30 +105,29 @@ TagScanDatabase(Client &client, const char *uri, TagHandler &handler)
 #else
 		(void)client;
 		(void)uri;
-		(void)handler;
 #endif
 		throw ProtocolError(ACK_ERROR_NO_EXIST, "No database");
 #ifdef ENABLE_DATABASE
 	}
 
 	{
-		const auto path_fs = storage->MapFS(uri);
+		auto path_fs = storage->MapFS(uri);
 		if (!path_fs.IsNull())
-			return TagScanFile(path_fs, handler);
+			return {std::move(path_fs), {}};
 	}
 
 	{
-		const auto absolute_uri = storage->MapUTF8(uri);
+		auto absolute_uri = storage->MapUTF8(uri);
 		if (uri_has_scheme(absolute_uri))
-			return TagScanStream(absolute_uri.c_str(), handler);
+			return {nullptr, std::move(absolute_uri)};
 	}
 
 	throw ProtocolError(ACK_ERROR_NO_EXIST, "No such file");
 #endif
 }
 
-void
-TagScanAny(Client &client, const char *uri, TagHandler &handler)
+TagScanLocation
+TagLocateAny(Client &client, const char *uri)
 {
 	const auto located_uri = LocateUri(UriPluginKind::INPUT, uri, &client
 #ifdef ENABLE_DATABASE
@@ -137,15 +136,29 @@ TagScanAny(Client &client, const char *uri, TagHandler &handler)
 					   );
 	switch (located_uri.type) {
 	case LocatedUri::Type::ABSOLUTE:
-		return TagScanStream(located_uri.canonical_uri, handler);
+		return {nullptr, located_uri.canonical_uri};
 
 	case LocatedUri::Type::RELATIVE:
-		return TagScanDatabase(client, located_uri.canonical_uri,
-				       handler);
+		return TagLocateDatabase(client, located_uri.canonical_uri);
 
 	case LocatedUri::Type::PATH:
-		return TagScanFile(located_uri.path, handler);
+		return {located_uri.path, {}};
 	}
 
 	gcc_unreachable();
 }
+
+void
+TagScanAny(const TagScanLocation &location, TagHandler &handler)
+{
+	if (!location.path.IsNull())
+		TagScanFile(location.path, handler);
+	else
+		TagScanStream(location.uri.c_str(), handler);
+}
+
+void
+TagScanAny(Client &client, const char *uri, TagHandler &handler)
+{
+	TagScanAny(TagLocateAny(client, uri), handler);
+}
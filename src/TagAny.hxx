@@ -4,9 +4,51 @@
 #ifndef MPD_TAG_ANY_HXX
 #define MPD_TAG_ANY_HXX
 
+#include "fs/AllocatedPath.hxx"
+
+#include <string>
+
 class Client;
 class TagHandler;
 
+/**
+ * The location of a song file as determined by TagLocateAny().
+ * Unlike the URI, it does not depend on the #Client, so the actual
+ * scan may be done in another thread.
+ */
+struct TagScanLocation {
+	/**
+	 * The path of a local file; if this is "nulled", then #uri
+	 * is used.
+	 */
+	AllocatedPath path = nullptr;
+
+	/**
+	 * An URI to be opened with InputStream::OpenReady().
+	 */
+	std::string uri;
+};
+
+/**
+ * Resolve the given URI (see TagScanAny()) without reading the file.
+ * This needs the database and the #Storage and must therefore be
+ * called in the main thread.
+ *
+ * Throws on error.
+ */
+TagScanLocation
+TagLocateAny(Client &client, const char *uri);
+
+/**
+ * Scan tags in the song file at the given location.  This is the
+ * expensive part of TagScanAny(), and it may be called in any
+ * thread.
+ *
+ * Throws on error.
+ */
+void
+TagScanAny(const TagScanLocation &location, TagHandler &handler);
+
 /**
  * Scan tags in the song file specified by the given URI.  The URI may
  * be relative to the music directory (the "client" parameter will be
@@ -26,6 +26,13 @@ public:
 	 * #Client's #EventLoop thread.
 	 */
 	virtual void Cancel() noexcept = 0;
+
+	/**
+	 * The client's output buffer has been sent completely.  This
+	 * allows a command to send a huge response piecewise.  It will
+	 * be called from the #Client's #EventLoop thread.
+	 */
+	virtual void OnClientOutputEmpty() noexcept {}
 };
 
 #endif
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "BackgroundThreadPool.hxx"
+#include "ThreadBackgroundCommand.hxx"
+#include "thread/Name.hxx"
+
+#include <algorithm>
+#include <cassert>
+
+BackgroundThreadPool::BackgroundThreadPool(unsigned n_threads)
+	:max_long_running(std::max(n_threads, 2U) - 1)
+{
+	assert(n_threads > 0);
+
+	for (unsigned i = 0; i < n_threads; ++i) {
+		threads.emplace_front(BIND_THIS_METHOD(RunWorker));
+
+		try {
+			threads.front().Start();
+		} catch (...) {
+			/* this Thread was never started; remove it
+			   before joining the others */
+			threads.pop_front();
+			StopThreads();
+			throw;
+		}
+	}
+}
+
+BackgroundThreadPool::~BackgroundThreadPool() noexcept
+{
+	assert(waiting.empty());
+
+	StopThreads();
+}
+
+void
+BackgroundThreadPool::StopThreads() noexcept
+{
+	{
+		const std::scoped_lock lock{mutex};
+		quit = true;
+		worker_cond.notify_all();
+	}
+
+	for (auto &thread : threads)
+		thread.Join();
+}
+
+void
+BackgroundThreadPool::Push(ThreadBackgroundCommand &cmd) noexcept
+{
+	const std::scoped_lock lock{mutex};
+	assert(cmd.state == ThreadBackgroundCommand::State::NONE);
+
+	cmd.state = ThreadBackgroundCommand::State::WAITING;
+	waiting.push_back(&cmd);
+	worker_cond.notify_one();
+}
+
+void
+BackgroundThreadPool::Cancel(ThreadBackgroundCommand &cmd) noexcept
+{
+	std::unique_lock lock{mutex};
+
+	switch (cmd.state) {
+	case ThreadBackgroundCommand::State::NONE:
+	case ThreadBackgroundCommand::State::DONE:
+		break;
+
+	case ThreadBackgroundCommand::State::WAITING:
+		waiting.erase(std::find(waiting.begin(), waiting.end(), &cmd));
+		cmd.state = ThreadBackgroundCommand::State::NONE;
+		break;
+
+	case ThreadBackgroundCommand::State::RUNNING:
+		{
+			const ScopeUnlock unlock(mutex);
+			cmd.CancelThread();
+		}
+
+		done_cond.wait(lock, [&cmd]{
+			return cmd.state == ThreadBackgroundCommand::State::DONE;
+		});
+		break;
+	}
+}
+
+inline std::deque<ThreadBackgroundCommand *>::iterator
+BackgroundThreadPool::FindRunnable() noexcept
+{
+	if (n_long_running < max_long_running)
+		return waiting.begin();
+
+	return std::find_if(waiting.begin(), waiting.end(), [](const auto *cmd){
+		return !cmd->long_running;
+	});
+}
+
+inline void
+BackgroundThreadPool::RunWorker() noexcept
+{
+	SetThreadName("background");
+
+	std::unique_lock lock{mutex};
+
+	while (true) {
+		std::deque<ThreadBackgroundCommand *>::iterator i;
+		worker_cond.wait(lock, [this, &i]{
+			return quit || (i = FindRunnable()) != waiting.end();
+		});
+
+		if (quit)
+			break;
+
+		auto &cmd = **i;
+		waiting.erase(i);
+		cmd.state = ThreadBackgroundCommand::State::RUNNING;
+
+		if (cmd.long_running)
+			++n_long_running;
+
+		{
+			const ScopeUnlock unlock(mutex);
+			cmd._Run();
+		}
+
+		/* this worker will pick up the next long-running
+		   command (if any), so no other worker needs to be
+		   woken */
+		if (cmd.long_running)
+			--n_long_running;
+
+		/* this must be done while holding the mutex, because
+		   as soon as Cancel() sees DONE or the InjectEvent
+		   fires, the command may be deleted */
+		cmd.state = ThreadBackgroundCommand::State::DONE;
+		cmd.defer_finish.Schedule();
+		done_cond.notify_all();
+	}
+}
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_BACKGROUND_THREAD_POOL_HXX
+#define MPD_BACKGROUND_THREAD_POOL_HXX
+
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+#include "thread/Thread.hxx"
+
+#include <deque>
+#include <forward_list>
+
+class ThreadBackgroundCommand;
+
+/**
+ * A bounded pool of threads which run #ThreadBackgroundCommand
+ * instances.  The threads are reused, and commands which are
+ * submitted while all threads are busy wait in a queue.
+ *
+ * Long-running commands (see ThreadBackgroundCommand::long_running)
+ * may occupy all threads but one, so they cannot stall the short
+ * ones.  With only one thread, there is no such reservation.
+ *
+ * Push() and Cancel() may only be called from the main thread.
+ */
+class BackgroundThreadPool {
+	Mutex mutex;
+
+	/**
+	 * Signalled when a command has been added to #waiting or
+	 * when #quit has been set.
+	 */
+	Cond worker_cond;
+
+	/**
+	 * Signalled when a command has finished.
+	 */
+	Cond done_cond;
+
+	/**
+	 * The commands which have not yet been picked up by a
+	 * worker.
+	 */
+	std::deque<ThreadBackgroundCommand *> waiting;
+
+	std::forward_list<Thread> threads;
+
+	/**
+	 * The maximum number of long-running commands which may be
+	 * executed at a time.
+	 */
+	const unsigned max_long_running;
+
+	/**
+	 * The number of long-running commands which are being
+	 * executed right now.
+	 */
+	unsigned n_long_running = 0;
+
+	bool quit = false;
+
+public:
+	/**
+	 * Throws on error.
+	 */
+	explicit BackgroundThreadPool(unsigned n_threads);
+
+	~BackgroundThreadPool() noexcept;
+
+	BackgroundThreadPool(const BackgroundThreadPool &) = delete;
+	BackgroundThreadPool &operator=(const BackgroundThreadPool &) = delete;
+
+	/**
+	 * Submit a command.  ThreadBackgroundCommand::Run() will be
+	 * called in a worker thread.
+	 */
+	void Push(ThreadBackgroundCommand &cmd) noexcept;
+
+	/**
+	 * Remove the command from the queue.  If it is already
+	 * running, then call ThreadBackgroundCommand::CancelThread()
+	 * and wait for it to finish.  This blocks only briefly,
+	 * because commands check for cancellation periodically (see
+	 * BufferedBackgroundCommand::CheckCancel()).
+	 */
+	void Cancel(ThreadBackgroundCommand &cmd) noexcept;
+
+private:
+	void StopThreads() noexcept;
+
+	/**
+	 * Find the first command in #waiting which may be executed
+	 * now.
+	 *
+	 * Caller must lock the mutex.
+	 *
+	 * @return an iterator to the command or waiting.end()
+	 */
+	std::deque<ThreadBackgroundCommand *>::iterator FindRunnable() noexcept;
+
+	void RunWorker() noexcept;
+};
+
+#endif
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "BufferedBackgroundCommand.hxx"
+
+#include <stdexcept>
+
+void
+BufferedBackgroundCommand::Run()
+{
+	Response response(client, 0, *this);
+	Generate(response);
+
+	if (overflow)
+		throw std::runtime_error("Output buffer is full");
+}
+
+void
+BufferedBackgroundCommand::CheckCancel() const
+{
+	if (cancel.load(std::memory_order_relaxed))
+		throw std::runtime_error("Cancelled");
+
+	if (overflow)
+		throw std::runtime_error("Output buffer is full");
+}
+
+void
+BufferedBackgroundCommand::SendResponse(Response &r) noexcept
+{
+	if (cache != nullptr)
+		cache->Put(cache_generation, std::move(cache_key), buffer);
+
+	r.Write(buffer.data(), buffer.size());
+}
+
+void
+BufferedBackgroundCommand::CancelThread() noexcept
+{
+	/* Generate() will throw in its next CheckCancel() call;
+	   until then, its output is discarded */
+	cancel.store(true, std::memory_order_relaxed);
+}
+
+bool
+BufferedBackgroundCommand::WriteResponse(std::span<const std::byte> src) noexcept
+{
+	if (cancel.load(std::memory_order_relaxed) || overflow)
+		return false;
+
+	if (buffer.size() + src.size() > max_size) {
+		overflow = true;
+		return false;
+	}
+
+	buffer.append((const char *)src.data(), src.size());
+	return true;
+}
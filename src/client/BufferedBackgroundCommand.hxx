@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_BUFFERED_BACKGROUND_COMMAND_HXX
+#define MPD_BUFFERED_BACKGROUND_COMMAND_HXX
+
+#include "ThreadBackgroundCommand.hxx"
+#include "Response.hxx"
+#include "ResponseCache.hxx"
+#include "Client.hxx"
+#include "command/CommandResult.hxx"
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+/**
+ * A #ThreadBackgroundCommand which generates a response in a worker
+ * thread and collects it in a buffer, to be sent to the client when
+ * it has finished.
+ *
+ * @see RunInBackground()
+ */
+class BufferedBackgroundCommand : public ThreadBackgroundCommand, ResponseSink {
+	Client &client;
+
+	/**
+	 * The maximum size of #buffer, i.e. the client's output
+	 * buffer size.
+	 */
+	const std::size_t max_size;
+
+	std::string buffer;
+
+	std::atomic_bool cancel{false};
+
+	bool overflow = false;
+
+	/**
+	 * If set, then a successful response is added to this cache.
+	 */
+	ResponseCache *cache = nullptr;
+
+	unsigned cache_generation;
+
+	std::string cache_key;
+
+public:
+	BufferedBackgroundCommand(Client &_client, const Response &r) noexcept
+		:ThreadBackgroundCommand(_client, r.GetCommand()),
+		 client(_client),
+		 max_size(_client.GetOutputMaxSize()) {}
+
+	/**
+	 * Add the response to the given cache after it has been
+	 * generated successfully.  Must be called before Start().
+	 */
+	void EnableCache(ResponseCache &_cache, std::string &&_key) noexcept {
+		cache = &_cache;
+		cache_generation = _cache.GetGeneration();
+		cache_key = std::move(_key);
+	}
+
+protected:
+	/**
+	 * Generate the response.  This runs in a worker thread, and it
+	 * must not access data which is owned by the main thread.
+	 * It should call CheckCancel() periodically.
+	 */
+	virtual void Generate(Response &r) = 0;
+
+	/**
+	 * Throws if the command has been cancelled or if the output
+	 * buffer is full, to release the worker thread early.  This
+	 * must be called only by Generate(), at points where it does
+	 * not hold any locks.
+	 */
+	void CheckCancel() const;
+
+private:
+	/* virtual methods from class ThreadBackgroundCommand */
+	void Run() final;
+	void SendResponse(Response &r) noexcept final;
+	void CancelThread() noexcept final;
+
+	/* virtual methods from class ResponseSink */
+	bool WriteResponse(std::span<const std::byte> src) noexcept final;
+};
+
+template<typename F>
+class BufferedBackgroundCommandFunction final
+	: public BufferedBackgroundCommand {
+	F f;
+
+public:
+	BufferedBackgroundCommandFunction(Client &_client, const Response &r,
+					  F &&_f) noexcept
+		:BufferedBackgroundCommand(_client, r),
+		 f(std::move(_f)) {}
+
+protected:
+	void Generate(Response &r) override {
+		f(r, [this]{ CheckCancel(); });
+	}
+};
+
+/**
+ * Run the given function in the #BackgroundThreadPool, which keeps
+ * the main thread responsive while an expensive read-only command is
+ * executed.  The function receives a #Response which collects all
+ * data in a buffer; it must not access data which is owned by the
+ * main thread.  Its second parameter is a yield function (see
+ * #DatabaseYield) which it should call periodically while it does
+ * not hold any locks; it throws when the command has been cancelled.
+ *
+ * This must not be used inside a command list (see
+ * Client::IsProcessingCommandList()).
+ *
+ * @param cache if not nullptr, then the response is added to this
+ * cache with the given key
+ */
+template<typename F>
+CommandResult
+RunInBackground(Client &client, Response &r, F &&f,
+		ResponseCache *cache=nullptr, std::string cache_key={})
+{
+	assert(!client.IsProcessingCommandList());
+
+	using C = BufferedBackgroundCommandFunction<std::decay_t<F>>;
+	auto cmd = std::make_unique<C>(client, r, std::forward<F>(f));
+	if (cache != nullptr)
+		cmd->EnableCache(*cache, std::move(cache_key));
+	cmd->Start();
+	client.SetBackgroundCommand(std::move(cmd));
+	return CommandResult::BACKGROUND;
+}
+
+#endif
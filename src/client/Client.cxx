@@ -6,6 +6,7 @@
 #include "Partition.hxx"
 #include "Instance.hxx"
 #include "BackgroundCommand.hxx"
+#include "CompactSongEncoder.hxx"
 #include "IdleFlags.hxx"
 #include "config.h"
 
@@ -46,15 +47,27 @@ Client::OnBackgroundCommandFinished() noexcept
 	timeout_event.Schedule(client_timeout);
 }
 
+void
+Client::OnSocketOutputEmpty() noexcept
+{
+	if (background_command)
+		background_command->OnClientOutputEmpty();
+}
+
 void
 Client::SetPartition(Partition &new_partition) noexcept
 {
 	if (partition == &new_partition)
 		return;
 
+	/* idle events of the old partition which have not yet been
+	   collected are still relevant */
+	CollectIdle();
+
 	partition->clients.erase(partition->clients.iterator_to(*this));
 	partition = &new_partition;
 	partition->clients.push_back(*this);
+	idle_serial = partition->idle_waiters.GetSerial();
 
 	/* set idle flags for those subsystems which are specific to
 	   the current partition to force the client to reload its
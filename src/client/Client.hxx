@@ -14,6 +14,7 @@
 #include "util/IntrusiveList.hxx"
 
 #include <cstddef>
+#include <cstdint>
 #include <list>
 #include <memory>
 #include <set>
@@ -30,15 +31,22 @@ struct playlist;
 class Database;
 class Storage;
 class BackgroundCommand;
+class CompactSongEncoder;
 
 class Client final
 	: FullyBufferedSocket
 {
 	friend struct ClientPerPartitionListHook;
+	friend struct ClientIdleWaiterHook;
 	friend class ClientList;
 
 	IntrusiveListHook<> list_siblings, partition_siblings;
 
+	/**
+	 * Linked into an #IdleWaiterList while #idle_waiting is set.
+	 */
+	IntrusiveListHook<IntrusiveHookMode::AUTO_UNLINK> idle_siblings;
+
 	CoarseTimerEvent timeout_event;
 
 	Partition *partition;
@@ -59,9 +67,19 @@ class Client final
 	    the client enters "idle" */
 	unsigned idle_flags = 0;
 
+	/**
+	 * The IdleWaiterList::GetSerial() value of the partition's
+	 * events which have already been added to #idle_flags.  Later
+	 * events are collected by CollectIdle().
+	 */
+	uint_least64_t idle_serial;
+
 	/** idle flags that the client wants to receive */
 	unsigned idle_subscriptions;
 
+	/** is a command list being executed right now? */
+	bool processing_command_list = false;
+
 public:
 	// TODO: make this attribute "private"
 	/**
@@ -75,6 +93,13 @@ public:
 	 */
 	size_t binary_limit = 8192;
 
+	/**
+	 * If this is set, then song listings are sent in the
+	 * "compact" format.  Can be changed with the "songformat"
+	 * command.
+	 */
+	std::unique_ptr<CompactSongEncoder> compact_song_encoder;
+
 	/**
 	 * This caches the last "albumart" InputStream instance, to
 	 * avoid repeating the search for each chunk requested by this
@@ -121,6 +146,7 @@ public:
 
 	using FullyBufferedSocket::GetEventLoop;
 	using FullyBufferedSocket::GetOutputMaxSize;
+	using FullyBufferedSocket::IsOutputEmpty;
 
 	[[gnu::pure]]
 	bool IsExpired() const noexcept {
@@ -171,9 +197,25 @@ public:
 	 * Send "idle" response to this client.
 	 */
 	void IdleNotify() noexcept;
+
+	/**
+	 * Send a response generated by the #IdleWaiterList to this
+	 * client, which has already been removed from that list.
+	 */
+	void IdleNotify(std::string_view response) noexcept;
+
 	void IdleAdd(unsigned flags) noexcept;
 	bool IdleWait(unsigned flags) noexcept;
 
+	/**
+	 * Is the current command part of a command list?  Commands
+	 * in a command list must not be deferred to a
+	 * #BackgroundCommand.
+	 */
+	bool IsProcessingCommandList() const noexcept {
+		return processing_command_list;
+	}
+
 	/**
 	 * Called by a command handler to defer execution to a
 	 * #BackgroundCommand.
@@ -266,8 +308,23 @@ public:
 	const Storage *GetStorage() const noexcept;
 
 private:
+	/**
+	 * Add the partition's idle events which have been broadcast
+	 * since the last call to #idle_flags.
+	 */
+	void CollectIdle() noexcept;
+
+	/**
+	 * Leave "idle" mode without sending a response.
+	 */
+	void IdleCancel() noexcept {
+		idle_waiting = false;
+		if (idle_siblings.is_linked())
+			idle_siblings.unlink();
+	}
+
 	CommandResult ProcessCommandList(bool list_ok,
-					 std::list<std::string> &&list) noexcept;
+					 std::string &&list) noexcept;
 
 	CommandResult ProcessLine(char *line) noexcept;
 
@@ -276,6 +333,9 @@ private:
 	void OnSocketError(std::exception_ptr ep) noexcept override;
 	void OnSocketClosed() noexcept override;
 
+	/* virtual methods from class FullyBufferedSocket */
+	void OnSocketOutputEmpty() noexcept override;
+
 	/* callback for TimerEvent */
 	void OnTimeout() noexcept;
 };
@@ -283,6 +343,9 @@ private:
 struct ClientPerPartitionListHook
 	: IntrusiveListMemberHookTraits<&Client::partition_siblings> {};
 
+struct ClientIdleWaiterHook
+	: IntrusiveListMemberHookTraits<&Client::idle_siblings> {};
+
 void
 client_new(EventLoop &loop, Partition &partition,
 	   UniqueSocketDescriptor fd, SocketAddress address, int uid,
@@ -12,6 +12,10 @@ Client::SetExpired() noexcept
 	if (IsExpired())
 		return;
 
+	if (idle_siblings.is_linked())
+		/* don't receive any more "idle" events */
+		idle_siblings.unlink();
+
 	if (background_command) {
 		background_command->Cancel();
 		background_command.reset();
@@ -3,36 +3,48 @@
 
 #include "Client.hxx"
 #include "Config.hxx"
-#include "Response.hxx"
-#include "Idle.hxx"
-
-#include <fmt/format.h>
+#include "IdleWaiterList.hxx"
+#include "Partition.hxx"
 
 #include <cassert>
+#include <utility>
 
-static void
-WriteIdleResponse(Response &r, unsigned flags) noexcept
+void
+Client::CollectIdle() noexcept
 {
-	const char *const*idle_names = idle_get_names();
-	for (unsigned i = 0; idle_names[i]; ++i) {
-		if (flags & (1 << i))
-			r.Fmt(FMT_STRING("changed: {}\n"), idle_names[i]);
-	}
-
-	r.Write("OK\n");
+	const auto &waiters = partition->idle_waiters;
+	idle_flags |= waiters.CollectSince(idle_serial);
+	idle_serial = waiters.GetSerial();
 }
 
 void
 Client::IdleNotify() noexcept
 {
 	assert(idle_waiting);
+	assert(!idle_siblings.is_linked());
 	assert(idle_flags != 0);
 
 	unsigned flags = std::exchange(idle_flags, 0) & idle_subscriptions;
 	idle_waiting = false;
 
-	Response r(*this, 0);
-	WriteIdleResponse(r, flags);
+	Write(MakeIdleResponse(flags));
+
+	timeout_event.Schedule(client_timeout);
+}
+
+void
+Client::IdleNotify(std::string_view response) noexcept
+{
+	assert(idle_waiting);
+	assert(!idle_siblings.is_linked());
+
+	/* the response contains all events up to now, and those not
+	   subscribed are discarded */
+	idle_flags = 0;
+	idle_serial = partition->idle_waiters.GetSerial();
+	idle_waiting = false;
+
+	Write(response);
 
 	timeout_event.Schedule(client_timeout);
 }
@@ -44,8 +56,11 @@ Client::IdleAdd(unsigned flags) noexcept
 		return;
 
 	idle_flags |= flags;
-	if (idle_waiting && (idle_flags & idle_subscriptions))
+	if (idle_waiting && (idle_flags & idle_subscriptions)) {
+		idle_siblings.unlink();
+		CollectIdle();
 		IdleNotify();
+	}
 }
 
 bool
@@ -53,6 +68,8 @@ Client::IdleWait(unsigned flags) noexcept
 {
 	assert(!idle_waiting);
 
+	CollectIdle();
+
 	idle_waiting = true;
 	idle_subscriptions = flags;
 
@@ -60,6 +77,8 @@ Client::IdleWait(unsigned flags) noexcept
 		IdleNotify();
 		return true;
 	} else {
+		partition->idle_waiters.Add(*this, idle_subscriptions);
+
 		/* disable timeouts while in "idle" */
 		timeout_event.Cancel();
 		return false;
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "IdleWaiterList.hxx"
+#include "Client.hxx"
+#include "IdleFlags.hxx"
+
+#include <bit>
+
+IdleWaiterList::IdleWaiterList() noexcept = default;
+IdleWaiterList::~IdleWaiterList() noexcept = default;
+
+unsigned
+IdleWaiterList::CollectSince(uint_least64_t since) const noexcept
+{
+	unsigned flags = 0;
+	for (unsigned i = 0; i < flag_serials.size(); ++i)
+		if (flag_serials[i] > since)
+			flags |= 1U << i;
+	return flags;
+}
+
+void
+IdleWaiterList::Add(Client &client, unsigned subscriptions) noexcept
+{
+	groups[subscriptions].push_back(client);
+}
+
+void
+IdleWaiterList::Broadcast(unsigned flags) noexcept
+{
+	++serial;
+
+	for (unsigned i = flags; i != 0; i &= i - 1)
+		flag_serials[std::countr_zero(i)] = serial;
+
+	for (auto i = groups.begin(); i != groups.end();) {
+		auto &[subscriptions, list] = *i;
+
+		if (list.empty()) {
+			/* all clients of this group have been
+			   notified or disconnected since the previous
+			   event */
+			i = groups.erase(i);
+			continue;
+		}
+
+		if (subscriptions & flags) {
+			/* all clients of this group get the same
+			   response */
+			const auto response = MakeIdleResponse(subscriptions & flags);
+
+			list.clear_and_dispose([&response](Client *client){
+				client->IdleNotify(response);
+			});
+		}
+
+		++i;
+	}
+}
+
+std::string
+MakeIdleResponse(unsigned flags) noexcept
+{
+	std::string response;
+
+	const char *const*idle_names = idle_get_names();
+	for (unsigned i = 0; idle_names[i]; ++i) {
+		if (flags & (1 << i)) {
+			response += "changed: ";
+			response += idle_names[i];
+			response += '\n';
+		}
+	}
+
+	response += "OK\n";
+	return response;
+}
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_IDLE_WAITER_LIST_HXX
+#define MPD_IDLE_WAITER_LIST_HXX
+
+#include "util/IntrusiveList.hxx"
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+
+class Client;
+struct ClientIdleWaiterHook;
+
+/**
+ * Delivers "idle" events to the clients of a #Partition.
+ *
+ * Clients which are waiting in the "idle" command are grouped by
+ * their subscription mask, so an event visits only the groups which
+ * are interested in it, and the response is generated once per
+ * group.  Clients which are not waiting are not visited at all;
+ * instead, each event gets a serial number, and a client collects
+ * the events it has missed with CollectSince() when it enters
+ * "idle".
+ *
+ * This class is not thread-safe; it may only be used in the main
+ * thread.
+ */
+class IdleWaiterList {
+	using List = IntrusiveList<Client, ClientIdleWaiterHook, false>;
+
+	/**
+	 * Incremented by each Broadcast() call.
+	 */
+	uint_least64_t serial = 0;
+
+	/**
+	 * The #serial of the most recent Broadcast() call which
+	 * included this idle flag.
+	 */
+	std::array<uint_least64_t, 32> flag_serials{};
+
+	/**
+	 * The waiting clients, grouped by subscription mask.
+	 */
+	std::map<unsigned, List> groups;
+
+public:
+	IdleWaiterList() noexcept;
+	~IdleWaiterList() noexcept;
+
+	IdleWaiterList(const IdleWaiterList &) = delete;
+	IdleWaiterList &operator=(const IdleWaiterList &) = delete;
+
+	uint_least64_t GetSerial() const noexcept {
+		return serial;
+	}
+
+	/**
+	 * Determine the idle flags which have been broadcast after
+	 * the given serial.
+	 */
+	[[gnu::pure]]
+	unsigned CollectSince(uint_least64_t since) const noexcept;
+
+	/**
+	 * Add a client which is waiting for one of the given idle
+	 * flags.  It is removed automatically when it gets
+	 * notified; to remove it earlier, unlink its hook.
+	 */
+	void Add(Client &client, unsigned subscriptions) noexcept;
+
+	/**
+	 * Record an idle event and notify all clients waiting for
+	 * it.
+	 */
+	void Broadcast(unsigned flags) noexcept;
+};
+
+/**
+ * Generate the response to the "idle" command.
+ */
+std::string
+MakeIdleResponse(unsigned flags) noexcept;
+
+#endif
@@ -12,6 +12,7 @@
 #include "net/SocketAddress.hxx"
 #include "net/ToString.hxx"
 #include "Log.hxx"
+#include "CompactSongEncoder.hxx"
 #include "Version.h"
 
 #include <cassert>
@@ -29,6 +30,7 @@ Client::Client(EventLoop &_loop, Partition &_partition,
 	 permission(_permission),
 	 uid(_uid),
 	 num(_num),
+	 idle_serial(_partition.idle_waiters.GetSerial()),
 	 last_album_art(_loop)
 {
 	timeout_event.Schedule(client_timeout);
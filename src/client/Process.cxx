@@ -9,21 +9,27 @@
 #include "util/StringAPI.hxx"
 #include "util/CharUtil.hxx"
 
+#include <cstring>
+
 #define CLIENT_LIST_MODE_BEGIN "command_list_begin"
 #define CLIENT_LIST_OK_MODE_BEGIN "command_list_ok_begin"
 #define CLIENT_LIST_MODE_END "command_list_end"
 
 inline CommandResult
-Client::ProcessCommandList(bool list_ok,
-			   std::list<std::string> &&list) noexcept
+Client::ProcessCommandList(bool list_ok, std::string &&list) noexcept
 {
 	unsigned n = 0;
 
-	for (auto &&i : list) {
-		char *cmd = &*i.begin();
+	for (char *p = list.data(), *const end = p + list.size(); p != end;) {
+		/* the commands are null-terminated, and
+		   command_process() tokenizes them in place */
+		char *cmd = p;
+		p += std::strlen(cmd) + 1;
 
 		FmtDebug(client_domain, "process command \"{}\"", cmd);
+		processing_command_list = true;
 		auto ret = command_process(*this, n++, cmd);
+		processing_command_list = false;
 		FmtDebug(client_domain, "command returned {}", unsigned(ret));
 		if (IsExpired())
 			return CommandResult::CLOSE;
@@ -54,7 +60,7 @@ Client::ProcessLine(char *line) noexcept
 	if (StringIsEqual(line, "noidle")) {
 		if (idle_waiting) {
 			/* send empty idle response and leave idle mode */
-			idle_waiting = false;
+			IdleCancel();
 			WriteOK();
 		}
 
@@ -6,22 +6,33 @@
 
 #include <fmt/format.h>
 
+#include <string.h>
+
 TagMask
 Response::GetTagMask() const noexcept
 {
 	return GetClient().tag_mask;
 }
 
+CompactSongEncoder *
+Response::GetCompactSongEncoder() const noexcept
+{
+	return client.compact_song_encoder.get();
+}
+
 bool
 Response::Write(const void *data, size_t length) noexcept
 {
+	if (sink != nullptr)
+		return sink->WriteResponse({(const std::byte *)data, length});
+
 	return client.Write(data, length);
 }
 
 bool
 Response::Write(const char *data) noexcept
 {
-	return client.Write(data);
+	return Write(data, strlen(data));
 }
 
 bool
@@ -47,6 +58,19 @@ Response::WriteBinary(std::span<const std::byte> payload) noexcept
 		Write("\n");
 }
 
+bool
+Response::WriteBinaryChunks(std::span<const std::byte> payload) noexcept
+{
+	while (payload.size() > client.binary_limit) {
+		if (!WriteBinary(payload.first(client.binary_limit)))
+			return false;
+
+		payload = payload.subspan(client.binary_limit);
+	}
+
+	return WriteBinary(payload);
+}
+
 void
 Response::Error(enum ack code, const char *msg) noexcept
 {
@@ -16,10 +16,30 @@
 
 class Client;
 class TagMask;
+class CompactSongEncoder;
+
+/**
+ * An alternative destination for the data written to a #Response.
+ * It is used by commands which generate their response in another
+ * thread.
+ */
+class ResponseSink {
+public:
+	/**
+	 * @return false if the data could not be accepted
+	 */
+	virtual bool WriteResponse(std::span<const std::byte> src) noexcept = 0;
+};
 
 class Response {
 	Client &client;
 
+	/**
+	 * If this is set, then all data is written to this object
+	 * instead of the #Client.
+	 */
+	ResponseSink *const sink = nullptr;
+
 	/**
 	 * This command's index in the command list.  Used to generate
 	 * error messages.
@@ -35,6 +55,10 @@ public:
 	Response(Client &_client, unsigned _list_index) noexcept
 		:client(_client), list_index(_list_index) {}
 
+	Response(Client &_client, unsigned _list_index,
+		 ResponseSink &_sink) noexcept
+		:client(_client), sink(&_sink), list_index(_list_index) {}
+
 	Response(const Response &) = delete;
 	Response &operator=(const Response &) = delete;
 
@@ -55,10 +79,23 @@ public:
 	[[gnu::pure]]
 	TagMask GetTagMask() const noexcept;
 
+	/**
+	 * Accessor for Client::compact_song_encoder.
+	 *
+	 * @return nullptr if the client has not enabled the
+	 * "compact" song format
+	 */
+	[[gnu::pure]]
+	CompactSongEncoder *GetCompactSongEncoder() const noexcept;
+
 	void SetCommand(const char *_command) noexcept {
 		command = _command;
 	}
 
+	const char *GetCommand() const noexcept {
+		return command;
+	}
+
 	bool Write(const void *data, size_t length) noexcept;
 	bool Write(const char *data) noexcept;
 
@@ -84,6 +121,14 @@ public:
 	 */
 	bool WriteBinary(std::span<const std::byte> payload) noexcept;
 
+	/**
+	 * Like WriteBinary(), but split the payload into as many
+	 * chunks as necessary to obey the client's "binarylimit".
+	 *
+	 * @return true on success
+	 */
+	bool WriteBinaryChunks(std::span<const std::byte> payload) noexcept;
+
 	void Error(enum ack code, const char *msg) noexcept;
 
 	void VFmtError(enum ack code,
@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "ResponseCache.hxx"
+#include "util/DeleteDisposer.hxx"
+
+#include <cassert>
+
+inline std::size_t
+ResponseCache::ItemHash::operator()(std::string_view key) const noexcept
+{
+	return std::hash<std::string_view>{}(key);
+}
+
+inline std::size_t
+ResponseCache::ItemHash::operator()(const Item &item) const noexcept
+{
+	return std::hash<std::string_view>{}(item.key);
+}
+
+inline bool
+ResponseCache::ItemEqual::operator()(const Item &a,
+				     std::string_view b) const noexcept
+{
+	return a.key == b;
+}
+
+inline bool
+ResponseCache::ItemEqual::operator()(std::string_view a,
+				     const Item &b) const noexcept
+{
+	return a == b.key;
+}
+
+inline bool
+ResponseCache::ItemEqual::operator()(const Item &a,
+				     const Item &b) const noexcept
+{
+	return a.key == b.key;
+}
+
+ResponseCache::~ResponseCache() noexcept
+{
+	items_by_key.clear();
+	items_by_time.clear_and_dispose(DeleteDisposer());
+}
+
+std::string
+ResponseCache::MakeKey(std::string_view command,
+		       std::span<const std::string_view> args) noexcept
+{
+	/* the null byte cannot occur in a command line, so it makes
+	   an unambiguous separator */
+	std::string key{command};
+	for (const auto arg : args) {
+		key.push_back('\0');
+		key.append(arg);
+	}
+
+	return key;
+}
+
+const std::string *
+ResponseCache::Get(std::string_view key) noexcept
+{
+	auto i = items_by_key.find(key);
+	if (i == items_by_key.end()) {
+		++misses;
+		return nullptr;
+	}
+
+	++hits;
+
+	/* refresh */
+	auto &item = *i;
+	items_by_time.erase(items_by_time.iterator_to(item));
+	items_by_time.push_back(item);
+
+	return &item.value;
+}
+
+void
+ResponseCache::Put(unsigned _generation, std::string &&key,
+		   std::string_view value) noexcept
+{
+	if (_generation != generation)
+		/* the database has been modified meanwhile */
+		return;
+
+	auto *item = new Item(std::move(key), value);
+	const std::size_t size = item->GetMemorySize();
+	if (size > max_total_size / 4) {
+		/* not worth evicting everything else */
+		delete item;
+		return;
+	}
+
+	if (auto i = items_by_key.find(item->key); i != items_by_key.end())
+		/* another client has generated the same response
+		   concurrently */
+		Remove(*i);
+
+	while (total_size + size > max_total_size)
+		Remove(items_by_time.front());
+
+	total_size += size;
+	items_by_key.insert(*item);
+	items_by_time.push_back(*item);
+}
+
+void
+ResponseCache::Clear() noexcept
+{
+	++generation;
+
+	items_by_key.clear();
+	items_by_time.clear_and_dispose(DeleteDisposer());
+	total_size = 0;
+}
+
+void
+ResponseCache::Remove(Item &item) noexcept
+{
+	assert(total_size >= item.GetMemorySize());
+	total_size -= item.GetMemorySize();
+
+	items_by_key.erase(items_by_key.iterator_to(item));
+	items_by_time.erase(items_by_time.iterator_to(item));
+	delete &item;
+}
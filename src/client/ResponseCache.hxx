@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_RESPONSE_CACHE_HXX
+#define MPD_RESPONSE_CACHE_HXX
+
+#include "util/IntrusiveHashSet.hxx"
+#include "util/IntrusiveList.hxx"
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+/**
+ * A cache for the rendered responses of read-only database queries,
+ * keyed by the normalized command line.  It is flushed with Clear() whenever
+ * the database gets modified.
+ *
+ * This class is not thread-safe; it may only be used in the main
+ * thread.
+ */
+class ResponseCache {
+	struct Item final
+		: IntrusiveListHook<>, IntrusiveHashSetHook<>
+	{
+		const std::string key, value;
+
+		Item(std::string &&_key, std::string_view _value) noexcept
+			:key(std::move(_key)), value(_value) {}
+
+		std::size_t GetMemorySize() const noexcept {
+			return sizeof(*this) + key.size() + value.size();
+		}
+	};
+
+	struct ItemHash {
+		[[gnu::pure]]
+		std::size_t operator()(std::string_view key) const noexcept;
+
+		[[gnu::pure]]
+		std::size_t operator()(const Item &item) const noexcept;
+	};
+
+	struct ItemEqual {
+		[[gnu::pure]]
+		bool operator()(const Item &a,
+				std::string_view b) const noexcept;
+
+		[[gnu::pure]]
+		bool operator()(std::string_view a,
+				const Item &b) const noexcept;
+
+		[[gnu::pure]]
+		bool operator()(const Item &a,
+				const Item &b) const noexcept;
+	};
+
+	const std::size_t max_total_size;
+
+	std::size_t total_size = 0;
+
+	/**
+	 * Incremented by Clear().  Responses which were generated
+	 * before that are rejected by Put().
+	 */
+	unsigned generation = 0;
+
+	unsigned long hits = 0, misses = 0;
+
+	/**
+	 * All items, the least recently used first.
+	 */
+	IntrusiveList<Item> items_by_time;
+
+	IntrusiveHashSet<Item, 127, ItemHash, ItemEqual> items_by_key;
+
+public:
+	explicit ResponseCache(std::size_t _max_total_size) noexcept
+		:max_total_size(_max_total_size) {}
+
+	~ResponseCache() noexcept;
+
+	ResponseCache(const ResponseCache &) = delete;
+	ResponseCache &operator=(const ResponseCache &) = delete;
+
+	unsigned long GetHits() const noexcept {
+		return hits;
+	}
+
+	unsigned long GetMisses() const noexcept {
+		return misses;
+	}
+
+	unsigned GetGeneration() const noexcept {
+		return generation;
+	}
+
+	/**
+	 * Build a cache key from a command name and its arguments.
+	 * The caller should normalize the arguments, so that
+	 * equivalent queries get the same key.
+	 */
+	[[gnu::pure]]
+	static std::string MakeKey(std::string_view command,
+				   std::span<const std::string_view> args) noexcept;
+
+	/**
+	 * Look up a response and update the hit/miss counters.
+	 *
+	 * @return the cached response or nullptr; the pointer is
+	 * valid until this object is modified
+	 */
+	const std::string *Get(std::string_view key) noexcept;
+
+	/**
+	 * Add a response to the cache.
+	 *
+	 * @param _generation the value of GetGeneration() before the
+	 * response was generated; if Clear() has been called since
+	 * then, the response is discarded
+	 */
+	void Put(unsigned _generation, std::string &&key,
+		 std::string_view value) noexcept;
+
+	/**
+	 * Remove all items.  This must be called whenever the
+	 * database gets modified.
+	 */
+	void Clear() noexcept;
+
+private:
+	void Remove(Item &item) noexcept;
+};
+
+#endif
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "StreamBackgroundCommand.hxx"
+#include "Client.hxx"
+#include "Config.hxx"
+#include "Domain.hxx"
+#include "Instance.hxx"
+#include "command/CommandError.hxx"
+#include "Log.hxx"
+
+#include <stdexcept>
+
+StreamBackgroundCommand::StreamBackgroundCommand(Client &_client,
+						 const char *_command) noexcept
+	:thread(BIND_THIS_METHOD(_Run)),
+	 defer_transfer(_client.GetEventLoop(), BIND_THIS_METHOD(OnTransfer)),
+	 timeout_event(_client.GetEventLoop(), BIND_THIS_METHOD(OnTimeout)),
+	 client(_client), command(_command),
+	 max_size(_client.GetOutputMaxSize())
+{
+	++client.GetInstance().n_stream_commands;
+}
+
+StreamBackgroundCommand::~StreamBackgroundCommand() noexcept
+{
+	assert(client.GetInstance().n_stream_commands > 0);
+
+	--client.GetInstance().n_stream_commands;
+}
+
+bool
+StreamBackgroundCommand::CanCreate(const Client &client) noexcept
+{
+	return client.GetInstance().n_stream_commands < MAX_INSTANCES;
+}
+
+void
+StreamBackgroundCommand::_Run() noexcept
+{
+	assert(!error);
+
+	try {
+		Response response(client, 0, *this);
+		Run(response);
+	} catch (...) {
+		error = std::current_exception();
+	}
+
+	{
+		const std::scoped_lock lock{mutex};
+		finished = true;
+	}
+
+	defer_transfer.Schedule();
+}
+
+bool
+StreamBackgroundCommand::WriteResponse(std::span<const std::byte> src) noexcept
+{
+	bool schedule;
+
+	{
+		const std::scoped_lock lock{mutex};
+		if (cancel || overflow)
+			return false;
+
+		if (pending.size() + src.size() > max_size) {
+			overflow = true;
+			return false;
+		}
+
+		schedule = pending.size() < CHUNK_SIZE &&
+			pending.size() + src.size() >= CHUNK_SIZE;
+		pending.append((const char *)src.data(), src.size());
+	}
+
+	if (schedule)
+		defer_transfer.Schedule();
+
+	return true;
+}
+
+void
+StreamBackgroundCommand::WaitWritable()
+{
+	std::unique_lock lock{mutex};
+	cond.wait(lock, [this]{
+		return cancel || overflow || pending.size() < CHUNK_SIZE;
+	});
+
+	if (cancel)
+		throw std::runtime_error("Cancelled");
+
+	if (overflow)
+		throw std::runtime_error("Output buffer is full");
+}
+
+void
+StreamBackgroundCommand::OnTransfer() noexcept
+{
+	if (!client.IsOutputEmpty()) {
+		/* wait for OnClientOutputEmpty(), but not forever */
+		if (!timeout_event.IsPending())
+			timeout_event.Schedule(client_timeout);
+		return;
+	}
+
+	timeout_event.Cancel();
+
+	bool _finished;
+
+	{
+		const std::scoped_lock lock{mutex};
+		if (!finished && pending.size() < CHUNK_SIZE)
+			/* not worth it; wait until WriteResponse()
+			   has collected a whole chunk */
+			return;
+
+		transfer.swap(pending);
+		_finished = finished;
+	}
+
+	cond.notify_one();
+
+	if (!transfer.empty()) {
+		if (!client.Write(transfer))
+			/* the client has been closed, which has
+			   deleted this object */
+			return;
+
+		transfer.clear();
+	}
+
+	if (_finished)
+		Finish();
+}
+
+void
+StreamBackgroundCommand::OnTimeout() noexcept
+{
+	LogDebug(client_domain, "Timeout while sending a response");
+
+	/* this cancels and deletes this object */
+	client.SetExpired();
+}
+
+void
+StreamBackgroundCommand::Finish() noexcept
+{
+	/* free the Thread */
+	thread.Join();
+
+	Client &c = client;
+
+	if (overflow) {
+		/* same as FullyBufferedSocket::Write() */
+		LogError(client_domain, "Output buffer is full");
+
+		/* this deletes this object */
+		c.SetExpired();
+		return;
+	}
+
+	/* send the response */
+	Response response(c, 0);
+	response.SetCommand(command);
+
+	if (error)
+		PrintError(response, error);
+	else
+		c.WriteOK();
+
+	if (c.IsExpired())
+		return;
+
+	/* delete this object */
+	c.OnBackgroundCommandFinished();
+}
+
+void
+StreamBackgroundCommand::OnClientOutputEmpty() noexcept
+{
+	/* don't transfer right now, because we're inside
+	   FullyBufferedSocket::Flush(), and finishing this command
+	   may resume processing the client's input */
+	defer_transfer.Schedule();
+}
+
+void
+StreamBackgroundCommand::Cancel() noexcept
+{
+	{
+		const std::scoped_lock lock{mutex};
+		cancel = true;
+	}
+
+	cond.notify_one();
+
+	if (thread.IsDefined())
+		thread.Join();
+
+	/* cancel the InjectEvent, just in case the Thread has
+	   meanwhile finished execution */
+	defer_transfer.Cancel();
+	timeout_event.Cancel();
+}
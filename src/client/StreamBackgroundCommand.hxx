@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_STREAM_BACKGROUND_COMMAND_HXX
+#define MPD_STREAM_BACKGROUND_COMMAND_HXX
+
+#include "BackgroundCommand.hxx"
+#include "Response.hxx"
+#include "event/InjectEvent.hxx"
+#include "event/CoarseTimerEvent.hxx"
+#include "thread/Thread.hxx"
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+
+#include <exception>
+#include <string>
+
+class Client;
+
+/**
+ * A #BackgroundCommand which generates a (possibly huge) response in
+ * a new thread.  The response is passed to the client piece by piece
+ * whenever the client's output buffer has been sent, and the thread
+ * gets suspended in WaitWritable() while the client is lagging
+ * behind.  This way, the memory occupied by the response is bounded.
+ *
+ * A client which does not receive anything for #client_timeout gets
+ * disconnected, just like an idle client.
+ */
+class StreamBackgroundCommand : public BackgroundCommand, ResponseSink {
+	/**
+	 * Pass data to the client when this many bytes have been
+	 * generated, and suspend the thread (in WaitWritable()) while
+	 * the client has not yet picked it up.
+	 */
+	static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+	/**
+	 * The maximum number of instances (i.e. threads) per
+	 * #Instance, see CanCreate().
+	 */
+	static constexpr unsigned MAX_INSTANCES = 16;
+
+	Thread thread;
+	InjectEvent defer_transfer;
+
+	/**
+	 * Disconnects the client if it does not receive the pending
+	 * output in time.
+	 */
+	CoarseTimerEvent timeout_event;
+
+	Client &client;
+
+	/**
+	 * The name of the command, used to generate error messages.
+	 */
+	const char *const command;
+
+	/**
+	 * The maximum size of #pending; exceeding it is an error,
+	 * just like exceeding the client's output buffer.
+	 */
+	const std::size_t max_size;
+
+	/**
+	 * Protects #pending, #finished, #cancel and #overflow.
+	 */
+	Mutex mutex;
+
+	/**
+	 * Signalled when #pending has been picked up or when
+	 * #cancel has been set.
+	 */
+	Cond cond;
+
+	/**
+	 * Data generated by the thread which has not yet been passed
+	 * to the client.
+	 */
+	std::string pending;
+
+	/**
+	 * The buffer which is being passed to the client; it is
+	 * swapped with #pending to avoid reallocations.  Only used
+	 * in the #EventLoop thread.
+	 */
+	std::string transfer;
+
+	/**
+	 * The error thrown by Run().
+	 */
+	std::exception_ptr error;
+
+	/**
+	 * Has Run() returned?
+	 */
+	bool finished = false;
+
+	/**
+	 * Has Cancel() been called?
+	 */
+	bool cancel = false;
+
+	/**
+	 * Has #pending exceeded #max_size?
+	 */
+	bool overflow = false;
+
+public:
+	/**
+	 * @param _command the name of the command (pointer to a
+	 * string literal)
+	 */
+	StreamBackgroundCommand(Client &_client, const char *_command) noexcept;
+
+	~StreamBackgroundCommand() noexcept override;
+
+	/**
+	 * May another instance be created?  Each one has a thread
+	 * which may be suspended until the client times out, so the
+	 * number is limited; callers shall run the command
+	 * synchronously if this returns false.
+	 */
+	[[gnu::pure]]
+	static bool CanCreate(const Client &client) noexcept;
+
+	void Start() {
+		thread.Start();
+	}
+
+	/* virtual methods from class BackgroundCommand */
+	void Cancel() noexcept final;
+	void OnClientOutputEmpty() noexcept final;
+
+private:
+	void _Run() noexcept;
+	void OnTransfer() noexcept;
+	void OnTimeout() noexcept;
+	void Finish() noexcept;
+
+	/* virtual methods from class ResponseSink */
+	bool WriteResponse(std::span<const std::byte> src) noexcept final;
+
+protected:
+	/**
+	 * Block until the client has picked up the data generated so
+	 * far.  This must be called periodically by Run(), at points
+	 * where it does not hold any locks.
+	 *
+	 * Throws if the command has been cancelled.
+	 */
+	void WaitWritable();
+
+	/**
+	 * Generate the response.  This runs in the new thread.
+	 *
+	 * If this method throws, the exception will be converted to
+	 * a MPD response.
+	 */
+	virtual void Run(Response &response) = 0;
+};
+
+#endif
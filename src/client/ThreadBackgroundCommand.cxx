@@ -2,17 +2,27 @@
 // Copyright The Music Player Daemon Project
 
 #include "ThreadBackgroundCommand.hxx"
+#include "BackgroundThreadPool.hxx"
 #include "Client.hxx"
 #include "Response.hxx"
+#include "Instance.hxx"
 #include "command/CommandError.hxx"
 
-ThreadBackgroundCommand::ThreadBackgroundCommand(Client &_client) noexcept
-	:thread(BIND_THIS_METHOD(_Run)),
+ThreadBackgroundCommand::ThreadBackgroundCommand(Client &_client,
+						 const char *_command,
+						 bool _long_running) noexcept
+	:pool(*_client.GetInstance().background_pool),
 	 defer_finish(_client.GetEventLoop(), BIND_THIS_METHOD(DeferredFinish)),
-	 client(_client)
+	 client(_client), command(_command), long_running(_long_running)
 {
 }
 
+void
+ThreadBackgroundCommand::Start() noexcept
+{
+	pool.Push(*this);
+}
+
 void
 ThreadBackgroundCommand::_Run() noexcept
 {
@@ -23,37 +33,39 @@ ThreadBackgroundCommand::_Run() noexcept
 	} catch (...) {
 		error = std::current_exception();
 	}
-
-	defer_finish.Schedule();
 }
 
 void
 ThreadBackgroundCommand::DeferredFinish() noexcept
 {
-	/* free the Thread */
-	thread.Join();
+	Client &c = client;
 
 	/* send the response */
-	Response response(client, 0);
+	Response response(c, 0);
+	response.SetCommand(command);
 
 	if (error) {
 		PrintError(response, error);
 	} else {
 		SendResponse(response);
-		client.WriteOK();
+		c.WriteOK();
 	}
 
+	if (c.IsExpired())
+		/* writing has failed, and the client has already
+		   deleted this object */
+		return;
+
 	/* delete this object */
-	client.OnBackgroundCommandFinished();
+	c.OnBackgroundCommandFinished();
 }
 
 void
 ThreadBackgroundCommand::Cancel() noexcept
 {
-	CancelThread();
-	thread.Join();
+	pool.Cancel(*this);
 
-	/* cancel the InjectEvent, just in case the Thread has
+	/* cancel the InjectEvent, just in case the command has
 	   meanwhile finished execution */
 	defer_finish.Cancel();
 }
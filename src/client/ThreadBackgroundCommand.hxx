@@ -6,36 +6,82 @@
 
 #include "BackgroundCommand.hxx"
 #include "event/InjectEvent.hxx"
-#include "thread/Thread.hxx"
 
 #include <exception>
 
 class Client;
 class Response;
+class BackgroundThreadPool;
 
 /**
- * A #BackgroundCommand which defers execution into a new thread.
+ * A #BackgroundCommand which defers execution into a thread of the
+ * #BackgroundThreadPool.
  */
 class ThreadBackgroundCommand : public BackgroundCommand {
-	Thread thread;
+	friend class BackgroundThreadPool;
+
+	BackgroundThreadPool &pool;
 	InjectEvent defer_finish;
 	Client &client;
 
+	/**
+	 * The name of the command, used to generate error messages.
+	 */
+	const char *const command;
+
+	/**
+	 * Does this command take a long time, e.g. because it
+	 * decodes a whole song file?  The #BackgroundThreadPool
+	 * keeps a thread free for the other commands.
+	 */
+	const bool long_running;
+
 	/**
 	 * The error thrown by Run().
 	 */
 	std::exception_ptr error;
 
+	/**
+	 * Protected by the #BackgroundThreadPool's mutex.
+	 */
+	enum class State {
+		/**
+		 * Not submitted to the #BackgroundThreadPool (or
+		 * removed from it).
+		 */
+		NONE,
+
+		/**
+		 * Waiting for a worker thread.
+		 */
+		WAITING,
+
+		/**
+		 * Run() is being executed.
+		 */
+		RUNNING,
+
+		/**
+		 * Run() has finished.
+		 */
+		DONE,
+	} state = State::NONE;
+
 public:
-	explicit ThreadBackgroundCommand(Client &_client) noexcept;
+	/**
+	 * @param _command the name of the command (pointer to a
+	 * string literal)
+	 * @param _long_running see #long_running
+	 */
+	ThreadBackgroundCommand(Client &_client,
+				const char *_command="",
+				bool _long_running=false) noexcept;
 
 	auto &GetEventLoop() const noexcept {
 		return defer_finish.GetEventLoop();
 	}
 
-	void Start() {
-		thread.Start();
-	}
+	void Start() noexcept;
 
 	void Cancel() noexcept final;
 
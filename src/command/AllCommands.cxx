@@ -182,6 +182,7 @@ static constexpr struct command commands[] = {
 	{ "setvol", PERMISSION_PLAYER, 1, 1, handle_setvol },
 	{ "shuffle", PERMISSION_PLAYER, 0, 1, handle_shuffle },
 	{ "single", PERMISSION_PLAYER, 1, 1, handle_single },
+	{ "songformat", PERMISSION_NONE, 1, 1, handle_songformat },
 	{ "stats", PERMISSION_READ, 0, 0, handle_stats },
 	{ "status", PERMISSION_READ, 0, 0, handle_status },
 #ifdef ENABLE_SQLITE
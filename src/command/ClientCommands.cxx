@@ -7,6 +7,7 @@
 #include "client/Client.hxx"
 #include "client/Response.hxx"
 #include "TagPrint.hxx"
+#include "CompactSongEncoder.hxx"
 #include "tag/ParseName.hxx"
 #include "tag/Type.hxx"
 #include "util/StringAPI.hxx"
@@ -40,6 +41,25 @@ handle_binary_limit(Client &client, Request args,
 	return CommandResult::OK;
 }
 
+CommandResult
+handle_songformat(Client &client, Request args, Response &r)
+{
+	const char *format = args.front();
+	if (StringIsEqual(format, "text")) {
+		client.compact_song_encoder.reset();
+	} else if (StringIsEqual(format, "compact")) {
+		/* always start over with empty tables, even if the
+		   "compact" format was already enabled */
+		client.compact_song_encoder =
+			std::make_unique<CompactSongEncoder>();
+	} else {
+		r.Error(ACK_ERROR_ARG, "Unknown song format");
+		return CommandResult::ERROR;
+	}
+
+	return CommandResult::OK;
+}
+
 CommandResult
 handle_password(Client &client, Request args, Response &r)
 {
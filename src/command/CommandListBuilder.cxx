@@ -4,8 +4,6 @@
 #include "CommandListBuilder.hxx"
 #include "client/Config.hxx"
 
-#include <string.h>
-
 void
 CommandListBuilder::Reset()
 {
@@ -14,13 +12,12 @@ CommandListBuilder::Reset()
 }
 
 bool
-CommandListBuilder::Add(const char *cmd)
+CommandListBuilder::Add(std::string_view cmd)
 {
-	size_t len = strlen(cmd) + 1;
-	size += len;
-	if (size > client_max_command_list_size)
+	if (list.size() + cmd.size() + 1 > client_max_command_list_size)
 		return false;
 
-	list.emplace_back(cmd);
+	list.append(cmd);
+	list.push_back('\0');
 	return true;
 }
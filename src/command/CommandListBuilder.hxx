@@ -5,8 +5,8 @@
 #define MPD_COMMAND_LIST_BUILDER_HXX
 
 #include <cassert>
-#include <list>
 #include <string>
+#include <string_view>
 
 class CommandListBuilder {
 	/**
@@ -30,14 +30,11 @@ class CommandListBuilder {
 	} mode = Mode::DISABLED;
 
 	/**
-	 * for when in list mode
+	 * for when in list mode: the commands, each one terminated
+	 * with a null byte.  They are stored in one contiguous buffer
+	 * to avoid allocating memory for each command.
 	 */
-	std::list<std::string> list;
-
-	/**
-	 * Memory consumed by the list.
-	 */
-	size_t size;
+	std::string list;
 
 public:
 	/**
@@ -69,18 +66,18 @@ public:
 		assert(mode == Mode::DISABLED);
 
 		mode = (Mode)ok;
-		size = 0;
 	}
 
 	/**
 	 * @return false if the list is full
 	 */
-	bool Add(const char *cmd);
+	bool Add(std::string_view cmd);
 
 	/**
-	 * Finishes the list and returns it.
+	 * Finishes the list and returns it.  It contains the commands
+	 * passed to Add(), each one terminated with a null byte.
 	 */
-	std::list<std::string> Commit() {
+	std::string Commit() {
 		assert(IsActive());
 
 		return std::move(list);
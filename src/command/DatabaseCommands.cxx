@@ -10,9 +10,15 @@
 #include "db/DatabasePrint.hxx"
 #include "db/Count.hxx"
 #include "db/Selection.hxx"
+#include "db/Interface.hxx"
+#include "db/DatabasePlugin.hxx"
 #include "protocol/RangeArg.hxx"
 #include "client/Client.hxx"
 #include "client/Response.hxx"
+#include "client/StreamBackgroundCommand.hxx"
+#include "client/BufferedBackgroundCommand.hxx"
+#include "client/ResponseCache.hxx"
+#include "Instance.hxx"
 #include "tag/Names.hxx"
 #include "tag/ParseName.hxx"
 #include "util/Exception.hxx"
@@ -23,6 +29,7 @@
 #include <fmt/format.h>
 
 #include <memory>
+#include <string_view>
 #include <vector>
 
 #include <limits.h> // for UINT_MAX
@@ -133,9 +140,201 @@ ParseDatabaseSelection(Request args, bool fold_case, SongFilter &filter)
 	return selection;
 }
 
+namespace {
+
+/**
+ * Prints a #DatabaseSelection in a #StreamBackgroundCommand.  The
+ * database is visited in a separate thread which gets suspended
+ * between two directories while the client is lagging behind, so
+ * huge responses occupy only a bounded amount of memory.
+ */
+class DatabasePrintCommand final : public StreamBackgroundCommand {
+	const Database &db;
+
+	const bool full;
+
+public:
+	SongFilter filter;
+
+	DatabaseSelection selection;
+
+	DatabasePrintCommand(Client &_client, const Response &r,
+			     const Database &_db,
+			     const char *uri, bool _full) noexcept
+		:StreamBackgroundCommand(_client, r.GetCommand()),
+		 db(_db), full(_full),
+		 selection(uri, true) {}
+
+protected:
+	/* virtual methods from class StreamBackgroundCommand */
+	void Run(Response &response) override {
+		selection.yield = [this]{ WaitWritable(); };
+		db_selection_print(response, db, selection, full, false);
+	}
+};
+
+} // anonymous namespace
+
+/**
+ * Returns the #Database if a database query can be deferred to a
+ * worker thread (see RunInBackground()), nullptr otherwise.
+ */
+static const Database *
+GetBackgroundDatabase(Client &client)
+{
+	if (client.IsProcessingCommandList())
+		return nullptr;
+
+	const Database &db = client.GetDatabaseOrThrow();
+	if (!db.GetPlugin().IsThreadSafe())
+		return nullptr;
+
+	return &db;
+}
+
+/**
+ * Returns the #Database if a database query can be deferred to a
+ * #DatabasePrintCommand, nullptr otherwise.
+ */
+static const Database *
+GetStreamDatabase(Client &client)
+{
+	if (!StreamBackgroundCommand::CanCreate(client))
+		/* too many threads; run it synchronously */
+		return nullptr;
+
+	const Database *db = GetBackgroundDatabase(client);
+	if (db != nullptr && !db->GetPlugin().SupportsYield())
+		return nullptr;
+
+	return db;
+}
+
+/**
+ * Look up the query in the #ResponseCache and send the cached
+ * response.  The cache key is built from the parsed arguments, so
+ * different spellings of the same query (e.g. "list album" and
+ * "list Album", or the old "list album ARTIST" syntax and the
+ * equivalent filter expression) share one entry.
+ *
+ * @param names canonical names (e.g. from #tag_item_names) which,
+ * together with the command and the filter, identify the query
+ * @param filter an optimized filter or nullptr
+ * @param key_r on a cache miss, this receives the cache key which
+ * shall be passed to RunCachedDatabaseQuery(); it is left empty if
+ * the cache is disabled
+ * @return true if the cached response has been sent
+ */
+static bool
+SendCachedResponse(Client &client, Response &r,
+		   std::span<const std::string_view> names,
+		   const SongFilter *filter,
+		   std::string &key_r) noexcept
+{
+	auto *cache = client.GetInstance().response_cache.get();
+	if (cache == nullptr)
+		return false;
+
+	std::vector<std::string_view> args{names.begin(), names.end()};
+
+	/* a filter expression always starts with a parenthesis,
+	   which is never part of a name */
+	std::string expression;
+	if (filter != nullptr && !filter->IsEmpty()) {
+		expression = filter->ToExpression();
+		args.emplace_back(expression);
+	}
+
+	std::string key = ResponseCache::MakeKey(r.GetCommand(), args);
+	if (const auto *value = cache->Get(key)) {
+		r.Write(value->data(), value->size());
+		return true;
+	}
+
+	key_r = std::move(key);
+	return false;
+}
+
+namespace {
+
+/**
+ * Collects a response in a string.
+ */
+class StringResponseSink final : public ResponseSink {
+public:
+	std::string value;
+
+	bool WriteResponse(std::span<const std::byte> src) noexcept override {
+		value.append((const char *)src.data(), src.size());
+		return true;
+	}
+};
+
+} // anonymous namespace
+
+/**
+ * Run a database query whose response depends only on the command
+ * line and on the database contents.  If possible, it runs in the
+ * #BackgroundThreadPool.  The response is added to the #ResponseCache
+ * (unless the key is empty).
+ *
+ * @param f a function which gets a #Response, a #Database and a
+ * #DatabaseYield and generates the response
+ */
+template<typename F>
+static CommandResult
+RunCachedDatabaseQuery(Client &client, Response &r, std::string &&key, F &&f)
+{
+	auto *cache = key.empty()
+		? nullptr
+		: client.GetInstance().response_cache.get();
+
+	if (const auto *db = GetBackgroundDatabase(client))
+		return RunInBackground(client, r,
+				       [db, f=std::forward<F>(f)](Response &r2,
+								  const DatabaseYield &yield){
+					       f(r2, *db, yield);
+				       },
+				       cache, std::move(key));
+
+	const Database &db = client.GetDatabaseOrThrow();
+
+	if (cache == nullptr) {
+		f(r, db, DatabaseYield{});
+		return CommandResult::OK;
+	}
+
+	const unsigned generation = cache->GetGeneration();
+
+	StringResponseSink sink;
+	Response r2(client, 0, sink);
+	f(r2, db, DatabaseYield{});
+
+	cache->Put(generation, std::move(key), sink.value);
+	r.Write(sink.value.data(), sink.value.size());
+	return CommandResult::OK;
+}
+
+static CommandResult
+StartDatabasePrint(Client &client, std::unique_ptr<DatabasePrintCommand> cmd)
+{
+	cmd->Start();
+	client.SetBackgroundCommand(std::move(cmd));
+	return CommandResult::BACKGROUND;
+}
+
 static CommandResult
 handle_match(Client &client, Request args, Response &r, bool fold_case)
 {
+	if (const auto *db = GetStreamDatabase(client)) {
+		auto cmd = std::make_unique<DatabasePrintCommand>(client, r,
+								  *db, "",
+								  true);
+		cmd->selection = ParseDatabaseSelection(args, fold_case,
+							cmd->filter);
+		return StartDatabasePrint(client, std::move(cmd));
+	}
+
 	SongFilter filter;
 	const auto selection = ParseDatabaseSelection(args, fold_case, filter);
 
@@ -248,8 +447,22 @@ handle_count_internal(Client &client, Request args, Response &r, bool fold_case)
 		filter.Optimize();
 	}
 
-	PrintSongCount(r, client.GetPartition(), "", &filter, group);
-	return CommandResult::OK;
+	std::vector<std::string_view> names;
+	if (group != TAG_NUM_OF_ITEM_TYPES)
+		names = {"group", tag_item_names[group]};
+
+	std::string cache_key;
+	if (SendCachedResponse(client, r, names, &filter, cache_key))
+		return CommandResult::OK;
+
+	return RunCachedDatabaseQuery(client, r, std::move(cache_key),
+				      [filter=std::move(filter), group](Response &r2,
+									 const Database &db,
+									 const DatabaseYield &yield){
+					      PrintSongCount(r2, db, "",
+							     &filter, group,
+							     yield);
+				      });
 }
 
 CommandResult
@@ -270,6 +483,12 @@ handle_listall(Client &client, Request args, Response &r)
 	/* default is root directory */
 	const auto uri = args.GetOptional(0, "");
 
+	if (const auto *db = GetStreamDatabase(client))
+		return StartDatabasePrint(client,
+					  std::make_unique<DatabasePrintCommand>(client, r,
+										 *db, uri,
+										 false));
+
 	db_selection_print(r, client.GetPartition(),
 			   DatabaseSelection(uri, true),
 			   false, false);
@@ -293,8 +512,19 @@ handle_list_file(Client &client, Request args, Response &r)
 		filter->Optimize();
 	}
 
-	PrintSongUris(r, client.GetPartition(), filter.get());
-	return CommandResult::OK;
+	static constexpr std::string_view names[]{"file"};
+
+	std::string cache_key;
+	if (SendCachedResponse(client, r, names, filter.get(), cache_key))
+		return CommandResult::OK;
+
+	return RunCachedDatabaseQuery(client, r, std::move(cache_key),
+				      [filter=std::move(filter)](Response &r2,
+								  const Database &db,
+								  const DatabaseYield &yield){
+					      PrintSongUris(r2, db, filter.get(),
+							    yield);
+				      });
 }
 
 CommandResult
@@ -368,10 +598,25 @@ handle_list(Client &client, Request args, Response &r)
 		filter->Optimize();
 	}
 
-	PrintUniqueTags(r, client.GetPartition(),
-			{&tag_types.front(), tag_types.size()},
-			filter.get());
-	return CommandResult::OK;
+	std::vector<std::string_view> names;
+	names.reserve(tag_types.size());
+	for (const auto i : tag_types)
+		names.emplace_back(tag_item_names[i]);
+
+	std::string cache_key;
+	if (SendCachedResponse(client, r, names, filter.get(), cache_key))
+		return CommandResult::OK;
+
+	return RunCachedDatabaseQuery(client, r, std::move(cache_key),
+				      [tag_types=std::move(tag_types),
+				       filter=std::move(filter)](Response &r2,
+								 const Database &db,
+								 const DatabaseYield &yield){
+					      PrintUniqueTags(r2, db,
+							      tag_types,
+							      filter.get(),
+							      yield);
+				      });
 }
 
 CommandResult
@@ -380,6 +625,12 @@ handle_listallinfo(Client &client, Request args, Response &r)
 	/* default is root directory */
 	const auto uri = args.GetOptional(0, "");
 
+	if (const auto *db = GetStreamDatabase(client))
+		return StartDatabasePrint(client,
+					  std::make_unique<DatabasePrintCommand>(client, r,
+										 *db, uri,
+										 true));
+
 	db_selection_print(r, client.GetPartition(),
 			   DatabaseSelection(uri, true),
 			   true, false);
@@ -7,6 +7,7 @@
 #include "protocol/Ack.hxx"
 #include "client/Client.hxx"
 #include "client/Response.hxx"
+#include "client/BufferedBackgroundCommand.hxx"
 #include "util/CharUtil.hxx"
 #include "util/OffsetPointer.hxx"
 #include "util/ScopeExit.hxx"
@@ -265,6 +266,14 @@ read_db_art(Client &client, Response &r, const char *uri, const uint64_t offset)
 }
 #endif
 
+/*
+ * Unlike "readpicture", this command is not deferred to the
+ * #BackgroundThreadPool: the #InputStream is kept open in
+ * Client::last_album_art between two chunk requests, and that cache
+ * (including its expiry timer) belongs to the client's #EventLoop.
+ * Only the first request opens the file; the others just seek and
+ * read at most Client::binary_limit bytes.
+ */
 CommandResult
 handle_album_art(Client &client, Request args, Response &r)
 {
@@ -353,8 +362,19 @@ handle_read_picture(Client &client, Request args, Response &r)
 	const char *const uri = args.front();
 	const size_t offset = args.ParseUnsigned(1);
 
-	PrintPictureHandler handler(r, offset);
-	TagScanAny(client, uri, handler);
-	handler.RethrowError();
+	auto location = TagLocateAny(client, uri);
+
+	auto f = [location=std::move(location), offset](Response &r2, const auto &){
+		PrintPictureHandler handler(r2, offset);
+		TagScanAny(location, handler);
+		handler.RethrowError();
+	};
+
+	if (!client.IsProcessingCommandList())
+		/* reading the file (possibly from a remote server)
+		   may take a while; don't block the main thread */
+		return RunInBackground(client, r, std::move(f));
+
+	f(r, nullptr);
 	return CommandResult::OK;
 }
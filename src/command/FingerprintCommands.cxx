@@ -37,7 +37,7 @@ class GetChromaprintCommand final
 public:
 	GetChromaprintCommand(Client &_client, std::string &&_uri,
 			      AllocatedPath &&_path)  noexcept
-		:ThreadBackgroundCommand(_client),
+		:ThreadBackgroundCommand(_client, "getfingerprint", true),
 		 uri(std::move(_uri)), path(std::move(_path))
 	{
 	}
@@ -41,7 +41,10 @@ enum class ConfigOption {
 	REPLAYGAIN_LIMIT,
 	VOLUME_NORMALIZATION,
 	SAMPLERATE_CONVERTER,
+	DSD2PCM,
+	DSD2PCM_THREADS,
 	AUDIO_BUFFER_SIZE,
+	AUDIO_BUFFER_CHUNK_SIZE,
 	BUFFER_BEFORE_PLAY,
 	HTTP_PROXY_HOST,
 	HTTP_PROXY_PORT,
@@ -52,6 +55,8 @@ enum class ConfigOption {
 	MAX_PLAYLIST_LENGTH,
 	MAX_COMMAND_LIST_SIZE,
 	MAX_OUTPUT_BUFFER_SIZE,
+	BACKGROUND_THREADS,
+	RESPONSE_CACHE_SIZE,
 	FS_CHARSET,
 	ID3V1_ENCODING,
 	METADATA_TO_USE,
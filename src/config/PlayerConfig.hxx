@@ -5,6 +5,7 @@
 
 #include "pcm/AudioFormat.hxx"
 #include "ReplayGainConfig.hxx"
+#include "MusicChunk.hxx"
 
 struct ConfigData;
 
@@ -14,6 +15,11 @@ static constexpr size_t MEGABYTE = 1024 * KILOBYTE;
 struct PlayerConfig {
 	static constexpr size_t DEFAULT_BUFFER_SIZE = 8 * MEGABYTE;
 
+	/**
+	 * The "audio_buffer_chunk_size" setting.
+	 */
+	std::size_t chunk_size = DEFAULT_CHUNK_SIZE;
+
 	unsigned buffer_chunks = DEFAULT_BUFFER_SIZE;
 
 	/**
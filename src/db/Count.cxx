@@ -4,7 +4,6 @@
 #include "Count.hxx"
 #include "Selection.hxx"
 #include "Interface.hxx"
-#include "Partition.hxx"
 #include "client/Response.hxx"
 #include "song/LightSong.hxx"
 #include "tag/Tag.hxx"
@@ -13,6 +12,7 @@
 
 #include <fmt/format.h>
 
+#include <cassert>
 #include <functional>
 #include <map>
 
@@ -78,13 +78,13 @@ GroupCountVisitor(TagCountMap &map, TagType group,
 }
 
 void
-PrintSongCount(Response &r, const Partition &partition, const char *name,
+PrintSongCount(Response &r, const Database &db, const char *name,
 	       const SongFilter *filter,
-	       TagType group)
+	       TagType group,
+	       const DatabaseYield &yield)
 {
-	const Database &db = partition.GetDatabaseOrThrow();
-
-	const DatabaseSelection selection(name, true, filter);
+	DatabaseSelection selection(name, true, filter);
+	selection.yield = yield;
 
 	if (group == TAG_NUM_OF_ITEM_TYPES) {
 		/* no grouping */
@@ -4,16 +4,22 @@
 #ifndef MPD_DB_COUNT_HXX
 #define MPD_DB_COUNT_HXX
 
+#include "Visitor.hxx"
+
 #include <cstdint>
 
 enum TagType : uint8_t;
-struct Partition;
+class Database;
 class Response;
 class SongFilter;
 
+/**
+ * @param yield see DatabaseSelection::yield
+ */
 void
-PrintSongCount(Response &r, const Partition &partition, const char *name,
+PrintSongCount(Response &r, const Database &db, const char *name,
 	       const SongFilter *filter,
-	       TagType group);
+	       TagType group,
+	       const DatabaseYield &yield={});
 
 #endif
@@ -23,6 +23,18 @@ struct DatabasePlugin {
 	 */
 	static constexpr unsigned FLAG_REQUIRE_STORAGE = 0x1;
 
+	/**
+	 * The methods Database::Visit(),
+	 * Database::CollectUniqueTags() and Database::GetStats() may
+	 * be called from any thread.
+	 */
+	static constexpr unsigned FLAG_THREAD_SAFE = 0x2;
+
+	/**
+	 * Database::Visit() implements DatabaseSelection::yield.
+	 */
+	static constexpr unsigned FLAG_YIELD = 0x4;
+
 	const char *name;
 
 	unsigned flags;
@@ -45,6 +57,14 @@ struct DatabasePlugin {
 	constexpr bool RequireStorage() const {
 		return flags & FLAG_REQUIRE_STORAGE;
 	}
+
+	constexpr bool IsThreadSafe() const {
+		return flags & FLAG_THREAD_SAFE;
+	}
+
+	constexpr bool SupportsYield() const {
+		return flags & FLAG_YIELD;
+	}
 };
 
 #endif
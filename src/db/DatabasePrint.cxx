@@ -97,7 +97,8 @@ PrintSongBrief(Response &r, bool base, const LightSong &song) noexcept
 static void
 PrintSongFull(Response &r, bool base, const LightSong &song) noexcept
 {
-	song_print_info(r, song, base);
+	if (!song_print_compact(r, song, base))
+		song_print_info(r, song, base);
 
 	if (song.tag.has_playlist)
 		/* this song file has an embedded CUE sheet */
@@ -131,8 +132,15 @@ db_selection_print(Response &r, Partition &partition,
 		   const DatabaseSelection &selection,
 		   bool full, bool base)
 {
-	const Database &db = partition.GetDatabaseOrThrow();
+	db_selection_print(r, partition.GetDatabaseOrThrow(),
+			   selection, full, base);
+}
 
+void
+db_selection_print(Response &r, const Database &db,
+		   const DatabaseSelection &selection,
+		   bool full, bool base)
+{
 	const auto d = selection.filter == nullptr
 		? [&,base](const auto &dir)
 			{ return full ?
@@ -162,12 +170,12 @@ PrintSongURIVisitor(Response &r, const LightSong &song) noexcept
 }
 
 void
-PrintSongUris(Response &r, Partition &partition,
-	      const SongFilter *filter)
+PrintSongUris(Response &r, const Database &db,
+	      const SongFilter *filter,
+	      const DatabaseYield &yield)
 {
-	const Database &db = partition.GetDatabaseOrThrow();
-
-	const DatabaseSelection selection("", true, filter);
+	DatabaseSelection selection("", true, filter);
+	selection.yield = yield;
 
 	const auto f = [&](const auto &song)
 		{ return PrintSongURIVisitor(r, song); };
@@ -191,13 +199,13 @@ PrintUniqueTags(Response &r, std::span<const TagType> tag_types,
 }
 
 void
-PrintUniqueTags(Response &r, Partition &partition,
+PrintUniqueTags(Response &r, const Database &db,
 		std::span<const TagType> tag_types,
-		const SongFilter *filter)
+		const SongFilter *filter,
+		const DatabaseYield &yield)
 {
-	const Database &db = partition.GetDatabaseOrThrow();
-
-	const DatabaseSelection selection("", true, filter);
+	DatabaseSelection selection("", true, filter);
+	selection.yield = yield;
 
 	PrintUniqueTags(r, tag_types,
 			db.CollectUniqueTags(selection, tag_types));
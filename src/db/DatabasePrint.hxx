@@ -4,10 +4,13 @@
 #ifndef MPD_DB_PRINT_H
 #define MPD_DB_PRINT_H
 
+#include "Visitor.hxx"
+
 #include <cstdint>
 #include <span>
 
 enum TagType : uint8_t;
+class Database;
 class SongFilter;
 struct DatabaseSelection;
 struct Partition;
@@ -23,12 +26,25 @@ db_selection_print(Response &r, Partition &partition,
 		   bool full, bool base);
 
 void
-PrintSongUris(Response &r, Partition &partition,
-	      const SongFilter *filter);
+db_selection_print(Response &r, const Database &db,
+		   const DatabaseSelection &selection,
+		   bool full, bool base);
 
+/**
+ * @param yield see DatabaseSelection::yield
+ */
+void
+PrintSongUris(Response &r, const Database &db,
+	      const SongFilter *filter,
+	      const DatabaseYield &yield={});
+
+/**
+ * @param yield see DatabaseSelection::yield
+ */
 void
-PrintUniqueTags(Response &r, Partition &partition,
+PrintUniqueTags(Response &r, const Database &db,
 		std::span<const TagType> tag_types,
-		const SongFilter *filter);
+		const SongFilter *filter,
+		const DatabaseYield &yield={});
 
 #endif
@@ -9,22 +9,42 @@
 #include "song/DetachedSong.hxx"
 
 #include <functional>
+#include <vector>
 
-static void
-AddToQueue(Partition &partition, const LightSong &song)
-{
-	const auto *storage = partition.instance.storage;
-	partition.playlist.AppendSong(partition.pc,
-				      DatabaseDetachSong(storage,
-							 song));
-}
+namespace {
+
+/**
+ * Thrown by the visitor to abort Database::Visit() when enough songs
+ * have been collected.
+ */
+class StopCollecting {};
+
+} // anonymous namespace
 
 void
 AddFromDatabase(Partition &partition, const DatabaseSelection &selection)
 {
 	const Database &db = partition.instance.GetDatabaseOrThrow();
+	const auto *storage = partition.instance.storage;
+	const auto &queue = partition.playlist.queue;
+
+	/* collect all songs first, so they can be appended to the
+	   queue in one batch; one more than fits is collected, which
+	   makes AppendSongs() report PlaylistResult::TOO_LARGE */
+	const std::size_t max_songs =
+		std::size_t(queue.max_length - queue.GetLength()) + 1;
+	std::vector<DetachedSong> songs;
+
+	const auto f = [&](const auto &song) {
+		songs.emplace_back(DatabaseDetachSong(storage, song));
+		if (songs.size() >= max_songs)
+			throw StopCollecting{};
+	};
+
+	try {
+		db.Visit(selection, f);
+	} catch (const StopCollecting &) {
+	}
 
-	const auto f = [&](const auto &song)
-		{ return AddToQueue(partition, song); };
-	db.Visit(selection, f);
+	partition.playlist.AppendSongs(partition.pc, std::move(songs));
 }
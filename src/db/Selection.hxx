@@ -4,6 +4,7 @@
 #ifndef MPD_DATABASE_SELECTION_HXX
 #define MPD_DATABASE_SELECTION_HXX
 
+#include "Visitor.hxx"
 #include "protocol/RangeArg.hxx"
 #include "tag/Type.hxx"
 
@@ -40,6 +41,15 @@ struct DatabaseSelection {
 	 */
 	bool recursive;
 
+	/**
+	 * If set, then the database plugin invokes this between two
+	 * directories of a recursive visit, while the database lock
+	 * is released.  This allows the caller to throttle a
+	 * long-running visit.  It is only implemented by plugins with
+	 * DatabasePlugin::FLAG_YIELD.
+	 */
+	DatabaseYield yield;
+
 	DatabaseSelection(const char *_uri, bool _recursive,
 			  const SongFilter *_filter=nullptr) noexcept;
 
@@ -6,6 +6,8 @@
 
 #include "Chrono.hxx"
 
+#include <cstddef>
+
 struct DatabaseStats {
 	/**
 	 * Number of songs.
@@ -27,10 +29,17 @@ struct DatabaseStats {
 	 */
 	unsigned album_count;
 
+	/**
+	 * Memory occupied by the database (in bytes).  Zero if
+	 * unknown.
+	 */
+	std::size_t memory_size;
+
 	void Clear() {
 		song_count = 0;
 		total_duration = total_duration.zero();
 		artist_count = album_count = 0;
+		memory_size = 0;
 	}
 };
 
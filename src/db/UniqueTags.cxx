@@ -7,7 +7,7 @@
 #include "tag/VisitFallback.hxx"
 #include "util/RecursiveMap.hxx"
 
-static void
+void
 CollectUniqueTags(RecursiveMap<std::string> &result,
 		  const Tag &tag,
 		  std::span<const TagType> tag_types) noexcept
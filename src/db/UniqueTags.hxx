@@ -9,10 +9,21 @@
 #include <string>
 
 enum TagType : uint8_t;
+struct Tag;
 class Database;
 struct DatabaseSelection;
 template<typename Key> class RecursiveMap;
 
+/**
+ * Add the values of the given #Tag to the #RecursiveMap, one level
+ * per tag type (with fallbacks, and an empty string if the #Tag has
+ * no such value).
+ */
+void
+CollectUniqueTags(RecursiveMap<std::string> &result,
+		  const Tag &tag,
+		  std::span<const TagType> tag_types) noexcept;
+
 /**
  * Walk the database and collect unique tag values.
  */
@@ -11,6 +11,91 @@
 #include <cassert>
 #include <utility>
 
+struct DatabaseVisitorHelper::Item {
+	DetachedSong song;
+
+	/**
+	 * The position of this song in the order it was visited;
+	 * used as tie breaker to make the sort stable.
+	 */
+	unsigned serial;
+};
+
+static const Tag &
+GetSortTag(const LightSong &song) noexcept
+{
+	return song.tag;
+}
+
+static const Tag &
+GetSortTag(const DetachedSong &song) noexcept
+{
+	return song.GetTag();
+}
+
+static auto
+GetSortLastModified(const LightSong &song) noexcept
+{
+	return song.mtime;
+}
+
+static auto
+GetSortLastModified(const DetachedSong &song) noexcept
+{
+	return song.GetLastModified();
+}
+
+/**
+ * Compare two songs according to DatabaseSelection::sort and
+ * DatabaseSelection::descending.  Both #LightSong and #DetachedSong
+ * are accepted, which allows comparing a visited song with the
+ * collected ones without copying it.
+ */
+class SongSortLess {
+	const TagType sort;
+	const bool descending;
+
+public:
+	constexpr SongSortLess(TagType _sort, bool _descending) noexcept
+		:sort(_sort), descending(_descending) {}
+
+	template<typename A, typename B>
+	[[gnu::pure]]
+	bool operator()(const A &a, const B &b) const noexcept {
+		if (sort == TagType(SORT_TAG_LAST_MODIFIED))
+			return descending
+				? GetSortLastModified(a) > GetSortLastModified(b)
+				: GetSortLastModified(a) < GetSortLastModified(b);
+
+		return CompareTags(sort, descending,
+				   GetSortTag(a), GetSortTag(b));
+	}
+};
+
+/**
+ * Like #SongSortLess, but equal songs are ordered by
+ * DatabaseVisitorHelper::Item::serial.
+ */
+class ItemSortLess {
+	const SongSortLess less;
+
+public:
+	explicit constexpr ItemSortLess(SongSortLess _less) noexcept
+		:less(_less) {}
+
+	template<typename T>
+	[[gnu::pure]]
+	bool operator()(const T &a, const T &b) const noexcept {
+		if (less(a.song, b.song))
+			return true;
+
+		if (less(b.song, a.song))
+			return false;
+
+		return a.serial < b.serial;
+	}
+};
+
 DatabaseVisitorHelper::DatabaseVisitorHelper(DatabaseSelection _selection,
 					     VisitSong &visit_song) noexcept
 	:selection(std::move(_selection))
@@ -22,12 +107,12 @@ DatabaseVisitorHelper::DatabaseVisitorHelper(DatabaseSelection _selection,
 	if (selection.sort != TAG_NUM_OF_ITEM_TYPES) {
 		/* the client has asked us to sort the result; this is
 		   pretty expensive, because instead of streaming the
-		   result to the client, we need to copy it all into
-		   this std::vector, and then sort it */
+		   result to the client, we need to copy it into this
+		   std::vector, and then sort it */
 
 		original_visit_song = std::move(visit_song);
 		visit_song = [this](const auto &song){
-			songs.emplace_back(song);
+			AddSorted(song);
 		};
 	} else if (selection.window != RangeArg::All()) {
 		original_visit_song = std::move(visit_song);
@@ -40,6 +125,42 @@ DatabaseVisitorHelper::DatabaseVisitorHelper(DatabaseSelection _selection,
 
 DatabaseVisitorHelper::~DatabaseVisitorHelper() noexcept = default;
 
+inline void
+DatabaseVisitorHelper::AddSorted(const LightSong &song)
+{
+	const unsigned serial = counter++;
+
+	if (selection.window.IsOpenEnded()) {
+		/* no limit: collect everything, sort later */
+		songs.push_back({DetachedSong{song}, serial});
+		return;
+	}
+
+	/* the window has an end: only the first "end" songs in sort
+	   order can be part of the result, so keep just those in a
+	   max-heap, with the "worst" one at the front */
+
+	const std::size_t limit = selection.window.end;
+	const SongSortLess less(selection.sort, selection.descending);
+	const ItemSortLess item_less(less);
+
+	if (songs.size() < limit) {
+		songs.push_back({DetachedSong{song}, serial});
+		std::push_heap(songs.begin(), songs.end(), item_less);
+		return;
+	}
+
+	/* on a tie, the new song loses because its serial is
+	   larger; this comparison doesn't copy the song, so most
+	   songs are discarded cheaply */
+	if (limit == 0 || !less(song, songs.front().song))
+		return;
+
+	std::pop_heap(songs.begin(), songs.end(), item_less);
+	songs.back() = {DetachedSong{song}, serial};
+	std::push_heap(songs.begin(), songs.end(), item_less);
+}
+
 void
 DatabaseVisitorHelper::Commit()
 {
@@ -50,24 +171,13 @@ DatabaseVisitorHelper::Commit()
 	assert(original_visit_song);
 
 	/* sort the song collection */
-	const auto sort = selection.sort;
-	const auto descending = selection.descending;
-
-	if (sort == TagType(SORT_TAG_LAST_MODIFIED))
-		std::stable_sort(songs.begin(), songs.end(),
-				 [descending](const DetachedSong &a, const DetachedSong &b){
-					 return descending
-						 ? a.GetLastModified() > b.GetLastModified()
-						 : a.GetLastModified() < b.GetLastModified();
-				 });
+	const ItemSortLess item_less(SongSortLess(selection.sort,
+						  selection.descending));
+
+	if (selection.window.IsOpenEnded())
+		std::sort(songs.begin(), songs.end(), item_less);
 	else
-		std::stable_sort(songs.begin(), songs.end(),
-				 [sort, descending](const DetachedSong &a,
-						    const DetachedSong &b){
-					 return CompareTags(sort, descending,
-							    a.GetTag(),
-							    b.GetTag());
-				 });
+		std::sort_heap(songs.begin(), songs.end(), item_less);
 
 	/* apply the "window" */
 	if (selection.window.end < songs.size())
@@ -81,6 +191,6 @@ DatabaseVisitorHelper::Commit()
 		    std::next(songs.begin(), selection.window.start));
 
 	/* now pass all songs to the original visitor callback */
-	for (const auto &song : songs)
-		original_visit_song((LightSong)song);
+	for (const auto &i : songs)
+		original_visit_song((LightSong)i.song);
 }
@@ -9,7 +9,7 @@
 
 #include <vector>
 
-class DetachedSong;
+struct LightSong;
 
 /**
  * This class helps implementing Database::Visit() by emulating
@@ -23,17 +23,22 @@ class DetachedSong;
 class DatabaseVisitorHelper {
 	const DatabaseSelection selection;
 
+	struct Item;
+
 	/**
 	 * If the plugin can't sort, then this container will collect
-	 * all songs, sort them and report them to the visitor in
-	 * Commit().
+	 * the songs, sort them and report them to the visitor in
+	 * Commit().  If the "window" has an end, then this is a heap
+	 * of only the first DatabaseSelection::window::end songs in
+	 * sort order.
 	 */
-	std::vector<DetachedSong> songs;
+	std::vector<Item> songs;
 
 	VisitSong original_visit_song;
 
 	/**
-	 * Used to emulate the "window".
+	 * Used to emulate the "window" and, while sorting, to number
+	 * the songs in their original order.
 	 */
 	unsigned counter = 0;
 
@@ -49,6 +54,9 @@ public:
 	~DatabaseVisitorHelper() noexcept;
 
 	void Commit();
+
+private:
+	void AddSorted(const LightSong &song);
 };
 
 #endif
@@ -18,4 +18,11 @@ typedef std::function<void(const PlaylistInfo &,
 
 typedef std::function<void(const Tag &)> VisitTag;
 
+/**
+ * Called by a database plugin at points where the visit can be
+ * suspended, without holding the database lock.  It may block, and
+ * it may throw to abort the visit.
+ */
+typedef std::function<void()> DatabaseYield;
+
 #endif
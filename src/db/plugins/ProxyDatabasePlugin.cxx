@@ -942,6 +942,7 @@ ProxyDatabase::GetStats(const DatabaseSelection &selection) const
 	stats.total_duration = std::chrono::seconds(mpd_stats_get_db_play_time(stats2));
 	stats.artist_count = mpd_stats_get_number_of_artists(stats2);
 	stats.album_count = mpd_stats_get_number_of_albums(stats2);
+	stats.memory_size = 0;
 	mpd_stats_free(stats2);
 	return stats;
 }
@@ -0,0 +1,540 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "Arena.hxx"
+#include "thread/Mutex.hxx"
+#include "util/HugeAllocator.hxx"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+/**
+ * The size of a regular chunk.
+ */
+static constexpr std::size_t CHUNK_SIZE = 1024 * 1024;
+
+/**
+ * Allocations up to this size (including the header) are carved
+ * from chunks and recycled through the free lists.  Larger ones
+ * get a #HugeAllocate() of their own, which is given back
+ * immediately by db_arena_free().
+ */
+static constexpr std::size_t MAX_SMALL_SIZE = 4096;
+
+/**
+ * There is one free list for each multiple of #DB_ARENA_ALIGNMENT
+ * up to #MAX_SMALL_SIZE.
+ */
+static constexpr std::size_t N_SIZE_CLASSES =
+	MAX_SMALL_SIZE / DB_ARENA_ALIGNMENT + 1;
+
+struct ArenaChunk {
+	ArenaChunk *next;
+
+	/**
+	 * The size of this chunk including this header.
+	 */
+	const std::size_t size;
+
+	/**
+	 * The offset of the first unused byte (relative to this
+	 * header).
+	 */
+	std::size_t fill = sizeof(ArenaChunk);
+
+	ArenaChunk(ArenaChunk *_next, std::size_t _size) noexcept
+		:next(_next), size(_size) {}
+
+	std::size_t GetAvailable() const noexcept {
+		return size - fill;
+	}
+
+	void *Allocate(std::size_t n) noexcept {
+		assert(n <= GetAvailable());
+
+		auto *p = reinterpret_cast<std::byte *>(this) + fill;
+		fill += n;
+		return p;
+	}
+};
+
+static_assert(sizeof(ArenaChunk) % DB_ARENA_ALIGNMENT == 0);
+
+/**
+ * A freed block on a free list.  This overlays the memory after the
+ * block's header.
+ */
+struct ArenaFreeBlock {
+	ArenaFreeBlock *next;
+};
+
+static_assert(sizeof(ArenaFreeBlock) <= DB_ARENA_ALIGNMENT);
+
+struct ArenaStringSlot;
+
+/**
+ * The number of independently locked parts of a generation's string
+ * table, see #ArenaStringShard.
+ */
+static constexpr std::size_t N_STRING_SHARDS = 16;
+
+/**
+ * A hash table of #ArenaStringSlot instances.  Each generation has
+ * #N_STRING_SHARDS of these, selected by the string's hash, so
+ * threads interning different strings (e.g. the update workers) do
+ * not have to wait for each other.
+ */
+struct ArenaStringShard {
+	Mutex mutex;
+
+	/**
+	 * The hash buckets; the size is a power of two which is
+	 * doubled when the number of strings exceeds it.
+	 *
+	 * Protected by #mutex.
+	 */
+	std::vector<ArenaStringSlot *> buckets;
+
+	/**
+	 * Protected by #mutex.
+	 */
+	std::size_t n_strings = 0;
+};
+
+/**
+ * A set of chunks belonging to one database tree, see
+ * db_arena_new_generation().
+ */
+struct ArenaGeneration {
+	/**
+	 * Protects all attributes except for #strings.
+	 */
+	Mutex mutex;
+
+	/**
+	 * All chunks of this generation.  New blocks are carved from
+	 * the first one.
+	 */
+	ArenaChunk *chunks = nullptr;
+
+	/**
+	 * The number of allocations which have not yet been freed.
+	 */
+	std::size_t n_allocations = 0;
+
+	/**
+	 * Has db_arena_retire_generation() been called?  Freed memory
+	 * is not reused then, and the generation gets deleted as soon
+	 * as #n_allocations drops to zero.
+	 */
+	bool retired = false;
+
+	std::array<ArenaFreeBlock *, N_SIZE_CLASSES> free_lists{};
+
+	std::array<ArenaStringShard, N_STRING_SHARDS> strings;
+};
+
+/**
+ * Each allocation is preceded by a pointer to its generation, which
+ * allows db_arena_free() to find it.
+ */
+static constexpr std::size_t HEADER_SIZE = sizeof(ArenaGeneration *);
+static_assert(HEADER_SIZE % DB_ARENA_ALIGNMENT == 0);
+
+/**
+ * The total size of all chunks and large allocations.
+ */
+static std::atomic_size_t arena_size;
+
+static constexpr std::size_t
+AlignSize(std::size_t size) noexcept
+{
+	return (size + DB_ARENA_ALIGNMENT - 1) / DB_ARENA_ALIGNMENT
+		* DB_ARENA_ALIGNMENT;
+}
+
+/**
+ * Returns the size of the block (including the header) which is
+ * used for an allocation of the given size.
+ */
+static constexpr std::size_t
+BlockSize(std::size_t size) noexcept
+{
+	return HEADER_SIZE + AlignSize(std::max(size, std::size_t(1)));
+}
+
+static ArenaGeneration &
+GetGeneration(const void *p) noexcept
+{
+	auto *block = static_cast<const std::byte *>(p) - HEADER_SIZE;
+	return **reinterpret_cast<ArenaGeneration *const*>(block);
+}
+
+static std::byte *
+NewHuge(std::size_t size)
+{
+	const auto allocation = HugeAllocate(size);
+	HugeSetName(allocation.data(), allocation.size(), "DatabaseArena");
+	arena_size.fetch_add(size, std::memory_order_relaxed);
+	return allocation.data();
+}
+
+static void
+FreeHuge(void *p, std::size_t size) noexcept
+{
+	assert(arena_size.load(std::memory_order_relaxed) >= size);
+
+	arena_size.fetch_sub(size, std::memory_order_relaxed);
+	HugeFree(p, size);
+}
+
+static void
+FreeChunks(ArenaChunk *chunk) noexcept
+{
+	while (chunk != nullptr) {
+		ArenaChunk *next = chunk->next;
+		FreeHuge(chunk, chunk->size);
+		chunk = next;
+	}
+}
+
+static void
+DeleteGeneration(ArenaGeneration &generation) noexcept
+{
+	assert(generation.retired);
+	assert(generation.n_allocations == 0);
+
+	FreeChunks(generation.chunks);
+	delete &generation;
+}
+
+/**
+ * Put the block at the given address on the free list for its size
+ * class.
+ */
+static void
+PushFree(ArenaGeneration &generation, std::byte *block,
+	 std::size_t n) noexcept
+{
+	assert(n <= MAX_SMALL_SIZE);
+	assert(n % DB_ARENA_ALIGNMENT == 0);
+
+	*reinterpret_cast<ArenaGeneration **>(block) = &generation;
+
+	auto &head = generation.free_lists[n / DB_ARENA_ALIGNMENT];
+	head = ::new(block + HEADER_SIZE) ArenaFreeBlock{head};
+}
+
+/**
+ * Carve a block of the given size (including the header) from the
+ * first chunk, allocating a new one if necessary.
+ */
+static std::byte *
+CarveBlock(ArenaGeneration &generation, std::size_t n)
+{
+	ArenaChunk *chunk = generation.chunks;
+	if (chunk == nullptr || chunk->GetAvailable() < n) {
+		auto *memory = NewHuge(CHUNK_SIZE);
+		generation.chunks = ::new(memory) ArenaChunk(chunk, CHUNK_SIZE);
+
+		/* the rest of the old chunk is not lost, it can
+		   still be used by a smaller allocation */
+		if (chunk != nullptr &&
+		    chunk->GetAvailable() >= HEADER_SIZE + DB_ARENA_ALIGNMENT) {
+			const std::size_t rest = chunk->GetAvailable();
+			PushFree(generation,
+				 static_cast<std::byte *>(chunk->Allocate(rest)),
+				 rest);
+		}
+
+		chunk = generation.chunks;
+	}
+
+	return static_cast<std::byte *>(chunk->Allocate(n));
+}
+
+/**
+ * Allocate a block.  Caller must lock the generation's mutex.
+ */
+static void *
+Allocate(ArenaGeneration &generation, std::size_t size)
+{
+	assert(!generation.retired);
+
+	const std::size_t n = BlockSize(size);
+
+	std::byte *block;
+	if (n > MAX_SMALL_SIZE) {
+		block = NewHuge(n);
+	} else if (auto &head = generation.free_lists[n / DB_ARENA_ALIGNMENT];
+		   head != nullptr) {
+		block = reinterpret_cast<std::byte *>(head) - HEADER_SIZE;
+		head = head->next;
+	} else {
+		block = CarveBlock(generation, n);
+	}
+
+	*reinterpret_cast<ArenaGeneration **>(block) = &generation;
+	++generation.n_allocations;
+	return block + HEADER_SIZE;
+}
+
+/**
+ * Free a block.  Caller must lock the generation's mutex.
+ *
+ * @return true if the generation is now empty and retired; the
+ * caller shall then call DeleteGeneration() after unlocking
+ */
+static bool
+Free(ArenaGeneration &generation, void *p, std::size_t size) noexcept
+{
+	assert(&GetGeneration(p) == &generation);
+	assert(generation.n_allocations > 0);
+
+	const std::size_t n = BlockSize(size);
+	auto *block = static_cast<std::byte *>(p) - HEADER_SIZE;
+
+	--generation.n_allocations;
+
+	if (n > MAX_SMALL_SIZE)
+		FreeHuge(block, n);
+	else if (!generation.retired)
+		PushFree(generation, block, n);
+	else
+		/* a retired generation: its memory is not reused,
+		   but given back as soon as it is empty */
+		return generation.n_allocations == 0;
+
+	return false;
+}
+
+ArenaGeneration &
+db_arena_new_generation()
+{
+	return *new ArenaGeneration();
+}
+
+void
+db_arena_retire_generation(ArenaGeneration &generation) noexcept
+{
+	bool empty;
+
+	{
+		const std::scoped_lock lock{generation.mutex};
+		assert(!generation.retired);
+
+		generation.retired = true;
+		generation.free_lists = {};
+		empty = generation.n_allocations == 0;
+	}
+
+	if (empty)
+		DeleteGeneration(generation);
+}
+
+void *
+db_arena_allocate(ArenaGeneration &generation, std::size_t size)
+{
+	const std::scoped_lock lock{generation.mutex};
+	return Allocate(generation, size);
+}
+
+void
+db_arena_free(void *p, std::size_t size) noexcept
+{
+	assert(p != nullptr);
+
+	auto &generation = GetGeneration(p);
+
+	bool empty;
+
+	{
+		const std::scoped_lock lock{generation.mutex};
+		empty = Free(generation, p, size);
+	}
+
+	if (empty)
+		DeleteGeneration(generation);
+}
+
+std::size_t
+db_arena_size() noexcept
+{
+	return arena_size.load(std::memory_order_relaxed);
+}
+
+/**
+ * An interned string, see #ArenaString.
+ */
+struct ArenaStringSlot {
+	ArenaStringSlot *next;
+
+	uint32_t ref = 1;
+
+	const uint32_t length;
+
+	char value[sizeof(void *)];
+
+	ArenaStringSlot(ArenaStringSlot *_next,
+			std::string_view src) noexcept
+		:next(_next), length(src.size()) {
+		*std::copy(src.begin(), src.end(), value) = 0;
+	}
+
+	static constexpr std::size_t GetAllocationSize(std::size_t length) noexcept {
+		return std::max(offsetof(ArenaStringSlot, value) + length + 1,
+				sizeof(ArenaStringSlot));
+	}
+
+	operator std::string_view() const noexcept {
+		return {value, length};
+	}
+
+	static ArenaStringSlot &FromValue(const char *value) noexcept {
+		return *reinterpret_cast<ArenaStringSlot *>(const_cast<char *>(value) - offsetof(ArenaStringSlot, value));
+	}
+};
+
+/**
+ * The initial number of buckets of an #ArenaStringShard.
+ */
+static constexpr std::size_t MIN_STRING_BUCKETS = 64;
+
+[[gnu::pure]]
+static std::size_t
+HashString(std::string_view s) noexcept
+{
+	std::size_t hash = 5381;
+
+	for (auto ch : s)
+		hash = (hash << 5) + hash + ch;
+
+	return hash;
+}
+
+static ArenaStringShard &
+GetStringShard(ArenaGeneration &generation, std::size_t hash) noexcept
+{
+	return generation.strings[hash % N_STRING_SHARDS];
+}
+
+/**
+ * Caller must lock the shard's mutex.
+ */
+static ArenaStringSlot *&
+GetStringBucket(ArenaStringShard &shard, std::size_t hash) noexcept
+{
+	assert(!shard.buckets.empty());
+
+	/* the lower bits have already been used to select the
+	   shard */
+	return shard.buckets[(hash / N_STRING_SHARDS) & (shard.buckets.size() - 1)];
+}
+
+/**
+ * Double the number of buckets if the shard has become too crowded.
+ * Caller must lock the shard's mutex.
+ *
+ * Throws std::bad_alloc on error.
+ */
+static void
+GrowStringShard(ArenaStringShard &shard)
+{
+	if (shard.n_strings < shard.buckets.size())
+		return;
+
+	const std::size_t n_buckets = shard.buckets.empty()
+		? MIN_STRING_BUCKETS
+		: shard.buckets.size() * 2;
+
+	std::vector<ArenaStringSlot *> old_buckets(n_buckets, nullptr);
+	old_buckets.swap(shard.buckets);
+
+	for (ArenaStringSlot *slot : old_buckets) {
+		while (slot != nullptr) {
+			ArenaStringSlot *next = slot->next;
+			auto &head = GetStringBucket(shard, HashString(*slot));
+			slot->next = head;
+			head = slot;
+			slot = next;
+		}
+	}
+}
+
+void
+ArenaString::Assign(ArenaGeneration &generation, std::string_view src)
+{
+	assert(value_length == 0);
+
+	if (src.empty())
+		return;
+
+	const std::size_t hash = HashString(src);
+	auto &shard = GetStringShard(generation, hash);
+
+	const std::scoped_lock lock{shard.mutex};
+	GrowStringShard(shard);
+
+	auto &head = GetStringBucket(shard, hash);
+	ArenaStringSlot *slot = head;
+	while (slot != nullptr && std::string_view{*slot} != src)
+		slot = slot->next;
+
+	if (slot != nullptr) {
+		++slot->ref;
+	} else {
+		void *p = db_arena_allocate(generation,
+					    ArenaStringSlot::GetAllocationSize(src.size()));
+		slot = ::new(p) ArenaStringSlot(head, src);
+		head = slot;
+		++shard.n_strings;
+	}
+
+	value = slot->value;
+	value_length = src.size();
+}
+
+void
+ArenaString::Clear() noexcept
+{
+	if (value_length == 0)
+		return;
+
+	auto &slot = ArenaStringSlot::FromValue(value);
+	auto &generation = GetGeneration(&slot);
+	auto &shard = GetStringShard(generation, HashString(*this));
+
+	bool empty = false;
+
+	{
+		const std::scoped_lock lock{shard.mutex};
+		assert(slot.ref > 0);
+
+		if (--slot.ref == 0) {
+			auto *p = &GetStringBucket(shard, HashString(*this));
+			while (*p != &slot) {
+				assert(*p != nullptr);
+				p = &(*p)->next;
+			}
+
+			*p = slot.next;
+			--shard.n_strings;
+
+			const std::scoped_lock generation_lock{generation.mutex};
+			empty = Free(generation, &slot,
+				     ArenaStringSlot::GetAllocationSize(value_length));
+		}
+	}
+
+	if (empty)
+		DeleteGeneration(generation);
+
+	value = "";
+	value_length = 0;
+}
@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_DB_SIMPLE_ARENA_HXX
+#define MPD_DB_SIMPLE_ARENA_HXX
+
+#include <cstddef>
+#include <string_view>
+#include <utility>
+
+/**
+ * The alignment of all allocations returned by db_arena_allocate().
+ */
+static constexpr std::size_t DB_ARENA_ALIGNMENT = alignof(void *);
+
+/**
+ * A set of memory chunks which belongs to one database tree (i.e.
+ * one root #Directory), see db_arena_new_generation().  This is an
+ * opaque type.
+ */
+struct ArenaGeneration;
+
+/**
+ * Create a new generation for a new database tree.  Allocations in
+ * it do not share chunks with other generations, so the memory of a
+ * database can be given back as a whole once it has been freed, even
+ * while other databases (e.g. a mounted one or its replacement) are
+ * still being allocated.
+ *
+ * This function is thread-safe.
+ *
+ * Throws std::bad_alloc on error.
+ */
+ArenaGeneration &
+db_arena_new_generation();
+
+/**
+ * Declare that no more allocations will be made in this generation.
+ * Its memory is given back as soon as the last allocation inside it
+ * has been freed (or right now if there is none).
+ *
+ * This function is thread-safe.
+ */
+void
+db_arena_retire_generation(ArenaGeneration &generation) noexcept;
+
+/**
+ * Allocate memory for an object of the "simple" database (#Song,
+ * #Directory and their strings).  Small allocations are carved from
+ * large chunks instead of being allocated individually, and freed
+ * memory is kept in a free list per size class to be reused by the
+ * next allocation of the same size.
+ *
+ * This function is thread-safe; each generation has a lock of its
+ * own.
+ *
+ * Throws std::bad_alloc on error.
+ */
+[[gnu::malloc]] [[gnu::returns_nonnull]]
+void *
+db_arena_allocate(ArenaGeneration &generation, std::size_t size);
+
+/**
+ * Free memory allocated by db_arena_allocate().
+ *
+ * This function is thread-safe.
+ *
+ * @param size the size which was passed to db_arena_allocate()
+ */
+void
+db_arena_free(void *p, std::size_t size) noexcept;
+
+/**
+ * Returns the number of bytes currently occupied by all arena
+ * generations (including free lists and unused space at the end of
+ * their chunks).
+ */
+std::size_t
+db_arena_size() noexcept;
+
+/**
+ * An immutable string allocated with db_arena_allocate().  It is
+ * null-terminated, so it can be passed to C APIs.  Equal strings
+ * within one #ArenaGeneration are interned, i.e. they share one
+ * reference-counted allocation (many song file names such as
+ * "track0001" or "01.flac" occur in lots of directories).  Set()
+ * replaces the reference.
+ */
+class ArenaString {
+	const char *value = "";
+	std::size_t value_length = 0;
+
+public:
+	ArenaString() noexcept = default;
+
+	/**
+	 * Throws std::bad_alloc on error.
+	 */
+	ArenaString(ArenaGeneration &generation, std::string_view src) {
+		Assign(generation, src);
+	}
+
+	~ArenaString() noexcept {
+		Clear();
+	}
+
+	ArenaString(const ArenaString &) = delete;
+	ArenaString &operator=(const ArenaString &) = delete;
+
+	/**
+	 * Throws std::bad_alloc on error.
+	 */
+	void Set(ArenaGeneration &generation, std::string_view src) {
+		ArenaString tmp{generation, src};
+		std::swap(value, tmp.value);
+		std::swap(value_length, tmp.value_length);
+	}
+
+	bool empty() const noexcept {
+		return value_length == 0;
+	}
+
+	std::size_t size() const noexcept {
+		return value_length;
+	}
+
+	const char *c_str() const noexcept {
+		return value;
+	}
+
+	operator std::string_view() const noexcept {
+		return {value, value_length};
+	}
+
+	bool operator==(std::string_view other) const noexcept {
+		return std::string_view{*this} == other;
+	}
+
+private:
+	void Assign(ArenaGeneration &generation, std::string_view src);
+	void Clear() noexcept;
+};
+
+#endif
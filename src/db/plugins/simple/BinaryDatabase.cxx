@@ -0,0 +1,586 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * The binary database format is a flat image which can be mapped
+ * into memory and used without parsing.  All integers are stored in
+ * host byte order (which is verified by the header), all records are
+ * fixed-size and aligned to 8 bytes.  The file layout is:
+ *
+ * - #BinaryHeader
+ * - the tag type names (uint32_t string references, padded to 8 bytes)
+ * - #BinaryDirectory records in pre-order; the root comes first, and
+ *   a parent always precedes its children
+ * - #BinarySong records; the songs of each directory are contiguous
+ * - #BinaryTagItem records; the items of each song are contiguous
+ * - #BinaryPlaylist records
+ * - the string table: null-terminated strings, referenced by their
+ *   byte offset; offset 0 is the empty string
+ */
+
+#include "BinaryDatabase.hxx"
+#include "Directory.hxx"
+#include "Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "io/BufferedOutputStream.hxx"
+#include "lib/fmt/RuntimeError.hxx"
+#include "tag/Builder.hxx"
+#include "tag/Names.hxx"
+#include "tag/ParseName.hxx"
+#include "tag/Settings.hxx"
+#include "time/ChronoUtil.hxx"
+#include "fs/Charset.hxx"
+#include "util/StringAPI.hxx"
+#include "Version.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+static constexpr std::array<char, 8> BINARY_DB_MAGIC{
+	'\x89', 'M', 'P', 'D', 'd', 'b', '\r', '\n',
+};
+
+static constexpr uint32_t BINARY_DB_VERSION = 1;
+
+/**
+ * A well-known value which allows detecting files written on a host
+ * with a different byte order.
+ */
+static constexpr uint32_t BINARY_DB_BYTE_ORDER = 0x01020304;
+
+static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+/**
+ * Marker for an unknown/unavailable modification time.
+ */
+static constexpr int64_t NO_MTIME = INT64_MIN;
+
+static constexpr uint8_t SONG_FLAG_IN_PLAYLIST = 0x1;
+static constexpr uint8_t SONG_FLAG_HAS_PLAYLIST = 0x2;
+
+struct BinaryHeader {
+	std::array<char, 8> magic;
+	uint32_t version;
+	uint32_t byte_order;
+
+	/**
+	 * String references.
+	 */
+	uint32_t mpd_version, fs_charset;
+
+	uint32_t n_tag_types;
+	uint32_t n_directories;
+	uint32_t n_songs;
+	uint32_t n_tag_items;
+	uint32_t n_playlists;
+	uint32_t reserved;
+
+	uint64_t string_size;
+};
+
+struct BinaryDirectory {
+	int64_t mtime;
+	uint32_t name;
+	uint32_t parent;
+	uint32_t device;
+	uint32_t first_song, n_songs;
+	uint32_t first_playlist, n_playlists;
+	uint32_t reserved;
+};
+
+struct BinarySong {
+	int64_t mtime;
+	uint32_t filename, target;
+	uint32_t start_ms, end_ms;
+	int32_t duration_ms;
+	uint32_t sample_rate;
+	uint32_t first_tag_item;
+	uint16_t n_tag_items;
+	uint8_t sample_format, channels;
+	uint8_t flags;
+	uint8_t reserved[7];
+};
+
+struct BinaryTagItem {
+	/**
+	 * An index into the file's tag type list.
+	 */
+	uint32_t type;
+
+	uint32_t value;
+};
+
+struct BinaryPlaylist {
+	int64_t mtime;
+	uint32_t name;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(BinaryHeader) == 56);
+static_assert(sizeof(BinaryDirectory) == 40);
+static_assert(sizeof(BinarySong) == 48);
+static_assert(sizeof(BinaryTagItem) == 8);
+static_assert(sizeof(BinaryPlaylist) == 16);
+static_assert(std::is_trivially_copyable_v<BinarySong>);
+
+static constexpr std::size_t
+PadSize(std::size_t size) noexcept
+{
+	return (size + 7) & ~std::size_t(7);
+}
+
+static constexpr int64_t
+ExportTime(std::chrono::system_clock::time_point t) noexcept
+{
+	return IsNegative(t)
+		? NO_MTIME
+		: int64_t(std::chrono::system_clock::to_time_t(t));
+}
+
+static constexpr std::chrono::system_clock::time_point
+ImportTime(int64_t t) noexcept
+{
+	return t == NO_MTIME
+		? std::chrono::system_clock::time_point::min()
+		: std::chrono::system_clock::from_time_t(t);
+}
+
+bool
+db_is_binary(std::span<const std::byte> data) noexcept
+{
+	return data.size() >= BINARY_DB_MAGIC.size() &&
+		memcmp(data.data(), BINARY_DB_MAGIC.data(),
+		       BINARY_DB_MAGIC.size()) == 0;
+}
+
+namespace {
+
+/**
+ * Collects all strings, eliminating duplicates.  The keys point into
+ * the #Directory tree, which must not be modified while this object
+ * exists.
+ */
+class StringTableBuilder {
+	std::string data{'\0'};
+
+	std::unordered_map<std::string_view, uint32_t> map;
+
+public:
+	uint32_t Add(std::string_view s) {
+		if (s.empty())
+			return 0;
+
+		auto [i, inserted] = map.try_emplace(s, data.size());
+		if (inserted) {
+			if (data.size() + s.size() + 1 > UINT32_MAX)
+				throw std::runtime_error("Database too large");
+
+			data.append(s);
+			data.push_back('\0');
+		}
+
+		return i->second;
+	}
+
+	std::string_view GetData() const noexcept {
+		return data;
+	}
+};
+
+class BinaryDatabaseWriter {
+	StringTableBuilder strings;
+
+	std::vector<uint32_t> tag_types;
+
+	/**
+	 * Maps #TagType to an index in #tag_types.
+	 */
+	std::array<uint32_t, TAG_NUM_OF_ITEM_TYPES> tag_type_index;
+
+	std::vector<BinaryDirectory> directories;
+	std::vector<BinarySong> songs;
+	std::vector<BinaryTagItem> tag_items;
+	std::vector<BinaryPlaylist> playlists;
+
+	uint32_t mpd_version, fs_charset;
+
+public:
+	BinaryDatabaseWriter()
+		:mpd_version(strings.Add(VERSION)),
+		 fs_charset(strings.Add(GetFSCharset()))
+	{
+		for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i) {
+			tag_type_index[i] = tag_types.size();
+			if (IsTagEnabled(i))
+				tag_types.push_back(strings.Add(tag_item_names[i]));
+		}
+	}
+
+	void AddDirectory(const Directory &directory, uint32_t parent);
+
+	void Write(BufferedOutputStream &os) const;
+
+private:
+	void AddSong(const Song &song);
+
+	template<typename T>
+	static void WriteArray(BufferedOutputStream &os,
+			       const std::vector<T> &v) {
+		os.Write(v.data(), v.size() * sizeof(T));
+	}
+};
+
+void
+BinaryDatabaseWriter::AddDirectory(const Directory &directory,
+				   uint32_t parent)
+{
+	const uint32_t index = directories.size();
+
+	auto &d = directories.emplace_back();
+	d.name = directory.IsRoot() ? 0 : strings.Add(directory.GetName());
+	d.parent = parent;
+	d.mtime = ExportTime(directory.mtime);
+	d.device = directory.IsReallyAFile() ? directory.device : 0;
+	d.first_song = songs.size();
+	d.first_playlist = playlists.size();
+
+	for (const auto &song : directory.songs)
+		AddSong(song);
+
+	for (const PlaylistInfo &pi : directory.playlists) {
+		auto &p = playlists.emplace_back();
+		p.mtime = ExportTime(pi.mtime);
+		p.name = strings.Add(pi.name);
+	}
+
+	d.n_songs = songs.size() - d.first_song;
+	d.n_playlists = playlists.size() - d.first_playlist;
+
+	for (const auto &child : directory.children)
+		if (!child.IsMount())
+			AddDirectory(child, index);
+}
+
+void
+BinaryDatabaseWriter::AddSong(const Song &song)
+{
+	auto &s = songs.emplace_back();
+	s.filename = strings.Add(song.filename);
+	s.target = strings.Add(song.target);
+	s.mtime = ExportTime(song.mtime);
+	s.start_ms = song.start_time.ToMS();
+	s.end_ms = song.end_time.ToMS();
+	s.duration_ms = song.tag.duration.count();
+	s.sample_rate = song.audio_format.sample_rate;
+	s.sample_format = uint8_t(song.audio_format.format);
+	s.channels = song.audio_format.channels;
+	s.flags = (song.in_playlist ? SONG_FLAG_IN_PLAYLIST : 0) |
+		(song.tag.has_playlist ? SONG_FLAG_HAS_PLAYLIST : 0);
+	s.first_tag_item = tag_items.size();
+
+	for (const auto &i : song.tag) {
+		if (!IsTagEnabled(i.type))
+			continue;
+
+		auto &item = tag_items.emplace_back();
+		item.type = tag_type_index[i.type];
+		item.value = strings.Add(i.value);
+	}
+
+	s.n_tag_items = tag_items.size() - s.first_tag_item;
+}
+
+void
+BinaryDatabaseWriter::Write(BufferedOutputStream &os) const
+{
+	const auto string_data = strings.GetData();
+
+	BinaryHeader header{};
+	header.magic = BINARY_DB_MAGIC;
+	header.version = BINARY_DB_VERSION;
+	header.byte_order = BINARY_DB_BYTE_ORDER;
+	header.n_tag_types = tag_types.size();
+	header.n_directories = directories.size();
+	header.n_songs = songs.size();
+	header.n_tag_items = tag_items.size();
+	header.n_playlists = playlists.size();
+	header.mpd_version = mpd_version;
+	header.fs_charset = fs_charset;
+	header.string_size = string_data.size();
+
+	os.WriteT(header);
+
+	WriteArray(os, tag_types);
+	if (tag_types.size() % 2)
+		os.WriteT(uint32_t{});
+
+	WriteArray(os, directories);
+	WriteArray(os, songs);
+	WriteArray(os, tag_items);
+	WriteArray(os, playlists);
+
+	os.Write(string_data.data(), string_data.size());
+}
+
+/**
+ * A read-only view of a mapped binary database file.
+ */
+class BinaryDatabaseReader {
+	const BinaryHeader &header;
+
+	std::span<const uint32_t> tag_type_names;
+	std::span<const BinaryDirectory> directories;
+	std::span<const BinarySong> songs;
+	std::span<const BinaryTagItem> tag_items;
+	std::span<const BinaryPlaylist> playlists;
+	std::string_view strings;
+
+	/**
+	 * Maps the file's tag type index to #TagType.
+	 */
+	std::vector<TagType> tag_types;
+
+public:
+	explicit BinaryDatabaseReader(std::span<const std::byte> data);
+
+	void Load(Directory &root) const;
+
+private:
+	template<typename T>
+	static std::span<const T> Section(std::span<const std::byte> data,
+					  std::size_t &position,
+					  std::size_t n) {
+		const std::size_t size = n * sizeof(T);
+		if (position + size > data.size())
+			throw std::runtime_error("Database corrupted");
+
+		std::span<const T> result{
+			(const T *)(const void *)(data.data() + position),
+			n,
+		};
+
+		position += PadSize(size);
+		return result;
+	}
+
+	[[gnu::pure]]
+	const char *GetString(uint32_t offset) const {
+		if (offset >= strings.size())
+			throw std::runtime_error("Database corrupted");
+
+		return strings.data() + offset;
+	}
+
+	void LoadDirectory(Directory &directory,
+			   const BinaryDirectory &d) const;
+
+	SongPtr LoadSong(Directory &parent, const BinarySong &s) const;
+};
+
+static const BinaryHeader &
+GetHeader(std::span<const std::byte> data)
+{
+	if (data.size() < sizeof(BinaryHeader) || !db_is_binary(data))
+		throw std::runtime_error("Database corrupted");
+
+	if (reinterpret_cast<std::uintptr_t>(data.data()) % alignof(BinarySong) != 0)
+		throw std::runtime_error("Misaligned database buffer");
+
+	return *(const BinaryHeader *)(const void *)data.data();
+}
+
+BinaryDatabaseReader::BinaryDatabaseReader(std::span<const std::byte> data)
+	:header(GetHeader(data))
+{
+	if (header.version != BINARY_DB_VERSION ||
+	    header.byte_order != BINARY_DB_BYTE_ORDER)
+		throw std::runtime_error("Database format mismatch, "
+					 "discarding database file");
+
+	std::size_t position = sizeof(header);
+	tag_type_names = Section<uint32_t>(data, position, header.n_tag_types);
+	directories = Section<BinaryDirectory>(data, position,
+					       header.n_directories);
+	songs = Section<BinarySong>(data, position, header.n_songs);
+	tag_items = Section<BinaryTagItem>(data, position,
+					   header.n_tag_items);
+	playlists = Section<BinaryPlaylist>(data, position,
+					    header.n_playlists);
+
+	if (header.string_size == 0 ||
+	    header.string_size != data.size() - position)
+		throw std::runtime_error("Database corrupted");
+
+	strings = {(const char *)(const void *)(data.data() + position),
+		   header.string_size};
+
+	/* this guarantees that all strings are null-terminated */
+	if (strings.back() != '\0')
+		throw std::runtime_error("Database corrupted");
+
+	const char *fs_charset = GetString(header.fs_charset);
+	const char *const old_charset = GetFSCharset();
+	if (*old_charset != 0 && !StringIsEqual(fs_charset, old_charset))
+		throw FmtRuntimeError("Existing database has charset "
+				      "\"{}\" instead of \"{}\"; "
+				      "discarding database file",
+				      fs_charset, old_charset);
+
+	bool tags[TAG_NUM_OF_ITEM_TYPES]{};
+
+	tag_types.reserve(tag_type_names.size());
+	for (const uint32_t i : tag_type_names) {
+		const char *name = GetString(i);
+		const TagType tag = tag_name_parse(name);
+		if (tag == TAG_NUM_OF_ITEM_TYPES)
+			throw FmtRuntimeError("Unrecognized tag '{}', "
+					      "discarding database file",
+					      name);
+
+		tags[tag] = true;
+		tag_types.push_back(tag);
+	}
+
+	for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i)
+		if (IsTagEnabled(i) && !tags[i])
+			throw std::runtime_error("Tag list mismatch, "
+						 "discarding database file");
+
+	if (directories.empty() || directories.front().parent != NO_PARENT)
+		throw std::runtime_error("Database corrupted");
+}
+
+inline SongPtr
+BinaryDatabaseReader::LoadSong(Directory &parent, const BinarySong &s) const
+{
+	const char *filename = GetString(s.filename);
+	if (*filename == 0)
+		throw std::runtime_error("Database corrupted");
+
+	if (parent.FindSong(filename) != nullptr)
+		throw FmtRuntimeError("Duplicate song '{}'", filename);
+
+	auto song = Song::New(filename, parent);
+	song->target = GetString(s.target);
+	song->mtime = ImportTime(s.mtime);
+	song->start_time = SongTime::FromMS(s.start_ms);
+	song->end_time = SongTime::FromMS(s.end_ms);
+
+	/* a corrupt (or newer) file may contain values which the rest
+	   of MPD cannot cope with */
+	const SampleFormat sample_format = SampleFormat(s.sample_format);
+	if ((sample_format != SampleFormat::UNDEFINED &&
+	     !audio_valid_sample_format(sample_format)) ||
+	    (s.channels != 0 && !audio_valid_channel_count(s.channels)) ||
+	    (s.sample_rate != 0 && !audio_valid_sample_rate(s.sample_rate)))
+		throw std::runtime_error("Database corrupted");
+
+	song->audio_format = AudioFormat(s.sample_rate, sample_format,
+					 s.channels);
+	song->in_playlist = s.flags & SONG_FLAG_IN_PLAYLIST;
+
+	if (s.first_tag_item > tag_items.size() ||
+	    s.n_tag_items > tag_items.size() - s.first_tag_item)
+		throw std::runtime_error("Database corrupted");
+
+	TagBuilder tag;
+	tag.SetDuration(SignedSongTime::FromMS(s.duration_ms));
+	tag.SetHasPlaylist(s.flags & SONG_FLAG_HAS_PLAYLIST);
+	tag.Reserve(s.n_tag_items);
+
+	for (const auto &i : tag_items.subspan(s.first_tag_item,
+					       s.n_tag_items)) {
+		if (i.type >= tag_types.size())
+			throw std::runtime_error("Database corrupted");
+
+		const TagType type = tag_types[i.type];
+
+		/* the value has already been sanitized by
+		   TagBuilder::AddItem() before it was saved */
+		if (IsTagEnabled(type))
+			tag.AddItemUnchecked(type, GetString(i.value));
+	}
+
+	tag.Commit(song->tag);
+	return song;
+}
+
+inline void
+BinaryDatabaseReader::LoadDirectory(Directory &directory,
+				    const BinaryDirectory &d) const
+{
+	directory.mtime = ImportTime(d.mtime);
+	directory.device = d.device;
+
+	if (d.first_song > songs.size() ||
+	    d.n_songs > songs.size() - d.first_song ||
+	    d.first_playlist > playlists.size() ||
+	    d.n_playlists > playlists.size() - d.first_playlist)
+		throw std::runtime_error("Database corrupted");
+
+	for (const auto &s : songs.subspan(d.first_song, d.n_songs))
+		directory.AddSong(LoadSong(directory, s));
+
+	for (const auto &p : playlists.subspan(d.first_playlist,
+					       d.n_playlists))
+		directory.playlists.UpdateOrInsert(PlaylistInfo(GetString(p.name),
+								ImportTime(p.mtime)));
+}
+
+void
+BinaryDatabaseReader::Load(Directory &root) const
+{
+	/* all Directory objects, indexed by their position in the
+	   file */
+	std::vector<Directory *> objects;
+	objects.reserve(directories.size());
+
+	objects.push_back(&root);
+	LoadDirectory(root, directories.front());
+
+	for (const auto &d : directories.subspan(1)) {
+		/* parents must precede their children */
+		if (d.parent >= objects.size())
+			throw std::runtime_error("Database corrupted");
+
+		Directory &parent = *objects[d.parent];
+
+		const char *name = GetString(d.name);
+		if (*name == 0 || std::strchr(name, '/') != nullptr)
+			throw std::runtime_error("Database corrupted");
+
+		if (parent.FindChild(name) != nullptr)
+			throw FmtRuntimeError("Duplicate subdirectory '{}'",
+					      name);
+
+		Directory *directory = parent.CreateChild(name);
+		objects.push_back(directory);
+		LoadDirectory(*directory, d);
+	}
+}
+
+} // anonymous namespace
+
+void
+db_save_binary(BufferedOutputStream &os, const Directory &root)
+{
+	BinaryDatabaseWriter writer;
+	writer.AddDirectory(root, NO_PARENT);
+	writer.Write(os);
+}
+
+void
+db_load_binary(std::span<const std::byte> data, Directory &root)
+{
+	const BinaryDatabaseReader reader(data);
+
+	const ScopeDatabaseLock protect;
+	reader.Load(root);
+}
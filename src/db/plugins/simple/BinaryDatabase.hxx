@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_BINARY_DATABASE_HXX
+#define MPD_BINARY_DATABASE_HXX
+
+#include <cstddef>
+#include <span>
+
+struct Directory;
+class BufferedOutputStream;
+
+/**
+ * Does the given file contents start with the signature of the
+ * binary database format?
+ */
+[[gnu::pure]]
+bool
+db_is_binary(std::span<const std::byte> data) noexcept;
+
+/**
+ * Write the whole database in the binary format, which is meant to
+ * be mapped into memory by db_load_binary().
+ *
+ * Throws on error.
+ */
+void
+db_save_binary(BufferedOutputStream &os, const Directory &root);
+
+/**
+ * Load a database file written by db_save_binary().  The given
+ * buffer is usually a #MappedFile; it may be released after this
+ * function returns.
+ *
+ * Throws #std::runtime_error on error.
+ */
+void
+db_load_binary(std::span<const std::byte> data, Directory &root);
+
+#endif
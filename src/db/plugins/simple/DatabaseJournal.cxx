@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "DatabaseJournal.hxx"
+#include "DirectorySave.hxx"
+#include "Directory.hxx"
+#include "db/DatabaseLock.hxx"
+#include "io/BufferedOutputStream.hxx"
+#include "io/LineReader.hxx"
+#include "fs/FileInfo.hxx"
+#include "lib/fmt/RuntimeError.hxx"
+#include "util/NumberParser.hxx"
+#include "util/StringCompare.hxx"
+
+#include <fmt/format.h>
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define JOURNAL_BASE_SIZE "journal_base_size: "
+#define JOURNAL_BASE_MTIME "journal_base_mtime: "
+#define JOURNAL_RECORD "record: "
+#define JOURNAL_END "end: "
+
+/**
+ * A #LineReader which returns the lines of one journal record which
+ * were buffered by db_journal_load().
+ */
+class JournalRecord final : public LineReader {
+	std::vector<std::string> lines;
+	std::size_t position = 0;
+
+public:
+	void Add(const char *line) {
+		lines.emplace_back(line);
+	}
+
+	/* virtual methods from class LineReader */
+	char *ReadLine() override {
+		if (position >= lines.size())
+			return nullptr;
+
+		return lines[position++].data();
+	}
+};
+
+void
+db_journal_save_header(BufferedOutputStream &os, const FileInfo &base)
+{
+	os.Fmt(FMT_STRING(JOURNAL_BASE_SIZE "{}\n"), base.GetSize());
+	os.Fmt(FMT_STRING(JOURNAL_BASE_MTIME "{}\n"),
+	       std::chrono::system_clock::to_time_t(base.GetModificationTime()));
+}
+
+/**
+ * Returns the path of the given directory as written to the journal.
+ * The root directory is written as "/" because the #LineReader strips
+ * trailing whitespace.
+ */
+[[gnu::pure]]
+static const char *
+GetRecordPath(const Directory &directory) noexcept
+{
+	return directory.IsRoot() ? "/" : directory.GetPath();
+}
+
+void
+db_journal_save(BufferedOutputStream &os, Directory &directory)
+{
+	assert(holding_db_lock());
+
+	if (directory.IsMount())
+		return;
+
+	/* the parent is written before its children, so replaying
+	   the parent's list of children doesn't delete a child
+	   which is written afterwards */
+
+	if (directory.dirty) {
+		const char *path = GetRecordPath(directory);
+		os.Fmt(FMT_STRING(JOURNAL_RECORD "{}\n"), path);
+		directory_save_record(os, directory);
+		os.Fmt(FMT_STRING(JOURNAL_END "{}\n"), path);
+
+		directory.dirty = false;
+	}
+
+	for (auto &child : directory.children)
+		db_journal_save(os, child);
+}
+
+static uint64_t
+ReadHeaderValue(LineReader &file, const char *prefix)
+{
+	const char *line = file.ReadLine();
+	if (line == nullptr)
+		throw std::runtime_error("Malformed journal header");
+
+	const char *p = StringAfterPrefix(line, prefix);
+	if (p == nullptr)
+		throw std::runtime_error("Malformed journal header");
+
+	return ParseUint64(p);
+}
+
+JournalLoadResult
+db_journal_load(LineReader &file, Directory &root, const FileInfo &base)
+{
+	const uint64_t base_size = ReadHeaderValue(file, JOURNAL_BASE_SIZE);
+	const uint64_t base_mtime = ReadHeaderValue(file, JOURNAL_BASE_MTIME);
+	if (base_size != base.GetSize() ||
+	    base_mtime != uint64_t(std::chrono::system_clock::to_time_t(base.GetModificationTime())))
+		return JournalLoadResult::STALE;
+
+	const ScopeDatabaseLock protect;
+
+	const char *line;
+	while ((line = file.ReadLine()) != nullptr) {
+		const char *p = StringAfterPrefix(line, JOURNAL_RECORD);
+		if (p == nullptr) {
+			const std::string malformed{line};
+
+			/* the "record" line itself may have been cut
+			   off */
+			if (file.ReadLine() == nullptr)
+				return JournalLoadResult::TRUNCATED;
+
+			throw FmtRuntimeError("Malformed line: {}", malformed);
+		}
+
+		const std::string path{p};
+
+		/* buffer the whole record before applying it, to be
+		   able to ignore a record which was cut off */
+		JournalRecord record;
+		while (true) {
+			line = file.ReadLine();
+			if (line == nullptr)
+				return JournalLoadResult::TRUNCATED;
+
+			if (const char *end = StringAfterPrefix(line, JOURNAL_END)) {
+				if (path == end)
+					break;
+
+				/* a mismatch means the "end" line was
+				   cut off, which is only possible at the
+				   end of the file */
+				if (file.ReadLine() == nullptr)
+					return JournalLoadResult::TRUNCATED;
+
+				throw std::runtime_error("Malformed journal record");
+			}
+
+			record.Add(line);
+		}
+
+		directory_load_record(record, root, path.c_str());
+	}
+
+	return JournalLoadResult::COMPLETE;
+}
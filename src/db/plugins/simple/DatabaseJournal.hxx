@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_DATABASE_JOURNAL_HXX
+#define MPD_DATABASE_JOURNAL_HXX
+
+/** \file
+ *
+ * The journal of the "simple" database is a text file next to the
+ * database file.  Instead of rewriting the whole database after an
+ * update, records describing all directories modified since the
+ * previous save (see Directory::dirty) are appended to it.  Loading
+ * the database replays these records on top of the database file.
+ *
+ * Each record describes one directory completely (but not the
+ * contents of its children), so replaying the journal is idempotent,
+ * and a record at the end which was cut off by a crash can simply be
+ * ignored; the affected directories then still have their old
+ * modification time and will be scanned again by the next update.
+ * Nothing must be appended after such a record, because the new
+ * records would then follow a partial line.
+ */
+
+struct Directory;
+class BufferedOutputStream;
+class LineReader;
+class FileInfo;
+
+/**
+ * Write the header of a new journal.
+ *
+ * @param base the database file this journal belongs to
+ */
+void
+db_journal_save_header(BufferedOutputStream &os, const FileInfo &base);
+
+/**
+ * Write records for all dirty directories and clear their
+ * Directory::dirty flags.
+ *
+ * Caller must lock the #db_mutex.
+ */
+void
+db_journal_save(BufferedOutputStream &os, Directory &root);
+
+enum class JournalLoadResult {
+	/**
+	 * The journal belongs to a different database file, and
+	 * nothing was applied.
+	 */
+	STALE,
+
+	/**
+	 * All records were applied.
+	 */
+	COMPLETE,
+
+	/**
+	 * The last record was cut off and has been ignored; all
+	 * records before it were applied.  The journal must not be
+	 * appended to.
+	 */
+	TRUNCATED,
+};
+
+/**
+ * Replay a journal.
+ *
+ * Throws on error (after having applied all complete records
+ * preceding the error).
+ *
+ * @param base the database file which was loaded into #root
+ */
+JournalLoadResult
+db_journal_load(LineReader &file, Directory &root, const FileInfo &base);
+
+#endif
@@ -4,6 +4,8 @@
 #include "DatabaseSave.hxx"
 #include "db/DatabaseLock.hxx"
 #include "DirectorySave.hxx"
+#include "Directory.hxx"
+#include "BinaryDatabase.hxx"
 #include "lib/fmt/RuntimeError.hxx"
 #include "io/BufferedOutputStream.hxx"
 #include "io/LineReader.hxx"
@@ -11,6 +13,11 @@
 #include "tag/ParseName.hxx"
 #include "tag/Settings.hxx"
 #include "fs/Charset.hxx"
+#include "fs/io/MappedFile.hxx"
+#include "fs/io/TextFile.hxx"
+#include "fs/Path.hxx"
+#include "time/ChronoUtil.hxx"
+#include "util/NumberParser.hxx"
 #include "util/StringCompare.hxx"
 #include "Version.h"
 
@@ -25,8 +32,14 @@
 #define DIRECTORY_MPD_VERSION "mpd_version: "
 #define DIRECTORY_FS_CHARSET "fs_charset: "
 #define DB_TAG_PREFIX "tag: "
+#define DB_ROOT_MTIME "root_mtime: "
 
-static constexpr unsigned DB_FORMAT = 2;
+/**
+ * Format 3 added the "root_mtime" line.  Older MPD versions reject
+ * unknown header lines, so this bump makes them report a format
+ * mismatch instead of a malformed line.
+ */
+static constexpr unsigned DB_FORMAT = 3;
 
 /**
  * The oldest database format understood by this MPD version.
@@ -46,6 +59,10 @@ db_save_internal(BufferedOutputStream &os, const Directory &music_root)
 			os.Fmt(FMT_STRING(DB_TAG_PREFIX "{}\n"),
 			       tag_item_names[i]);
 
+	if (!IsNegative(music_root.mtime))
+		os.Fmt(FMT_STRING(DB_ROOT_MTIME "{}\n"),
+		       std::chrono::system_clock::to_time_t(music_root.mtime));
+
 	os.Write(DIRECTORY_INFO_END "\n");
 
 	directory_save(os, music_root);
@@ -58,6 +75,8 @@ db_load_internal(LineReader &file, Directory &music_root)
 	unsigned format = 0;
 	bool found_charset = false, found_version = false;
 	bool tags[TAG_NUM_OF_ITEM_TYPES];
+	std::chrono::system_clock::time_point root_mtime =
+		std::chrono::system_clock::time_point::min();
 
 	/* get initial info */
 	line = file.ReadLine();
@@ -100,6 +119,14 @@ db_load_internal(LineReader &file, Directory &music_root)
 						      name);
 
 			tags[tag] = true;
+		} else if ((p = StringAfterPrefix(line, DB_ROOT_MTIME))) {
+			char *endptr;
+			const auto mtime = ParseUint64(p, &endptr);
+			if (endptr == p || *endptr != 0)
+				throw FmtRuntimeError("Malformed line: {}", line);
+
+			if (mtime > 0)
+				root_mtime = std::chrono::system_clock::from_time_t(mtime);
 		} else {
 			throw FmtRuntimeError("Malformed line: {}", line);
 		}
@@ -115,5 +142,19 @@ db_load_internal(LineReader &file, Directory &music_root)
 						 "discarding database file");
 
 	const ScopeDatabaseLock protect;
+	music_root.mtime = root_mtime;
 	directory_load(file, music_root);
 }
+
+void
+db_load_file(Path path, Directory &root)
+{
+	const MappedFile mapped(path);
+	if (db_is_binary(mapped.GetData())) {
+		db_load_binary(mapped.GetData(), root);
+		return;
+	}
+
+	TextFile file(path);
+	db_load_internal(file, root);
+}
@@ -7,6 +7,7 @@
 struct Directory;
 class BufferedOutputStream;
 class LineReader;
+class Path;
 
 void
 db_save_internal(BufferedOutputStream &os, const Directory &root);
@@ -17,4 +18,13 @@ db_save_internal(BufferedOutputStream &os, const Directory &root);
 void
 db_load_internal(LineReader &file, Directory &root);
 
+/**
+ * Load a database file, auto-detecting its format (text, gzipped
+ * text or binary).
+ *
+ * Throws on error.
+ */
+void
+db_load_file(Path path, Directory &root);
+
 #endif
@@ -5,6 +5,7 @@
 #include "ExportedSong.hxx"
 #include "SongSort.hxx"
 #include "Song.hxx"
+#include "TagIndex.hxx"
 #include "Mount.hxx"
 #include "db/LightDirectory.hxx"
 #include "db/Uri.hxx"
@@ -20,27 +21,74 @@
 #include "util/StringSplit.hxx"
 
 #include <cassert>
+#include <vector>
 
 #include <string.h>
 #include <stdlib.h>
 
 using std::string_view_literals::operator""sv;
 
-Directory::Directory(std::string &&_path_utf8, Directory *_parent) noexcept
+static_assert(alignof(Directory) <= DB_ARENA_ALIGNMENT);
+
+/**
+ * Free the given (already unlinked) #Directory, or postpone that
+ * until it gets unpinned (see Directory::Unpin()).
+ *
+ * Caller must lock the #db_mutex.
+ */
+static void
+DisposeDirectory(Directory *directory) noexcept
+{
+	assert(holding_db_lock());
+	assert(!directory->deleted);
+
+	if (directory->pin_count > 0)
+		directory->deleted = true;
+	else
+		delete directory;
+}
+
+Directory::Directory(ArenaGeneration &_arena,
+		     std::string_view _path_utf8, Directory *_parent)
 	:parent(_parent),
-	 path(std::move(_path_utf8))
+	 arena(_arena),
+	 path(_arena, _path_utf8)
+{
+}
+
+Directory *
+Directory::NewRoot()
 {
+	auto &arena = db_arena_new_generation();
+
+	try {
+		return new(arena) Directory(arena, {}, nullptr);
+	} catch (...) {
+		db_arena_retire_generation(arena);
+		throw;
+	}
 }
 
 Directory::~Directory() noexcept
 {
+	/* descendants can't be pinned either, because Pin() also
+	   pins all ancestors */
+	assert(pin_count == 0);
+
 	if (mounted_database != nullptr) {
 		mounted_database->Close();
 		mounted_database.reset();
 	}
 
+	song_index.Clear();
 	songs.clear_and_dispose(DeleteDisposer());
+	child_index.Clear();
 	children.clear_and_dispose(DeleteDisposer());
+
+	if (IsRoot())
+		/* the generation is deleted after this object has
+		   been freed, which is its last allocation */
+		db_arena_retire_generation(arena);
 }
 
 void
@@ -49,8 +97,43 @@ Directory::Delete() noexcept
 	assert(holding_db_lock());
 	assert(parent != nullptr);
 
+	if (auto *index = GetTagIndex())
+		index->RemoveDirectory(*this);
+
+	parent->MarkDirty();
+	parent->child_index.Remove(*this);
 	parent->children.erase_and_dispose(parent->children.iterator_to(*this),
-					   DeleteDisposer());
+					   DisposeDirectory);
+}
+
+void
+Directory::Unpin() const noexcept
+{
+	assert(holding_db_lock());
+
+	const Directory *i = this;
+	do {
+		assert(i->pin_count > 0);
+
+		/* a deleted directory has been unlinked from its
+		   parent, but its (pinned) parent pointer is still
+		   valid */
+		const Directory *next = i->parent;
+		if (--i->pin_count == 0 && i->deleted)
+			delete i;
+
+		i = next;
+	} while (i != nullptr);
+}
+
+TagIndex *
+Directory::GetTagIndex() const noexcept
+{
+	const Directory *root = this;
+	while (root->parent != nullptr)
+		root = root->parent;
+
+	return root->tag_index.get();
 }
 
 const char *
@@ -66,7 +149,7 @@ Directory::GetName() const noexcept
 
 	/* strip the parent directory path and the slash separator
 	   from this directory's path, and the base name remains */
-	return path.c_str() + parent->path.length() + 1;
+	return path.c_str() + parent->path.size() + 1;
 }
 
 Directory *
@@ -79,8 +162,10 @@ Directory::CreateChild(std::string_view name_utf8) noexcept
 		? std::string(name_utf8)
 		: PathTraitsUTF8::Build(GetPath(), name_utf8);
 
-	auto *child = new Directory(std::move(path_utf8), this);
+	auto *child = new(arena) Directory(arena, path_utf8, this);
+	MarkDirty();
 	children.push_back(*child);
+	child_index.Add(*child, children);
 	return child;
 }
 
@@ -89,11 +174,7 @@ Directory::FindChild(std::string_view name) const noexcept
 {
 	assert(holding_db_lock());
 
-	for (const auto &child : children)
-		if (name.compare(child.GetName()) == 0)
-			return &child;
-
-	return nullptr;
+	return child_index.Find(children, name);
 }
 
 Song *
@@ -120,10 +201,12 @@ Directory::PruneEmpty() noexcept
 	     child != end;) {
 		child->PruneEmpty();
 
-		if (child->IsEmpty() && !child->IsMount())
+		if (child->IsEmpty() && !child->IsMount()) {
+			MarkDirty();
+			child_index.Remove(*child);
 			child = children.erase_and_dispose(child,
-							   DeleteDisposer());
-		else
+							   DisposeDirectory);
+		} else
 			++child;
 	}
 }
@@ -164,7 +247,12 @@ Directory::AddSong(SongPtr song) noexcept
 	assert(song != nullptr);
 	assert(&song->parent == this);
 
+	MarkDirty();
 	songs.push_back(*song.release());
+	song_index.Add(songs.back(), songs);
+
+	if (auto *index = GetTagIndex())
+		index->Add(songs.back());
 }
 
 SongPtr
@@ -174,23 +262,48 @@ Directory::RemoveSong(Song *song) noexcept
 	assert(song != nullptr);
 	assert(&song->parent == this);
 
+	if (auto *index = GetTagIndex())
+		index->Remove(*song);
+
+	MarkDirty();
+	song_index.Remove(*song);
 	songs.erase(songs.iterator_to(*song));
 	return SongPtr(song);
 }
 
+void
+Directory::SongTagChanged(const Song &song, const Tag &old_tag) noexcept
+{
+	assert(holding_db_lock());
+	assert(&song.parent == this);
+
+	MarkDirty();
+
+	if (auto *index = GetTagIndex()) {
+		index->Remove(song, old_tag);
+		index->Add(song);
+	}
+}
+
 const Song *
 Directory::FindSong(std::string_view name_utf8) const noexcept
 {
 	assert(holding_db_lock());
 
-	for (auto &song : songs) {
-		assert(&song.parent == this);
+	const Song *song = song_index.Find(songs, name_utf8);
+	assert(song == nullptr || &song->parent == this);
+	return song;
+}
 
-		if (song.filename == name_utf8)
-			return &song;
-	}
+void
+Directory::ClearDirty() noexcept
+{
+	assert(holding_db_lock());
+
+	dirty = false;
 
-	return nullptr;
+	for (auto &child : children)
+		child.ClearDirty();
 }
 
 [[gnu::pure]]
@@ -216,7 +329,8 @@ void
 Directory::Walk(bool recursive, const SongFilter *filter,
 		bool hide_playlist_targets,
 		const VisitDirectory& visit_directory, const VisitSong& visit_song,
-		const VisitPlaylist& visit_playlist) const
+		const VisitPlaylist& visit_playlist,
+		const DatabaseYield &yield) const
 {
 	if (IsMount()) {
 		assert(IsEmpty());
@@ -224,6 +338,7 @@ Directory::Walk(bool recursive, const SongFilter *filter,
 		/* TODO: eliminate this unlock/lock; it is necessary
 		   because the child's SimpleDatabasePlugin::Visit()
 		   call will lock it again */
+		const ScopeMountWalk mount_walk;
 		const ScopeDatabaseUnlock unlock;
 		WalkMount(GetPath(), *mounted_database,
 			  "", DatabaseSelection("", recursive, filter),
@@ -248,15 +363,40 @@ Directory::Walk(bool recursive, const SongFilter *filter,
 			visit_playlist(p, Export());
 	}
 
-	for (auto &child : children) {
+	if (!recursive) {
+		if (visit_directory)
+			for (const auto &child : children)
+				visit_directory(child.Export());
+		return;
+	}
+
+	/* the database lock is released briefly before descending
+	   into each child, to allow the update thread to modify the
+	   database during a large Walk(); this is not a consistent
+	   view of the whole tree, only each directory's contents are
+	   visited atomically; children which get deleted meanwhile
+	   are kept alive by their pins and are visited in the state
+	   they had before their deletion */
+
+	PinnedDirectoryList child_list;
+	child_list.reserve(children.size());
+	for (const auto &child : children)
+		child_list.push_back(child);
+
+	for (const auto *child : child_list) {
+		{
+			const ScopeDatabaseUnlock unlock;
+			if (yield)
+				yield();
+		}
+
 		if (visit_directory)
-			visit_directory(child.Export());
+			visit_directory(child->Export());
 
-		if (recursive)
-			child.Walk(recursive, filter,
-				   hide_playlist_targets,
-				   visit_directory, visit_song,
-				   visit_playlist);
+		child->Walk(recursive, filter,
+			    hide_playlist_targets,
+			    visit_directory, visit_song,
+			    visit_playlist, yield);
 	}
 }
 
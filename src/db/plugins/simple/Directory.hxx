@@ -5,14 +5,18 @@
 #define MPD_DIRECTORY_HXX
 
 #include "Ptr.hxx"
+#include "Arena.hxx"
+#include "NameIndex.hxx"
 #include "Song.hxx" // TODO eliminate this include, forward-declare only
 #include "db/Visitor.hxx"
 #include "db/PlaylistVector.hxx"
 #include "db/Ptr.hxx"
 #include "util/IntrusiveList.hxx"
 
+#include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 
 /**
  * Virtual directory that is really an archive file or a folder inside
@@ -34,6 +38,7 @@ static constexpr unsigned DEVICE_CONTAINER = -2;
 static constexpr unsigned DEVICE_PLAYLIST = -3;
 
 class SongFilter;
+class TagIndex;
 
 struct Directory : IntrusiveListHook<> {
 	/* Note: the #IntrusiveListHook is protected with the global
@@ -58,6 +63,30 @@ struct Directory : IntrusiveListHook<> {
 	 */
 	IntrusiveList<Song> songs;
 
+	struct GetChildName {
+		[[gnu::pure]]
+		std::string_view operator()(const Directory &child) const noexcept {
+			return child.GetName();
+		}
+	};
+
+	struct GetSongName {
+		[[gnu::pure]]
+		std::string_view operator()(const Song &song) const noexcept {
+			return song.filename;
+		}
+	};
+
+	/**
+	 * Optional hash indexes for FindChild() and FindSong(); they
+	 * are kept in sync with #children and #songs by CreateChild(),
+	 * Delete(), AddSong() and RemoveSong().
+	 *
+	 * These attributes are protected with the global #db_mutex.
+	 */
+	NameIndex<Directory, GetChildName> child_index;
+	NameIndex<Song, GetSongName> song_index;
+
 	PlaylistVector playlists;
 
 	Directory *const parent;
@@ -67,7 +96,42 @@ struct Directory : IntrusiveListHook<> {
 
 	uint64_t inode = 0, device = 0;
 
-	const std::string path;
+	/**
+	 * Has this directory (its attributes, songs, playlists or the
+	 * list of children) been modified since the database was
+	 * saved?  This is used to write only modified directories to
+	 * the journal, see DatabaseJournal.hxx.  New directories are
+	 * dirty.
+	 *
+	 * This attribute is protected with the global #db_mutex.
+	 */
+	bool dirty = true;
+
+	/**
+	 * Has this directory been removed from its parent by
+	 * Delete() while it was pinned?  It will be freed by the last
+	 * Unpin() call.
+	 *
+	 * This attribute is protected with the global #db_mutex.
+	 */
+	bool deleted = false;
+
+	/**
+	 * The number of pins (see Pin()) on this directory and all of
+	 * its descendants.
+	 *
+	 * This attribute is protected with the global #db_mutex.
+	 */
+	mutable unsigned pin_count = 0;
+
+	/**
+	 * The arena generation of this tree, created by NewRoot().
+	 * All directories, songs and their strings are allocated
+	 * there.
+	 */
+	ArenaGeneration &arena;
+
+	const ArenaString path;
 
 	/**
 	 * If this is not nullptr, then this directory does not really
@@ -75,17 +139,45 @@ struct Directory : IntrusiveListHook<> {
 	 */
 	DatabasePtr mounted_database;
 
+	/**
+	 * The inverted tag index of the whole tree.  Only the root
+	 * directory may have one; it is kept up to date by
+	 * AddSong(), RemoveSong(), Delete() and SongTagChanged().
+	 *
+	 * This attribute is protected with the global #db_mutex.
+	 */
+	std::unique_ptr<TagIndex> tag_index;
+
 public:
-	Directory(std::string &&_path_utf8, Directory *_parent) noexcept;
+	Directory(ArenaGeneration &_arena,
+		  std::string_view _path_utf8, Directory *_parent);
 	~Directory() noexcept;
 
+	/* all directories live in the database arena, see
+	   db_arena_allocate() */
+	static void *operator new(std::size_t size, ArenaGeneration &arena) {
+		return db_arena_allocate(arena, size);
+	}
+
+	static void operator delete(void *p, ArenaGeneration &) noexcept {
+		db_arena_free(p, sizeof(Directory));
+	}
+
+	static void operator delete(void *p, std::size_t size) noexcept {
+		db_arena_free(p, size);
+	}
+
 	/**
-	 * Create a new root #Directory object.
+	 * Create a new root #Directory object with a new arena
+	 * generation (see db_arena_new_generation()), which is
+	 * retired when the root is deleted.  This way, the memory of
+	 * a database can be given back as a whole once it has been
+	 * freed.
+	 *
+	 * Throws std::bad_alloc on error.
 	 */
 	[[gnu::malloc]] [[gnu::returns_nonnull]]
-	static Directory *NewRoot() noexcept {
-		return new Directory(std::string(), nullptr);
-	}
+	static Directory *NewRoot();
 
 	bool IsPlaylist() const noexcept {
 		return device == DEVICE_PLAYLIST;
@@ -105,6 +197,54 @@ public:
 		return mounted_database != nullptr;
 	}
 
+	/**
+	 * Mark this directory as modified.  This needs to be called
+	 * after modifying attributes or #playlists directly;
+	 * methods like AddSong() do it automatically.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	void MarkDirty() noexcept {
+		dirty = true;
+	}
+
+	/**
+	 * Pin this directory, i.e. make sure that it and all of its
+	 * ancestors are not freed until Unpin() is called, even if
+	 * they get deleted meanwhile.  This allows using the pointer
+	 * while the #db_mutex is released.  Deleted directories are
+	 * kept in the state they had before their deletion.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	void Pin() const noexcept {
+		for (const Directory *i = this; i != nullptr; i = i->parent)
+			++i->pin_count;
+	}
+
+	/**
+	 * Undo Pin(), and free all deleted directories which are not
+	 * pinned anymore.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	void Unpin() const noexcept;
+
+	/**
+	 * Clear the #dirty flag of this directory and all its
+	 * children.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	void ClearDirty() noexcept;
+
+	/**
+	 * Returns the #TagIndex of the tree this directory belongs
+	 * to, or nullptr if there is none.
+	 */
+	[[gnu::pure]]
+	TagIndex *GetTagIndex() const noexcept;
+
 	/**
 	 * Checks whether this is a "special" directory
 	 * (e.g. #DEVICE_PLAYLIST) and whether the underlying plugin
@@ -114,7 +254,8 @@ public:
 	bool IsPluginAvailable() const noexcept;
 
 	/**
-	 * Remove this #Directory object from its parent and free it.  This
+	 * Remove this #Directory object from its parent and free it
+	 * (or postpone that while a Walk() is in progress).  This
 	 * must not be called with the root Directory.
 	 *
 	 * Caller must lock the #db_mutex.
@@ -257,6 +398,17 @@ public:
 	 */
 	SongPtr RemoveSong(Song *song) noexcept;
 
+	/**
+	 * Update the #TagIndex (and mark this directory dirty) after
+	 * the tag of a song in this directory has been replaced,
+	 * e.g. by Song::UpdateFile().
+	 *
+	 * Caller must lock the #db_mutex.
+	 *
+	 * @param old_tag the previous value of Song::tag
+	 */
+	void SongTagChanged(const Song &song, const Tag &old_tag) noexcept;
+
 	/**
 	 * Caller must lock the #db_mutex.
 	 */
@@ -270,15 +422,81 @@ public:
 	void Sort() noexcept;
 
 	/**
-	 * Caller must lock #db_mutex.
+	 * Caller must lock #db_mutex.  If #recursive is true, the
+	 * lock is released briefly before descending into each
+	 * child, so other threads may modify the tree meanwhile;
+	 * each directory's contents are visited atomically, and
+	 * directories deleted during the walk are freed only
+	 * after it has finished.
+	 *
+	 * @param yield if set, this is invoked each time the lock is
+	 * released between two directories
 	 */
 	void Walk(bool recursive, const SongFilter *match,
 		  bool hide_playlist_targets,
 		  const VisitDirectory& visit_directory, const VisitSong& visit_song,
-		  const VisitPlaylist& visit_playlist) const;
+		  const VisitPlaylist& visit_playlist,
+		  const DatabaseYield &yield={}) const;
 
 	[[gnu::pure]]
 	LightDirectory Export() const noexcept;
 };
 
+/**
+ * A list of #Directory pointers which are pinned (see
+ * Directory::Pin()) while they are in this list, so they remain
+ * valid after the #db_mutex has been released.  This is used by
+ * Directory::Walk() and #SearchPool.
+ *
+ * All methods (including the destructor) must be called while
+ * holding the #db_mutex.
+ */
+class PinnedDirectoryList {
+	std::vector<const Directory *> list;
+
+public:
+	PinnedDirectoryList() noexcept = default;
+
+	~PinnedDirectoryList() noexcept {
+		clear();
+	}
+
+	PinnedDirectoryList(const PinnedDirectoryList &) = delete;
+	PinnedDirectoryList &operator=(const PinnedDirectoryList &) = delete;
+
+	std::size_t size() const noexcept {
+		return list.size();
+	}
+
+	const Directory *operator[](std::size_t i) const noexcept {
+		return list[i];
+	}
+
+	auto begin() const noexcept {
+		return list.begin();
+	}
+
+	auto end() const noexcept {
+		return list.end();
+	}
+
+	void reserve(std::size_t n) {
+		list.reserve(n);
+	}
+
+	/**
+	 * Throws std::bad_alloc on error.
+	 */
+	void push_back(const Directory &directory) {
+		list.push_back(&directory);
+		directory.Pin();
+	}
+
+	void clear() noexcept {
+		for (const auto *directory : list)
+			directory->Unpin();
+		list.clear();
+	}
+};
+
 #endif
@@ -13,10 +13,15 @@
 #include "lib/fmt/RuntimeError.hxx"
 #include "util/StringAPI.hxx"
 #include "util/StringCompare.hxx"
+#include "util/IterableSplitString.hxx"
 #include "util/NumberParser.hxx"
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include <string.h>
 
 #define DIRECTORY_DIR "directory: "
@@ -24,6 +29,7 @@
 #define DIRECTORY_MTIME "mtime: "
 #define DIRECTORY_BEGIN "begin: "
 #define DIRECTORY_END "end: "
+#define DIRECTORY_CHILD "child: "
 
 [[gnu::const]]
 static const char *
@@ -136,6 +142,24 @@ directory_load_subdir(LineReader &file, Directory &parent, std::string_view name
 	return directory;
 }
 
+static void
+directory_load_song(LineReader &file, Directory &directory, const char *name)
+{
+	if (directory.FindSong(name) != nullptr)
+		throw FmtRuntimeError("Duplicate song '{}'", name);
+
+	std::string target;
+	bool in_playlist = false;
+	auto detached_song = song_load(file, name,
+				       &target, &in_playlist);
+
+	auto song = Song::New(std::move(detached_song), directory);
+	song->target = std::move(target);
+	song->in_playlist = in_playlist;
+
+	directory.AddSong(std::move(song));
+}
+
 void
 directory_load(LineReader &file, Directory &directory)
 {
@@ -147,28 +171,98 @@ directory_load(LineReader &file, Directory &directory)
 		if ((p = StringAfterPrefix(line, DIRECTORY_DIR))) {
 			directory_load_subdir(file, directory, p);
 		} else if ((p = StringAfterPrefix(line, SONG_BEGIN))) {
+			directory_load_song(file, directory, p);
+		} else if ((p = StringAfterPrefix(line, PLAYLIST_META_BEGIN))) {
 			const char *name = p;
+			playlist_metadata_load(file, directory.playlists, name);
+		} else {
+			throw FmtRuntimeError("Malformed line: {}", line);
+		}
+	}
+}
+
+void
+directory_save_record(BufferedOutputStream &os, const Directory &directory)
+{
+	const char *type = DeviceToTypeString(directory.device);
+	if (type != nullptr)
+		os.Fmt(FMT_STRING(DIRECTORY_TYPE "{}\n"), type);
+
+	if (!IsNegative(directory.mtime))
+		os.Fmt(FMT_STRING(DIRECTORY_MTIME "{}\n"),
+		       std::chrono::system_clock::to_time_t(directory.mtime));
+
+	for (const auto &child : directory.children)
+		if (!child.IsMount())
+			os.Fmt(FMT_STRING(DIRECTORY_CHILD "{}\n"),
+			       child.GetName());
+
+	for (const auto &song : directory.songs)
+		song_save(os, song);
+
+	playlist_vector_save(os, directory.playlists);
+}
 
-			if (directory.FindSong(name) != nullptr)
-				throw FmtRuntimeError("Duplicate song '{}'",
-						      name);
+/**
+ * Look up a directory by its path, creating all missing path
+ * segments.
+ */
+static Directory &
+MakeDirectory(Directory &root, std::string_view path)
+{
+	auto r = root.LookupDirectory(path);
+	Directory *directory = r.directory;
 
-			std::string target;
-			bool in_playlist = false;
-			auto detached_song = song_load(file, name,
-						       &target, &in_playlist);
+	for (const std::string_view name : IterableSplitString(r.rest, '/')) {
+		if (name.empty())
+			throw FmtRuntimeError("Malformed path: {}", path);
 
-			auto song = std::make_unique<Song>(std::move(detached_song),
-							   directory);
-			song->target = std::move(target);
-			song->in_playlist = in_playlist;
+		directory = directory->MakeChild(name);
+	}
+
+	return *directory;
+}
+
+void
+directory_load_record(LineReader &file, Directory &root, const char *path)
+{
+	Directory &directory = MakeDirectory(root, path);
 
-			directory.AddSong(std::move(song));
+	directory.device = 0;
+	directory.mtime = std::chrono::system_clock::time_point::min();
+	directory.ForEachSongSafe([&directory](Song &song){
+		directory.RemoveSong(&song);
+	});
+	directory.playlists.erase(directory.playlists.begin(),
+				  directory.playlists.end());
+
+	std::vector<std::string> children;
+
+	const char *line;
+	while ((line = file.ReadLine()) != nullptr) {
+		const char *p;
+		if ((p = StringAfterPrefix(line, DIRECTORY_CHILD))) {
+			children.emplace_back(p);
+		} else if ((p = StringAfterPrefix(line, SONG_BEGIN))) {
+			directory_load_song(file, directory, p);
 		} else if ((p = StringAfterPrefix(line, PLAYLIST_META_BEGIN))) {
 			const char *name = p;
 			playlist_metadata_load(file, directory.playlists, name);
-		} else {
+		} else if (!ParseLine(directory, line)) {
 			throw FmtRuntimeError("Malformed line: {}", line);
 		}
 	}
+
+	directory.ForEachChildSafe([&children](Directory &child){
+		if (child.IsMount())
+			return;
+
+		const std::string_view name = child.GetName();
+		if (std::find(children.begin(), children.end(),
+			      name) == children.end())
+			child.Delete();
+	});
+
+	for (const auto &name : children)
+		directory.MakeChild(name);
 }
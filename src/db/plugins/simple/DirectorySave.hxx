@@ -17,4 +17,28 @@ directory_save(BufferedOutputStream &os, const Directory &directory);
 void
 directory_load(LineReader &file, Directory &directory);
 
+/**
+ * Write the body of a journal record describing the attributes, the
+ * songs, the playlists and the names of the children of the given
+ * directory, but not the contents of the children.
+ */
+void
+directory_save_record(BufferedOutputStream &os, const Directory &directory);
+
+/**
+ * Apply a journal record body written by directory_save_record(),
+ * replacing the contents of the directory with the given path (which
+ * is created if it does not exist).  Children which are not listed in
+ * the record are deleted.
+ *
+ * Caller must lock the #db_mutex.
+ *
+ * Throws #std::runtime_error on error.
+ *
+ * @param file a #LineReader which returns the record body and then
+ * end-of-file
+ */
+void
+directory_load_record(LineReader &file, Directory &root, const char *path);
+
 #endif
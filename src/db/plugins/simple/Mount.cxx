@@ -7,7 +7,11 @@
 #include "db/Selection.hxx"
 #include "db/LightDirectory.hxx"
 #include "db/Interface.hxx"
+#include "db/DatabaseLock.hxx"
 #include "fs/Traits.hxx"
+#include "thread/Cond.hxx"
+
+#include <cassert>
 
 #include <string>
 
@@ -24,6 +28,58 @@ struct PrefixedLightDirectory : LightDirectory {
 	}
 };
 
+/**
+ * The number of #ScopeMountWalk instances.
+ *
+ * Protected by #db_mutex.
+ */
+static unsigned mount_walk_count;
+
+/**
+ * Signalled when #mount_walk_count drops to zero.
+ */
+static Cond mount_walk_cond;
+
+ScopeMountWalk::ScopeMountWalk() noexcept
+{
+	assert(holding_db_lock());
+
+	++mount_walk_count;
+}
+
+ScopeMountWalk::~ScopeMountWalk() noexcept
+{
+	assert(holding_db_lock());
+	assert(mount_walk_count > 0);
+
+	if (--mount_walk_count == 0)
+		mount_walk_cond.notify_all();
+}
+
+void
+WaitMountWalks() noexcept
+{
+	assert(holding_db_lock());
+
+	if (mount_walk_count == 0)
+		return;
+
+	std::unique_lock<Mutex> lock(db_mutex, std::adopt_lock);
+
+	do {
+#ifndef NDEBUG
+		db_mutex_holder = ThreadId::Null();
+#endif
+		mount_walk_cond.wait(lock);
+#ifndef NDEBUG
+		db_mutex_holder = ThreadId::GetCurrent();
+#endif
+	} while (mount_walk_count > 0);
+
+	/* the caller still owns the lock */
+	lock.release();
+}
+
 static void
 PrefixVisitDirectory(std::string_view base, const VisitDirectory &visit_directory,
 		     const LightDirectory &directory)
@@ -71,6 +127,7 @@ WalkMount(std::string_view base, const Database &db,
 
 	DatabaseSelection selection(old_selection);
 	selection.uri = uri;
+	selection.yield = {};
 
 	SongFilter prefix_filter;
 
@@ -11,6 +11,36 @@
 class Database;
 struct DatabaseSelection;
 
+/**
+ * Registers a visit of a mounted database, which happens while the
+ * #db_mutex is released.  Unmounting waits for these with
+ * WaitMountWalks(), because visits may run in other threads.
+ *
+ * Construct and destruct this object with the #db_mutex locked.
+ */
+class ScopeMountWalk {
+public:
+	ScopeMountWalk() noexcept;
+	~ScopeMountWalk() noexcept;
+
+	ScopeMountWalk(const ScopeMountWalk &) = delete;
+	ScopeMountWalk &operator=(const ScopeMountWalk &) = delete;
+};
+
+/**
+ * Wait until no #ScopeMountWalk exists anymore.  The #db_mutex is
+ * released while waiting.
+ *
+ * Caller must lock the #db_mutex.
+ */
+void
+WaitMountWalks() noexcept;
+
+/**
+ * Visit the given mounted database.  DatabaseSelection::yield is not
+ * passed to it, because that might block a thread which waits in
+ * WaitMountWalks().
+ */
 void
 WalkMount(std::string_view base, const Database &db,
 	  std::string_view uri,
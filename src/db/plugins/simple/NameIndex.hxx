@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_NAME_INDEX_HXX
+#define MPD_NAME_INDEX_HXX
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+
+/**
+ * An optional hash index which allows looking up the items of an
+ * #IntrusiveList by their name in O(1).  The hash table is only
+ * allocated after the list has grown beyond #THRESHOLD items; small
+ * lists are searched linearly, which is cheaper for them anyway.
+ *
+ * The caller is responsible for keeping this object in sync with the
+ * list by calling Add() and Remove() for each modification.  An
+ * item's name must not change while it is in the index.
+ *
+ * @param GetName a function object returning the name of an item as
+ * std::string_view
+ */
+template<typename T, typename GetName>
+class NameIndex {
+	static constexpr std::size_t THRESHOLD = 32;
+
+	struct Hash {
+		using is_transparent = void;
+
+		[[gnu::pure]]
+		std::size_t operator()(std::string_view name) const noexcept {
+			return std::hash<std::string_view>{}(name);
+		}
+
+		[[gnu::pure]]
+		std::size_t operator()(const T *item) const noexcept {
+			return (*this)(GetName{}(*item));
+		}
+	};
+
+	struct Equal {
+		using is_transparent = void;
+
+		[[gnu::pure]]
+		bool operator()(const T *a, const T *b) const noexcept {
+			return a == b;
+		}
+
+		[[gnu::pure]]
+		bool operator()(std::string_view a, const T *b) const noexcept {
+			return a == GetName{}(*b);
+		}
+
+		[[gnu::pure]]
+		bool operator()(const T *a, std::string_view b) const noexcept {
+			return GetName{}(*a) == b;
+		}
+	};
+
+	using Set = std::unordered_set<const T *, Hash, Equal>;
+
+	/**
+	 * The number of items in the list.
+	 */
+	std::size_t size = 0;
+
+	std::unique_ptr<Set> set;
+
+public:
+	/**
+	 * Has the hash table been allocated?
+	 */
+	bool IsActive() const noexcept {
+		return set != nullptr;
+	}
+
+	/**
+	 * Call this after an item has been added to the list.
+	 */
+	template<typename List>
+	void Add(const T &item, const List &list) noexcept {
+		++size;
+
+		if (set != nullptr)
+			set->insert(&item);
+		else if (size > THRESHOLD)
+			Build(list);
+	}
+
+	/**
+	 * Call this before an item gets removed from the list.
+	 */
+	void Remove(const T &item) noexcept {
+		--size;
+
+		if (set != nullptr)
+			set->erase(&item);
+	}
+
+	/**
+	 * Call this after the list has been cleared.
+	 */
+	void Clear() noexcept {
+		size = 0;
+		set.reset();
+	}
+
+	template<typename List>
+	[[gnu::pure]]
+	const T *Find(const List &list,
+		      std::string_view name) const noexcept {
+		if (set != nullptr) {
+			const auto i = set->find(name);
+			return i != set->end() ? *i : nullptr;
+		}
+
+		for (const auto &item : list)
+			if (GetName{}(item) == name)
+				return &item;
+
+		return nullptr;
+	}
+
+private:
+	template<typename List>
+	void Build(const List &list) noexcept {
+		set = std::make_unique<Set>();
+		set->reserve(size);
+
+		for (const auto &item : list)
+			set->insert(&item);
+	}
+};
+
+#endif
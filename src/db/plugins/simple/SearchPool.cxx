@@ -0,0 +1,248 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "SearchPool.hxx"
+#include "Directory.hxx"
+#include "Song.hxx"
+#include "ExportedSong.hxx"
+#include "db/DatabaseLock.hxx"
+#include "song/Filter.hxx"
+#include "song/LightSong.hxx"
+#include "thread/Name.hxx"
+
+#include <algorithm>
+#include <cassert>
+
+/**
+ * The number of songs per shard.  This is small enough to keep all
+ * threads busy until the end of a search, but large enough to make
+ * the synchronization overhead negligible.
+ */
+static constexpr std::size_t SHARD_SIZE = 2048;
+
+SearchPool::SearchPool(unsigned _n_threads)
+	:n_threads(_n_threads)
+{
+	assert(n_threads > 0);
+
+	for (unsigned i = 0; i < n_threads; ++i) {
+		threads.emplace_front(BIND_THIS_METHOD(RunWorker));
+
+		try {
+			threads.front().Start();
+		} catch (...) {
+			/* this Thread was never started; remove it
+			   before joining the others */
+			threads.pop_front();
+			StopThreads();
+			throw;
+		}
+	}
+}
+
+SearchPool::~SearchPool() noexcept
+{
+	StopThreads();
+}
+
+void
+SearchPool::StopThreads() noexcept
+{
+	{
+		const std::scoped_lock lock{mutex};
+		quit = true;
+		worker_cond.notify_all();
+	}
+
+	for (auto &thread : threads)
+		thread.Join();
+}
+
+void
+SearchPool::CollectDirectories(const Directory &directory,
+			       std::size_t &n_songs)
+{
+	if (directory.IsMount())
+		return;
+
+	directories.push_back(directory);
+	n_songs += directory.songs.size();
+
+	if (n_songs >= SHARD_SIZE) {
+		const std::size_t begin = shards.empty()
+			? 0 : shards.back().end;
+		shards.push_back({begin, directories.size(), {}});
+		n_songs = 0;
+	}
+
+	for (const auto &child : directory.children)
+		CollectDirectories(child, n_songs);
+}
+
+bool
+SearchPool::Walk(const Directory &directory, const SongFilter &_filter,
+		 bool _hide_playlist_targets,
+		 const VisitSong &visit_song,
+		 const DatabaseYield &yield)
+{
+	assert(holding_db_lock());
+
+	if (busy)
+		return false;
+
+	/* no worker is looking at these fields until #end_shard is
+	   set, so they can be modified without locking */
+	assert(shards.empty());
+
+	filter = &_filter;
+	hide_playlist_targets = _hide_playlist_targets;
+
+	std::size_t n_songs = 0;
+
+	try {
+		CollectDirectories(directory, n_songs);
+	} catch (...) {
+		directories.clear();
+		shards.clear();
+		throw;
+	}
+
+	if (n_songs > 0 || shards.empty()) {
+		const std::size_t begin = shards.empty()
+			? 0 : shards.back().end;
+		shards.push_back({begin, directories.size(), {}});
+	}
+
+	if (shards.size() == 1) {
+		/* not worth waking up the workers */
+		RunShard(shards.front());
+		auto shard = std::move(shards.front());
+		directories.clear();
+		shards.clear();
+
+		if (shard.error)
+			std::rethrow_exception(shard.error);
+
+		for (const Song *song : shard.matches)
+			visit_song(song->Export());
+		return true;
+	}
+
+	busy = true;
+
+	try {
+		for (std::size_t i = 0; i < shards.size();) {
+			const std::size_t wave_end =
+				std::min(i + n_threads, shards.size());
+
+			{
+				const std::scoped_lock lock{mutex};
+				end_shard = wave_end;
+				worker_cond.notify_all();
+			}
+
+			for (; i < wave_end; ++i)
+				VisitShard(shards[i], visit_song);
+
+			if (i < shards.size()) {
+				/* the matches of this wave have been
+				   visited, so no Song pointer is held
+				   anymore; only the (pinned) Directory
+				   pointers are */
+				const ScopeDatabaseUnlock unlock;
+				if (yield)
+					yield();
+			}
+		}
+	} catch (...) {
+		Finish();
+		busy = false;
+		throw;
+	}
+
+	Finish();
+	busy = false;
+	return true;
+}
+
+void
+SearchPool::VisitShard(Shard &shard, const VisitSong &visit_song)
+{
+	{
+		std::unique_lock lock{mutex};
+		done_cond.wait(lock, [&shard]{
+			return shard.done;
+		});
+	}
+
+	if (shard.error)
+		std::rethrow_exception(shard.error);
+
+	for (const Song *song : shard.matches)
+		visit_song(song->Export());
+
+	shard.matches = {};
+}
+
+void
+SearchPool::Finish() noexcept
+{
+	std::unique_lock lock{mutex};
+
+	/* don't start any more shards */
+	end_shard = next_shard;
+
+	done_cond.wait(lock, [this]{ return n_busy == 0; });
+
+	next_shard = end_shard = 0;
+	shards.clear();
+	directories.clear();
+}
+
+void
+SearchPool::RunShard(Shard &shard) const noexcept
+try {
+	for (std::size_t i = shard.begin; i < shard.end; ++i) {
+		for (const auto &song : directories[i]->songs) {
+			if (hide_playlist_targets && song.in_playlist)
+				continue;
+
+			if (filter->Match(song.Export()))
+				shard.matches.push_back(&song);
+		}
+	}
+} catch (...) {
+	/* std::bad_alloc from push_back(); let the calling thread
+	   rethrow it */
+	shard.matches = {};
+	shard.error = std::current_exception();
+}
+
+inline void
+SearchPool::RunWorker() noexcept
+{
+	SetThreadName("db_search");
+
+	std::unique_lock lock{mutex};
+
+	while (true) {
+		worker_cond.wait(lock, [this]{
+			return quit || next_shard < end_shard;
+		});
+
+		if (quit)
+			break;
+
+		auto &shard = shards[next_shard++];
+		++n_busy;
+
+		{
+			const ScopeUnlock unlock(mutex);
+			RunShard(shard);
+		}
+
+		shard.done = true;
+		--n_busy;
+		done_cond.notify_all();
+	}
+}
@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_SIMPLE_SEARCH_POOL_HXX
+#define MPD_SIMPLE_SEARCH_POOL_HXX
+
+#include "Directory.hxx"
+#include "db/Visitor.hxx"
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+#include "thread/Thread.hxx"
+
+#include <cstddef>
+#include <exception>
+#include <forward_list>
+#include <vector>
+
+struct Song;
+class SongFilter;
+
+/**
+ * A pool of threads which evaluate a #SongFilter on a directory tree
+ * in parallel.  The tree is split into shards of consecutive
+ * directories; each worker collects the matching songs of one shard,
+ * and the calling thread passes them to the visitor in tree order,
+ * so the result is the same as with Directory::Walk().
+ *
+ * The shards are submitted in "waves" of one shard per thread; the
+ * database lock is held only while a wave is being processed and its
+ * results are passed to the visitor, and it is released between two
+ * waves, just like Directory::Walk() releases it between two
+ * directories.
+ */
+class SearchPool {
+	struct Shard {
+		/**
+		 * Range of indexes in #directories.
+		 */
+		std::size_t begin, end;
+
+		/**
+		 * The matching songs (filled by the worker).
+		 */
+		std::vector<const Song *> matches;
+
+		/**
+		 * The exception thrown by the worker (e.g.
+		 * std::bad_alloc), to be rethrown by the calling
+		 * thread.
+		 */
+		std::exception_ptr error;
+
+		/**
+		 * Has the worker finished?  Protected by #mutex.
+		 */
+		bool done = false;
+	};
+
+	Mutex mutex;
+
+	/**
+	 * Signalled when a new search has been submitted or when
+	 * #quit has been set.
+	 */
+	Cond worker_cond;
+
+	/**
+	 * Signalled when a shard has been finished.
+	 */
+	Cond done_cond;
+
+	/**
+	 * The directories of the current search in pre-order.  They
+	 * are pinned, because the database lock is released between
+	 * two waves.
+	 */
+	PinnedDirectoryList directories;
+
+	/**
+	 * The shards of the current search.  This vector is only
+	 * modified while no worker is active (see #end_shard).
+	 */
+	std::vector<Shard> shards;
+
+	/**
+	 * The index of the next shard to be picked up by a worker.
+	 * Protected by #mutex.
+	 */
+	std::size_t next_shard = 0;
+
+	/**
+	 * Workers pick up shards until #next_shard reaches this
+	 * index.  Protected by #mutex.
+	 */
+	std::size_t end_shard = 0;
+
+	/**
+	 * The number of shards currently being worked on.  Protected
+	 * by #mutex.
+	 */
+	std::size_t n_busy = 0;
+
+	/**
+	 * Parameters of the current search.
+	 */
+	const SongFilter *filter;
+	bool hide_playlist_targets;
+
+	std::forward_list<Thread> threads;
+
+	/**
+	 * The number of threads, which is also the number of shards
+	 * per wave.
+	 */
+	const unsigned n_threads;
+
+	bool quit = false;
+
+	/**
+	 * Is a Walk() in progress?  Protected by #db_mutex.
+	 */
+	bool busy = false;
+
+public:
+	/**
+	 * Throws on error.
+	 */
+	explicit SearchPool(unsigned n_threads);
+
+	~SearchPool() noexcept;
+
+	SearchPool(const SearchPool &) = delete;
+	SearchPool &operator=(const SearchPool &) = delete;
+
+	/**
+	 * Visit all songs in the given directory and all of its
+	 * descendants (excluding mounted databases) which match the
+	 * filter, in the same order as Directory::Walk().
+	 *
+	 * The caller must hold the database lock.  It is released
+	 * briefly between two waves (see class documentation); the
+	 * directories are pinned by #directories meanwhile.
+	 * The visitor is invoked in the calling thread while the
+	 * lock is held.
+	 *
+	 * @param yield if set, this is invoked each time the lock is
+	 * released between two waves
+	 * @return false if another thread is currently using this
+	 * pool (while it has released the lock); the caller shall
+	 * fall back to Directory::Walk() then
+	 */
+	bool Walk(const Directory &directory, const SongFilter &filter,
+		  bool hide_playlist_targets,
+		  const VisitSong &visit_song,
+		  const DatabaseYield &yield={});
+
+private:
+	void StopThreads() noexcept;
+
+	/**
+	 * Append the given directory and its descendants to
+	 * #directories and split them into #shards.
+	 *
+	 * @param n_songs the number of songs in the directories
+	 * which have not yet been assigned to a shard
+	 */
+	void CollectDirectories(const Directory &directory,
+				std::size_t &n_songs);
+
+	/**
+	 * Wait for all workers to finish and discard the current
+	 * search.
+	 */
+	void Finish() noexcept;
+
+	/**
+	 * Wait for the given shard to be finished by a worker and
+	 * pass its matches to the visitor.
+	 *
+	 * Throws the worker's exception or the visitor's exception.
+	 */
+	void VisitShard(Shard &shard, const VisitSong &visit_song);
+
+	/**
+	 * Collect the matching songs of the given shard.  Errors
+	 * are stored in Shard::error.
+	 */
+	void RunShard(Shard &shard) const noexcept;
+
+	void RunWorker() noexcept;
+};
+
+#endif
@@ -12,20 +12,30 @@
 #include "db/UniqueTags.hxx"
 #include "db/VHelper.hxx"
 #include "db/LightDirectory.hxx"
+#include "Arena.hxx"
 #include "Directory.hxx"
 #include "Song.hxx"
+#include "TagIndex.hxx"
+#include "SearchPool.hxx"
 #include "DatabaseSave.hxx"
+#include "DatabaseJournal.hxx"
+#include "BinaryDatabase.hxx"
 #include "db/DatabaseLock.hxx"
 #include "db/DatabaseError.hxx"
 #include "lib/fmt/PathFormatter.hxx"
-#include "fs/io/TextFile.hxx"
+#include "lib/fmt/RuntimeError.hxx"
 #include "io/BufferedOutputStream.hxx"
 #include "io/FileOutputStream.hxx"
+#include "io/FileReader.hxx"
+#include "io/StringOutputStream.hxx"
 #include "fs/FileInfo.hxx"
+#include "fs/Traits.hxx"
+#include "fs/io/TextFile.hxx"
 #include "config/Block.hxx"
 #include "fs/FileSystem.hxx"
 #include "lib/fmt/SystemError.hxx"
 #include "util/CharUtil.hxx"
+#include "util/StringAPI.hxx"
 #include "util/Domain.hxx"
 #include "util/RecursiveMap.hxx"
 #include "Log.hxx"
@@ -36,39 +46,61 @@
 
 #include <cerrno>
 #include <memory>
+#include <string>
 
 static constexpr Domain simple_db_domain("simple_db");
 
+static SimpleDatabase::Format
+ParseFormat(const char *s)
+{
+	if (StringIsEqual(s, "text"))
+		return SimpleDatabase::Format::TEXT;
+	else if (StringIsEqual(s, "binary"))
+		return SimpleDatabase::Format::BINARY;
+	else
+		throw FmtRuntimeError("Unrecognized database format: {}", s);
+}
+
 inline SimpleDatabase::SimpleDatabase(const ConfigBlock &block)
 	:Database(simple_db_plugin),
 	 path(block.GetPath("path")),
+	 journal_path(nullptr),
 #ifdef ENABLE_ZLIB
 	 compress(block.GetBlockValue("compress", true)),
 #endif
+	 format(ParseFormat(block.GetBlockValue("format", "text"))),
+	 journal(block.GetBlockValue("journal", false)),
 	 hide_playlist_targets(block.GetBlockValue("hide_playlist_targets", true)),
+	 search_threads(block.GetPositiveValue("search_threads", 1U)),
 	 cache_path(block.GetPath("cache_directory"))
 {
 	if (path.IsNull())
 		throw std::runtime_error("No \"path\" parameter specified");
 
 	path_utf8 = path.ToUTF8();
+	journal_path = path + PATH_LITERAL(".journal");
 }
 
-inline SimpleDatabase::SimpleDatabase(AllocatedPath &&_path,
+SimpleDatabase::SimpleDatabase(AllocatedPath &&_path,
 #ifndef ENABLE_ZLIB
 				      [[maybe_unused]]
 #endif
-				      bool _compress) noexcept
+				      bool _compress,
+				      Format _format) noexcept
 	:Database(simple_db_plugin),
 	 path(std::move(_path)),
 	 path_utf8(path.ToUTF8()),
+	 journal_path(path + PATH_LITERAL(".journal")),
 #ifdef ENABLE_ZLIB
 	 compress(_compress),
 #endif
+	 format(_format),
 	 cache_path(nullptr)
 {
 }
 
+SimpleDatabase::~SimpleDatabase() noexcept = default;
+
 DatabasePtr
 SimpleDatabase::Create(EventLoop &, EventLoop &,
 		       [[maybe_unused]] DatabaseListener &listener,
@@ -132,15 +164,80 @@ SimpleDatabase::Load()
 	assert(!path.IsNull());
 	assert(root != nullptr);
 
-	TextFile file(path);
-
 	LogDebug(simple_db_domain, "reading DB");
 
-	db_load_internal(file, *root);
+	db_load_file(path, *root);
 
 	FileInfo fi;
-	if (GetFileInfo(path, fi))
+	if (GetFileInfo(path, fi)) {
 		mtime = fi.GetModificationTime();
+		in_sync = LoadJournal(fi);
+	}
+}
+
+/**
+ * Does the given file end with a newline?  If not, its last line was
+ * cut off, even though #LineReader returns it like a complete one.
+ */
+static bool
+EndsWithNewline(Path path)
+{
+	FileReader reader(path);
+	const auto size = reader.GetSize();
+	if (size == 0)
+		return true;
+
+	reader.Seek(size - 1);
+
+	char ch;
+	return reader.Read(&ch, sizeof(ch)) == sizeof(ch) && ch == '\n';
+}
+
+bool
+SimpleDatabase::LoadJournal(const FileInfo &base) noexcept
+{
+	need_full_save = true;
+
+	bool truncated = false;
+
+	FileInfo journal_info;
+	if (GetFileInfo(journal_path, journal_info)) {
+		LogDebug(simple_db_domain, "reading DB journal");
+
+		try {
+			TextFile file(journal_path);
+			switch (db_journal_load(file, *root, base)) {
+			case JournalLoadResult::STALE:
+				LogWarning(simple_db_domain,
+					   "Discarding stale database journal");
+				return false;
+
+			case JournalLoadResult::COMPLETE:
+				truncated = !EndsWithNewline(journal_path);
+				break;
+
+			case JournalLoadResult::TRUNCATED:
+				LogWarning(simple_db_domain,
+					   "Ignoring incomplete record at the end of the database journal");
+				truncated = true;
+				break;
+			}
+		} catch (...) {
+			LogError(std::current_exception(),
+				 "Failed to replay the database journal");
+			return false;
+		}
+
+		mtime = journal_info.GetModificationTime();
+	}
+
+	/* nothing may be appended after an incomplete record; the
+	   next Save() replaces both files */
+	need_full_save = truncated;
+
+	const ScopeDatabaseLock protect;
+	root->ClearDirty();
+	return true;
 }
 
 void
@@ -150,6 +247,7 @@ SimpleDatabase::Open()
 
 	root = Directory::NewRoot();
 	mtime = std::chrono::system_clock::time_point::min();
+	in_sync = false;
 
 #ifndef NDEBUG
 	borrowed_song_count = 0;
@@ -166,6 +264,20 @@ SimpleDatabase::Open()
 
 		root = Directory::NewRoot();
 	}
+
+	LogDebug(simple_db_domain, "building tag index");
+
+	root->tag_index = std::make_unique<TagIndex>();
+	root->tag_index->AddDirectory(*root);
+
+	if (search_threads > 1) {
+		try {
+			search_pool = std::make_unique<SearchPool>(search_threads);
+		} catch (...) {
+			LogError(std::current_exception(),
+				 "Failed to start search threads");
+		}
+	}
 }
 
 void
@@ -175,6 +287,20 @@ SimpleDatabase::Close() noexcept
 	assert(prefixed_light_song == nullptr);
 	assert(borrowed_song_count == 0);
 
+	search_pool.reset();
+
+	/* merge the journal into the database file (unless
+	   loading it has failed; then the database in memory may be
+	   missing data which is still in the files) */
+	if (in_sync && FileExists() && PathExists(journal_path)) {
+		try {
+			SaveFull();
+		} catch (...) {
+			LogError(std::current_exception(),
+				 "Failed to save the database");
+		}
+	}
+
 	delete root;
 }
 
@@ -269,7 +395,8 @@ SimpleDatabase::Visit(const DatabaseSelection &selection,
 
 	if (r.directory->IsMount()) {
 		/* pass the request and the remaining uri to the mounted database */
-		protect.unlock();
+		const ScopeMountWalk mount_walk;
+		const ScopeDatabaseUnlock unlock;
 
 		WalkMount(r.uri, *(r.directory->mounted_database),
 			  r.rest,
@@ -287,10 +414,30 @@ SimpleDatabase::Visit(const DatabaseSelection &selection,
 		if (selection.recursive && visit_directory)
 			visit_directory(r.directory->Export());
 
+		if (selection.filter != nullptr && n_mounts == 0 &&
+		    !visit_directory && !visit_playlist && visit_song &&
+		    root->tag_index->Visit(*r.directory, selection.recursive,
+					   *selection.filter,
+					   hide_playlist_targets,
+					   visit_song)) {
+			helper.Commit();
+			return;
+		}
+
+		if (selection.filter != nullptr && search_pool &&
+		    selection.recursive && n_mounts == 0 &&
+		    !visit_directory && !visit_playlist && visit_song &&
+		    search_pool->Walk(*r.directory, *selection.filter,
+				      hide_playlist_targets, visit_song,
+				      selection.yield)) {
+			helper.Commit();
+			return;
+		}
+
 		r.directory->Walk(selection.recursive, selection.filter,
 				  hide_playlist_targets,
 				  visit_directory, visit_song,
-				  visit_playlist);
+				  visit_playlist, selection.yield);
 		helper.Commit();
 		return;
 	}
@@ -317,43 +464,43 @@ RecursiveMap<std::string>
 SimpleDatabase::CollectUniqueTags(const DatabaseSelection &selection,
 				  std::span<const TagType> tag_types) const
 {
+	if (!selection.IsFiltered() && selection.recursive &&
+	    selection.window.IsAll() && !tag_types.empty()) {
+		RecursiveMap<std::string> result;
+
+		const ScopeDatabaseLock protect;
+		if (n_mounts == 0 &&
+		    root->tag_index->CollectUniqueTags(*root, result,
+						       tag_types,
+						       hide_playlist_targets))
+			return result;
+	}
+
 	return ::CollectUniqueTags(*this, selection, tag_types);
 }
 
 DatabaseStats
 SimpleDatabase::GetStats(const DatabaseSelection &selection) const
 {
-	return ::GetStats(*this, selection);
+	auto stats = ::GetStats(*this, selection);
+	stats.memory_size = db_arena_size();
+	return stats;
 }
 
-void
-SimpleDatabase::Save()
+inline void
+SimpleDatabase::SaveText(OutputStream &os)
 {
-	{
-		const ScopeDatabaseLock protect;
-
-		LogDebug(simple_db_domain, "removing empty directories from DB");
-		root->PruneEmpty();
-
-		LogDebug(simple_db_domain, "sorting DB");
-		root->Sort();
-	}
-
-	LogDebug(simple_db_domain, "writing DB");
-
-	FileOutputStream fos(path);
-
-	OutputStream *os = &fos;
+	OutputStream *os2 = &os;
 
 #ifdef ENABLE_ZLIB
 	std::unique_ptr<GzipOutputStream> gzip;
 	if (compress) {
-		gzip = std::make_unique<GzipOutputStream>(*os);
-		os = gzip.get();
+		gzip = std::make_unique<GzipOutputStream>(*os2);
+		os2 = gzip.get();
 	}
 #endif
 
-	BufferedOutputStream bos(*os);
+	BufferedOutputStream bos(*os2);
 
 	db_save_internal(bos, *root);
 
@@ -365,12 +512,113 @@ SimpleDatabase::Save()
 		gzip.reset();
 	}
 #endif
+}
+
+void
+SimpleDatabase::SaveJournal(const FileInfo &base, bool create)
+{
+	LogDebug(simple_db_domain, "writing DB journal");
+
+	/* if anything goes wrong, the journal may be incomplete, and
+	   the next Save() needs to write everything */
+	need_full_save = true;
+
+	/* serialize the records into memory, so clients are not
+	   blocked by the database lock while the file is written */
+	StringOutputStream sos;
+
+	{
+		BufferedOutputStream bos(sos);
+
+		if (create)
+			db_journal_save_header(bos, base);
+
+		{
+			const ScopeDatabaseLock protect;
+			db_journal_save(bos, *root);
+		}
+
+		bos.Flush();
+	}
+
+	const std::string &records = sos.GetValue();
+
+	FileOutputStream fos(journal_path,
+			     FileOutputStream::Mode::APPEND_OR_CREATE);
+	fos.Write(records.data(), records.size());
+	fos.Commit();
+
+	need_full_save = false;
+
+	FileInfo fi;
+	if (GetFileInfo(journal_path, fi))
+		mtime = fi.GetModificationTime();
+}
+
+void
+SimpleDatabase::Save()
+{
+	{
+		const ScopeDatabaseLock protect;
+
+		LogDebug(simple_db_domain, "removing empty directories from DB");
+		root->PruneEmpty();
+
+		LogDebug(simple_db_domain, "sorting DB");
+		root->Sort();
+	}
+
+	if (journal && !need_full_save) {
+		/* append to the journal until it grows larger than
+		   the database file; then compact both into a new
+		   database file */
+		FileInfo base, journal_info;
+		if (GetFileInfo(path, base)) {
+			const bool create = !GetFileInfo(journal_path,
+							 journal_info);
+			if (create || journal_info.GetSize() < base.GetSize()) {
+				SaveJournal(base, create);
+				return;
+			}
+
+			LogDebug(simple_db_domain, "compacting DB journal");
+		}
+	}
+
+	SaveFull();
+}
+
+void
+SimpleDatabase::SaveFull()
+{
+	LogDebug(simple_db_domain, "writing DB");
+
+	FileOutputStream fos(path);
+
+	if (format == Format::BINARY) {
+		/* not compressed, because the binary format is meant
+		   to be mapped into memory */
+		BufferedOutputStream bos(fos);
+		db_save_binary(bos, *root);
+		bos.Flush();
+	} else
+		SaveText(fos);
 
 	fos.Commit();
 
 	FileInfo fi;
 	if (GetFileInfo(path, fi))
 		mtime = fi.GetModificationTime();
+
+	/* the journal is now obsolete */
+	if (PathExists(journal_path))
+		RemoveFile(journal_path);
+
+	need_full_save = false;
+	in_sync = true;
+
+	const ScopeDatabaseLock protect;
+	root->ClearDirty();
 }
 
 void
@@ -396,6 +644,7 @@ SimpleDatabase::Mount(const char *uri, DatabasePtr db)
 
 	Directory *mnt = r.directory->CreateChild(r.rest);
 	mnt->mounted_database = std::move(db);
+	++n_mounts;
 }
 
 static constexpr bool
@@ -426,7 +675,7 @@ SimpleDatabase::Mount(const char *local_uri, const char *storage_uri)
 	constexpr bool compress = false;
 #endif
 	auto db = std::make_unique<SimpleDatabase>(cache_path / name_fs,
-						   compress);
+						   compress, format);
 	db->Open();
 
 	bool exists = db->FileExists();
@@ -441,6 +690,9 @@ SimpleDatabase::LockUmountSteal(const char *uri) noexcept
 {
 	ScopeDatabaseLock protect;
 
+	/* another thread may be visiting a mounted database */
+	WaitMountWalks();
+
 	auto r = root->LookupDirectory(uri);
 	if (r.rest.data() != nullptr || !r.directory->IsMount())
 		return nullptr;
@@ -448,6 +700,9 @@ SimpleDatabase::LockUmountSteal(const char *uri) noexcept
 	auto db = std::move(r.directory->mounted_database);
 	r.directory->Delete();
 
+	assert(n_mounts > 0);
+	--n_mounts;
+
 	return db;
 }
 
@@ -464,6 +719,6 @@ SimpleDatabase::Unmount(const char *uri) noexcept
 
 constexpr DatabasePlugin simple_db_plugin = {
 	"simple",
-	DatabasePlugin::FLAG_REQUIRE_STORAGE,
+	DatabasePlugin::FLAG_REQUIRE_STORAGE|DatabasePlugin::FLAG_THREAD_SAFE|DatabasePlugin::FLAG_YIELD,
 	SimpleDatabase::Create,
 };
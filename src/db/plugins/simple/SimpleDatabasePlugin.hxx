@@ -12,6 +12,8 @@
 #include "config.h"
 
 #include <cassert>
+#include <cstdint>
+#include <memory>
 
 struct ConfigBlock;
 struct Directory;
@@ -19,17 +21,82 @@ struct DatabasePlugin;
 class EventLoop;
 class DatabaseListener;
 class PrefixedLightSong;
+class OutputStream;
+class FileInfo;
+class SearchPool;
 
 class SimpleDatabase : public Database {
+public:
+	/**
+	 * The file format used by Save().  Load() auto-detects the
+	 * format.
+	 */
+	enum class Format : uint8_t {
+		/**
+		 * The traditional line-based text format
+		 * (optionally gzip-compressed).
+		 */
+		TEXT,
+
+		/**
+		 * A binary image which is mapped into memory for
+		 * loading; see BinaryDatabase.hxx.
+		 */
+		BINARY,
+	};
+
+private:
 	AllocatedPath path;
 	std::string path_utf8;
 
+	/**
+	 * The path of the journal file (see DatabaseJournal.hxx).  It
+	 * is replayed by Load() even if #journal is disabled.
+	 */
+	AllocatedPath journal_path;
+
 #ifdef ENABLE_ZLIB
 	bool compress;
 #endif
 
+	Format format;
+
+	/**
+	 * Shall Save() append modified directories to the journal
+	 * instead of rewriting the whole database file?
+	 */
+	bool journal = false;
+
+	/**
+	 * If true, the next Save() rewrites the whole database file
+	 * even if #journal is enabled, e.g. because the journal could
+	 * not be replayed or written.
+	 */
+	bool need_full_save = true;
+
+	/**
+	 * Does the database in memory match the database file plus
+	 * the journal?  This is false if loading the database file or
+	 * replaying the journal has failed.  Only then may Close()
+	 * merge the journal into the database file; otherwise, the
+	 * files are left alone.
+	 */
+	bool in_sync = false;
+
 	bool hide_playlist_targets;
 
+	/**
+	 * The number of threads evaluating search filters (setting
+	 * "search_threads").
+	 */
+	unsigned search_threads = 1;
+
+	/**
+	 * Evaluates search filters in parallel if #search_threads is
+	 * larger than 1.  Only available while the database is open.
+	 */
+	std::unique_ptr<SearchPool> search_pool;
+
 	/**
 	 * The path where cache files for Mount() are located.
 	 */
@@ -37,6 +104,13 @@ class SimpleDatabase : public Database {
 
 	Directory *root;
 
+	/**
+	 * The number of databases mounted with Mount().  Searches
+	 * are not answered from the #TagIndex while there are any,
+	 * because it doesn't cover them.
+	 */
+	unsigned n_mounts = 0;
+
 	std::chrono::system_clock::time_point mtime;
 
 	/**
@@ -56,7 +130,9 @@ class SimpleDatabase : public Database {
 
 public:
 	SimpleDatabase(const ConfigBlock &block);
-	SimpleDatabase(AllocatedPath &&_path, bool _compress) noexcept;
+	SimpleDatabase(AllocatedPath &&_path, bool _compress,
+		       Format _format) noexcept;
+	~SimpleDatabase() noexcept override;
 
 	static DatabasePtr Create(EventLoop &main_event_loop,
 				  EventLoop &io_event_loop,
@@ -127,11 +203,40 @@ private:
 
 	void Check() const;
 
+	void SaveText(OutputStream &os);
+
+	/**
+	 * Rewrite the whole database file and delete the journal.
+	 *
+	 * Throws on error.
+	 */
+	void SaveFull();
+
+	/**
+	 * Append all modified directories to the journal.
+	 *
+	 * Throws on error.
+	 *
+	 * @param base the current database file
+	 * @param create true if the journal does not exist yet
+	 */
+	void SaveJournal(const FileInfo &base, bool create);
+
 	/**
 	 * Throws #std::runtime_error on error.
 	 */
 	void Load();
 
+	/**
+	 * Replay the journal (if one exists) after the database file
+	 * has been loaded.
+	 *
+	 * @param base the database file
+	 * @return true on success (or if there is no journal), false
+	 * if the journal is stale or could not be replayed
+	 */
+	bool LoadJournal(const FileInfo &base) noexcept;
+
 	DatabasePtr LockUmountSteal(const char *uri) noexcept;
 };
 
@@ -14,9 +14,16 @@
 
 using std::string_view_literals::operator""sv;
 
-Song::Song(DetachedSong &&other, Directory &_parent) noexcept
+static_assert(alignof(Song) <= DB_ARENA_ALIGNMENT);
+
+Song::Song(std::string_view _filename, Directory &_parent)
+	:parent(_parent), filename(_parent.arena, _filename)
+{
+}
+
+Song::Song(DetachedSong &&other, Directory &_parent)
 	:parent(_parent),
-	 filename(other.GetURI()),
+	 filename(_parent.arena, other.GetURI()),
 	 tag(std::move(other.WritableTag())),
 	 mtime(other.GetLastModified()),
 	 start_time(other.GetStartTime()),
@@ -25,6 +32,18 @@ Song::Song(DetachedSong &&other, Directory &_parent) noexcept
 {
 }
 
+SongPtr
+Song::New(std::string_view filename, Directory &parent)
+{
+	return SongPtr{new(parent.arena) Song(filename, parent)};
+}
+
+SongPtr
+Song::New(DetachedSong &&other, Directory &parent)
+{
+	return SongPtr{new(parent.arena) Song(std::move(other), parent)};
+}
+
 const char *
 Song::GetFilenameSuffix() const noexcept
 {
@@ -37,7 +56,7 @@ std::string
 Song::GetURI() const noexcept
 {
 	if (parent.IsRoot())
-		return filename;
+		return std::string{filename};
 	else {
 		const char *path = parent.GetPath();
 		return PathTraitsUTF8::Build(path, filename);
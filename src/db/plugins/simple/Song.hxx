@@ -5,6 +5,7 @@
 #define MPD_SONG_HXX
 
 #include "Ptr.hxx"
+#include "Arena.hxx"
 #include "Chrono.hxx"
 #include "tag/Tag.hxx"
 #include "pcm/AudioFormat.hxx"
@@ -36,7 +37,7 @@ struct Song : IntrusiveListHook<> {
 	/**
 	 * The file name.
 	 */
-	std::string filename;
+	ArenaString filename;
 
 	/**
 	 * If non-empty, then this object does not describe a file
@@ -79,11 +80,32 @@ struct Song : IntrusiveListHook<> {
 	 */
 	bool in_playlist = false;
 
-	template<typename F>
-	Song(F &&_filename, Directory &_parent) noexcept
-		:parent(_parent), filename(std::forward<F>(_filename)) {}
+	Song(std::string_view _filename, Directory &_parent);
 
-	Song(DetachedSong &&other, Directory &_parent) noexcept;
+	Song(DetachedSong &&other, Directory &_parent);
+
+	/**
+	 * Allocate a new #Song in the arena generation of the given
+	 * directory.
+	 *
+	 * Throws std::bad_alloc on error.
+	 */
+	static SongPtr New(std::string_view filename, Directory &parent);
+	static SongPtr New(DetachedSong &&other, Directory &parent);
+
+	/* all songs live in the database arena, see
+	   db_arena_allocate() */
+	static void *operator new(std::size_t size, ArenaGeneration &arena) {
+		return db_arena_allocate(arena, size);
+	}
+
+	static void operator delete(void *p, ArenaGeneration &) noexcept {
+		db_arena_free(p, sizeof(Song));
+	}
+
+	static void operator delete(void *p, std::size_t size) noexcept {
+		db_arena_free(p, size);
+	}
 
 	[[gnu::pure]]
 	const char *GetFilenameSuffix() const noexcept;
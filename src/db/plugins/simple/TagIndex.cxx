@@ -0,0 +1,441 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "TagIndex.hxx"
+#include "Directory.hxx"
+#include "Song.hxx"
+#include "ExportedSong.hxx"
+#include "db/UniqueTags.hxx"
+#include "song/Filter.hxx"
+#include "song/TagSongFilter.hxx"
+#include "tag/Tag.hxx"
+#include "tag/Mask.hxx"
+#include "tag/Fallback.hxx"
+#include "util/RecursiveMap.hxx"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_set>
+
+/**
+ * These tags are (almost) unique per song; indexing them would cost
+ * a lot of memory for little gain, because they are rarely used as
+ * an exact "find" criterion.
+ */
+static constexpr TagMask unindexed_tags = TagMask(TAG_TITLE) |
+	TAG_TITLE_SORT | TAG_COMMENT |
+	TAG_MUSICBRAINZ_TRACKID | TAG_MUSICBRAINZ_RELEASETRACKID;
+
+static constexpr bool
+IsIndexed(TagType type) noexcept
+{
+	return !unindexed_tags.Test(type);
+}
+
+/**
+ * Are the given tag type and all of its fallbacks indexed?
+ */
+[[gnu::const]]
+static bool
+IsIndexedWithFallback(TagType type) noexcept
+{
+	return !ApplyTagWithFallback(type, [](TagType t){
+		return !IsIndexed(t);
+	});
+}
+
+[[gnu::pure]]
+static TagMask
+GetTagMask(const Tag &tag) noexcept
+{
+	auto mask = TagMask::None();
+	for (const auto &item : tag)
+		mask.Set(item.type);
+	return mask;
+}
+
+/**
+ * Determine which tag type provides the value for the given type,
+ * i.e. the type itself or the first fallback which is present.
+ *
+ * @return the tag type or #TAG_NUM_OF_ITEM_TYPES if there is none
+ */
+[[gnu::pure]]
+static TagType
+FindTagWithFallback(TagMask present, TagType type) noexcept
+{
+	TagType result = TAG_NUM_OF_ITEM_TYPES;
+	ApplyTagWithFallback(type, [present, &result](TagType t){
+		if (!present.Test(t))
+			return false;
+
+		result = t;
+		return true;
+	});
+	return result;
+}
+
+static bool
+IsVisible(const Song &song, bool hide_playlist_targets) noexcept
+{
+	return !hide_playlist_targets || !song.in_playlist;
+}
+
+void
+TagIndex::AddDirectory(const Directory &directory) noexcept
+{
+	for (const auto &song : directory.songs)
+		Add(song);
+
+	for (const auto &child : directory.children)
+		AddDirectory(child);
+}
+
+void
+TagIndex::RemoveDirectory(const Directory &directory) noexcept
+{
+	for (const auto &song : directory.songs)
+		Remove(song);
+
+	for (const auto &child : directory.children)
+		RemoveDirectory(child);
+}
+
+/**
+ * Remove one pointer from an unordered #std::vector.
+ */
+template<typename T>
+static void
+UnorderedErase(std::vector<T> &v, T value) noexcept
+{
+	auto i = std::find(v.begin(), v.end(), value);
+	assert(i != v.end());
+	if (i == v.end())
+		return;
+
+	/* the order doesn't matter, so instead of erase(), move
+	   the last element into the gap */
+	*i = v.back();
+	v.pop_back();
+}
+
+void
+TagIndex::Add(const Song &song) noexcept
+{
+	if (!song.target.empty()) {
+		with_target.push_back(&song);
+		return;
+	}
+
+	for (const auto &item : song.tag) {
+		if (!IsIndexed(item.type))
+			continue;
+
+		auto &map = values[item.type];
+		auto i = map.find(std::string_view{item.value});
+		if (i == map.end())
+			i = map.emplace(item.value, Posting{}).first;
+
+		i->second.push_back(&song);
+	}
+
+	const auto present = GetTagMask(song.tag);
+	for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i) {
+		if (FindTagWithFallback(present, TagType(i)) != TAG_NUM_OF_ITEM_TYPES)
+			++n_with_value[i];
+		else if (without_value[i])
+			without_value[i]->push_back(&song);
+	}
+
+	++n_songs;
+}
+
+void
+TagIndex::Remove(const Song &song, const Tag &tag) noexcept
+{
+	if (!song.target.empty()) {
+		UnorderedErase(with_target, &song);
+		return;
+	}
+
+	for (const auto &item : tag) {
+		if (!IsIndexed(item.type))
+			continue;
+
+		auto &map = values[item.type];
+		auto i = map.find(std::string_view{item.value});
+		assert(i != map.end());
+		if (i == map.end())
+			continue;
+
+		auto &posting = i->second;
+		UnorderedErase(posting, &song);
+		if (posting.empty())
+			map.erase(i);
+	}
+
+	const auto present = GetTagMask(tag);
+	for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i) {
+		if (FindTagWithFallback(present, TagType(i)) != TAG_NUM_OF_ITEM_TYPES)
+			--n_with_value[i];
+		else if (without_value[i])
+			UnorderedErase(*without_value[i], &song);
+	}
+
+	assert(n_songs > 0);
+	--n_songs;
+}
+
+void
+TagIndex::Remove(const Song &song) noexcept
+{
+	Remove(song, song.tag);
+}
+
+inline bool
+TagIndex::IsUsable(const TagSongFilter &f) const noexcept
+{
+	/* negations and empty values match songs which are missing
+	   the tag, and those are not in the index; case folding,
+	   regular expressions and substrings can't be looked up in a
+	   hash table */
+	return f.GetTagType() < TAG_NUM_OF_ITEM_TYPES &&
+		IsIndexedWithFallback(f.GetTagType()) &&
+		!f.IsNegated() && !f.GetValue().empty() &&
+		!f.GetFoldCase() && !f.IsRegex() &&
+		(f.GetPosition() == StringFilter::Position::FULL ||
+		 f.GetPosition() == StringFilter::Position::PREFIX);
+}
+
+template<typename F>
+inline void
+TagIndex::ForEachPosting(const TagSongFilter &f, F &&function) const
+{
+	const std::string_view value = f.GetValue();
+	const bool prefix = f.GetPosition() == StringFilter::Position::PREFIX;
+
+	/* the filter falls back to other tags if the song doesn't
+	   have the specified one, so those need to be looked up as
+	   well; TagSongFilter::Match() sorts out the false
+	   positives */
+	ApplyTagWithFallback(f.GetTagType(), [&](TagType type){
+		const auto &map = values[type];
+
+		if (prefix) {
+			for (const auto &[key, posting] : map)
+				if (key.starts_with(value))
+					function(posting);
+		} else if (const auto i = map.find(value); i != map.end())
+			function(i->second);
+
+		return false;
+	});
+}
+
+inline std::size_t
+TagIndex::CountCandidates(const TagSongFilter &f) const noexcept
+{
+	std::size_t n = 0;
+	ForEachPosting(f, [&n](const Posting &posting){
+		n += posting.size();
+	});
+	return n;
+}
+
+using SongSet = std::unordered_set<const Song *>;
+using DirectorySet = std::unordered_set<const Directory *>;
+
+/**
+ * Like Directory::Walk(), but only descend into the given
+ * directories and only visit the given songs.
+ */
+static void
+WalkCandidates(const Directory &directory, bool recursive,
+	       const SongSet &songs, const DirectorySet &directories,
+	       const SongFilter &filter, bool hide_playlist_targets,
+	       const VisitSong &visit_song)
+{
+	for (const auto &song : directory.songs) {
+		if (!songs.contains(&song) ||
+		    !IsVisible(song, hide_playlist_targets))
+			continue;
+
+		const auto song2 = song.Export();
+		if (filter.Match(song2))
+			visit_song(song2);
+	}
+
+	if (!recursive)
+		return;
+
+	for (const auto &child : directory.children)
+		if (directories.contains(&child))
+			WalkCandidates(child, recursive,
+				       songs, directories,
+				       filter, hide_playlist_targets,
+				       visit_song);
+}
+
+bool
+TagIndex::Visit(const Directory &base, bool recursive,
+		const SongFilter &filter,
+		bool hide_playlist_targets,
+		const VisitSong &visit_song) const
+{
+	/* pick the most selective criterion; the other ones are
+	   checked by SongFilter::Match() on the candidates */
+	const TagSongFilter *best = nullptr;
+	std::size_t best_count = 0;
+
+	for (const auto &i : filter.GetItems()) {
+		const auto *f = dynamic_cast<const TagSongFilter *>(i.get());
+		if (f == nullptr || !IsUsable(*f))
+			continue;
+
+		const std::size_t count = CountCandidates(*f);
+		if (best == nullptr || count < best_count) {
+			best = f;
+			best_count = count;
+		}
+	}
+
+	/* if the index doesn't narrow the search down considerably,
+	   a plain Directory::Walk() is cheaper */
+	if (best == nullptr ||
+	    best_count + with_target.size() > (n_songs + with_target.size()) / 2)
+		return false;
+
+	SongSet songs;
+	songs.reserve(best_count + with_target.size());
+
+	/* all directories containing a candidate, and all of their
+	   ancestors */
+	DirectorySet directories;
+
+	const auto add_candidates = [&songs, &directories](const Posting &posting){
+		for (const Song *song : posting) {
+			if (!songs.insert(song).second)
+				continue;
+
+			for (const Directory *d = &song->parent;
+			     d != nullptr && directories.insert(d).second;
+			     d = d->parent) {}
+		}
+	};
+
+	ForEachPosting(*best, add_candidates);
+	add_candidates(with_target);
+
+	if (directories.contains(&base))
+		WalkCandidates(base, recursive, songs, directories,
+			       filter, hide_playlist_targets, visit_song);
+
+	return true;
+}
+
+/**
+ * Add all songs below the given #Directory which have no value for
+ * the given tag type to the #std::vector.
+ */
+static void
+CollectWithoutValue(std::vector<const Song *> &dest,
+		    const Directory &directory, TagType type)
+{
+	for (const auto &song : directory.songs)
+		/* songs with a target are not indexed */
+		if (song.target.empty() &&
+		    FindTagWithFallback(GetTagMask(song.tag),
+					type) == TAG_NUM_OF_ITEM_TYPES)
+			dest.push_back(&song);
+
+	for (const auto &child : directory.children)
+		CollectWithoutValue(dest, child, type);
+}
+
+const TagIndex::Posting &
+TagIndex::GetWithoutValue(const Directory &root, TagType type) const
+{
+	auto &posting = without_value[type];
+	if (!posting) {
+		auto p = std::make_unique<Posting>();
+
+		/* if all songs have a value, the list stays
+		   empty and the tree doesn't need to be scanned */
+		if (n_with_value[type] < n_songs) {
+			p->reserve(n_songs - n_with_value[type]);
+			CollectWithoutValue(*p, root, type);
+		}
+
+		assert(p->size() == n_songs - n_with_value[type]);
+		posting = std::move(p);
+	}
+
+	return *posting;
+}
+
+bool
+TagIndex::CollectUniqueTags(const Directory &root,
+			    RecursiveMap<std::string> &result,
+			    std::span<const TagType> tag_types,
+			    bool hide_playlist_targets) const
+{
+	assert(!tag_types.empty());
+
+	const TagType type = tag_types.front();
+	const auto rest = tag_types.subspan(1);
+
+	if (type >= TAG_NUM_OF_ITEM_TYPES ||
+	    !IsIndexedWithFallback(type))
+		return false;
+
+	/* songs without a value are collected as empty string */
+	RecursiveMap<std::string> *empty = nullptr;
+	for (const Song *song : GetWithoutValue(root, type)) {
+		if (!IsVisible(*song, hide_playlist_targets))
+			continue;
+
+		if (empty == nullptr)
+			empty = &result[""];
+
+		if (rest.empty())
+			break;
+
+		::CollectUniqueTags(*empty, song->tag, rest);
+	}
+
+	ApplyTagWithFallback(type, [&](TagType t){
+		for (const auto &[value, posting] : values[t]) {
+			RecursiveMap<std::string> *sub = nullptr;
+
+			for (const Song *song : posting) {
+				if (!IsVisible(*song, hide_playlist_targets))
+					continue;
+
+				/* a song contributes to a fallback
+				   tag only if it lacks all preferred
+				   ones */
+				if (t != type &&
+				    FindTagWithFallback(GetTagMask(song->tag),
+							type) != t)
+					continue;
+
+				if (sub == nullptr)
+					sub = &result[value];
+
+				if (rest.empty())
+					break;
+
+				::CollectUniqueTags(*sub, song->tag, rest);
+			}
+		}
+
+		return false;
+	});
+
+	for (const Song *song : with_target)
+		if (IsVisible(*song, hide_playlist_targets))
+			::CollectUniqueTags(result, song->Export().tag,
+					    tag_types);
+
+	return true;
+}
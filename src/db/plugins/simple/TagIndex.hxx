@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_TAG_INDEX_HXX
+#define MPD_TAG_INDEX_HXX
+
+#include "db/Visitor.hxx"
+#include "tag/Type.hxx"
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct Tag;
+struct Song;
+struct Directory;
+class SongFilter;
+class TagSongFilter;
+template<typename Key> class RecursiveMap;
+
+/**
+ * An inverted index which maps tag values to the songs containing
+ * them.  It allows SimpleDatabase to answer "find" and "list"
+ * requests without evaluating the #SongFilter on every single
+ * #Song.
+ *
+ * The index is owned by the root #Directory (see
+ * Directory::tag_index) and is updated by Directory::AddSong(),
+ * Directory::RemoveSong(), Directory::Delete() and
+ * Directory::SongTagChanged().
+ *
+ * All methods must be called with the #db_mutex locked.
+ */
+class TagIndex {
+	struct Hash {
+		using is_transparent = void;
+
+		[[gnu::pure]]
+		std::size_t operator()(std::string_view value) const noexcept {
+			return std::hash<std::string_view>{}(value);
+		}
+	};
+
+	/**
+	 * All songs which contain a certain tag value, in no
+	 * particular order.
+	 */
+	using Posting = std::vector<const Song *>;
+
+	using ValueMap = std::unordered_map<std::string, Posting,
+					    Hash, std::equal_to<>>;
+
+	std::array<ValueMap, TAG_NUM_OF_ITEM_TYPES> values;
+
+	/**
+	 * For each tag type, the number of songs which have a value
+	 * for it (possibly from a fallback tag).
+	 */
+	std::array<std::size_t, TAG_NUM_OF_ITEM_TYPES> n_with_value{};
+
+	/**
+	 * For each tag type, the songs which have no value for it
+	 * (not even from a fallback tag), or nullptr if this list has
+	 * not been built yet.  Most songs lack most tags, so these
+	 * lists are created only for tag types which were requested
+	 * by CollectUniqueTags(), and are kept up to date from then
+	 * on.
+	 */
+	mutable std::array<std::unique_ptr<Posting>,
+			   TAG_NUM_OF_ITEM_TYPES> without_value;
+
+	/**
+	 * The number of songs in #values.
+	 */
+	std::size_t n_songs = 0;
+
+	/**
+	 * Songs with a Song::target are not in #values, because
+	 * Song::Export() merges the tags of the target song into
+	 * theirs; they are candidates for every query.
+	 */
+	Posting with_target;
+
+public:
+	TagIndex() noexcept = default;
+	TagIndex(const TagIndex &) = delete;
+	TagIndex &operator=(const TagIndex &) = delete;
+
+	/**
+	 * Add all songs of the given #Directory (recursively).
+	 */
+	void AddDirectory(const Directory &directory) noexcept;
+
+	/**
+	 * Remove all songs of the given #Directory (recursively).
+	 */
+	void RemoveDirectory(const Directory &directory) noexcept;
+
+	void Add(const Song &song) noexcept;
+
+	/**
+	 * Remove a song which was indexed with the given #Tag (which
+	 * may differ from the song's current tag).
+	 */
+	void Remove(const Song &song, const Tag &tag) noexcept;
+
+	void Remove(const Song &song) noexcept;
+
+	/**
+	 * Invoke #visit_song for all songs below #base which match
+	 * the filter, in the same order as Directory::Walk().
+	 *
+	 * @return false if the filter cannot be answered from the
+	 * index efficiently (e.g. regular expressions, case folding
+	 * or too many candidates); the caller should fall back to
+	 * Directory::Walk() then
+	 */
+	bool Visit(const Directory &base, bool recursive,
+		   const SongFilter &filter,
+		   bool hide_playlist_targets,
+		   const VisitSong &visit_song) const;
+
+	/**
+	 * Collect the unique tag values of the whole database, like
+	 * the generic CollectUniqueTags() does for an unfiltered
+	 * #DatabaseSelection.  Songs without a value are collected as
+	 * empty string.
+	 *
+	 * @param root the root #Directory which owns this index
+	 * @return false if this request cannot be answered from the
+	 * index (because the first tag type is not indexed)
+	 */
+	bool CollectUniqueTags(const Directory &root,
+			       RecursiveMap<std::string> &result,
+			       std::span<const TagType> tag_types,
+			       bool hide_playlist_targets) const;
+
+private:
+	[[gnu::pure]]
+	bool IsUsable(const TagSongFilter &f) const noexcept;
+
+	/**
+	 * Invoke the given function for each #Posting which may
+	 * contain songs matching the given filter (which must be
+	 * IsUsable()).
+	 */
+	template<typename F>
+	void ForEachPosting(const TagSongFilter &f, F &&function) const;
+
+	[[gnu::pure]]
+	std::size_t CountCandidates(const TagSongFilter &f) const noexcept;
+
+	/**
+	 * Returns the #without_value list for the given tag type,
+	 * building it if necessary.
+	 */
+	const Posting &GetWithoutValue(const Directory &root,
+				       TagType type) const;
+};
+
+#endif
@@ -78,11 +78,15 @@ UpdateWalk::UpdateArchiveTree(ArchiveFile &archive, Directory &directory,
 					  directory.GetPath(), name);
 			}
 		} else {
+			const Tag old_tag = song->tag;
 			if (!song->UpdateFileInArchive(archive)) {
 				FmtDebug(update_domain,
 					 "deleting unrecognized file {}/{}",
 					 directory.GetPath(), name);
 				editor.LockDeleteSong(directory, song);
+			} else {
+				const ScopeDatabaseLock protect;
+				directory.SongTagChanged(*song, old_tag);
 			}
 		}
 	}
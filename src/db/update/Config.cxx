@@ -3,10 +3,14 @@
 
 #include "Config.hxx"
 #include "config/Data.hxx"
+#include "config/Block.hxx"
 #include "config/Option.hxx"
 
 UpdateConfig::UpdateConfig(const ConfigData &config)
 {
+	if (const auto *block = config.GetBlock(ConfigBlockOption::DATABASE))
+		n_threads = block->GetPositiveValue("update_threads", n_threads);
+
 #ifndef _WIN32
 	follow_inside_symlinks =
 		config.GetBool(ConfigOption::FOLLOW_INSIDE_SYMLINKS,
@@ -15,7 +19,5 @@ UpdateConfig::UpdateConfig(const ConfigData &config)
 	follow_outside_symlinks =
 		config.GetBool(ConfigOption::FOLLOW_OUTSIDE_SYMLINKS,
 			       DEFAULT_FOLLOW_OUTSIDE_SYMLINKS);
-#else
-	(void)config;
 #endif
 }
@@ -7,6 +7,13 @@
 struct ConfigData;
 
 struct UpdateConfig {
+	/**
+	 * The number of threads which scan song files in parallel
+	 * (setting "update_threads" in the "database" block).  With
+	 * only one, the update thread scans all files itself.
+	 */
+	unsigned n_threads = 1;
+
 #ifndef _WIN32
 	static constexpr bool DEFAULT_FOLLOW_INSIDE_SYMLINKS = true;
 	static constexpr bool DEFAULT_FOLLOW_OUTSIDE_SYMLINKS = true;
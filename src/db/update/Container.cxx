@@ -2,6 +2,7 @@
 // Copyright The Music Player Daemon Project
 
 #include "Walk.hxx"
+#include "SongScan.hxx"
 #include "UpdateDomain.hxx"
 #include "song/DetachedSong.hxx"
 #include "db/DatabaseLock.hxx"
@@ -14,66 +15,73 @@
 #include "storage/FileInfo.hxx"
 #include "Log.hxx"
 
+#include <cassert>
+
 bool
-UpdateWalk::UpdateContainerFile(Directory &directory,
-				std::string_view name, std::string_view suffix,
-				const StorageFileInfo &info) noexcept
+UpdateWalk::PrepareContainerFile(SongScanJob &job, std::string_view suffix,
+				 const StorageFileInfo &info) noexcept
 {
-	const DecoderPlugin *_plugin = decoder_plugins_find([suffix](const DecoderPlugin &plugin){
-			return plugin.SupportsContainerSuffix(suffix);
+	const DecoderPlugin *plugin = decoder_plugins_find([suffix](const DecoderPlugin &p){
+			return p.SupportsContainerSuffix(suffix);
 		});
-	if (_plugin == nullptr)
-		return false;
-	const DecoderPlugin &plugin = *_plugin;
+	if (plugin == nullptr)
+		return true;
 
 	Directory *contdir;
 	{
 		const ScopeDatabaseLock protect;
-		contdir = MakeVirtualDirectoryIfModified(directory, name,
+		contdir = MakeVirtualDirectoryIfModified(job.directory, job.name,
 							 info,
 							 DEVICE_CONTAINER);
 		if (contdir == nullptr)
 			/* not modified */
-			return true;
+			return false;
 	}
 
-	const auto pathname = storage.MapFS(contdir->GetPath());
+	auto pathname = storage.MapFS(contdir->GetPath());
 	if (pathname.IsNull()) {
 		/* not a local file: skip, because the container API
 		   supports only local files */
 		editor.LockDeleteDirectory(contdir);
-		return false;
+		return true;
 	}
 
-	try {
-		auto v = plugin.container_scan(pathname);
-		if (v.empty()) {
-			editor.LockDeleteDirectory(contdir);
-			return false;
-		}
+	job.container_plugin = plugin;
+	job.contdir = contdir;
+	job.container_path = std::move(pathname);
+	return true;
+}
+
+bool
+UpdateWalk::UpdateContainerFile(SongScanJob &job) noexcept
+{
+	Directory *const contdir = job.contdir;
+	assert(contdir != nullptr);
 
-		for (auto &vtrack : v) {
-			auto song = std::make_unique<Song>(std::move(vtrack),
-							   *contdir);
+	if (job.container_error)
+		LogError(job.container_error);
 
-			// shouldn't be necessary but it's there..
-			song->mtime = info.mtime;
+	if (job.tracks.empty()) {
+		editor.LockDeleteDirectory(contdir);
+		return false;
+	}
 
-			FmtNotice(update_domain, "added {}/{}",
-				  contdir->GetPath(),
-				  song->filename);
+	for (auto &vtrack : job.tracks) {
+		auto song = Song::New(std::move(vtrack), *contdir);
 
-			{
-				const ScopeDatabaseLock protect;
-				contdir->AddSong(std::move(song));
-			}
+		// shouldn't be necessary but it's there..
+		song->mtime = job.mtime;
 
-			modified = true;
+		FmtNotice(update_domain, "added {}/{}",
+			  contdir->GetPath(),
+			  song->filename.c_str());
+
+		{
+			const ScopeDatabaseLock protect;
+			contdir->AddSong(std::move(song));
 		}
-	} catch (...) {
-		LogError(std::current_exception());
-		editor.LockDeleteDirectory(contdir);
-		return false;
+
+		modified = true;
 	}
 
 	return true;
@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_INOTIFY_LISTENER_HXX
+#define MPD_INOTIFY_LISTENER_HXX
+
+/**
+ * An object that receives the directories which need to be updated
+ * from #InotifyUpdate.
+ *
+ * @see #InotifyQueue
+ */
+class InotifyListener {
+public:
+	/**
+	 * A directory has been modified.  This is called in the
+	 * #EventLoop thread.
+	 *
+	 * @param uri_utf8 the URI of the directory relative to the
+	 * music directory; an empty string means the music directory
+	 * itself
+	 */
+	virtual void OnInotifyModified(const char *uri_utf8) noexcept = 0;
+};
+
+#endif
@@ -4,6 +4,7 @@
 #ifndef MPD_INOTIFY_QUEUE_HXX
 #define MPD_INOTIFY_QUEUE_HXX
 
+#include "InotifyListener.hxx"
 #include "event/CoarseTimerEvent.hxx"
 
 #include <list>
@@ -11,7 +12,7 @@
 
 class UpdateService;
 
-class InotifyQueue final {
+class InotifyQueue final : public InotifyListener {
 	UpdateService &update;
 
 	std::list<std::string> queue;
@@ -27,6 +28,11 @@ public:
 
 private:
 	void OnDelay() noexcept;
+
+	/* virtual methods from class InotifyListener */
+	void OnInotifyModified(const char *uri_utf8) noexcept override {
+		Enqueue(uri_utf8);
+	}
 };
 
 #endif
@@ -2,8 +2,11 @@
 // Copyright The Music Player Daemon Project
 
 #include "InotifyUpdate.hxx"
+#include "InotifyListener.hxx"
 #include "InotifyDomain.hxx"
 #include "ExcludeList.hxx"
+#include "db/DatabaseLock.hxx"
+#include "db/plugins/simple/Directory.hxx"
 #include "lib/fmt/ExceptionFormatter.hxx"
 #include "lib/fmt/PathFormatter.hxx"
 #include "storage/StorageInterface.hxx"
@@ -14,12 +17,16 @@
 #include "fs/FileInfo.hxx"
 #include "fs/Traits.hxx"
 #include "thread/Mutex.hxx"
+#include "thread/Name.hxx"
+#include "thread/Util.hxx"
+#include "time/ChronoUtil.hxx"
 #include "Log.hxx"
 
 #include <cassert>
 #include <cstring>
 #include <forward_list>
 #include <string>
+#include <utility>
 
 #include <sys/inotify.h>
 #include <dirent.h>
@@ -144,10 +151,46 @@ SkipFilename(Path name) noexcept
 		name.HasNewline();
 }
 
+bool
+InotifyUpdate::CheckModified(const WatchDirectory &directory,
+			     const FileInfo &fi) noexcept
+try {
+	assert(db_root != nullptr);
+
+	std::string uri;
+	if (const auto uri_fs = directory.GetUriFS(); !uri_fs.IsNull()) {
+		uri = uri_fs.ToUTF8();
+		if (uri.empty())
+			return false;
+	}
+
+	{
+		const ScopeDatabaseLock protect;
+		const auto lr = db_root->LookupDirectory(uri);
+		if (lr.rest.data() != nullptr || lr.directory->IsMount())
+			/* not in the database; if it was created
+			   after the last update, then the parent
+			   directory has been modified as well */
+			return false;
+
+		const auto mtime = lr.directory->mtime;
+		if (IsNegative(mtime) || mtime == fi.GetModificationTime())
+			return false;
+	}
+
+	FmtDebug(inotify_domain, "modified since last update: '{}'", uri);
+	modified_directories.emplace_front(std::move(uri));
+	return true;
+} catch (...) {
+	LogError(std::current_exception());
+	return false;
+}
+
 void
 InotifyUpdate::RecursiveWatchSubdirectories(WatchDirectory &parent,
 					    const Path path_fs,
-					    unsigned depth) noexcept
+					    unsigned depth,
+					    bool check_db) noexcept
 try {
 	assert(depth <= max_depth);
 	assert(!path_fs.IsNull());
@@ -158,7 +201,7 @@ try {
 		return;
 
 	DirectoryReader dir(path_fs);
-	while (dir.ReadEntry()) {
+	while (!cancel_scan && dir.ReadEntry()) {
 		int ret;
 
 		const Path name_fs = dir.GetEntry();
@@ -203,7 +246,13 @@ try {
 
 		AddToMap(*child);
 
-		RecursiveWatchSubdirectories(*child, child_path_fs, depth);
+		/* once a directory is known to be modified, its
+		   whole subtree will be updated, so there's no need
+		   to check the subdirectories */
+		const bool modified = check_db && CheckModified(*child, fi);
+
+		RecursiveWatchSubdirectories(*child, child_path_fs, depth,
+					     check_db && !modified);
 	}
 } catch (...) {
 	LogError(std::current_exception());
@@ -221,33 +270,93 @@ WatchDirectory::GetDepth() const noexcept
 	return depth;
 }
 
-inline
-InotifyUpdate::InotifyUpdate(EventLoop &loop, UpdateService &update,
-			     unsigned _max_depth)
+InotifyUpdate::InotifyUpdate(EventLoop &loop, InotifyListener &_listener,
+			     unsigned _max_depth, Directory *_db_root)
 	:inotify_event(loop, *this),
-	 queue(loop, update),
-	 max_depth(_max_depth)
+	 listener(_listener),
+	 max_depth(_max_depth),
+	 db_root(_db_root),
+	 scan_thread(BIND_THIS_METHOD(RunScan)),
+	 scan_done_event(loop, BIND_THIS_METHOD(OnScanDone))
 {
 }
 
-InotifyUpdate::~InotifyUpdate() noexcept = default;
+InotifyUpdate::~InotifyUpdate() noexcept
+{
+	if (scan_thread.IsDefined()) {
+		cancel_scan = true;
+		scan_thread.Join();
+	}
+}
 
-inline void
+void
 InotifyUpdate::Start(Path path)
 {
 	int descriptor = inotify_event.AddWatch(path.c_str(), IN_MASK);
 
 	root = std::make_unique<WatchDirectory>(path, descriptor);
-	root->LoadExcludeList(path);
 
 	AddToMap(*root);
 
-	RecursiveWatchSubdirectories(*root, path, 0);
+	scan_thread.Start();
+}
+
+void
+InotifyUpdate::RunScan() noexcept
+{
+	SetThreadName("inotify");
+	SetThreadIdlePriority();
+
+	const Path path = root->name;
+	root->LoadExcludeList(path);
+
+	bool check_db = db_root != nullptr;
+	if (check_db) {
+		try {
+			check_db = !CheckModified(*root, FileInfo{path});
+		} catch (...) {
+			LogError(std::current_exception());
+			check_db = false;
+		}
+	}
+
+	RecursiveWatchSubdirectories(*root, path, 0, check_db);
+
+	scan_done_event.Schedule();
+}
+
+void
+InotifyUpdate::OnScanDone() noexcept
+{
+	scan_thread.Join();
+
+	FmtDebug(inotify_domain, "watching {} directories",
+		 directories.size());
+
+	for (const auto &uri : modified_directories)
+		listener.OnInotifyModified(uri.c_str());
+	modified_directories.clear();
+
+	/* now handle the events which were received during the
+	   scan */
+	try {
+		for (const auto &[wd, mask] : std::exchange(pending_events, {}))
+			OnInotify(wd, mask, nullptr);
+	} catch (...) {
+		LogError(std::current_exception());
+	}
 }
 
 void
 InotifyUpdate::OnInotify(int wd, unsigned mask, const char *)
 {
+	if (scan_thread.IsDefined()) {
+		/* the initial scan is still running and owns the
+		   WatchDirectory tree; postpone this event */
+		pending_events[wd] |= mask;
+		return;
+	}
+
 	auto i = directories.find(wd);
 	if (i == directories.end())
 		return;
@@ -272,7 +381,7 @@ InotifyUpdate::OnInotify(int wd, unsigned mask, const char *)
 			: (root_path / uri_fs);
 
 		RecursiveWatchSubdirectories(directory, path_fs,
-					     directory.GetDepth());
+					     directory.GetDepth(), false);
 	}
 
 	if ((mask & (IN_CLOSE_WRITE|IN_MOVE|IN_DELETE)) != 0 ||
@@ -286,10 +395,10 @@ InotifyUpdate::OnInotify(int wd, unsigned mask, const char *)
 		if (!uri_fs.IsNull()) {
 			const std::string uri_utf8 = uri_fs.ToUTF8();
 			if (!uri_utf8.empty())
-				queue.Enqueue(uri_utf8.c_str());
+				listener.OnInotifyModified(uri_utf8.c_str());
 		}
 		else
-			queue.Enqueue("");
+			listener.OnInotifyModified("");
 	}
 }
 
@@ -300,8 +409,8 @@ InotifyUpdate::OnInotifyError(std::exception_ptr error) noexcept
 }
 
 std::unique_ptr<InotifyUpdate>
-mpd_inotify_init(EventLoop &loop, Storage &storage, UpdateService &update,
-		 unsigned max_depth)
+mpd_inotify_init(EventLoop &loop, Storage &storage, InotifyListener &listener,
+		 unsigned max_depth, Directory *db_root)
 {
 	LogDebug(inotify_domain, "initializing inotify");
 
@@ -311,10 +420,11 @@ mpd_inotify_init(EventLoop &loop, Storage &storage, UpdateService &update,
 		return {};
 	}
 
-	auto iu = std::make_unique<InotifyUpdate>(loop, update, max_depth);
+	auto iu = std::make_unique<InotifyUpdate>(loop, listener, max_depth,
+						  db_root);
 	iu->Start(path);
 
-	LogDebug(inotify_domain, "watching music directory");
+	LogDebug(inotify_domain, "scanning music directory");
 
 	return iu;
 }
@@ -4,44 +4,115 @@
 #ifndef MPD_INOTIFY_UPDATE_HXX
 #define MPD_INOTIFY_UPDATE_HXX
 
-#include "InotifyQueue.hxx"
 #include "event/InotifyEvent.hxx"
+#include "event/InjectEvent.hxx"
+#include "thread/Thread.hxx"
 
+#include <atomic>
+#include <forward_list>
 #include <map>
 #include <memory>
+#include <string>
 
 class Path;
+class FileInfo;
 class Storage;
+class InotifyListener;
+struct Directory;
 struct WatchDirectory;
 
 /**
- * Glue code between InotifySource and InotifyQueue.
+ * Glue code between InotifySource and an #InotifyListener (usually
+ * #InotifyQueue).
+ *
+ * The initial registration of all watches happens in a separate
+ * thread, because it may take a long time on large music
+ * directories.  During this scan, the modification times of all
+ * directories are compared with the ones stored in the database, and
+ * changed directories are updated.
  */
 class InotifyUpdate final : InotifyHandler {
 	InotifyEvent inotify_event;
-	InotifyQueue queue;
+	InotifyListener &listener;
 
 	const unsigned max_depth;
 
+	/**
+	 * The root of the database which is compared with the file
+	 * system by the initial scan; nullptr if there is nothing to
+	 * compare with (e.g. because a full update has been
+	 * scheduled already).
+	 */
+	Directory *const db_root;
+
 	std::unique_ptr<WatchDirectory> root;
 	std::map<int, WatchDirectory *> directories;
 
+	/**
+	 * This thread registers the initial watches.  While it is
+	 * running, it owns #root and #directories.
+	 */
+	Thread scan_thread;
+
+	/**
+	 * Notifies the #EventLoop thread that #scan_thread has
+	 * finished.
+	 */
+	InjectEvent scan_done_event;
+
+	/**
+	 * Set by the destructor to make #scan_thread quit early.
+	 */
+	std::atomic_bool cancel_scan = false;
+
+	/**
+	 * Inotify events which were received while #scan_thread was
+	 * running (watch descriptor to event mask).  They are
+	 * handled after the scan has finished.
+	 */
+	std::map<int, unsigned> pending_events;
+
+	/**
+	 * Directories (relative URIs) which were found to be modified
+	 * by #scan_thread.
+	 */
+	std::forward_list<std::string> modified_directories;
+
 public:
-	InotifyUpdate(EventLoop &loop, UpdateService &update,
-		      unsigned _max_depth);
+	InotifyUpdate(EventLoop &loop, InotifyListener &_listener,
+		      unsigned _max_depth, Directory *_db_root);
 	~InotifyUpdate() noexcept;
 
 	void Start(Path path);
 
 private:
+	void RunScan() noexcept;
+	void OnScanDone() noexcept;
+
+	/**
+	 * Compare the modification time of the given directory with
+	 * the one in the database (called by #scan_thread).
+	 *
+	 * @return true if the directory has been modified and an
+	 * update has been scheduled for it
+	 */
+	bool CheckModified(const WatchDirectory &directory,
+			   const FileInfo &fi) noexcept;
+
 	void AddToMap(WatchDirectory &directory) noexcept;
 	void RemoveFromMap(WatchDirectory &directory) noexcept;
 	void Disable(WatchDirectory &directory) noexcept;
 	void Delete(WatchDirectory &directory) noexcept;
 
+	/**
+	 * @param check_db compare the modification times of all
+	 * subdirectories with the database?  (only during the initial
+	 * scan)
+	 */
 	void RecursiveWatchSubdirectories(WatchDirectory &parent,
 					  Path path_fs,
-					  unsigned depth) noexcept;
+					  unsigned depth,
+					  bool check_db) noexcept;
 
 private:
 	/* virtual methods from class InotifyHandler */
@@ -51,9 +122,13 @@ private:
 
 /**
  * Throws on error.
+ *
+ * @param db_root the root of the database; if not nullptr, then all
+ * directories whose modification time differs from the one in the
+ * database are updated
  */
 std::unique_ptr<InotifyUpdate>
-mpd_inotify_init(EventLoop &loop, Storage &storage, UpdateService &update,
-		 unsigned max_depth);
+mpd_inotify_init(EventLoop &loop, Storage &storage, InotifyListener &listener,
+		 unsigned max_depth, Directory *db_root);
 
 #endif
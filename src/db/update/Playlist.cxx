@@ -32,17 +32,17 @@ UpdateWalk::UpdatePlaylistFile(Directory &directory,
 		if (!song)
 			break;
 
-		auto db_song = std::make_unique<Song>(std::move(*song),
-						      directory);
+		auto db_song = Song::New(std::move(*song), directory);
 		const bool is_absolute =
 			PathTraitsUTF8::IsAbsoluteOrHasScheme(db_song->filename.c_str());
 		db_song->target = is_absolute
-			? db_song->filename
+			? std::string{db_song->filename}
 			/* prepend "../" to relative paths to go from
 			   the virtual directory (DEVICE_PLAYLIST) to
 			   the containing directory */
-			: "../" + db_song->filename;
-		db_song->filename = fmt::format("track{:04}", ++track);
+			: "../" + std::string{db_song->filename};
+		db_song->filename.Set(directory.arena,
+				      fmt::format("track{:04}", ++track));
 
 		{
 			const ScopeDatabaseLock protect;
@@ -106,8 +106,10 @@ UpdateWalk::UpdatePlaylistFile(Directory &directory,
 	PlaylistInfo pi(name, info.mtime);
 
 	const ScopeDatabaseLock protect;
-	if (directory.playlists.UpdateOrInsert(std::move(pi)))
+	if (directory.playlists.UpdateOrInsert(std::move(pi))) {
+		directory.MarkDirty();
 		modified = true;
+	}
 
 	return true;
 }
@@ -136,7 +138,10 @@ UpdateWalk::PurgeDanglingFromPlaylists(Directory &directory) noexcept
 			} else {
 				/* the target exists: mark it (for
 				   option "hide_playlist_targets") */
-				target->in_playlist = true;
+				if (!target->in_playlist) {
+					target->in_playlist = true;
+					target->parent.MarkDirty();
+				}
 			}
 		}
 	});
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "ScanPool.hxx"
+#include "thread/Name.hxx"
+#include "thread/Util.hxx"
+
+#include <cassert>
+
+UpdateScanPool::UpdateScanPool(unsigned n_threads)
+{
+	assert(n_threads > 0);
+
+	for (unsigned i = 0; i < n_threads; ++i) {
+		threads.emplace_front(BIND_THIS_METHOD(RunWorker));
+
+		try {
+			threads.front().Start();
+		} catch (...) {
+			/* this Thread was never started; remove it
+			   before joining the others */
+			threads.pop_front();
+			StopThreads();
+			throw;
+		}
+	}
+}
+
+UpdateScanPool::~UpdateScanPool() noexcept
+{
+	StopThreads();
+}
+
+void
+UpdateScanPool::StopThreads() noexcept
+{
+	{
+		const std::scoped_lock lock{mutex};
+		quit = true;
+		worker_cond.notify_all();
+	}
+
+	for (auto &thread : threads)
+		thread.Join();
+}
+
+void
+UpdateScanPool::Push(std::unique_ptr<UpdateScanJob> job) noexcept
+{
+	assert(job);
+	assert(!job->done);
+
+	const std::scoped_lock lock{mutex};
+	waiting.push_back(job.get());
+	jobs.push_back(std::move(job));
+	worker_cond.notify_one();
+}
+
+std::unique_ptr<UpdateScanJob>
+UpdateScanPool::Pop(bool wait) noexcept
+{
+	std::unique_lock lock{mutex};
+
+	if (jobs.empty())
+		return nullptr;
+
+	if (wait)
+		done_cond.wait(lock, [this]{ return jobs.front()->done; });
+	else if (!jobs.front()->done)
+		return nullptr;
+
+	auto job = std::move(jobs.front());
+	jobs.pop_front();
+	return job;
+}
+
+inline void
+UpdateScanPool::RunWorker() noexcept
+{
+	SetThreadName("update_scan");
+	SetThreadIdlePriority();
+
+	std::unique_lock lock{mutex};
+
+	while (true) {
+		worker_cond.wait(lock, [this]{
+			return quit || !waiting.empty();
+		});
+
+		if (quit)
+			break;
+
+		auto &job = *waiting.front();
+		waiting.pop_front();
+
+		{
+			const ScopeUnlock unlock(mutex);
+			job.Run();
+		}
+
+		job.done = true;
+		done_cond.notify_all();
+	}
+}
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_UPDATE_SCAN_POOL_HXX
+#define MPD_UPDATE_SCAN_POOL_HXX
+
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+#include "thread/Thread.hxx"
+
+#include <cstddef>
+#include <deque>
+#include <forward_list>
+#include <memory>
+
+/**
+ * A job which is executed by an #UpdateScanPool worker thread.  It
+ * must not modify the database; the results are stored in the job
+ * object and are applied by the update thread after
+ * UpdateScanPool::Pop() has returned it.
+ */
+class UpdateScanJob {
+	friend class UpdateScanPool;
+
+	/**
+	 * Has Run() finished?  Protected by UpdateScanPool::mutex.
+	 */
+	bool done = false;
+
+public:
+	virtual ~UpdateScanJob() noexcept = default;
+
+	/**
+	 * Do the work.  This is called in a worker thread.
+	 */
+	virtual void Run() noexcept = 0;
+};
+
+/**
+ * A pool of threads which run #UpdateScanJob instances in parallel.
+ * The jobs are returned by Pop() in the order they were submitted,
+ * which keeps the result of a database update deterministic,
+ * regardless of which job finishes first.
+ *
+ * Push() and Pop() may only be called by one thread (the update
+ * thread).
+ */
+class UpdateScanPool {
+	Mutex mutex;
+
+	/**
+	 * Signalled when a job has been added to #waiting or when
+	 * #quit has been set.
+	 */
+	Cond worker_cond;
+
+	/**
+	 * Signalled when a job has finished.
+	 */
+	Cond done_cond;
+
+	/**
+	 * All jobs which have not yet been returned by Pop(), in the
+	 * order they were submitted.
+	 */
+	std::deque<std::unique_ptr<UpdateScanJob>> jobs;
+
+	/**
+	 * The jobs which have not yet been picked up by a worker.
+	 */
+	std::deque<UpdateScanJob *> waiting;
+
+	std::forward_list<Thread> threads;
+
+	bool quit = false;
+
+public:
+	/**
+	 * Throws on error.
+	 */
+	explicit UpdateScanPool(unsigned n_threads);
+
+	~UpdateScanPool() noexcept;
+
+	UpdateScanPool(const UpdateScanPool &) = delete;
+	UpdateScanPool &operator=(const UpdateScanPool &) = delete;
+
+	/**
+	 * Returns the number of jobs which have been submitted, but
+	 * have not yet been returned by Pop().
+	 */
+	std::size_t GetSize() noexcept {
+		const std::scoped_lock lock{mutex};
+		return jobs.size();
+	}
+
+	void Push(std::unique_ptr<UpdateScanJob> job) noexcept;
+
+	/**
+	 * Remove the oldest job from the pool and return it.
+	 *
+	 * @param wait if true, then wait for the oldest job to
+	 * finish; if false, return nullptr if it has not yet finished
+	 * @return the job or nullptr if there is none
+	 */
+	std::unique_ptr<UpdateScanJob> Pop(bool wait) noexcept;
+
+private:
+	void StopThreads() noexcept;
+
+	void RunWorker() noexcept;
+};
+
+#endif
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_UPDATE_SONG_SCAN_HXX
+#define MPD_UPDATE_SONG_SCAN_HXX
+
+#include "ScanPool.hxx"
+#include "db/plugins/simple/Ptr.hxx"
+#include "song/DetachedSong.hxx"
+#include "fs/AllocatedPath.hxx"
+
+#include <chrono>
+#include <exception>
+#include <forward_list>
+#include <string>
+#include <string_view>
+
+struct Song;
+struct Directory;
+struct DecoderPlugin;
+class Storage;
+
+/**
+ * Scan the tags of a song file (or the tracks of a container file).
+ * Run() only reads the file and does not touch the database;
+ * UpdateWalk::ApplySongScan() applies the result.
+ */
+struct SongScanJob final : UpdateScanJob {
+	Storage &storage;
+
+	Directory &directory;
+
+	const std::string name;
+
+	const std::chrono::system_clock::time_point mtime;
+
+	/**
+	 * The existing #Song object for this file or nullptr if this
+	 * is a new file.
+	 */
+	Song *const song;
+
+	/**
+	 * If this is not nullptr, then Run() attempts to scan the
+	 * file as a container with this plugin and store the tracks
+	 * in #contdir.
+	 */
+	const DecoderPlugin *container_plugin = nullptr;
+
+	Directory *contdir = nullptr;
+
+	AllocatedPath container_path = nullptr;
+
+	/**
+	 * The result of DecoderPlugin::container_scan().
+	 */
+	std::forward_list<DetachedSong> tracks;
+
+	std::exception_ptr container_error;
+
+	/**
+	 * The result of Song::LoadFile(); nullptr if the file was not
+	 * recognized.
+	 */
+	SongPtr new_song;
+
+	std::exception_ptr error;
+
+	SongScanJob(Storage &_storage, Directory &_directory,
+		    std::string_view _name,
+		    std::chrono::system_clock::time_point _mtime,
+		    Song *_song) noexcept
+		:storage(_storage), directory(_directory),
+		 name(_name), mtime(_mtime), song(_song) {}
+
+	/* virtual methods from UpdateScanJob */
+	void Run() noexcept override;
+};
+
+#endif
@@ -2,6 +2,7 @@
 // Copyright The Music Player Daemon Project
 
 #include "Walk.hxx"
+#include "SongScan.hxx"
 #include "UpdateIO.hxx"
 #include "UpdateDomain.hxx"
 #include "lib/fmt/ExceptionFormatter.hxx"
@@ -9,34 +10,45 @@
 #include "db/plugins/simple/Directory.hxx"
 #include "db/plugins/simple/Song.hxx"
 #include "decoder/DecoderList.hxx"
+#include "decoder/DecoderPlugin.hxx"
 #include "storage/FileInfo.hxx"
 #include "Log.hxx"
 
+#include <cassert>
+#include <utility>
+
 #include <unistd.h>
 
-inline void
-UpdateWalk::UpdateSongFile2(Directory &directory,
-			    std::string_view name, std::string_view suffix,
-			    const StorageFileInfo &info) noexcept
-try {
-	Song *song;
-	{
-		const ScopeDatabaseLock protect;
-		song = directory.FindSong(name);
+void
+SongScanJob::Run() noexcept
+{
+	if (container_plugin != nullptr) {
+		try {
+			tracks = container_plugin->container_scan(container_path);
+			if (!tracks.empty())
+				return;
+		} catch (...) {
+			container_error = std::current_exception();
+		}
 	}
 
-	if (!directory_child_access(storage, directory, name, R_OK)) {
-		FmtError(update_domain,
-			 "no read permissions on {}/{}",
-			 directory.GetPath(), name);
-		if (song != nullptr)
-			editor.LockDeleteSong(directory, song);
-
-		return;
+	try {
+		new_song = Song::LoadFile(storage, name, directory);
+	} catch (...) {
+		error = std::current_exception();
 	}
+}
 
-	if (!(song != nullptr && info.mtime == song->mtime && !walk_discard) &&
-	    UpdateContainerFile(directory, name, suffix, info)) {
+void
+UpdateWalk::ApplySongScan(SongScanJob &job) noexcept
+{
+	auto &directory = job.directory;
+	const std::string_view name = job.name;
+	Song *const song = job.song;
+
+	++n_scanned;
+
+	if (job.contdir != nullptr && UpdateContainerFile(job)) {
 		if (song != nullptr)
 			editor.LockDeleteSong(directory, song);
 
@@ -44,11 +56,14 @@ try {
 	}
 
 	if (song == nullptr) {
-		FmtDebug(update_domain, "reading {}/{}",
-			 directory.GetPath(), name);
+		if (job.error) {
+			FmtError(update_domain,
+				 "error reading file {}/{}: {}",
+				 directory.GetPath(), name, job.error);
+			return;
+		}
 
-		auto new_song = Song::LoadFile(storage, name, directory);
-		if (!new_song) {
+		if (!job.new_song) {
 			FmtDebug(update_domain,
 				 "ignoring unrecognized file {}/{}",
 				 directory.GetPath(), name);
@@ -57,28 +72,115 @@ try {
 
 		{
 			const ScopeDatabaseLock protect;
-			directory.AddSong(std::move(new_song));
+			directory.AddSong(std::move(job.new_song));
 		}
 
 		modified = true;
 		FmtNotice(update_domain, "added {}/{}",
 			  directory.GetPath(), name);
-	} else if (info.mtime != song->mtime || walk_discard) {
+	} else {
 		FmtNotice(update_domain, "updating {}/{}",
 			  directory.GetPath(), name);
-		if (!song->UpdateFile(storage)) {
+
+		if (job.error) {
+			FmtError(update_domain,
+				 "error reading file {}/{}: {}",
+				 directory.GetPath(), name, job.error);
+			return;
+		}
+
+		if (!job.new_song) {
 			FmtDebug(update_domain,
 				 "deleting unrecognized file {}/{}",
 				 directory.GetPath(), name);
 			editor.LockDeleteSong(directory, song);
+		} else {
+			const ScopeDatabaseLock protect;
+			const Tag old_tag = std::exchange(song->tag,
+							  std::move(job.new_song->tag));
+			song->mtime = job.new_song->mtime;
+			song->audio_format = job.new_song->audio_format;
+			directory.SongTagChanged(*song, old_tag);
 		}
 
 		modified = true;
 	}
-} catch (...) {
-	FmtError(update_domain,
-		 "error reading file {}/{}: {}",
-		 directory.GetPath(), name, std::current_exception());
+}
+
+void
+UpdateWalk::ApplySongScans(std::size_t max_pending) noexcept
+{
+	assert(scan_pool);
+
+	while (auto job = scan_pool->Pop(scan_pool->GetSize() > max_pending))
+		ApplySongScan(static_cast<SongScanJob &>(*job));
+}
+
+void
+UpdateWalk::FlushSongScans() noexcept
+{
+	if (scan_pool)
+		ApplySongScans(0);
+}
+
+inline void
+UpdateWalk::SubmitSongScan(std::unique_ptr<SongScanJob> job) noexcept
+{
+	if (!scan_pool) {
+		job->Run();
+		ApplySongScan(*job);
+		return;
+	}
+
+	scan_pool->Push(std::move(job));
+
+	/* apply the results which are already available, and don't
+	   let the queue grow too large (the jobs keep references to
+	   the database, and the results need memory) */
+	ApplySongScans(config.n_threads * 4);
+}
+
+inline void
+UpdateWalk::UpdateSongFile2(Directory &directory,
+			    std::string_view name, std::string_view suffix,
+			    const StorageFileInfo &info) noexcept
+{
+	Song *song;
+	{
+		const ScopeDatabaseLock protect;
+		song = directory.FindSong(name);
+	}
+
+	if (!directory_child_access(storage, directory, name, R_OK)) {
+		FmtError(update_domain,
+			 "no read permissions on {}/{}",
+			 directory.GetPath(), name);
+		if (song != nullptr)
+			editor.LockDeleteSong(directory, song);
+
+		return;
+	}
+
+	if (song != nullptr && info.mtime == song->mtime && !walk_discard)
+		/* not modified */
+		return;
+
+	auto job = std::make_unique<SongScanJob>(storage, directory, name,
+						 info.mtime, song);
+
+	if (!PrepareContainerFile(*job, suffix, info)) {
+		/* unmodified container */
+		if (song != nullptr)
+			editor.LockDeleteSong(directory, song);
+
+		return;
+	}
+
+	if (song == nullptr)
+		FmtDebug(update_domain, "reading {}/{}",
+			 directory.GetPath(), name);
+
+	SubmitSongScan(std::move(job));
 }
 
 bool
@@ -2,6 +2,7 @@
 // Copyright The Music Player Daemon Project
 
 #include "Walk.hxx"
+#include "ScanPool.hxx"
 #include "UpdateIO.hxx"
 #include "Editor.hxx"
 #include "UpdateDomain.hxx"
@@ -22,8 +23,10 @@
 #include "util/UriExtract.hxx"
 #include "Log.hxx"
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <chrono>
 #include <exception>
 #include <memory>
 
@@ -37,8 +40,18 @@ UpdateWalk::UpdateWalk(const UpdateConfig &_config,
 	 storage(_storage),
 	 editor(_loop, _listener)
 {
+	if (config.n_threads > 1) {
+		try {
+			scan_pool = std::make_unique<UpdateScanPool>(config.n_threads);
+		} catch (...) {
+			LogError(std::current_exception(),
+				 "Failed to start the update scanner threads");
+		}
+	}
 }
 
+UpdateWalk::~UpdateWalk() noexcept = default;
+
 static void
 directory_set_stat(Directory &dir, const StorageFileInfo &info)
 {
@@ -112,6 +125,7 @@ UpdateWalk::PurgeDeletedFromDirectory(Directory &directory) noexcept
 		if (!directory_child_is_regular(storage, directory, i->name)) {
 			const ScopeDatabaseLock protect;
 			i = directory.playlists.erase(i);
+			directory.MarkDirty();
 		} else
 			++i;
 	}
@@ -370,7 +384,11 @@ UpdateWalk::UpdateDirectory(Directory &directory,
 		UpdateDirectoryChild(directory, child_exclude_list, name_utf8, info2);
 	}
 
-	directory.mtime = info.mtime;
+	if (directory.mtime != info.mtime) {
+		const ScopeDatabaseLock protect;
+		directory.mtime = info.mtime;
+		directory.MarkDirty();
+	}
 
 	return true;
 }
@@ -494,6 +512,10 @@ UpdateWalk::Walk(Directory &root, const char *path, bool discard) noexcept
 {
 	walk_discard = discard;
 	modified = false;
+	n_scanned = 0;
+
+	using Clock = std::chrono::steady_clock;
+	const auto start_time = Clock::now();
 
 	if (path != nullptr && !isRootDirectory(path)) {
 		UpdateUri(root, path);
@@ -513,6 +535,17 @@ UpdateWalk::Walk(Directory &root, const char *path, bool discard) noexcept
 		UpdateDirectory(root, exclude_list, info);
 	}
 
+	FlushSongScans();
+
+	if (n_scanned > 0) {
+		const std::chrono::duration<double> duration =
+			Clock::now() - start_time;
+		FmtNotice(update_domain,
+			  "scanned {} files in {:.1f} s ({:.0f} files/s)",
+			  n_scanned, duration.count(),
+			  n_scanned / std::max(duration.count(), 0.001));
+	}
+
 	{
 		const ScopeDatabaseLock protect;
 		PurgeDanglingFromPlaylists(root);
@@ -9,6 +9,8 @@
 #include "config.h"
 
 #include <atomic>
+#include <cstddef>
+#include <memory>
 #include <string_view>
 
 struct StorageFileInfo;
@@ -19,6 +21,9 @@ class SongEnumerator;
 class ArchiveFile;
 class Storage;
 class ExcludeList;
+class UpdateScanPool;
+struct DecoderPlugin;
+struct SongScanJob;
 
 class UpdateWalk final {
 #ifdef ENABLE_ARCHIVE
@@ -41,10 +46,23 @@ class UpdateWalk final {
 
 	DatabaseEditor editor;
 
+	/**
+	 * The worker threads which scan song files in parallel; only
+	 * present if UpdateConfig::n_threads is larger than one.
+	 */
+	std::unique_ptr<UpdateScanPool> scan_pool;
+
+	/**
+	 * The number of song files which were scanned during this
+	 * Walk() call (for the statistics in the log).
+	 */
+	unsigned n_scanned;
+
 public:
 	UpdateWalk(const UpdateConfig &_config,
 		   EventLoop &_loop, DatabaseListener &_listener,
 		   Storage &_storage) noexcept;
+	~UpdateWalk() noexcept;
 
 	/**
 	 * Cancel the current update and quit the Walk() method as
@@ -78,6 +96,31 @@ private:
 	 */
 	void PurgeDanglingFromPlaylists(Directory &directory) noexcept;
 
+	/**
+	 * Scan a song file, either in this thread or by submitting
+	 * it to the #scan_pool.
+	 */
+	void SubmitSongScan(std::unique_ptr<SongScanJob> job) noexcept;
+
+	/**
+	 * Apply the result of a #SongScanJob to the database.
+	 */
+	void ApplySongScan(SongScanJob &job) noexcept;
+
+	/**
+	 * Apply all finished #SongScanJob instances from the
+	 * #scan_pool (in the order they were submitted), and wait
+	 * until there are no more than the given number of pending
+	 * jobs.
+	 */
+	void ApplySongScans(std::size_t max_pending) noexcept;
+
+	/**
+	 * Wait for all pending #SongScanJob instances and apply
+	 * them.  This must be called before Walk() returns.
+	 */
+	void FlushSongScans() noexcept;
+
 	void UpdateSongFile2(Directory &directory,
 			     std::string_view name, std::string_view suffix,
 			     const StorageFileInfo &info) noexcept;
@@ -86,10 +129,25 @@ private:
 			    std::string_view name, std::string_view suffix,
 			    const StorageFileInfo &info) noexcept;
 
-	bool UpdateContainerFile(Directory &directory,
-				 std::string_view name, std::string_view suffix,
-				 const StorageFileInfo &info) noexcept;
+	/**
+	 * If the file is a container, create its virtual directory
+	 * and prepare the #SongScanJob for calling
+	 * DecoderPlugin::container_scan().
+	 *
+	 * @return false if the container is unmodified and nothing
+	 * needs to be scanned
+	 */
+	bool PrepareContainerFile(SongScanJob &job, std::string_view suffix,
+				  const StorageFileInfo &info) noexcept;
 
+	/**
+	 * Apply the result of a container_scan() call which was done
+	 * by SongScanJob::Run().
+	 *
+	 * @return true if the container has been added; false if the
+	 * file shall be treated like a regular song file
+	 */
+	bool UpdateContainerFile(SongScanJob &job) noexcept;
 
 #ifdef ENABLE_ARCHIVE
 	void UpdateArchiveTree(ArchiveFile &archive, Directory &parent,
@@ -39,6 +39,11 @@ DecoderBridge::~DecoderBridge() noexcept
 {
 	/* caller must flush the chunk */
 	assert(current_chunk == nullptr);
+
+	if (copied_bytes > 0 || direct_bytes > 0)
+		FmtDebug(decoder_domain,
+			 "decoded {} bytes, {} of them copied into the music pipe",
+			 copied_bytes + direct_bytes, copied_bytes);
 }
 
 InputStreamPtr
@@ -243,6 +248,33 @@ DecoderBridge::UpdateStreamTag(InputStream *is) noexcept
 	return true;
 }
 
+DecoderCommand
+DecoderBridge::SendStreamTag(InputStream *is) noexcept
+{
+	if (!UpdateStreamTag(is))
+		return DecoderCommand::NONE;
+
+	if (decoder_tag != nullptr)
+		/* merge with tag from decoder plugin */
+		return DoSendTag(Tag::Merge(*decoder_tag, *stream_tag));
+	else
+		/* send only the stream tag */
+		return DoSendTag(*stream_tag);
+}
+
+uint64_t
+DecoderBridge::GetRemainingFrames() const noexcept
+{
+	if (!dc.end_time.IsPositive())
+		return UINT64_MAX;
+
+	const auto end_frame =
+		dc.end_time.ToScale<uint64_t>(dc.in_audio_format.sample_rate);
+	return end_frame > absolute_frame
+		? end_frame - absolute_frame
+		: 0;
+}
+
 void
 DecoderBridge::Ready(const AudioFormat audio_format,
 		     bool seekable, SignedSongTime duration) noexcept
@@ -454,20 +486,9 @@ DecoderBridge::SubmitAudio(InputStream *is,
 
 	/* send stream tags */
 
-	if (UpdateStreamTag(is)) {
-		if (decoder_tag != nullptr)
-			/* merge with tag from decoder plugin */
-			cmd = DoSendTag(Tag::Merge(*decoder_tag,
-						   *stream_tag));
-		else
-			/* send only the stream tag */
-			cmd = DoSendTag(*stream_tag);
-
-		if (cmd != DecoderCommand::NONE)
-			return cmd;
-	}
-
-	cmd = DecoderCommand::NONE;
+	cmd = SendStreamTag(is);
+	if (cmd != DecoderCommand::NONE)
+		return cmd;
 
 	const size_t frame_size = dc.in_audio_format.GetFrameSize();
 	size_t data_frames = audio.size() / frame_size;
@@ -475,12 +496,10 @@ DecoderBridge::SubmitAudio(InputStream *is,
 	if (dc.end_time.IsPositive()) {
 		/* enforce the given end time */
 
-		const auto end_frame =
-			dc.end_time.ToScale<uint64_t>(dc.in_audio_format.sample_rate);
-		if (absolute_frame >= end_frame)
+		const uint64_t remaining_frames = GetRemainingFrames();
+		if (remaining_frames == 0)
 			return DecoderCommand::STOP;
 
-		const uint64_t remaining_frames = end_frame - absolute_frame;
 		if (data_frames >= remaining_frames) {
 			/* past the end of the range: truncate this
 			   data submission and stop the decoder */
@@ -541,6 +560,7 @@ DecoderBridge::SubmitAudio(InputStream *is,
 		}
 
 		audio = audio.subspan(nbytes);
+		copied_bytes += nbytes;
 
 		timestamp += dc.out_audio_format.SizeToTime<FloatDuration>(nbytes);
 	}
@@ -550,6 +570,84 @@ DecoderBridge::SubmitAudio(InputStream *is,
 	return cmd;
 }
 
+std::span<std::byte>
+DecoderBridge::GetAudioBuffer(InputStream *is) noexcept
+{
+	assert(dc.state == DecoderState::DECODE);
+	assert(dc.pipe != nullptr);
+
+	if (convert != nullptr)
+		/* the data needs to be converted, which copies it
+		   anyway */
+		return {};
+
+	/* let SubmitAudio() deal with commands */
+	if (LockGetVirtualCommand() != DecoderCommand::NONE)
+		return {};
+
+	assert(!initial_seek_pending);
+	assert(!initial_seek_running);
+
+	if (SendStreamTag(is) != DecoderCommand::NONE)
+		return {};
+
+	const uint64_t remaining_frames = GetRemainingFrames();
+	if (remaining_frames == 0)
+		return {};
+
+	while (true) {
+		auto *chunk = GetChunk();
+		if (chunk == nullptr)
+			return {};
+
+		auto dest =
+			chunk->Write(dc.out_audio_format,
+				     SongTime::Cast(timestamp) -
+				     dc.song->GetStartTime(),
+				     0);
+		if (dest.empty()) {
+			/* the chunk is full, flush it */
+			FlushChunk();
+			continue;
+		}
+
+		/* don't let the decoder write past the end time */
+		const size_t frame_size = dc.out_audio_format.GetFrameSize();
+		if (dest.size() / frame_size > remaining_frames)
+			dest = dest.first(remaining_frames * frame_size);
+
+		return dest;
+	}
+}
+
+DecoderCommand
+DecoderBridge::SubmitAudioBuffer(std::size_t nbytes,
+				 uint16_t kbit_rate) noexcept
+{
+	assert(dc.state == DecoderState::DECODE);
+	assert(convert == nullptr);
+	assert(current_chunk != nullptr);
+	assert(nbytes % dc.out_audio_format.GetFrameSize() == 0);
+
+	if (current_chunk->length == 0)
+		/* GetAudioBuffer() didn't know the bit rate yet */
+		current_chunk->bit_rate = kbit_rate;
+
+	if (current_chunk->Expand(dc.out_audio_format, nbytes))
+		/* the chunk is full, flush it */
+		FlushChunk();
+
+	timestamp += dc.out_audio_format.SizeToTime<FloatDuration>(nbytes);
+	absolute_frame += nbytes / dc.out_audio_format.GetFrameSize();
+	direct_bytes += nbytes;
+
+	if (dc.end_time.IsPositive() && GetRemainingFrames() == 0)
+		/* the end of the range has been reached */
+		return DecoderCommand::STOP;
+
+	return LockGetVirtualCommand();
+}
+
 DecoderCommand
 DecoderBridge::SubmitTag(InputStream *is, Tag &&tag) noexcept
 {
@@ -42,6 +42,13 @@ private:
 	 */
 	uint64_t absolute_frame = 0;
 
+	/**
+	 * Statistics: the number of bytes copied into chunks by
+	 * SubmitAudio() and the number of bytes written directly by
+	 * the decoder plugin (GetAudioBuffer()).
+	 */
+	uint64_t copied_bytes = 0, direct_bytes = 0;
+
 	/**
 	 * Is the initial seek (to the start position of the sub-song)
 	 * pending, or has it been performed already?
@@ -164,6 +171,9 @@ public:
 	DecoderCommand SubmitAudio(InputStream *is,
 				   std::span<const std::byte> audio,
 				   uint16_t kbit_rate) noexcept override;
+	std::span<std::byte> GetAudioBuffer(InputStream *is) noexcept override;
+	DecoderCommand SubmitAudioBuffer(std::size_t nbytes,
+					 uint16_t kbit_rate) noexcept override;
 	DecoderCommand SubmitTag(InputStream *is, Tag &&tag) noexcept override;
 	void SubmitReplayGain(const ReplayGainInfo *replay_gain_info) noexcept override;
 	void SubmitMixRamp(MixRampInfo &&mix_ramp) noexcept override;
@@ -190,6 +200,19 @@ private:
 	DecoderCommand DoSendTag(const Tag &tag) noexcept;
 
 	bool UpdateStreamTag(InputStream *is) noexcept;
+
+	/**
+	 * Send the stream tag if it has changed.  Helper for
+	 * SubmitAudio() and GetAudioBuffer().
+	 */
+	DecoderCommand SendStreamTag(InputStream *is) noexcept;
+
+	/**
+	 * Returns the number of frames which may still be submitted
+	 * before the configured end time is reached.
+	 */
+	[[gnu::pure]]
+	uint64_t GetRemainingFrames() const noexcept;
 };
 
 #endif
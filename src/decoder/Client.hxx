@@ -8,6 +8,7 @@
 #include "Chrono.hxx"
 #include "input/Ptr.hxx"
 
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <span>
@@ -142,6 +143,48 @@ public:
 		return SubmitAudio(is, audio_bytes, kbit_rate);
 	}
 
+	/**
+	 * Obtain a buffer where the decoder plugin may write PCM data
+	 * (in the audio format passed to Ready()) directly, which
+	 * avoids the copy done by SubmitAudio().  After writing, call
+	 * SubmitAudioBuffer().  Other than Read(), no method may be
+	 * called in between.
+	 *
+	 * This is only possible if the data does not need to be
+	 * converted and if no command is pending.  If this returns an
+	 * empty span, the decoder plugin shall fall back to
+	 * SubmitAudio(), which reports the command.
+	 *
+	 * @param is an input stream which is buffering while we are waiting
+	 * for the player
+	 * @return a writable buffer whose size is a multiple of the
+	 * frame size, or an empty span
+	 */
+	virtual std::span<std::byte> GetAudioBuffer([[maybe_unused]] InputStream *is) noexcept {
+		return {};
+	}
+
+	std::span<std::byte> GetAudioBuffer(InputStream &is) noexcept {
+		return GetAudioBuffer(&is);
+	}
+
+	/**
+	 * Commit data which was written to the buffer returned by
+	 * GetAudioBuffer().
+	 *
+	 * @param nbytes the number of bytes written (a multiple of the
+	 * frame size, may be zero)
+	 * @return the current command, or DecoderCommand::NONE if there is no
+	 * command pending
+	 */
+	virtual DecoderCommand SubmitAudioBuffer([[maybe_unused]] std::size_t nbytes,
+						 [[maybe_unused]] uint16_t kbit_rate) noexcept {
+		/* cannot be reached, because the default
+		   GetAudioBuffer() never returns a buffer */
+		assert(false);
+		return GetCommand();
+	}
+
 	/**
 	 * This function is called by the decoder plugin when it has
 	 * successfully decoded a tag.
@@ -10,6 +10,7 @@
 #include "Log.hxx"
 #include "input/InputStream.hxx"
 
+#include <algorithm>
 #include <exception>
 
 bool
@@ -120,6 +121,38 @@ FlacDecoder::GetDeltaPosition(const FLAC__StreamDecoder &sd)
 	return nbytes;
 }
 
+inline size_t
+FlacDecoder::ImportDirect(const FLAC__int32 *const buf[],
+			  size_t n_frames) noexcept
+{
+	auto *client = GetClient();
+	if (client == nullptr || !tag.IsEmpty())
+		/* the tag must be submitted first */
+		return 0;
+
+	const size_t frame_size = pcm_import.GetAudioFormat().GetFrameSize();
+
+	size_t offset = 0;
+	while (offset < n_frames) {
+		const auto dest = client->GetAudioBuffer(GetInputStream());
+		if (dest.empty())
+			break;
+
+		const size_t n = std::min(dest.size() / frame_size,
+					  n_frames - offset);
+		pcm_import.Import(dest.data(), buf, offset, n);
+		offset += n;
+
+		command = client->SubmitAudioBuffer(n * frame_size, kbit_rate);
+		if (command != DecoderCommand::NONE)
+			/* discard the rest of this frame and let the
+			   decoder loop handle the command */
+			return n_frames;
+	}
+
+	return offset;
+}
+
 FLAC__StreamDecoderWriteStatus
 FlacDecoder::OnWrite(const FLAC__Frame &frame,
 		     const FLAC__int32 *const buf[],
@@ -128,10 +161,16 @@ FlacDecoder::OnWrite(const FLAC__Frame &frame,
 	if (!initialized && !OnFirstFrame(frame.header))
 		return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
 
-	chunk = pcm_import.Import(buf, frame.header.blocksize);
-
 	kbit_rate = nbytes * 8 * frame.header.sample_rate /
 		(1000 * frame.header.blocksize);
 
+	const size_t n_frames = frame.header.blocksize;
+	const size_t offset = ImportDirect(buf, n_frames);
+
+	/* whatever could not be written directly is submitted
+	   later by the decoder loop */
+	if (offset < n_frames)
+		chunk = pcm_import.Import(buf, offset, n_frames - offset);
+
 	return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
 }
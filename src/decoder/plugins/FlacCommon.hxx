@@ -51,6 +51,13 @@ struct FlacDecoder : public FlacInput {
 	 */
 	std::span<const std::byte> chunk = {};
 
+	/**
+	 * A command returned by DecoderClient::SubmitAudioBuffer()
+	 * inside our libFLAC write callback which shall be handled
+	 * by the decoder loop.
+	 */
+	DecoderCommand command = DecoderCommand::NONE;
+
 	FlacDecoder(DecoderClient &_client,
 		    InputStream &_input_stream) noexcept
 		:FlacInput(_input_stream, &_client) {}
@@ -74,6 +81,15 @@ struct FlacDecoder : public FlacInput {
 	FLAC__uint64 GetDeltaPosition(const FLAC__StreamDecoder &sd);
 
 private:
+	/**
+	 * Import as much of the frame as possible directly into
+	 * buffers provided by DecoderClient::GetAudioBuffer().
+	 *
+	 * @return the number of frames which were consumed
+	 */
+	size_t ImportDirect(const FLAC__int32 *const buf[],
+			    size_t n_frames) noexcept;
+
 	void OnStreamInfo(const FLAC__StreamMetadata_StreamInfo &stream_info) noexcept;
 	void OnVorbisComment(const FLAC__StreamMetadata_VorbisComment &vc) noexcept;
 
@@ -12,6 +12,9 @@
 #include "fs/NarrowPath.hxx"
 #include "Log.hxx"
 
+#include <cassert>
+#include <utility>
+
 static void
 flacPrintErroredState(FLAC__StreamDecoderState state) noexcept
 {
@@ -122,6 +125,13 @@ flac_decoder_initialize(FlacDecoder *data, FLAC__StreamDecoder *sd) noexcept
 static DecoderCommand
 FlacSubmitToClient(DecoderClient &client, FlacDecoder &d) noexcept
 {
+	if (d.command != DecoderCommand::NONE) {
+		/* a command was received while submitting directly
+		   from the libFLAC write callback */
+		assert(d.chunk.empty());
+		return std::exchange(d.command, DecoderCommand::NONE);
+	}
+
 	if (d.tag.IsEmpty() && d.chunk.empty())
 		return client.GetCommand();
 
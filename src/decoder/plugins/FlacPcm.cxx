@@ -6,6 +6,8 @@
 #include "lib/xiph/FlacAudioFormat.hxx"
 #include "lib/fmt/RuntimeError.hxx"
 
+#include <FLAC/format.h>
+
 #include <cassert>
 
 void
@@ -52,34 +54,40 @@ FlacImport(T *dest, const FLAC__int32 *const src[], size_t n_frames,
 		FlacImportAny(dest, src, n_frames, n_channels);
 }
 
-template<typename T>
-static std::span<const std::byte>
-FlacImport(PcmBuffer &buffer, const FLAC__int32 *const src[], size_t n_frames,
-	   unsigned n_channels) noexcept
+std::span<const std::byte>
+FlacPcmImport::Import(const FLAC__int32 *const src[],
+		      size_t offset, size_t n_frames) noexcept
 {
-	size_t n_samples = n_frames * n_channels;
-	size_t dest_size = n_samples * sizeof(T);
-	T *dest = (T *)buffer.Get(dest_size);
-	FlacImport(dest, src, n_frames, n_channels);
-	return std::as_bytes(std::span{dest, n_samples});
+	const size_t dest_size = n_frames * audio_format.GetFrameSize();
+	auto *dest = (std::byte *)buffer.Get(dest_size);
+	Import(dest, src, offset, n_frames);
+	return {dest, dest_size};
 }
 
-std::span<const std::byte>
-FlacPcmImport::Import(const FLAC__int32 *const src[], size_t n_frames) noexcept
+void
+FlacPcmImport::Import(std::byte *dest, const FLAC__int32 *const src[],
+		      size_t offset, size_t n_frames) const noexcept
 {
+	const unsigned n_channels = audio_format.channels;
+	assert(n_channels <= FLAC__MAX_CHANNELS);
+
+	const FLAC__int32 *shifted[FLAC__MAX_CHANNELS];
+	for (unsigned c = 0; c != n_channels; ++c)
+		shifted[c] = src[c] + offset;
+
 	switch (audio_format.format) {
 	case SampleFormat::S16:
-		return FlacImport<int16_t>(buffer, src, n_frames,
-					   audio_format.channels);
+		FlacImport((int16_t *)dest, shifted, n_frames, n_channels);
+		return;
 
 	case SampleFormat::S24_P32:
 	case SampleFormat::S32:
-		return FlacImport<int32_t>(buffer, src, n_frames,
-					   audio_format.channels);
+		FlacImport((int32_t *)dest, shifted, n_frames, n_channels);
+		return;
 
 	case SampleFormat::S8:
-		return FlacImport<int8_t>(buffer, src, n_frames,
-					  audio_format.channels);
+		FlacImport((int8_t *)dest, shifted, n_frames, n_channels);
+		return;
 
 	case SampleFormat::FLOAT:
 	case SampleFormat::DSD:
@@ -32,8 +32,25 @@ public:
 		return audio_format;
 	}
 
+	/**
+	 * Import into the internal buffer.
+	 *
+	 * @param offset the first frame in #src to be imported
+	 */
 	std::span<const std::byte> Import(const FLAC__int32 *const src[],
+					  size_t offset,
 					  size_t n_frames) noexcept;
+
+	/**
+	 * Import into a buffer provided by the caller, e.g. one
+	 * obtained from DecoderClient::GetAudioBuffer().
+	 *
+	 * @param dest the destination buffer, large enough for
+	 * #n_frames
+	 * @param offset the first frame in #src to be imported
+	 */
+	void Import(std::byte *dest, const FLAC__int32 *const src[],
+		    size_t offset, size_t n_frames) const noexcept;
 };
 
 #endif
@@ -163,38 +163,66 @@ pcm_stream_decode(DecoderClient &client, InputStream &is)
 	   results for a full source buffer */
 	int32_t unpack_buffer[buffer.GetCapacity() / 3];
 
+	/* without conversion, the data can be read right into the
+	   MusicChunk */
+	const bool direct = !reverse_endian && !l24;
+
 	DecoderCommand cmd;
 	do {
-		if (!FillBuffer(client, is, buffer))
-			break;
-
-		auto r = buffer.Read();
-		/* round down to the nearest frame size, because we
-		   must not pass partial frames to
-		   DecoderClient::SubmitAudio() */
-		r = r.first(r.size() - r.size() % in_frame_size);
-		buffer.Consume(r.size());
-
-		if (reverse_endian)
-			/* make sure we deliver samples in host byte order */
-			reverse_bytes_16((uint16_t *)r.data(),
-					 (uint16_t *)r.data(),
-					 (uint16_t *)(r.data() + r.size()));
-		else if (l24) {
-			/* convert big-endian packed 24 bit
-			   (audio/L24) to native-endian 24 bit (in 32
-			   bit integers) */
-			pcm_unpack_24be(unpack_buffer,
-					r.data(), r.data() + r.size());
-			r = {
-				(uint8_t *)&unpack_buffer[0],
-				(r.size() / 3) * 4,
-			};
+		std::span<std::byte> dest;
+		if (direct && buffer.empty())
+			dest = client.GetAudioBuffer(is);
+
+		if (!dest.empty()) {
+			size_t nbytes = decoder_read(client, is,
+						     dest.data(), dest.size());
+			if (nbytes == 0 && is.LockIsEOF())
+				break;
+
+			/* a trailing partial frame goes to our buffer
+			   and will be completed by the next read */
+			const size_t partial = nbytes % in_frame_size;
+			nbytes -= partial;
+			if (partial > 0) {
+				auto w = buffer.Write();
+				memcpy(w.data(), dest.data() + nbytes, partial);
+				buffer.Append(partial);
+			}
+
+			cmd = client.SubmitAudioBuffer(nbytes, 0);
+		} else {
+			if (!FillBuffer(client, is, buffer))
+				break;
+
+			auto r = buffer.Read();
+			/* round down to the nearest frame size, because we
+			   must not pass partial frames to
+			   DecoderClient::SubmitAudio() */
+			r = r.first(r.size() - r.size() % in_frame_size);
+			buffer.Consume(r.size());
+
+			if (reverse_endian)
+				/* make sure we deliver samples in host byte order */
+				reverse_bytes_16((uint16_t *)r.data(),
+						 (uint16_t *)r.data(),
+						 (uint16_t *)(r.data() + r.size()));
+			else if (l24) {
+				/* convert big-endian packed 24 bit
+				   (audio/L24) to native-endian 24 bit (in 32
+				   bit integers) */
+				pcm_unpack_24be(unpack_buffer,
+						r.data(), r.data() + r.size());
+				r = {
+					(uint8_t *)&unpack_buffer[0],
+					(r.size() / 3) * 4,
+				};
+			}
+
+			cmd = !r.empty()
+				? client.SubmitAudio(is, r, 0)
+				: client.GetCommand();
 		}
 
-		cmd = !r.empty()
-			? client.SubmitAudio(is, r, 0)
-			: client.GetCommand();
 		if (cmd == DecoderCommand::SEEK) {
 			uint64_t frame = client.GetSeekFrame();
 			offset_type offset = frame * in_frame_size;
@@ -50,6 +50,9 @@ FullyBufferedSocket::Flush() noexcept
 	if (output.empty()) {
 		idle_event.Cancel();
 		event.CancelWrite();
+
+		OnSocketOutputEmpty();
+		return IsDefined();
 	}
 
 	return true;
@@ -92,6 +95,9 @@ FullyBufferedSocket::OnSocketReady(unsigned flags) noexcept
 void
 FullyBufferedSocket::OnIdle() noexcept
 {
-	if (Flush() && !output.empty())
+	/* if OnSocketOutputEmpty() has written more data, then
+	   #idle_event has been scheduled again and will take care
+	   of it */
+	if (Flush() && !output.empty() && !idle_event.IsPending())
 		event.ScheduleWrite();
 }
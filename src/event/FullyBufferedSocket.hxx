@@ -36,6 +36,11 @@ public:
 		return output.max_size();
 	}
 
+	[[gnu::pure]]
+	bool IsOutputEmpty() const noexcept {
+		return output.empty();
+	}
+
 private:
 	/**
 	 * @return the number of bytes written to the socket, 0 if the
@@ -59,6 +64,12 @@ protected:
 
 	void OnIdle() noexcept;
 
+	/**
+	 * Called by Flush() after the output buffer has been sent
+	 * completely.  The method may write more data.
+	 */
+	virtual void OnSocketOutputEmpty() noexcept {}
+
 	/* virtual methods from class BufferedSocket */
 	void OnSocketReady(unsigned flags) noexcept override;
 };
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "MappedFile.hxx"
+#include "io/FileReader.hxx"
+#include "fs/Path.hxx"
+#include "lib/fmt/PathFormatter.hxx"
+#include "lib/fmt/SystemError.hxx"
+
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+MappedFile::MappedFile(Path path_fs)
+{
+	FileReader reader(path_fs);
+
+	const std::size_t size = reader.GetSize();
+	if (size == 0)
+		return;
+
+#ifdef _WIN32
+	buffer = std::make_unique<std::byte[]>(size);
+
+	std::size_t position = 0;
+	while (position < size) {
+		std::size_t nbytes = reader.Read(buffer.get() + position,
+						 size - position);
+		if (nbytes == 0)
+			throw std::runtime_error("Unexpected end of file");
+
+		position += nbytes;
+	}
+
+	data = {buffer.get(), size};
+#else
+	void *p = mmap(nullptr, size, PROT_READ, MAP_SHARED,
+		       reader.GetFD().Get(), 0);
+	if (p == MAP_FAILED)
+		throw FmtErrno("Failed to map {}", path_fs);
+
+	/* the file is usually parsed from start to end */
+	madvise(p, size, MADV_SEQUENTIAL);
+
+	data = {(const std::byte *)p, size};
+#endif
+}
+
+MappedFile::~MappedFile() noexcept
+{
+#ifndef _WIN32
+	if (!data.empty())
+		munmap(const_cast<std::byte *>(data.data()), data.size());
+#endif
+}
@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_MAPPED_FILE_HXX
+#define MPD_MAPPED_FILE_HXX
+
+#include <cstddef>
+#include <memory>
+#include <span>
+
+class Path;
+
+/**
+ * Maps a whole file into memory (read-only).  On platforms without
+ * mmap(), the file is read into a heap buffer instead.
+ */
+class MappedFile final {
+	std::span<const std::byte> data;
+
+#ifdef _WIN32
+	std::unique_ptr<std::byte[]> buffer;
+#endif
+
+public:
+	/**
+	 * Throws on error.
+	 */
+	explicit MappedFile(Path path_fs);
+
+	~MappedFile() noexcept;
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	std::span<const std::byte> GetData() const noexcept {
+		return data;
+	}
+};
+
+#endif
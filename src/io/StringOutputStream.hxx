@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_STRING_OUTPUT_STREAM_HXX
+#define MPD_STRING_OUTPUT_STREAM_HXX
+
+#include "OutputStream.hxx"
+
+#include <string>
+
+/**
+ * An #OutputStream which appends everything to a std::string.
+ */
+class StringOutputStream final : public OutputStream {
+	std::string value;
+
+public:
+	const std::string &GetValue() const noexcept {
+		return value;
+	}
+
+	std::string &&Steal() noexcept {
+		return std::move(value);
+	}
+
+	/* virtual methods from class OutputStream */
+	void Write(const void *data, std::size_t size) override {
+		value.append(static_cast<const char *>(data), size);
+	}
+};
+
+#endif
@@ -12,11 +12,11 @@ SharedPipeConsumer::Get() noexcept
 		if (!consumed)
 			return chunk;
 
-		if (chunk->next == nullptr)
+		if (chunk->GetNext() == nullptr)
 			return nullptr;
 
 		consumed = false;
-		return chunk = chunk->next.get();
+		return chunk = chunk->GetNext();
 	} else {
 		/* get the first chunk from the pipe */
 		consumed = false;
@@ -33,9 +33,9 @@ SharedPipeConsumer::IsConsumed(const MusicChunk &_chunk) const noexcept
 	assert(&_chunk == chunk || pipe->Contains(chunk));
 
 	if (&_chunk != chunk) {
-		assert(_chunk.next != nullptr);
+		assert(_chunk.GetNext() != nullptr);
 		return true;
 	}
 
-	return consumed && _chunk.next == nullptr;
+	return consumed && _chunk.GetNext() == nullptr;
 }
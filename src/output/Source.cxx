@@ -29,6 +29,9 @@ AudioOutputSource::Open(const AudioFormat audio_format, const MusicPipe &_pipe,
 		pipe.Init(_pipe);
 	}
 
+	if (!IsOpen())
+		statistics = {};
+
 	/* (re)open the filter */
 
 	if (filter && audio_format != in_audio_format)
@@ -122,7 +125,7 @@ AudioOutputSource::GetChunkData(const MusicChunk &chunk,
 	assert(!chunk.IsEmpty());
 	assert(chunk.CheckFormat(in_audio_format));
 
-	std::span<const std::byte> data(chunk.data, chunk.length);
+	std::span<const std::byte> data = chunk.GetData();
 
 	assert(data.size() % in_audio_format.GetFrameSize() == 0);
 
@@ -221,6 +224,18 @@ AudioOutputSource::Fill(Mutex &mutex)
 		throw;
 	}
 
+	if (const auto data = current_chunk->GetData(); !data.empty()) {
+		/* if no filter has done anything, the output gets
+		   a pointer right into the chunk */
+		if (pending_data.data() == data.data()) {
+			++statistics.passthrough_chunks;
+			statistics.passthrough_bytes += data.size();
+		} else {
+			++statistics.copied_chunks;
+			statistics.copied_bytes += data.size();
+		}
+	}
+
 	return true;
 }
 
@@ -29,6 +29,19 @@ class PreparedFilter;
  * data.
  */
 class AudioOutputSource {
+public:
+	/**
+	 * Counters which tell how much data was handed to the
+	 * #AudioOutput without being copied (i.e. pointing right into
+	 * the #MusicChunk, because all filters were a no-op) and how
+	 * much had to be copied or converted by the filters.
+	 */
+	struct Statistics {
+		uint64_t passthrough_chunks = 0, passthrough_bytes = 0;
+		uint64_t copied_chunks = 0, copied_bytes = 0;
+	};
+
+private:
 	/**
 	 * The audio_format in which audio data is received from the
 	 * player thread (which in turn receives it from the decoder).
@@ -101,6 +114,8 @@ class AudioOutputSource {
 	 */
 	std::span<const std::byte> pending_data;
 
+	Statistics statistics;
+
 public:
 	AudioOutputSource() noexcept;
 	~AudioOutputSource() noexcept;
@@ -119,6 +134,13 @@ public:
 		return in_audio_format;
 	}
 
+	/**
+	 * Returns the statistics since this object was opened.
+	 */
+	const Statistics &GetStatistics() const noexcept {
+		return statistics;
+	}
+
 	AudioFormat Open(AudioFormat audio_format, const MusicPipe &_pipe,
 			 PreparedFilter *prepared_replay_gain_filter,
 			 PreparedFilter *prepared_other_replay_gain_filter,
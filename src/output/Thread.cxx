@@ -173,6 +173,14 @@ AudioOutputControl::InternalClose(bool drain) noexcept
 		output->Close(drain);
 	}
 
+	if (const auto &s = source.GetStatistics();
+	    s.passthrough_chunks > 0 || s.copied_chunks > 0)
+		FmtDebug(output_domain,
+			 "{}: {} chunks ({} bytes) passed through, {} chunks ({} bytes) copied",
+			 GetLogName(),
+			 s.passthrough_chunks, s.passthrough_bytes,
+			 s.copied_chunks, s.copied_bytes);
+
 	source.Close();
 }
 
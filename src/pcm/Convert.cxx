@@ -3,15 +3,49 @@
 
 #include "Convert.hxx"
 #include "ConfiguredResampler.hxx"
+#include "config/Data.hxx"
+#include "config/Option.hxx"
+#include "lib/fmt/RuntimeError.hxx"
 #include "util/SpanCast.hxx"
 
 #include <cassert>
 #include <stdexcept>
 
+#include <string.h>
+
+#ifdef ENABLE_DSD
+
+static PcmDsdConfig
+GetDsdConfig(const ConfigData &config)
+{
+	PcmDsdConfig dsd_config;
+
+	if (const auto *param = config.GetParam(ConfigOption::DSD2PCM)) {
+		const char *value = param->value.c_str();
+		if (strcmp(value, "fast") == 0)
+			dsd_config.fast = true;
+		else if (strcmp(value, "classic") == 0)
+			dsd_config.fast = false;
+		else
+			throw FmtRuntimeError("Invalid dsd2pcm engine in line {}: {}",
+					      param->line, value);
+	}
+
+	dsd_config.threads = config.GetPositive(ConfigOption::DSD2PCM_THREADS,
+						dsd_config.threads);
+	return dsd_config;
+}
+
+#endif
+
 void
 pcm_convert_global_init(const ConfigData &config)
 {
 	pcm_resampler_global_init(config);
+
+#ifdef ENABLE_DSD
+	pcm_dsd_global_init(GetDsdConfig(config));
+#endif
 }
 
 PcmConvert::PcmConvert(const AudioFormat _src_format,
@@ -35,7 +35,14 @@ or implied, of Sebastian Gesemann.
 #include "util/BitReverse.hxx"
 #include "util/GenerateArray.hxx"
 
+#include <algorithm>
 #include <cassert>
+#include <type_traits>
+
+#ifdef __x86_64__
+#include "X86.hxx"
+#include <immintrin.h>
+#endif
 
 #include <stdlib.h>
 #include <string.h>
@@ -318,3 +325,221 @@ MultiDsd2Pcm::TranslateStereoS24(size_t n_frames,
 	}
 	fifopos = ffp;
 }
+
+/*
+ * FastDsd2Pcm
+ */
+
+static_assert(FastDsd2Pcm::HISTORY == CTABLES * 2 - 1);
+
+/**
+ * Like #ctables, but indexed with bit-reversed bytes; this is used
+ * for the older half of the filter, which #Dsd2Pcm implements by
+ * bit-reversing the FIFO contents in-place.
+ */
+static constexpr auto rtables = GenerateArray<CTABLES>([](size_t t){
+	return GenerateArray<256>([t](size_t e){
+		return ctables[t][static_cast<std::size_t>(BitReverseMultiplyModulus(static_cast<std::byte>(e)))];
+	});
+});
+
+static constexpr auto rtables_s24 = GenerateArray<CTABLES>([](size_t t){
+	return GenerateArray<256>([t](size_t e){
+		return ctables_s24[t][static_cast<std::size_t>(BitReverseMultiplyModulus(static_cast<std::byte>(e)))];
+	});
+});
+
+void
+FastDsd2Pcm::Reset() noexcept
+{
+	constexpr std::byte silence = SampleTraits<SampleFormat::DSD>::SILENCE;
+
+	/* Dsd2Pcm::Reset() fills the FIFO with unreversed silence,
+	   and Dsd2Pcm::ApplySample() bit-reverses only bytes which
+	   become older than #CTABLES; the older bytes are therefore
+	   stored reversed here, because the "rtables" reverse them
+	   again */
+	std::fill_n(line.begin(), HISTORY - CTABLES,
+		    BitReverseMultiplyModulus(silence));
+	std::fill_n(line.begin() + HISTORY - CTABLES, CTABLES, silence);
+}
+
+/**
+ * Calculate one output sample.
+ *
+ * @param p pointer to the oldest of the #HISTORY + 1 input bytes
+ */
+static inline float
+CalcOutputSample(const std::byte *p) noexcept
+{
+	/* same operations in the same order as
+	   Dsd2Pcm::CalcOutputSample() to get the same rounding */
+	double acc = 0;
+	for (size_t i = 0; i < CTABLES; ++i) {
+		std::byte bite1 = p[FastDsd2Pcm::HISTORY - i];
+		std::byte bite2 = p[i];
+		acc += double(ctables[i][static_cast<std::size_t>(bite1)]
+			      + rtables[i][static_cast<std::size_t>(bite2)]);
+	}
+	return float(acc);
+}
+
+static inline int32_t
+CalcOutputSampleS24(const std::byte *p) noexcept
+{
+	int32_t acc = 0;
+	for (size_t i = 0; i < CTABLES; ++i) {
+		std::byte bite1 = p[FastDsd2Pcm::HISTORY - i];
+		std::byte bite2 = p[i];
+		acc += ctables_s24[i][static_cast<std::size_t>(bite1)]
+			+ rtables_s24[i][static_cast<std::size_t>(bite2)];
+	}
+	return acc;
+}
+
+#ifdef __x86_64__
+
+/**
+ * Load 8 consecutive bytes and zero-extend them to 32 bit.
+ */
+[[gnu::target("avx2")]]
+static inline __m256i
+Avx2LoadIndexes(const std::byte *p) noexcept
+{
+	return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)p));
+}
+
+/**
+ * Calculate 8 output samples at a time, each SIMD lane doing
+ * exactly what CalcOutputSample() does.
+ *
+ * @return the number of output samples
+ */
+[[gnu::target("avx2")]]
+static std::size_t
+Avx2CalcBlock(const std::byte *line, float *dest, std::size_t n) noexcept
+{
+	const std::size_t n_vectors = n / 8;
+	for (std::size_t v = 0; v < n_vectors; ++v, line += 8, dest += 8) {
+		__m256d acc_lo = _mm256_setzero_pd();
+		__m256d acc_hi = _mm256_setzero_pd();
+
+		for (size_t i = 0; i < CTABLES; ++i) {
+			const __m256i bite1 =
+				Avx2LoadIndexes(line + FastDsd2Pcm::HISTORY - i);
+			const __m256i bite2 = Avx2LoadIndexes(line + i);
+			const __m256 sum =
+				_mm256_add_ps(_mm256_i32gather_ps(ctables[i].data(),
+								  bite1, 4),
+					      _mm256_i32gather_ps(rtables[i].data(),
+								  bite2, 4));
+
+			acc_lo = _mm256_add_pd(acc_lo,
+					       _mm256_cvtps_pd(_mm256_castps256_ps128(sum)));
+			acc_hi = _mm256_add_pd(acc_hi,
+					       _mm256_cvtps_pd(_mm256_extractf128_ps(sum, 1)));
+		}
+
+		_mm_storeu_ps(dest, _mm256_cvtpd_ps(acc_lo));
+		_mm_storeu_ps(dest + 4, _mm256_cvtpd_ps(acc_hi));
+	}
+
+	return n_vectors * 8;
+}
+
+[[gnu::target("avx2")]]
+static std::size_t
+Avx2CalcBlock(const std::byte *line, int32_t *dest, std::size_t n) noexcept
+{
+	const std::size_t n_vectors = n / 8;
+	for (std::size_t v = 0; v < n_vectors; ++v, line += 8, dest += 8) {
+		__m256i acc = _mm256_setzero_si256();
+
+		for (size_t i = 0; i < CTABLES; ++i) {
+			const __m256i bite1 =
+				Avx2LoadIndexes(line + FastDsd2Pcm::HISTORY - i);
+			const __m256i bite2 = Avx2LoadIndexes(line + i);
+
+			acc = _mm256_add_epi32(acc,
+					       _mm256_i32gather_epi32((const int *)ctables_s24[i].data(),
+								      bite1, 4));
+			acc = _mm256_add_epi32(acc,
+					       _mm256_i32gather_epi32((const int *)rtables_s24[i].data(),
+								      bite2, 4));
+		}
+
+		_mm256_storeu_si256((__m256i *)dest, acc);
+	}
+
+	return n_vectors * 8;
+}
+
+#endif
+
+/**
+ * Calculate output samples from a linear buffer.
+ *
+ * @param line the input; the first #FastDsd2Pcm::HISTORY bytes are
+ * from the previous block
+ * @param n the number of output samples
+ */
+template<typename T>
+static void
+CalcBlock(const std::byte *line, T *dest, std::size_t n) noexcept
+{
+	std::size_t k = 0;
+
+#ifdef __x86_64__
+	if (X86HaveAvx2())
+		k = Avx2CalcBlock(line, dest, n);
+#endif
+
+	for (; k < n; ++k) {
+		if constexpr (std::is_same_v<T, float>)
+			dest[k] = CalcOutputSample(line + k);
+		else
+			dest[k] = CalcOutputSampleS24(line + k);
+	}
+}
+
+template<typename T>
+inline void
+FastDsd2Pcm::TranslateT(size_t samples,
+			const std::byte *gcc_restrict src, ptrdiff_t src_stride,
+			T *dst, ptrdiff_t dst_stride) noexcept
+{
+	T buffer[BLOCK_SIZE];
+
+	while (samples > 0) {
+		const size_t n = std::min(samples, BLOCK_SIZE);
+		samples -= n;
+
+		std::byte *p = line.data() + HISTORY;
+		for (size_t i = 0; i < n; ++i, src += src_stride)
+			p[i] = *src;
+
+		CalcBlock(line.data(), buffer, n);
+
+		for (size_t i = 0; i < n; ++i, dst += dst_stride)
+			*dst = buffer[i];
+
+		/* keep the last input bytes for the next block */
+		std::copy_n(line.data() + n, HISTORY, line.data());
+	}
+}
+
+void
+FastDsd2Pcm::Translate(size_t samples,
+		       const std::byte *src, ptrdiff_t src_stride,
+		       float *dst, ptrdiff_t dst_stride) noexcept
+{
+	TranslateT(samples, src, src_stride, dst, dst_stride);
+}
+
+void
+FastDsd2Pcm::TranslateS24(size_t samples,
+			  const std::byte *src, ptrdiff_t src_stride,
+			  int32_t *dst, ptrdiff_t dst_stride) noexcept
+{
+	TranslateT(samples, src, src_stride, dst, dst_stride);
+}
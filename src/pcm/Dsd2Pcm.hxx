@@ -120,5 +120,63 @@ private:
 				const std::byte *src, int32_t *dest) noexcept;
 };
 
+/**
+ * A faster "dsd2pcm engine" for one channel which produces exactly
+ * the same output as #Dsd2Pcm.
+ *
+ * Instead of a FIFO which is modified in-place, the input is copied
+ * into a linear buffer (after the last #HISTORY bytes of the previous
+ * block), and the older half of the (symmetric) filter uses lookup
+ * tables with bit-reversed indexes.  This allows calculating several
+ * output samples at once (with AVX2 if available).
+ */
+class FastDsd2Pcm {
+public:
+	/**
+	 * The number of input bytes which are needed to calculate
+	 * one output sample, minus one.
+	 */
+	static constexpr size_t HISTORY = 11;
+
+	/**
+	 * The maximum number of input bytes processed in one step.
+	 */
+	static constexpr size_t BLOCK_SIZE = 1024;
+
+private:
+	/**
+	 * The last #HISTORY input bytes followed by the bytes of the
+	 * current block.
+	 */
+	std::array<std::byte, HISTORY + BLOCK_SIZE> line;
+
+public:
+	FastDsd2Pcm() noexcept {
+		Reset();
+	}
+
+	/**
+	 * resets the internal state for a fresh new stream
+	 */
+	void Reset() noexcept;
+
+	/**
+	 * Same as Dsd2Pcm::Translate().
+	 */
+	void Translate(size_t samples,
+		       const std::byte *src, ptrdiff_t src_stride,
+		       float *dst, ptrdiff_t dst_stride) noexcept;
+
+	void TranslateS24(size_t samples,
+			  const std::byte *src, ptrdiff_t src_stride,
+			  int32_t *dst, ptrdiff_t dst_stride) noexcept;
+
+private:
+	template<typename T>
+	void TranslateT(size_t samples,
+			const std::byte *src, ptrdiff_t src_stride,
+			T *dst, ptrdiff_t dst_stride) noexcept;
+};
+
 #endif /* include guard DSD2PCM_H_INCLUDED */
 
@@ -10,8 +10,13 @@
 
 #include "Dither.cxx" // including the .cxx file to get inlined templates
 
+#ifdef __x86_64__
+#include "X86.hxx"
+#endif
+
 #include <cassert>
 #include <cmath>
+#include <type_traits>
 
 template<SampleFormat F, class Traits=SampleTraits<F>>
 static typename Traits::value_type
@@ -59,6 +64,15 @@ static void
 pcm_add_vol_float(float *buffer1, const float *buffer2,
 		  unsigned num_samples, float volume1, float volume2) noexcept
 {
+#ifdef __x86_64__
+	const std::size_t done = X86AddVolumeFloat(buffer1, buffer2,
+						   num_samples,
+						   volume1, volume2);
+	buffer1 += done;
+	buffer2 += done;
+	num_samples -= done;
+#endif
+
 	while (num_samples > 0) {
 		float sample1 = *buffer1;
 		float sample2 = *buffer2++;
@@ -131,7 +145,20 @@ PcmAdd(typename Traits::pointer a,
        typename Traits::const_pointer b,
        size_t n) noexcept
 {
-	for (size_t i = 0; i != n; ++i)
+	size_t i = 0;
+
+#ifdef __x86_64__
+	if constexpr (std::is_same_v<Traits, SampleTraits<F>>) {
+		if constexpr (F == SampleFormat::S16)
+			i = X86AddS16(a, b, n);
+		else if constexpr (F == SampleFormat::S24_P32)
+			i = X86AddS24(a, b, n);
+		else if constexpr (F == SampleFormat::S32)
+			i = X86AddS32(a, b, n);
+	}
+#endif
+
+	for (; i != n; ++i)
 		a[i] = PcmAdd<F, Traits>(a[i], b[i]);
 }
 
@@ -151,6 +178,15 @@ static void
 pcm_add_float(float *buffer1, const float *buffer2,
 	      unsigned num_samples) noexcept
 {
+#ifdef __x86_64__
+	/* multiplying with 1 is exact */
+	const std::size_t done = X86AddVolumeFloat(buffer1, buffer2,
+						   num_samples, 1, 1);
+	buffer1 += done;
+	buffer2 += done;
+	num_samples -= done;
+#endif
+
 	while (num_samples > 0) {
 		float sample1 = *buffer1;
 		float sample2 = *buffer2++;
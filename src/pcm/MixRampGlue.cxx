@@ -83,8 +83,8 @@ AnalyzeMixRamp(const MusicPipe &pipe, const AudioFormat &audio_format,
 
 	MixRampAnalyzer a;
 	do {
-		a.Process(FromBytesStrict<const ReplayGainAnalyzer::Frame>({chunk->data, chunk->length}));
-	} while ((chunk = chunk->next.get()) != nullptr);
+		a.Process(FromBytesStrict<const ReplayGainAnalyzer::Frame>(chunk->GetData()));
+	} while ((chunk = chunk->GetNext()) != nullptr);
 
 	return ToString(a.GetResult(), a.GetTime(), direction);
 }
@@ -3,8 +3,250 @@
 
 #include "PcmDsd.hxx"
 #include "Dsd2Pcm.hxx"
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+#include "thread/Thread.hxx"
+#include "thread/Name.hxx"
 
 #include <cassert>
+#include <forward_list>
+
+/**
+ * Multi-threading is only worth the synchronization overhead if
+ * there is enough work per channel.
+ */
+static constexpr size_t MIN_THREAD_FRAMES = 256;
+
+static PcmDsdConfig global_config;
+
+void
+pcm_dsd_global_init(const PcmDsdConfig &config) noexcept
+{
+	global_config = config;
+}
+
+/**
+ * Threads which convert one part of the channels each, while the
+ * calling thread converts the first part.
+ */
+class PcmDsd::Workers {
+	PcmDsd &parent;
+
+	Mutex mutex;
+
+	/**
+	 * Signalled when a new job has been submitted or when #quit
+	 * has been set.
+	 */
+	Cond cond;
+
+	/**
+	 * Signalled when #n_busy drops to zero.
+	 */
+	Cond done_cond;
+
+	std::forward_list<Thread> threads;
+
+	/**
+	 * The number of threads in #threads.
+	 */
+	unsigned n_threads = 0;
+
+	/**
+	 * The part number of the next thread to start.  Protected by
+	 * #mutex.
+	 */
+	unsigned next_part = 1;
+
+	/**
+	 * Incremented for each job.  Protected by #mutex.
+	 */
+	unsigned generation = 0;
+
+	/**
+	 * The number of threads still working on the current job.
+	 * Protected by #mutex.
+	 */
+	unsigned n_busy = 0;
+
+	bool quit = false;
+
+public:
+	/**
+	 * Throws on error.
+	 */
+	Workers(PcmDsd &_parent, unsigned _n_threads)
+		:parent(_parent)
+	{
+		for (unsigned i = 0; i < _n_threads; ++i) {
+			threads.emplace_front(BIND_THIS_METHOD(RunThread));
+
+			try {
+				threads.front().Start();
+			} catch (...) {
+				threads.pop_front();
+				StopThreads();
+				throw;
+			}
+
+			++n_threads;
+		}
+	}
+
+	~Workers() noexcept {
+		StopThreads();
+	}
+
+	/**
+	 * The number of parts (including the one of the calling
+	 * thread).
+	 */
+	unsigned GetPartCount() const noexcept {
+		return n_threads + 1;
+	}
+
+	/**
+	 * Run the parent's current job in all threads and wait for
+	 * completion.
+	 */
+	void Run() noexcept {
+		{
+			const std::scoped_lock lock{mutex};
+			++generation;
+			n_busy = n_threads;
+			cond.notify_all();
+		}
+
+		parent.RunPart(0);
+
+		std::unique_lock lock{mutex};
+		done_cond.wait(lock, [this]{ return n_busy == 0; });
+	}
+
+private:
+	void StopThreads() noexcept {
+		{
+			const std::scoped_lock lock{mutex};
+			quit = true;
+			cond.notify_all();
+		}
+
+		for (auto &thread : threads)
+			thread.Join();
+	}
+
+	void RunThread() noexcept {
+		SetThreadName("dsd2pcm");
+
+		std::unique_lock lock{mutex};
+		const unsigned part = next_part++;
+
+		/* not initialized from #generation, because Run() may
+		   have been called before this thread got here */
+		unsigned seen = 0;
+
+		while (true) {
+			cond.wait(lock, [this, seen]{
+				return quit || generation != seen;
+			});
+
+			if (quit)
+				break;
+
+			seen = generation;
+
+			{
+				const ScopeUnlock unlock(mutex);
+				parent.RunPart(part);
+			}
+
+			if (--n_busy == 0)
+				done_cond.notify_one();
+		}
+	}
+};
+
+PcmDsd::PcmDsd() noexcept
+	:PcmDsd(global_config) {}
+
+PcmDsd::PcmDsd(const PcmDsdConfig &_config) noexcept
+	:config(_config)
+{
+	if (config.fast)
+		fast = std::make_unique<std::array<FastDsd2Pcm, MAX_CHANNELS>>();
+}
+
+PcmDsd::~PcmDsd() noexcept = default;
+
+void
+PcmDsd::Reset() noexcept
+{
+	dsd2pcm.Reset();
+
+	if (fast)
+		for (auto &i : *fast)
+			i.Reset();
+}
+
+void
+PcmDsd::RunPart(unsigned part) noexcept
+{
+	if (part >= job.n_parts)
+		/* more threads than channels */
+		return;
+
+	const unsigned channels = job.channels;
+	const unsigned begin = part * channels / job.n_parts;
+	const unsigned end = (part + 1) * channels / job.n_parts;
+
+	for (unsigned i = begin; i < end; ++i) {
+		auto &engine = (*fast)[i];
+
+		if (job.dest_float != nullptr)
+			engine.Translate(job.n_frames,
+					 job.src + i, channels,
+					 job.dest_float + i, channels);
+		else
+			engine.TranslateS24(job.n_frames,
+					    job.src + i, channels,
+					    job.dest_s24 + i, channels);
+	}
+}
+
+inline void
+PcmDsd::TranslateFast(unsigned channels, size_t n_frames,
+		      const std::byte *src,
+		      float *dest_float, int32_t *dest_s24) noexcept
+{
+	assert(fast);
+	assert(channels <= fast->size());
+
+	job = {channels, 1, n_frames, src, dest_float, dest_s24};
+
+	if (config.threads > 1 && channels > 2 &&
+	    n_frames >= MIN_THREAD_FRAMES) {
+		if (!workers) {
+			try {
+				workers = std::make_unique<Workers>(*this,
+								    config.threads - 1);
+			} catch (...) {
+				/* no threads; convert everything in
+				   this thread */
+			}
+		}
+
+		if (workers) {
+			job.n_parts = std::min(workers->GetPartCount(),
+					       channels);
+			if (job.n_parts > 1) {
+				workers->Run();
+				return;
+			}
+		}
+	}
+
+	RunPart(0);
+}
 
 std::span<const float>
 PcmDsd::ToFloat(unsigned channels, std::span<const std::byte> src) noexcept
@@ -17,7 +259,10 @@ PcmDsd::ToFloat(unsigned channels, std::span<const std::byte> src) noexcept
 
 	auto *dest = buffer.GetT<float>(num_samples);
 
-	dsd2pcm.Translate(channels, num_frames, src.data(), dest);
+	if (fast)
+		TranslateFast(channels, num_frames, src.data(), dest, nullptr);
+	else
+		dsd2pcm.Translate(channels, num_frames, src.data(), dest);
 	return { dest, num_samples };
 }
 
@@ -32,6 +277,9 @@ PcmDsd::ToS24(unsigned channels, std::span<const std::byte> src) noexcept
 
 	auto *dest = buffer.GetT<int32_t>(num_samples);
 
-	dsd2pcm.TranslateS24(channels, num_frames, src.data(), dest);
+	if (fast)
+		TranslateFast(channels, num_frames, src.data(), nullptr, dest);
+	else
+		dsd2pcm.TranslateS24(channels, num_frames, src.data(), dest);
 	return { dest, num_samples };
 }
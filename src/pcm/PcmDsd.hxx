@@ -7,24 +7,102 @@
 #include "Dsd2Pcm.hxx"
 
 #include <cstdint>
+#include <memory>
 #include <span>
 
+/**
+ * Settings for #PcmDsd.
+ */
+struct PcmDsdConfig {
+	/**
+	 * Use #FastDsd2Pcm instead of #MultiDsd2Pcm?  Both produce
+	 * the same output.
+	 */
+	bool fast = true;
+
+	/**
+	 * The number of threads which convert the channels of a
+	 * multi-channel (more than two channels) stream in parallel,
+	 * including the calling thread.  This is only implemented for
+	 * the "fast" engine.
+	 */
+	unsigned threads = 1;
+};
+
+/**
+ * Set the #PcmDsdConfig for all #PcmDsd instances which get
+ * constructed afterwards.
+ */
+void
+pcm_dsd_global_init(const PcmDsdConfig &config) noexcept;
+
 /**
  * Wrapper for the dsd2pcm library.
  */
 class PcmDsd {
+	class Workers;
+
+	const PcmDsdConfig config;
+
 	PcmBuffer buffer;
 
 	MultiDsd2Pcm dsd2pcm;
 
+	/**
+	 * Only allocated if #PcmDsdConfig::fast is set.
+	 */
+	std::unique_ptr<std::array<FastDsd2Pcm, MAX_CHANNELS>> fast;
+
+	/**
+	 * Created on demand by Translate().
+	 */
+	std::unique_ptr<Workers> workers;
+
+	/**
+	 * Parameters of the current Translate() call, for the
+	 * workers.
+	 */
+	struct Job {
+		unsigned channels, n_parts;
+		size_t n_frames;
+		const std::byte *src;
+		float *dest_float;
+		int32_t *dest_s24;
+	} job;
+
 public:
-	void Reset() noexcept {
-		dsd2pcm.Reset();
-	}
+	/**
+	 * Construct an instance with the settings passed to
+	 * pcm_dsd_global_init().
+	 */
+	PcmDsd() noexcept;
+
+	explicit PcmDsd(const PcmDsdConfig &_config) noexcept;
+
+	~PcmDsd() noexcept;
+
+	PcmDsd(const PcmDsd &) = delete;
+	PcmDsd &operator=(const PcmDsd &) = delete;
+
+	void Reset() noexcept;
 
 	std::span<const float> ToFloat(unsigned channels,
 				       std::span<const std::byte> src) noexcept;
 
 	std::span<const int32_t> ToS24(unsigned channels,
 				       std::span<const std::byte> src) noexcept;
+
+private:
+	/**
+	 * Convert with the "fast" engine, using the #Workers if
+	 * appropriate.
+	 */
+	void TranslateFast(unsigned channels, size_t n_frames,
+			   const std::byte *src,
+			   float *dest_float, int32_t *dest_s24) noexcept;
+
+	/**
+	 * Convert one part of the channels of the current #job.
+	 */
+	void RunPart(unsigned part) noexcept;
 };
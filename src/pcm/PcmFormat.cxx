@@ -98,6 +98,28 @@ struct FloatToInteger<SampleFormat::S16, SampleTraits<SampleFormat::S16>>
 
 #endif
 
+#ifdef __x86_64__
+#include "X86.hxx"
+
+template<SampleFormat F>
+struct X86GlueFloatToInteger
+	: GlueOptimizedConvert<X86FloatToInteger<F>,
+			       PortableFloatToInteger<F>> {};
+
+template<>
+struct FloatToInteger<SampleFormat::S16, SampleTraits<SampleFormat::S16>>
+	: X86GlueFloatToInteger<SampleFormat::S16> {};
+
+template<>
+struct FloatToInteger<SampleFormat::S24_P32, SampleTraits<SampleFormat::S24_P32>>
+	: X86GlueFloatToInteger<SampleFormat::S24_P32> {};
+
+template<>
+struct FloatToInteger<SampleFormat::S32, SampleTraits<SampleFormat::S32>>
+	: X86GlueFloatToInteger<SampleFormat::S32> {};
+
+#endif
+
 template<class C>
 static std::span<const typename C::DstTraits::value_type>
 AllocateConvert(PcmBuffer &buffer, C convert,
@@ -312,14 +334,29 @@ pcm_convert_to_32(PcmBuffer &buffer,
 struct Convert8ToFloat
 	: PerSampleConvert<IntegerToFloatSampleConvert<SampleFormat::S8>> {};
 
-struct Convert16ToFloat
-	: PerSampleConvert<IntegerToFloatSampleConvert<SampleFormat::S16>> {};
+template<SampleFormat F>
+struct PortableIntegerToFloat
+	: PerSampleConvert<IntegerToFloatSampleConvert<F>> {};
+
+#ifdef __x86_64__
+
+template<SampleFormat F>
+struct IntegerToFloat
+	: GlueOptimizedConvert<X86IntegerToFloat<F>,
+			       PortableIntegerToFloat<F>> {};
+
+#else
+
+template<SampleFormat F>
+struct IntegerToFloat : PortableIntegerToFloat<F> {};
+
+#endif
+
+struct Convert16ToFloat : IntegerToFloat<SampleFormat::S16> {};
 
-struct Convert24ToFloat
-	: PerSampleConvert<IntegerToFloatSampleConvert<SampleFormat::S24_P32>> {};
+struct Convert24ToFloat : IntegerToFloat<SampleFormat::S24_P32> {};
 
-struct Convert32ToFloat
-	: PerSampleConvert<IntegerToFloatSampleConvert<SampleFormat::S32>> {};
+struct Convert32ToFloat : IntegerToFloat<SampleFormat::S32> {};
 
 static std::span<const float>
 pcm_allocate_8_to_float(PcmBuffer &buffer, std::span<const int8_t> src)
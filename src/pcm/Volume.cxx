@@ -10,6 +10,10 @@
 
 #include "Dither.cxx" // including the .cxx file to get inlined templates
 
+#ifdef __x86_64__
+#include "X86.hxx"
+#endif
+
 #include <cassert>
 #include <cstdint>
 
@@ -97,6 +101,13 @@ static void
 PcmVolumeChange16to32(int32_t *dest, const int16_t *src, size_t n,
 		      int volume) noexcept
 {
+#ifdef __x86_64__
+	const std::size_t done = X86Volume16To24(dest, src, n, volume);
+	dest += done;
+	src += done;
+	n -= done;
+#endif
+
 	transform_n(src, n, dest,
 		    [volume](auto x){
 			    return PcmVolumeConvert<SampleFormat::S16,
@@ -126,6 +137,13 @@ static void
 pcm_volume_change_float(float *dest, const float *src, size_t n,
 			float volume) noexcept
 {
+#ifdef __x86_64__
+	const std::size_t done = X86VolumeFloat(dest, src, n, volume);
+	dest += done;
+	src += done;
+	n -= done;
+#endif
+
 	transform_n(src, n, dest,
 		    [volume](float x){ return x * volume; });
 }
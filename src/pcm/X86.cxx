@@ -0,0 +1,678 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "X86.hxx"
+#include "Volume.hxx"
+#include "FloatConvert.hxx"
+
+#include <immintrin.h>
+
+#define AVX2 [[gnu::target("avx2")]]
+
+bool
+X86HaveAvx2() noexcept
+{
+	static const bool value = []{
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") != 0;
+	}();
+
+	return value;
+}
+
+/*
+ * float to integer
+ *
+ * The portable code multiplies with the factor, truncates and
+ * clamps.  Clamping the float value to the (integer) limits before
+ * truncating yields the same result.
+ */
+
+template<SampleFormat F>
+struct FloatToIntegerConstants {
+	using Traits = SampleTraits<F>;
+
+	static constexpr float factor =
+		FloatToIntegerSampleConvert<F>::factor;
+	static constexpr float min = Traits::MIN;
+	static constexpr float max = Traits::MAX;
+};
+
+static inline __m128i
+Sse2FloatToInteger(__m128 x, __m128 factor, __m128 min, __m128 max) noexcept
+{
+	return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(x, factor),
+						      min),
+					   max));
+}
+
+AVX2
+static inline __m256i
+Avx2FloatToInteger(__m256 x, __m256 factor, __m256 min, __m256 max) noexcept
+{
+	return _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(x, factor),
+							       min),
+						 max));
+}
+
+std::size_t
+Sse2FloatToS16(int16_t *dest, const float *src, std::size_t n) noexcept
+{
+	using C = FloatToIntegerConstants<SampleFormat::S16>;
+	const __m128 factor = _mm_set1_ps(C::factor);
+	const __m128 min = _mm_set1_ps(C::min), max = _mm_set1_ps(C::max);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     src += X86_BLOCK_SIZE, dest += X86_BLOCK_SIZE) {
+		__m128i v[4];
+		for (unsigned j = 0; j < 4; ++j)
+			v[j] = Sse2FloatToInteger(_mm_loadu_ps(src + j * 4),
+						  factor, min, max);
+
+		/* the values are already clamped, so the
+		   saturation of "packs" is a no-op */
+		_mm_storeu_si128((__m128i *)dest, _mm_packs_epi32(v[0], v[1]));
+		_mm_storeu_si128((__m128i *)(dest + 8), _mm_packs_epi32(v[2], v[3]));
+	}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+AVX2
+std::size_t
+Avx2FloatToS16(int16_t *dest, const float *src, std::size_t n) noexcept
+{
+	using C = FloatToIntegerConstants<SampleFormat::S16>;
+	const __m256 factor = _mm256_set1_ps(C::factor);
+	const __m256 min = _mm256_set1_ps(C::min), max = _mm256_set1_ps(C::max);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     src += X86_BLOCK_SIZE, dest += X86_BLOCK_SIZE) {
+		const __m256i a = Avx2FloatToInteger(_mm256_loadu_ps(src),
+						     factor, min, max);
+		const __m256i b = Avx2FloatToInteger(_mm256_loadu_ps(src + 8),
+						     factor, min, max);
+
+		/* "packs" works on each 128 bit lane separately;
+		   restore the order afterwards */
+		const __m256i packed = _mm256_packs_epi32(a, b);
+		_mm256_storeu_si256((__m256i *)dest,
+				    _mm256_permute4x64_epi64(packed, 0xd8));
+	}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+std::size_t
+X86FloatToS16(int16_t *dest, const float *src, std::size_t n) noexcept
+{
+	return X86HaveAvx2()
+		? Avx2FloatToS16(dest, src, n)
+		: Sse2FloatToS16(dest, src, n);
+}
+
+std::size_t
+Sse2FloatToS24(int32_t *dest, const float *src, std::size_t n) noexcept
+{
+	using C = FloatToIntegerConstants<SampleFormat::S24_P32>;
+	const __m128 factor = _mm_set1_ps(C::factor);
+	const __m128 min = _mm_set1_ps(C::min), max = _mm_set1_ps(C::max);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     src += X86_BLOCK_SIZE, dest += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 4)
+			_mm_storeu_si128((__m128i *)(dest + j),
+					 Sse2FloatToInteger(_mm_loadu_ps(src + j),
+							    factor, min, max));
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+AVX2
+std::size_t
+Avx2FloatToS24(int32_t *dest, const float *src, std::size_t n) noexcept
+{
+	using C = FloatToIntegerConstants<SampleFormat::S24_P32>;
+	const __m256 factor = _mm256_set1_ps(C::factor);
+	const __m256 min = _mm256_set1_ps(C::min), max = _mm256_set1_ps(C::max);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     src += X86_BLOCK_SIZE, dest += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 8)
+			_mm256_storeu_si256((__m256i *)(dest + j),
+					    Avx2FloatToInteger(_mm256_loadu_ps(src + j),
+							       factor, min, max));
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+std::size_t
+X86FloatToS24(int32_t *dest, const float *src, std::size_t n) noexcept
+{
+	return X86HaveAvx2()
+		? Avx2FloatToS24(dest, src, n)
+		: Sse2FloatToS24(dest, src, n);
+}
+
+/*
+ * S32: the upper limit 0x7fffffff cannot be represented as float,
+ * so instead of clamping, fix up the result of "cvttps" (which is
+ * 0x80000000 for all values out of range) for large positive
+ * values.
+ */
+
+static inline __m128i
+Sse2FloatToS32(__m128 x, __m128 factor) noexcept
+{
+	x = _mm_mul_ps(x, factor);
+	const __m128 overflow = _mm_cmpge_ps(x, factor);
+	return _mm_xor_si128(_mm_cvttps_epi32(x), _mm_castps_si128(overflow));
+}
+
+AVX2
+static inline __m256i
+Avx2FloatToS32(__m256 x, __m256 factor) noexcept
+{
+	x = _mm256_mul_ps(x, factor);
+	const __m256 overflow = _mm256_cmp_ps(x, factor, _CMP_GE_OQ);
+	return _mm256_xor_si256(_mm256_cvttps_epi32(x),
+				_mm256_castps_si256(overflow));
+}
+
+std::size_t
+Sse2FloatToS32(int32_t *dest, const float *src, std::size_t n) noexcept
+{
+	using C = FloatToIntegerConstants<SampleFormat::S32>;
+	const __m128 factor = _mm_set1_ps(C::factor);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     src += X86_BLOCK_SIZE, dest += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 4)
+			_mm_storeu_si128((__m128i *)(dest + j),
+					 Sse2FloatToS32(_mm_loadu_ps(src + j),
+							factor));
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+AVX2
+std::size_t
+Avx2FloatToS32(int32_t *dest, const float *src, std::size_t n) noexcept
+{
+	using C = FloatToIntegerConstants<SampleFormat::S32>;
+	const __m256 factor = _mm256_set1_ps(C::factor);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     src += X86_BLOCK_SIZE, dest += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 8)
+			_mm256_storeu_si256((__m256i *)(dest + j),
+					    Avx2FloatToS32(_mm256_loadu_ps(src + j),
+							   factor));
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+std::size_t
+X86FloatToS32(int32_t *dest, const float *src, std::size_t n) noexcept
+{
+	return X86HaveAvx2()
+		? Avx2FloatToS32(dest, src, n)
+		: Sse2FloatToS32(dest, src, n);
+}
+
+/*
+ * integer to float
+ */
+
+std::size_t
+Sse2S16ToFloat(float *dest, const int16_t *src, std::size_t n) noexcept
+{
+	const __m128 factor =
+		_mm_set1_ps(IntegerToFloatSampleConvert<SampleFormat::S16>::factor);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     src += X86_BLOCK_SIZE, dest += X86_BLOCK_SIZE) {
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 8) {
+			const __m128i v = _mm_loadu_si128((const __m128i *)(src + j));
+
+			/* sign-extend to 32 bit */
+			const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+			const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+			_mm_storeu_ps(dest + j,
+				      _mm_mul_ps(_mm_cvtepi32_ps(lo), factor));
+			_mm_storeu_ps(dest + j + 4,
+				      _mm_mul_ps(_mm_cvtepi32_ps(hi), factor));
+		}
+	}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+AVX2
+std::size_t
+Avx2S16ToFloat(float *dest, const int16_t *src, std::size_t n) noexcept
+{
+	const __m256 factor =
+		_mm256_set1_ps(IntegerToFloatSampleConvert<SampleFormat::S16>::factor);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     src += X86_BLOCK_SIZE, dest += X86_BLOCK_SIZE) {
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 8) {
+			const __m256i v =
+				_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + j)));
+			_mm256_storeu_ps(dest + j,
+					 _mm256_mul_ps(_mm256_cvtepi32_ps(v),
+						       factor));
+		}
+	}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+std::size_t
+X86S16ToFloat(float *dest, const int16_t *src, std::size_t n) noexcept
+{
+	return X86HaveAvx2()
+		? Avx2S16ToFloat(dest, src, n)
+		: Sse2S16ToFloat(dest, src, n);
+}
+
+std::size_t
+Sse2S32ToFloat(float *dest, const int32_t *src, std::size_t n,
+	       float _factor) noexcept
+{
+	const __m128 factor = _mm_set1_ps(_factor);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     src += X86_BLOCK_SIZE, dest += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 4) {
+			const __m128i v = _mm_loadu_si128((const __m128i *)(src + j));
+			_mm_storeu_ps(dest + j,
+				      _mm_mul_ps(_mm_cvtepi32_ps(v), factor));
+		}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+AVX2
+std::size_t
+Avx2S32ToFloat(float *dest, const int32_t *src, std::size_t n,
+	       float _factor) noexcept
+{
+	const __m256 factor = _mm256_set1_ps(_factor);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     src += X86_BLOCK_SIZE, dest += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 8) {
+			const __m256i v = _mm256_loadu_si256((const __m256i *)(src + j));
+			_mm256_storeu_ps(dest + j,
+					 _mm256_mul_ps(_mm256_cvtepi32_ps(v),
+						       factor));
+		}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+std::size_t
+X86S32ToFloat(float *dest, const int32_t *src, std::size_t n,
+	      float factor) noexcept
+{
+	return X86HaveAvx2()
+		? Avx2S32ToFloat(dest, src, n, factor)
+		: Sse2S32ToFloat(dest, src, n, factor);
+}
+
+/*
+ * software volume
+ */
+
+/**
+ * The number of bits to shift the product of a S16 sample and the
+ * volume to get a S24_P32 sample.
+ */
+static constexpr unsigned VOLUME_16_TO_24_SHIFT =
+	SampleTraits<SampleFormat::S16>::BITS + PCM_VOLUME_BITS
+	- SampleTraits<SampleFormat::S24_P32>::BITS;
+
+std::size_t
+Sse2Volume16To24(int32_t *dest, const int16_t *src, std::size_t n,
+		 int volume) noexcept
+{
+	if (volume < 0 || volume > 0x7fff)
+		return 0;
+
+	/* each 32 bit lane contains the pair (volume, 0); "madd"
+	   multiplies it with the pair (sample, 0) */
+	const __m128i v = _mm_set1_epi32(volume);
+	const __m128i zero = _mm_setzero_si128();
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     src += X86_BLOCK_SIZE, dest += X86_BLOCK_SIZE) {
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 8) {
+			const __m128i s = _mm_loadu_si128((const __m128i *)(src + j));
+			const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(s, zero), v);
+			const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(s, zero), v);
+
+			_mm_storeu_si128((__m128i *)(dest + j),
+					 _mm_srai_epi32(lo, VOLUME_16_TO_24_SHIFT));
+			_mm_storeu_si128((__m128i *)(dest + j + 4),
+					 _mm_srai_epi32(hi, VOLUME_16_TO_24_SHIFT));
+		}
+	}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+AVX2
+std::size_t
+Avx2Volume16To24(int32_t *dest, const int16_t *src, std::size_t n,
+		 int volume) noexcept
+{
+	const __m256i v = _mm256_set1_epi32(volume);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     src += X86_BLOCK_SIZE, dest += X86_BLOCK_SIZE) {
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 8) {
+			const __m256i s =
+				_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + j)));
+			_mm256_storeu_si256((__m256i *)(dest + j),
+					    _mm256_srai_epi32(_mm256_mullo_epi32(s, v),
+							      VOLUME_16_TO_24_SHIFT));
+		}
+	}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+std::size_t
+X86Volume16To24(int32_t *dest, const int16_t *src, std::size_t n,
+		int volume) noexcept
+{
+	return X86HaveAvx2()
+		? Avx2Volume16To24(dest, src, n, volume)
+		: Sse2Volume16To24(dest, src, n, volume);
+}
+
+std::size_t
+Sse2VolumeFloat(float *dest, const float *src, std::size_t n,
+		float volume) noexcept
+{
+	const __m128 v = _mm_set1_ps(volume);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     src += X86_BLOCK_SIZE, dest += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 4)
+			_mm_storeu_ps(dest + j,
+				      _mm_mul_ps(_mm_loadu_ps(src + j), v));
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+AVX2
+std::size_t
+Avx2VolumeFloat(float *dest, const float *src, std::size_t n,
+		float volume) noexcept
+{
+	const __m256 v = _mm256_set1_ps(volume);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     src += X86_BLOCK_SIZE, dest += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 8)
+			_mm256_storeu_ps(dest + j,
+					 _mm256_mul_ps(_mm256_loadu_ps(src + j), v));
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+std::size_t
+X86VolumeFloat(float *dest, const float *src, std::size_t n,
+	       float volume) noexcept
+{
+	return X86HaveAvx2()
+		? Avx2VolumeFloat(dest, src, n, volume)
+		: Sse2VolumeFloat(dest, src, n, volume);
+}
+
+/*
+ * mixing
+ */
+
+std::size_t
+Sse2AddS16(int16_t *a, const int16_t *b, std::size_t n) noexcept
+{
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     a += X86_BLOCK_SIZE, b += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 8) {
+			const __m128i x = _mm_loadu_si128((const __m128i *)(a + j));
+			const __m128i y = _mm_loadu_si128((const __m128i *)(b + j));
+			_mm_storeu_si128((__m128i *)(a + j), _mm_adds_epi16(x, y));
+		}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+AVX2
+std::size_t
+Avx2AddS16(int16_t *a, const int16_t *b, std::size_t n) noexcept
+{
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     a += X86_BLOCK_SIZE, b += X86_BLOCK_SIZE) {
+		const __m256i x = _mm256_loadu_si256((const __m256i *)a);
+		const __m256i y = _mm256_loadu_si256((const __m256i *)b);
+		_mm256_storeu_si256((__m256i *)a, _mm256_adds_epi16(x, y));
+	}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+std::size_t
+X86AddS16(int16_t *a, const int16_t *b, std::size_t n) noexcept
+{
+	return X86HaveAvx2()
+		? Avx2AddS16(a, b, n)
+		: Sse2AddS16(a, b, n);
+}
+
+/**
+ * Select "a" where the mask is set, "b" elsewhere (SSE2 has no
+ * "blend" instruction).
+ */
+static inline __m128i
+Sse2Select(__m128i mask, __m128i a, __m128i b) noexcept
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+std::size_t
+Sse2AddS24(int32_t *a, const int32_t *b, std::size_t n) noexcept
+{
+	using Traits = SampleTraits<SampleFormat::S24_P32>;
+	const __m128i min = _mm_set1_epi32(Traits::MIN);
+	const __m128i max = _mm_set1_epi32(Traits::MAX);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     a += X86_BLOCK_SIZE, b += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 4) {
+			const __m128i x = _mm_loadu_si128((const __m128i *)(a + j));
+			const __m128i y = _mm_loadu_si128((const __m128i *)(b + j));
+			__m128i sum = _mm_add_epi32(x, y);
+			sum = Sse2Select(_mm_cmpgt_epi32(sum, max), max, sum);
+			sum = Sse2Select(_mm_cmplt_epi32(sum, min), min, sum);
+			_mm_storeu_si128((__m128i *)(a + j), sum);
+		}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+AVX2
+std::size_t
+Avx2AddS24(int32_t *a, const int32_t *b, std::size_t n) noexcept
+{
+	using Traits = SampleTraits<SampleFormat::S24_P32>;
+	const __m256i min = _mm256_set1_epi32(Traits::MIN);
+	const __m256i max = _mm256_set1_epi32(Traits::MAX);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     a += X86_BLOCK_SIZE, b += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 8) {
+			const __m256i x = _mm256_loadu_si256((const __m256i *)(a + j));
+			const __m256i y = _mm256_loadu_si256((const __m256i *)(b + j));
+			const __m256i sum = _mm256_add_epi32(x, y);
+			_mm256_storeu_si256((__m256i *)(a + j),
+					    _mm256_max_epi32(_mm256_min_epi32(sum, max),
+							     min));
+		}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+std::size_t
+X86AddS24(int32_t *a, const int32_t *b, std::size_t n) noexcept
+{
+	return X86HaveAvx2()
+		? Avx2AddS24(a, b, n)
+		: Sse2AddS24(a, b, n);
+}
+
+/*
+ * S32: there is no saturating 32 bit addition; detect overflows
+ * (the sign of the sum differs from the sign of both operands) and
+ * replace the sum with the limit matching the sign of the first
+ * operand.
+ */
+
+static inline __m128i
+Sse2AddS32(__m128i x, __m128i y) noexcept
+{
+	const __m128i sum = _mm_add_epi32(x, y);
+	const __m128i overflow =
+		_mm_srai_epi32(_mm_and_si128(_mm_xor_si128(x, sum),
+					     _mm_xor_si128(y, sum)),
+			       31);
+	const __m128i limit = _mm_xor_si128(_mm_srai_epi32(x, 31),
+					    _mm_set1_epi32(0x7fffffff));
+	return Sse2Select(overflow, limit, sum);
+}
+
+AVX2
+static inline __m256i
+Avx2AddS32(__m256i x, __m256i y) noexcept
+{
+	const __m256i sum = _mm256_add_epi32(x, y);
+	const __m256i overflow =
+		_mm256_srai_epi32(_mm256_and_si256(_mm256_xor_si256(x, sum),
+						   _mm256_xor_si256(y, sum)),
+				  31);
+	const __m256i limit = _mm256_xor_si256(_mm256_srai_epi32(x, 31),
+					       _mm256_set1_epi32(0x7fffffff));
+	return _mm256_blendv_epi8(sum, limit, overflow);
+}
+
+std::size_t
+Sse2AddS32(int32_t *a, const int32_t *b, std::size_t n) noexcept
+{
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     a += X86_BLOCK_SIZE, b += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 4) {
+			const __m128i x = _mm_loadu_si128((const __m128i *)(a + j));
+			const __m128i y = _mm_loadu_si128((const __m128i *)(b + j));
+			_mm_storeu_si128((__m128i *)(a + j), Sse2AddS32(x, y));
+		}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+AVX2
+std::size_t
+Avx2AddS32(int32_t *a, const int32_t *b, std::size_t n) noexcept
+{
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     a += X86_BLOCK_SIZE, b += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 8) {
+			const __m256i x = _mm256_loadu_si256((const __m256i *)(a + j));
+			const __m256i y = _mm256_loadu_si256((const __m256i *)(b + j));
+			_mm256_storeu_si256((__m256i *)(a + j), Avx2AddS32(x, y));
+		}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+std::size_t
+X86AddS32(int32_t *a, const int32_t *b, std::size_t n) noexcept
+{
+	return X86HaveAvx2()
+		? Avx2AddS32(a, b, n)
+		: Sse2AddS32(a, b, n);
+}
+
+/*
+ * Note: "fma" is deliberately not enabled, because a fused
+ * multiply-add would round differently than the portable code.
+ */
+
+std::size_t
+Sse2AddVolumeFloat(float *a, const float *b, std::size_t n,
+		   float volume1, float volume2) noexcept
+{
+	const __m128 v1 = _mm_set1_ps(volume1), v2 = _mm_set1_ps(volume2);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     a += X86_BLOCK_SIZE, b += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 4) {
+			const __m128 x = _mm_mul_ps(_mm_loadu_ps(a + j), v1);
+			const __m128 y = _mm_mul_ps(_mm_loadu_ps(b + j), v2);
+			_mm_storeu_ps(a + j, _mm_add_ps(x, y));
+		}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+AVX2
+std::size_t
+Avx2AddVolumeFloat(float *a, const float *b, std::size_t n,
+		   float volume1, float volume2) noexcept
+{
+	const __m256 v1 = _mm256_set1_ps(volume1), v2 = _mm256_set1_ps(volume2);
+
+	const std::size_t n_blocks = n / X86_BLOCK_SIZE;
+	for (std::size_t i = 0; i < n_blocks; ++i,
+		     a += X86_BLOCK_SIZE, b += X86_BLOCK_SIZE)
+		for (unsigned j = 0; j < X86_BLOCK_SIZE; j += 8) {
+			const __m256 x = _mm256_mul_ps(_mm256_loadu_ps(a + j), v1);
+			const __m256 y = _mm256_mul_ps(_mm256_loadu_ps(b + j), v2);
+			_mm256_storeu_ps(a + j, _mm256_add_ps(x, y));
+		}
+
+	return n_blocks * X86_BLOCK_SIZE;
+}
+
+std::size_t
+X86AddVolumeFloat(float *a, const float *b, std::size_t n,
+		  float volume1, float volume2) noexcept
+{
+	return X86HaveAvx2()
+		? Avx2AddVolumeFloat(a, b, n, volume1, volume2)
+		: Sse2AddVolumeFloat(a, b, n, volume1, volume2);
+}
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_PCM_X86_HXX
+#define MPD_PCM_X86_HXX
+
+#include "Traits.hxx"
+#include "FloatConvert.hxx"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Vectorized PCM kernels for x86.  SSE2 is part of the x86-64
+ * baseline and is used unconditionally; AVX2 is used if the CPU
+ * supports it (detected at runtime).
+ *
+ * Each kernel processes only whole blocks of #X86_BLOCK_SIZE samples
+ * and returns the number of samples it has processed; the caller
+ * processes the rest with the portable code.  The results are
+ * bit-exact with the portable code.
+ *
+ * The "Sse2" and "Avx2" functions are exported only for the unit
+ * tests and benchmarks; all other callers should use the
+ * dispatching "X86" functions.
+ */
+
+static constexpr std::size_t X86_BLOCK_SIZE = 16;
+
+bool
+X86HaveAvx2() noexcept;
+
+/*
+ * float to integer, see FloatToIntegerSampleConvert
+ */
+
+std::size_t
+Sse2FloatToS16(int16_t *dest, const float *src, std::size_t n) noexcept;
+
+std::size_t
+Avx2FloatToS16(int16_t *dest, const float *src, std::size_t n) noexcept;
+
+std::size_t
+X86FloatToS16(int16_t *dest, const float *src, std::size_t n) noexcept;
+
+std::size_t
+Sse2FloatToS24(int32_t *dest, const float *src, std::size_t n) noexcept;
+
+std::size_t
+Avx2FloatToS24(int32_t *dest, const float *src, std::size_t n) noexcept;
+
+std::size_t
+X86FloatToS24(int32_t *dest, const float *src, std::size_t n) noexcept;
+
+std::size_t
+Sse2FloatToS32(int32_t *dest, const float *src, std::size_t n) noexcept;
+
+std::size_t
+Avx2FloatToS32(int32_t *dest, const float *src, std::size_t n) noexcept;
+
+std::size_t
+X86FloatToS32(int32_t *dest, const float *src, std::size_t n) noexcept;
+
+/*
+ * integer to float, see IntegerToFloatSampleConvert
+ */
+
+std::size_t
+Sse2S16ToFloat(float *dest, const int16_t *src, std::size_t n) noexcept;
+
+std::size_t
+Avx2S16ToFloat(float *dest, const int16_t *src, std::size_t n) noexcept;
+
+std::size_t
+X86S16ToFloat(float *dest, const int16_t *src, std::size_t n) noexcept;
+
+/**
+ * Convert S24_P32 or S32 to float.
+ *
+ * @param factor the factor from #IntegerToFloatSampleConvert
+ */
+std::size_t
+Sse2S32ToFloat(float *dest, const int32_t *src, std::size_t n,
+	       float factor) noexcept;
+
+std::size_t
+Avx2S32ToFloat(float *dest, const int32_t *src, std::size_t n,
+	       float factor) noexcept;
+
+std::size_t
+X86S32ToFloat(float *dest, const int32_t *src, std::size_t n,
+	      float factor) noexcept;
+
+/*
+ * software volume
+ */
+
+/**
+ * Apply the volume and convert S16 to S24_P32 (without dithering).
+ * The SSE2 implementation does not support volume values above
+ * 0x7fff (nothing is processed).
+ */
+std::size_t
+Sse2Volume16To24(int32_t *dest, const int16_t *src, std::size_t n,
+		 int volume) noexcept;
+
+std::size_t
+Avx2Volume16To24(int32_t *dest, const int16_t *src, std::size_t n,
+		 int volume) noexcept;
+
+std::size_t
+X86Volume16To24(int32_t *dest, const int16_t *src, std::size_t n,
+		int volume) noexcept;
+
+std::size_t
+Sse2VolumeFloat(float *dest, const float *src, std::size_t n,
+		float volume) noexcept;
+
+std::size_t
+Avx2VolumeFloat(float *dest, const float *src, std::size_t n,
+		float volume) noexcept;
+
+std::size_t
+X86VolumeFloat(float *dest, const float *src, std::size_t n,
+	       float volume) noexcept;
+
+/*
+ * mixing
+ */
+
+/**
+ * Add two S16 buffers with saturation (a += b).
+ */
+std::size_t
+Sse2AddS16(int16_t *a, const int16_t *b, std::size_t n) noexcept;
+
+std::size_t
+Avx2AddS16(int16_t *a, const int16_t *b, std::size_t n) noexcept;
+
+std::size_t
+X86AddS16(int16_t *a, const int16_t *b, std::size_t n) noexcept;
+
+/**
+ * Add two S24_P32 buffers, clamping to 24 bit (a += b).
+ */
+std::size_t
+Sse2AddS24(int32_t *a, const int32_t *b, std::size_t n) noexcept;
+
+std::size_t
+Avx2AddS24(int32_t *a, const int32_t *b, std::size_t n) noexcept;
+
+std::size_t
+X86AddS24(int32_t *a, const int32_t *b, std::size_t n) noexcept;
+
+/**
+ * Add two S32 buffers with saturation (a += b).
+ */
+std::size_t
+Sse2AddS32(int32_t *a, const int32_t *b, std::size_t n) noexcept;
+
+std::size_t
+Avx2AddS32(int32_t *a, const int32_t *b, std::size_t n) noexcept;
+
+std::size_t
+X86AddS32(int32_t *a, const int32_t *b, std::size_t n) noexcept;
+
+/**
+ * a = a * volume1 + b * volume2
+ */
+std::size_t
+Sse2AddVolumeFloat(float *a, const float *b, std::size_t n,
+		   float volume1, float volume2) noexcept;
+
+std::size_t
+Avx2AddVolumeFloat(float *a, const float *b, std::size_t n,
+		   float volume1, float volume2) noexcept;
+
+std::size_t
+X86AddVolumeFloat(float *a, const float *b, std::size_t n,
+		  float volume1, float volume2) noexcept;
+
+/**
+ * Adapter for #GlueOptimizedConvert.
+ */
+template<SampleFormat F>
+struct X86FloatToInteger {
+	static constexpr std::size_t BLOCK_SIZE = X86_BLOCK_SIZE;
+
+	void Convert(typename SampleTraits<F>::pointer dest,
+		     const float *src, std::size_t n) const noexcept {
+		if constexpr (F == SampleFormat::S16)
+			X86FloatToS16(dest, src, n);
+		else if constexpr (F == SampleFormat::S24_P32)
+			X86FloatToS24(dest, src, n);
+		else
+			X86FloatToS32(dest, src, n);
+	}
+};
+
+/**
+ * Adapter for #GlueOptimizedConvert.
+ */
+template<SampleFormat F>
+struct X86IntegerToFloat {
+	static constexpr std::size_t BLOCK_SIZE = X86_BLOCK_SIZE;
+
+	void Convert(float *dest,
+		     typename SampleTraits<F>::const_pointer src,
+		     std::size_t n) const noexcept {
+		if constexpr (F == SampleFormat::S16)
+			X86S16ToFloat(dest, src, n);
+		else
+			X86S32ToFloat(dest, src, n,
+				      IntegerToFloatSampleConvert<F>::factor);
+	}
+};
+
+#endif
@@ -509,9 +509,11 @@ Player::MixRampScannerReady() noexcept
 	if (dc.GetMixRampStart() == nullptr) {
 		const std::size_t want_pipe_bytes =
 			dc.out_audio_format.TimeToSize(std::chrono::seconds{20});
+		const std::size_t chunk_size =
+			buffer.GetChunkFillSize(dc.out_audio_format);
 		const std::size_t want_pipe_chunks =
-			std::min((want_pipe_bytes + sizeof(MusicChunk::data) - 1)
-				 / sizeof(MusicChunk::data),
+			std::min((want_pipe_bytes + chunk_size - 1)
+				 / chunk_size,
 				 buffer.GetSize() / std::size_t{3});
 
 		if (dc.pipe->GetSize() < want_pipe_chunks) {
@@ -594,9 +596,11 @@ Player::CheckDecoderStartup(std::unique_lock<Mutex> &lock) noexcept
 
 		const size_t buffer_before_play_size =
 			play_audio_format.TimeToSize(buffer_before_play_duration);
+		const std::size_t chunk_size =
+			buffer.GetChunkFillSize(play_audio_format);
 		buffer_before_play =
-			(buffer_before_play_size + sizeof(MusicChunk::data) - 1)
-			/ sizeof(MusicChunk::data);
+			(buffer_before_play_size + chunk_size - 1)
+			/ chunk_size;
 
 		pc.listener.OnPlayerStateChanged();
 
@@ -885,6 +889,7 @@ Player::CheckCrossFade() noexcept
 					dc.GetMixRampStart(),
 					dc.GetMixRampPreviousEnd(),
 					play_audio_format,
+					buffer.GetChunkFillSize(play_audio_format),
 					buffer.GetSize() -
 					buffer_before_play);
 	if (cross_fade_chunks > 0)
@@ -1248,7 +1253,7 @@ try {
 			  config.replay_gain);
 	dc.StartThread();
 
-	MusicBuffer buffer{config.buffer_chunks};
+	MusicBuffer buffer{config.buffer_chunks, config.chunk_size};
 
 	std::unique_lock<Mutex> lock(mutex);
 
@@ -1294,7 +1299,7 @@ try {
 
 			CommandFinished();
 
-			assert(buffer.IsEmptyUnsafe());
+			assert(buffer.IsEmpty());
 
 			break;
 
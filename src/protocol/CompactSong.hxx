@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_PROTOCOL_COMPACT_SONG_HXX
+#define MPD_PROTOCOL_COMPACT_SONG_HXX
+
+#include <cstdint>
+
+/**
+ * Definitions for the "compact" song format (see command
+ * "songformat").  Songs are transmitted as "binary" chunks; the
+ * concatenation of all song chunk payloads in a connection is a
+ * sequence of records, each starting with a #Record byte.  Integers
+ * are unsigned LEB128 ("varint").
+ */
+namespace CompactSong {
+
+enum class Record : uint8_t {
+	/**
+	 * Define a key: uint8_t key, uint8_t #ValueType, varint name
+	 * length, name.  Each key is defined only once per
+	 * connection, right before the first record using it.
+	 */
+	DEFINE_KEY = 1,
+
+	/**
+	 * A song: varint number of fields, followed by that many
+	 * fields; each is a uint8_t key followed by a value.
+	 */
+	SONG = 2,
+
+	/**
+	 * Clear the string table.
+	 */
+	RESET_STRINGS = 3,
+};
+
+enum class ValueType : uint8_t {
+	/**
+	 * A varint "v"; the lowest two bits of "v" are a
+	 * #StringMode, and the rest is the length of the literal
+	 * which follows or the index in the string table.
+	 */
+	STRING = 0,
+
+	/**
+	 * A varint.
+	 */
+	UNSIGNED = 1,
+};
+
+enum class StringMode : uint8_t {
+	/**
+	 * A literal string which is not added to the string table.
+	 */
+	LITERAL = 0,
+
+	/**
+	 * A literal string which is appended to the string table.
+	 */
+	STORE = 1,
+
+	/**
+	 * A reference to an earlier #STORE string.
+	 */
+	REFERENCE = 2,
+};
+
+/**
+ * Well-known keys.  Tags use #TAG_BASE plus the #TagType value; key
+ * numbers are not guaranteed to be stable across MPD versions, only
+ * the names from #Record::DEFINE_KEY are.
+ */
+enum Key : uint8_t {
+	/**
+	 * The song URI (string).
+	 */
+	KEY_FILE,
+
+	/**
+	 * The modification time in seconds since the epoch
+	 * (unsigned).
+	 */
+	KEY_LAST_MODIFIED,
+
+	/**
+	 * The audio format (string).
+	 */
+	KEY_FORMAT,
+
+	/**
+	 * The "Range" value, same syntax as in the text format
+	 * (string).
+	 */
+	KEY_RANGE,
+
+	/**
+	 * The duration in milliseconds (unsigned).
+	 */
+	KEY_DURATION,
+
+	KEY_TAG_BASE = 16,
+};
+
+} // namespace CompactSong
+
+#endif
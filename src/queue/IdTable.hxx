@@ -4,13 +4,23 @@
 #ifndef MPD_ID_TABLE_HXX
 #define MPD_ID_TABLE_HXX
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 
 /**
  * A table that maps id numbers to position numbers.
+ *
+ * The id number space can be enlarged with Grow() and reduced with
+ * Reset(); the array holding the positions grows on demand, i.e.
+ * only as far as id numbers have actually been handed out.
  */
 class IdTable {
-	const unsigned size;
+	/**
+	 * The size of the id number space; ids wrap around when
+	 * reaching this value.
+	 */
+	unsigned size;
 
 	/**
 	 * How many members of "data" are initialized?
@@ -23,11 +33,16 @@ class IdTable {
 
 	unsigned next;
 
-	int *const data;
+	/**
+	 * The number of allocated elements in #data.
+	 */
+	unsigned capacity = 0;
+
+	int *data = nullptr;
 
 public:
 	IdTable(unsigned _size) noexcept
-		:size(_size), next(1), data(new int[size]) {
+		:size(_size), next(1) {
 	}
 
 	~IdTable() noexcept {
@@ -37,8 +52,42 @@ public:
 	IdTable(const IdTable &) = delete;
 	IdTable &operator=(const IdTable &) = delete;
 
+	/**
+	 * Returns the number of bytes allocated by this object.
+	 */
+	std::size_t GetMemorySize() const noexcept {
+		return capacity * sizeof(*data);
+	}
+
+	/**
+	 * Enlarge the id number space.
+	 */
+	void Grow(unsigned new_size) noexcept {
+		assert(new_size >= size);
+
+		size = new_size;
+	}
+
+	/**
+	 * Change the size of the id number space and free unused
+	 * memory.  This may only be called while no id is in use.
+	 * Id numbers keep counting from where they were, unless
+	 * they are beyond the new size.
+	 */
+	void Reset(unsigned new_size) noexcept {
+		size = new_size;
+
+		if (next >= size)
+			next = 1;
+
+		/* all ids have been erased, so the array can be
+		   truncated to #next */
+		initialized = next;
+		Reallocate(initialized);
+	}
+
 	int IdToPosition(unsigned id) const noexcept {
-		return id < initialized
+		return id > 0 && id < initialized
 			? data[id]
 			: -1;
 	}
@@ -57,6 +106,11 @@ public:
 			if (id == initialized) {
 				/* the caller will initialize
 				   data[id] */
+				if (initialized >= capacity)
+					Reallocate(std::min(std::max(capacity * 2,
+								     64U),
+							    size));
+
 				++initialized;
 				return id;
 			}
@@ -88,6 +142,26 @@ public:
 
 		data[id] = -1;
 	}
+
+private:
+	void Reallocate(unsigned new_capacity) noexcept {
+		assert(new_capacity >= initialized);
+
+		int *new_data = nullptr;
+		if (new_capacity > 0) {
+			new_data = new int[new_capacity];
+
+			/* element 0 is never used */
+			new_data[0] = -1;
+			if (initialized > 1)
+				std::copy(data + 1, data + initialized,
+					  new_data + 1);
+		}
+
+		delete[] data;
+		data = new_data;
+		capacity = new_capacity;
+	}
 };
 
 #endif
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_QUEUE_JOURNAL_HXX
+#define MPD_QUEUE_JOURNAL_HXX
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+/**
+ * A bounded ring buffer which remembers which ranges of queue
+ * positions were modified in which queue version.  This allows
+ * answering "plchanges" without checking every queue item.
+ *
+ * All records must be added with non-decreasing version numbers.
+ */
+class QueueJournal {
+public:
+	/**
+	 * A range of queue positions.
+	 */
+	struct Range {
+		unsigned start, end;
+	};
+
+private:
+	struct Entry {
+		uint32_t version;
+		Range range;
+	};
+
+	static constexpr std::size_t CAPACITY = 1024;
+
+	std::array<Entry, CAPACITY> entries;
+
+	/**
+	 * The index where the next entry will be written.
+	 */
+	std::size_t head = 0;
+
+	/**
+	 * The number of valid entries.
+	 */
+	std::size_t n_entries = 0;
+
+	/**
+	 * All modifications with this version or newer are recorded
+	 * in the journal.
+	 */
+	uint32_t min_version = 0;
+
+public:
+	/**
+	 * Forget all entries.  Call this when the queue has become
+	 * empty.
+	 */
+	void Clear() noexcept {
+		n_entries = 0;
+		min_version = 0;
+	}
+
+	/**
+	 * Forget all entries and make the journal unusable until the
+	 * next Clear() call.  This is used after the queue version
+	 * has wrapped around.
+	 */
+	void Invalidate() noexcept {
+		n_entries = 0;
+		min_version = std::numeric_limits<uint32_t>::max();
+	}
+
+	/**
+	 * Record a modification of the given position range.
+	 * Adjacent or overlapping ranges of the same version are
+	 * merged into one entry.
+	 */
+	void Add(uint32_t version, unsigned start, unsigned end) noexcept {
+		if (start >= end)
+			return;
+
+		if (n_entries > 0) {
+			auto &last = entries[(head + CAPACITY - 1) % CAPACITY];
+			if (last.version == version &&
+			    start <= last.range.end && end >= last.range.start) {
+				last.range.start = std::min(last.range.start, start);
+				last.range.end = std::max(last.range.end, end);
+				return;
+			}
+		}
+
+		if (n_entries == CAPACITY)
+			/* the oldest entry is overwritten; this must not
+			   revive a journal which has been invalidated */
+			min_version = std::max(min_version,
+					       entries[head].version + 1);
+		else
+			++n_entries;
+
+		entries[head] = {version, {start, end}};
+		head = (head + 1) % CAPACITY;
+	}
+
+	void Add(uint32_t version, unsigned position) noexcept {
+		Add(version, position, position + 1);
+	}
+
+	/**
+	 * Collect all position ranges which were modified in the
+	 * given version or later, sorted and without overlaps.  The
+	 * ranges may exceed the current queue length.
+	 *
+	 * @return false if the journal does not reach back to the
+	 * given version
+	 */
+	bool Collect(uint32_t version, std::vector<Range> &result) const {
+		if (version < min_version)
+			return false;
+
+		for (std::size_t i = 1; i <= n_entries; ++i) {
+			const auto &entry = entries[(head + CAPACITY - i) % CAPACITY];
+			if (entry.version < version)
+				break;
+
+			result.push_back(entry.range);
+		}
+
+		std::sort(result.begin(), result.end(),
+			  [](const Range &a, const Range &b){
+				  return a.start < b.start;
+			  });
+
+		/* merge overlapping ranges */
+		auto out = result.begin();
+		for (auto i = result.begin(); i != result.end(); ++i) {
+			if (out != result.begin() && i->start <= std::prev(out)->end)
+				std::prev(out)->end = std::max(std::prev(out)->end,
+							       i->end);
+			else
+				*out++ = *i;
+		}
+
+		result.erase(out, result.end());
+		return true;
+	}
+};
+
+#endif
@@ -9,6 +9,8 @@
 #include "queue/Queue.hxx"
 #include "config.h"
 
+#include <vector>
+
 enum TagType : uint8_t;
 struct Tag;
 struct RangeArg;
@@ -203,6 +205,17 @@ public:
 	 */
 	unsigned AppendSong(PlayerControl &pc, DetachedSong &&song);
 
+	/**
+	 * Append many songs at once.  Unlike calling AppendSong() for
+	 * each of them, this reserves space in the #Queue only once,
+	 * shuffles all new songs in one pass (in random mode) and
+	 * increments the version only once.
+	 *
+	 * Throws PlaylistError if the queue would be too large; the
+	 * songs which fit have been appended already.
+	 */
+	void AppendSongs(PlayerControl &pc, std::vector<DetachedSong> &&songs);
+
 	/**
 	 * Throws #std::runtime_error on error.
 	 *
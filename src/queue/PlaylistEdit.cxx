@@ -103,6 +103,54 @@ playlist::AppendSong(PlayerControl &pc, DetachedSong &&song)
 	return id;
 }
 
+void
+playlist::AppendSongs(PlayerControl &pc, std::vector<DetachedSong> &&songs)
+{
+	if (songs.empty())
+		return;
+
+	queue.Reserve(songs.size());
+
+	const DetachedSong *const queued_song = GetQueuedSong();
+
+	const unsigned old_length = queue.GetLength();
+
+	bool too_large = false;
+	for (auto &song : songs) {
+		if (queue.IsFull()) {
+			too_large = true;
+			break;
+		}
+
+		queue.Append(std::move(song), 0);
+	}
+
+	songs.clear();
+
+	if (queue.GetLength() > old_length) {
+		if (queue.random) {
+			/* shuffle all new songs into the list of
+			   remaining songs to play */
+
+			unsigned start;
+			if (queued >= 0)
+				start = queued + 1;
+			else
+				start = current + 1;
+			if (start < queue.GetLength())
+				queue.ShuffleOrderLastGroup(start,
+							    queue.GetLength());
+		}
+
+		UpdateQueuedSong(pc, queued_song);
+		OnModified();
+	}
+
+	if (too_large)
+		throw PlaylistError(PlaylistResult::TOO_LARGE,
+				    "Playlist is too large");
+}
+
 unsigned
 playlist::AppendURI(PlayerControl &pc, const SongLoader &loader,
 		    const char *uri)
@@ -44,8 +44,9 @@
 #define PLAYLIST_STATE_FILE_STATE_STOP		"stop"
 
 void
-playlist_state_save(BufferedOutputStream &os, const struct playlist &playlist,
-		    PlayerControl &pc)
+playlist_state_save_head(BufferedOutputStream &os,
+			 const struct playlist &playlist,
+			 PlayerControl &pc)
 {
 	const auto player_status = pc.LockGetStatus();
 
@@ -86,6 +87,12 @@ playlist_state_save(BufferedOutputStream &os, const struct playlist &playlist,
 	os.Fmt(FMT_STRING(PLAYLIST_STATE_FILE_MIXRAMPDELAY "{}\n"),
 	       pc.GetMixRampDelay().count());
 	os.Write(PLAYLIST_STATE_FILE_PLAYLIST_BEGIN "\n");
+}
+
+void
+playlist_state_save_queue(BufferedOutputStream &os,
+			  const struct playlist &playlist)
+{
 	queue_save(os, playlist.queue);
 	os.Write(PLAYLIST_STATE_FILE_PLAYLIST_END "\n");
 }
@@ -16,9 +16,20 @@ class LineReader;
 class BufferedOutputStream;
 class SongLoader;
 
+/**
+ * Write the playback state and the options.  The caller must finish
+ * this section with the output of playlist_state_save_queue().
+ */
+void
+playlist_state_save_head(BufferedOutputStream &os, const playlist &playlist,
+			 PlayerControl &pc);
+
+/**
+ * Write the queue.  The output changes only when the queue version
+ * changes, so it may be reused by the caller.
+ */
 void
-playlist_state_save(BufferedOutputStream &os, const playlist &playlist,
-		    PlayerControl &pc);
+playlist_state_save_queue(BufferedOutputStream &os, const playlist &playlist);
 
 bool
 playlist_state_restore(const StateFileConfig &config,
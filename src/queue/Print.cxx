@@ -69,9 +69,9 @@ queue_print_changes_info(Response &r, const Queue &queue,
 	assert(start <= end);
 	assert(end <= queue.GetLength());
 
-	for (unsigned i = start; i < end; i++)
-		if (queue.IsNewerAtPosition(i, version))
-			queue_print_song_info(r, queue, i);
+	queue.ForEachNewerPosition(version, start, end, [&](unsigned i){
+		queue_print_song_info(r, queue, i);
+	});
 }
 
 void
@@ -82,10 +82,10 @@ queue_print_changes_position(Response &r, const Queue &queue,
 	assert(start <= end);
 	assert(end <= queue.GetLength());
 
-	for (unsigned i = start; i < end; i++)
-		if (queue.IsNewerAtPosition(i, version))
-			r.Fmt(FMT_STRING("cpos: {}\nId: {}\n"),
-			      i, queue.PositionToId(i));
+	queue.ForEachNewerPosition(version, start, end, [&](unsigned i){
+		r.Fmt(FMT_STRING("cpos: {}\nId: {}\n"),
+		      i, queue.PositionToId(i));
+	});
 }
 
 [[gnu::pure]]
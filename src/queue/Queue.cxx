@@ -9,9 +9,10 @@
 
 Queue::Queue(unsigned _max_length) noexcept
 	:max_length(_max_length),
-	 items(new Item[max_length]),
-	 order(new unsigned[max_length]),
-	 id_table(max_length * HASH_MULT)
+	 capacity(std::min(INITIAL_CAPACITY, max_length)),
+	 items(new Item[capacity]),
+	 order(new unsigned[capacity]),
+	 id_table(GetIdSpace(capacity))
 {
 }
 
@@ -23,6 +24,25 @@ Queue::~Queue() noexcept
 	delete[] order;
 }
 
+void
+Queue::Reallocate(unsigned new_capacity) noexcept
+{
+	assert(new_capacity >= length);
+	assert(new_capacity <= max_length);
+
+	auto *new_items = new Item[new_capacity];
+	std::copy_n(items, length, new_items);
+	delete[] items;
+	items = new_items;
+
+	auto *new_order = new unsigned[new_capacity];
+	std::copy_n(order, length, new_order);
+	delete[] order;
+	order = new_order;
+
+	capacity = new_capacity;
+}
+
 LightSong
 Queue::GetLight(unsigned position) const noexcept
 {
@@ -61,6 +81,10 @@ Queue::IncrementVersion() noexcept
 		for (unsigned i = 0; i < length; i++)
 			items[i].version = 0;
 
+		/* the journal can't express version 0 ("always
+		   newer") */
+		journal.Invalidate();
+
 		version = 1;
 	}
 }
@@ -79,6 +103,11 @@ Queue::Append(DetachedSong &&song, uint8_t priority) noexcept
 {
 	assert(!IsFull());
 
+	if (length == capacity) {
+		Reallocate(std::min(capacity * 2, max_length));
+		id_table.Grow(GetIdSpace(capacity));
+	}
+
 	const unsigned position = length++;
 	const unsigned id = id_table.Insert(position);
 
@@ -87,12 +116,25 @@ Queue::Append(DetachedSong &&song, uint8_t priority) noexcept
 	item.id = id;
 	item.version = version;
 	item.priority = priority;
+	journal.Add(version, position);
 
 	order[position] = position;
 
 	return id;
 }
 
+void
+Queue::Reserve(unsigned n) noexcept
+{
+	const unsigned wanted = length + std::min(n, max_length - length);
+	if (wanted <= capacity)
+		return;
+
+	/* grow at least geometrically, just like Append() does */
+	Reallocate(std::max(wanted, std::min(capacity * 2, max_length)));
+	id_table.Grow(GetIdSpace(capacity));
+}
+
 void
 Queue::SwapPositions(unsigned position1, unsigned position2) noexcept
 {
@@ -103,6 +145,8 @@ Queue::SwapPositions(unsigned position1, unsigned position2) noexcept
 
 	items[position1].version = version;
 	items[position2].version = version;
+	journal.Add(version, position1);
+	journal.Add(version, position2);
 
 	id_table.Move(id1, position2);
 	id_table.Move(id2, position1);
@@ -113,6 +157,10 @@ Queue::MovePostion(unsigned from, unsigned to) noexcept
 {
 	const Item tmp = items[from];
 
+	/* record the whole range at once; the journal merges the
+	   single positions recorded below into this entry */
+	journal.Add(version, std::min(from, to), std::max(from, to) + 1);
+
 	/* move songs to one less in from->to */
 
 	for (unsigned i = from; i < to; i++)
@@ -149,6 +197,11 @@ Queue::MoveRange(unsigned start, unsigned end, unsigned to) noexcept
 {
 	const auto tmp = std::make_unique<Item[]>(end - start);
 
+	/* record the whole range at once; the journal merges the
+	   single positions recorded below into this entry */
+	journal.Add(version, std::min(start, to),
+		    std::max(end, to + end - start));
+
 	// Copy the original block [start,end-1]
 	for (unsigned i = start; i < end; i++)
 		tmp[i - start] = items[i];
@@ -169,6 +222,7 @@ Queue::MoveRange(unsigned start, unsigned end, unsigned to) noexcept
 		id_table.Move(tmp[i - start].id, to + i - start);
 		items[to + i - start] = tmp[i-start];
 		items[to + i - start].version = version;
+		journal.Add(version, to + i - start);
 	}
 
 	if (random) {
@@ -237,6 +291,8 @@ Queue::DeletePosition(unsigned position) noexcept
 
 	--length;
 
+	journal.Add(version, position, length);
+
 	/* release the song id */
 
 	id_table.Erase(id);
@@ -270,6 +326,12 @@ Queue::Clear() noexcept
 	}
 
 	length = 0;
+	journal.Clear();
+
+	if (capacity > INITIAL_CAPACITY) {
+		Reallocate(INITIAL_CAPACITY);
+		id_table.Reset(GetIdSpace(capacity));
+	}
 }
 
 static void
@@ -376,6 +438,21 @@ Queue::ShuffleOrderLastWithPriority(unsigned start, unsigned end) noexcept
 	SwapOrders(end - 1, distribution(rand));
 }
 
+void
+Queue::ShuffleOrderLastGroup(unsigned start, unsigned end) noexcept
+{
+	assert(end <= length);
+	assert(start < end);
+
+	const auto last_priority = items[OrderToPosition(end - 1)].priority;
+	while (items[OrderToPosition(start)].priority != last_priority) {
+		++start;
+		assert(start < end);
+	}
+
+	ShuffleOrderRange(start, end);
+}
+
 void
 Queue::ShuffleRange(unsigned start, unsigned end) noexcept
 {
@@ -384,6 +461,8 @@ Queue::ShuffleRange(unsigned start, unsigned end) noexcept
 
 	rand.AutoCreate();
 
+	journal.Add(version, start, end);
+
 	for (unsigned i = start; i < end; i++) {
 		std::uniform_int_distribution<unsigned> distribution(start,
 								     end - 1);
@@ -438,6 +517,7 @@ Queue::SetPriority(unsigned position, uint8_t priority, int after_order,
 
 	item->version = version;
 	item->priority = priority;
+	journal.Add(version, position);
 
 	if (!random || !reorder)
 		/* don't reorder if not in random mode */
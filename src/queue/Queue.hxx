@@ -5,13 +5,17 @@
 #define MPD_QUEUE_HXX
 
 #include "IdTable.hxx"
+#include "Journal.hxx"
 #include "SingleMode.hxx"
 #include "ConsumeMode.hxx"
 #include "util/LazyRandomEngine.hxx"
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <utility>
+#include <vector>
 
 struct LightSong;
 class DetachedSong;
@@ -28,11 +32,24 @@ class DetachedSong;
  */
 struct Queue {
 	/**
-	 * reserve max_length * HASH_MULT elements in the id
+	 * reserve capacity * HASH_MULT elements in the id
 	 * number space
 	 */
 	static constexpr unsigned HASH_MULT = 4;
 
+	/**
+	 * The initial number of allocated items; the arrays grow
+	 * geometrically from here, up to #max_length.
+	 */
+	static constexpr unsigned INITIAL_CAPACITY = 64;
+
+	/**
+	 * The id number space covers at least this number of items
+	 * (times #HASH_MULT), even if fewer are allocated, to avoid
+	 * reusing ids too early in a short queue.
+	 */
+	static constexpr unsigned MIN_ID_CAPACITY = 16 * 1024;
+
 	/**
 	 * One element of the queue: basically a song plus some queue specific
 	 * information attached.
@@ -60,18 +77,24 @@ struct Queue {
 	/** number of songs in the queue */
 	unsigned length = 0;
 
+	/** number of allocated elements in #items and #order */
+	unsigned capacity;
+
 	/** the current version number */
 	uint32_t version = 1;
 
 	/** all songs in "position" order */
-	Item *const items;
+	Item *items;
 
 	/** map order numbers to positions */
-	unsigned *const order;
+	unsigned *order;
 
 	/** map song ids to positions */
 	IdTable id_table;
 
+	/** which positions were modified in recent versions? */
+	QueueJournal journal;
+
 	/** repeat playback when the end of the queue has been
 	    reached? */
 	bool repeat = false;
@@ -100,6 +123,16 @@ struct Queue {
 		return length;
 	}
 
+	/**
+	 * Returns the number of bytes allocated for managing the
+	 * queue (not including the songs).
+	 */
+	[[gnu::pure]]
+	std::size_t GetMemorySize() const noexcept {
+		return capacity * (sizeof(*items) + sizeof(*order)) +
+			id_table.GetMemorySize();
+	}
+
 	/**
 	 * Determine if the queue is empty, i.e. there are no songs.
 	 */
@@ -210,6 +243,39 @@ struct Queue {
 			items[position].version == 0;
 	}
 
+	/**
+	 * Invoke a function for each position in the range
+	 * [start,end) which is newer than the specified version (see
+	 * IsNewerAtPosition()), in ascending order.  This uses the
+	 * #journal to skip unmodified positions; only if the
+	 * journal does not reach back far enough, all positions are
+	 * checked.
+	 */
+	template<typename F>
+	void ForEachNewerPosition(uint32_t _version,
+				  unsigned start, unsigned end,
+				  F &&f) const {
+		assert(start <= end);
+		assert(end <= length);
+
+		std::vector<QueueJournal::Range> ranges;
+		if (_version <= version && journal.Collect(_version, ranges)) {
+			for (const auto &range : ranges) {
+				const unsigned range_end = std::min(range.end, end);
+				for (unsigned i = std::max(range.start, start);
+				     i < range_end; ++i)
+					if (IsNewerAtPosition(i, _version))
+						f(i);
+			}
+
+			return;
+		}
+
+		for (unsigned i = start; i < end; ++i)
+			if (IsNewerAtPosition(i, _version))
+				f(i);
+	}
+
 	/**
 	 * Returns the order number following the specified one.  This takes
 	 * end of queue and "repeat" mode into account.
@@ -234,6 +300,7 @@ struct Queue {
 		assert(position < length);
 
 		items[position].version = version;
+		journal.Add(version, position);
 	}
 
 	/**
@@ -255,6 +322,13 @@ struct Queue {
 	 */
 	unsigned Append(DetachedSong &&song, uint8_t priority) noexcept;
 
+	/**
+	 * Allocate enough space for appending the specified number
+	 * of songs (but not more than #max_length) without
+	 * reallocating.
+	 */
+	void Reserve(unsigned n) noexcept;
+
 	/**
 	 * Swaps two songs, addressed by their position.
 	 */
@@ -308,7 +382,8 @@ struct Queue {
 	void DeletePosition(unsigned position) noexcept;
 
 	/**
-	 * Removes all songs from the playlist.
+	 * Removes all songs from the playlist and frees unused
+	 * memory.
 	 */
 	void Clear() noexcept;
 
@@ -349,6 +424,13 @@ struct Queue {
 	 */
 	void ShuffleOrderLastWithPriority(unsigned start, unsigned end) noexcept;
 
+	/**
+	 * Like ShuffleOrderLastWithPriority(), but shuffle all songs
+	 * in the last song's priority group.  This is used in random
+	 * mode after many songs have been appended.
+	 */
+	void ShuffleOrderLastGroup(unsigned start, unsigned end) noexcept;
+
 	/**
 	 * Shuffles a (position) range in the queue.  The songs are physically
 	 * shuffled, not by using the "order" mapping.
@@ -362,11 +444,24 @@ struct Queue {
 			      uint8_t priority, int after_order) noexcept;
 
 private:
+	[[gnu::pure]]
+	unsigned GetIdSpace(unsigned _capacity) const noexcept {
+		return std::max(_capacity,
+				std::min(max_length, MIN_ID_CAPACITY))
+			* HASH_MULT;
+	}
+
+	/**
+	 * Change the size of the #items and #order arrays.
+	 */
+	void Reallocate(unsigned new_capacity) noexcept;
+
 	void MoveItemTo(unsigned from, unsigned to) noexcept {
 		unsigned from_id = items[from].id;
 
 		items[to] = items[from];
 		items[to].version = version;
+		journal.Add(version, to);
 		id_table.Move(from_id, to);
 	}
 
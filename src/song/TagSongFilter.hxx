@@ -34,6 +34,14 @@ public:
 		return filter.GetFoldCase();
 	}
 
+	auto GetPosition() const noexcept {
+		return filter.GetPosition();
+	}
+
+	bool IsRegex() const noexcept {
+		return filter.IsRegex();
+	}
+
 	bool IsNegated() const noexcept {
 		return filter.IsNegated();
 	}
@@ -0,0 +1,283 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// author: Max Kellermann <max.kellermann@gmail.com>
+
+#ifndef MPD_ATOMIC_SLICE_BUFFER_HXX
+#define MPD_ATOMIC_SLICE_BUFFER_HXX
+
+#include "HugeAllocator.hxx"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+
+/**
+ * A thread-safe variant of #SliceBuffer which does not need a mutex:
+ * the free slices are managed in a lock-free stack, and any number
+ * of threads may allocate and free slices concurrently.
+ *
+ * The slice size may be larger than sizeof(T), which allows
+ * allocating objects with a variable-sized tail.
+ *
+ * Like #SliceBuffer, the memory is given back to the kernel when the
+ * last slice gets freed; while that happens (which is rare),
+ * Allocate() callers in other threads spin.
+ */
+template<typename T>
+class AtomicSliceBuffer {
+	HugeArray<std::byte> buffer;
+
+	/**
+	 * The size of each slice in bytes.
+	 */
+	const std::size_t slice_size;
+
+	/**
+	 * The number of slices in #buffer.
+	 */
+	const unsigned n_slices;
+
+	/**
+	 * The index of the next free slice for each slice which is
+	 * in the free stack (plus one; zero means end of stack).
+	 * This is not stored in the slices themselves, because
+	 * another thread may still be reading the value while the
+	 * slice is already being used.
+	 */
+	const std::unique_ptr<std::atomic<uint32_t>[]> next_free;
+
+	/**
+	 * The top of the free stack: the lower 32 bits are the slice
+	 * index plus one (zero means the stack is empty), the upper
+	 * 32 bits are a counter which is incremented on each
+	 * modification to avoid the ABA problem.
+	 */
+	std::atomic<uint64_t> free_top{0};
+
+	/**
+	 * The number of slices that are initialized.  Slices beyond
+	 * this have never been touched, so the kernel does not need
+	 * to reserve physical memory pages for them.
+	 */
+	std::atomic<unsigned> n_initialized{0};
+
+	/**
+	 * This flag in #n_allocated means the memory is being
+	 * discarded right now.
+	 */
+	static constexpr unsigned DISCARDING = 1U << 31;
+
+	/**
+	 * The number of slices currently allocated, possibly
+	 * combined with #DISCARDING.
+	 */
+	std::atomic<unsigned> n_allocated{0};
+
+public:
+	/**
+	 * @param _slice_size the size of each slice in bytes; it is
+	 * rounded up to the alignment of T
+	 */
+	explicit AtomicSliceBuffer(unsigned _count,
+				   std::size_t _slice_size=sizeof(T))
+		:buffer(_count * AlignSize(_slice_size)),
+		 slice_size(AlignSize(_slice_size)),
+		 n_slices(_count),
+		 next_free(new std::atomic<uint32_t>[_count]) {
+		assert(_slice_size >= sizeof(T));
+		assert(_count < DISCARDING);
+
+		buffer.ForkCow(false);
+	}
+
+	~AtomicSliceBuffer() noexcept {
+		/* all slices must be freed explicitly, and this
+		   assertion checks for leaks */
+		assert(empty());
+	}
+
+	AtomicSliceBuffer(const AtomicSliceBuffer &other) = delete;
+	AtomicSliceBuffer &operator=(const AtomicSliceBuffer &other) = delete;
+
+	unsigned GetCapacity() const noexcept {
+		return n_slices;
+	}
+
+	/**
+	 * Returns the size of each slice in bytes.
+	 */
+	std::size_t GetSliceSize() const noexcept {
+		return slice_size;
+	}
+
+	bool empty() const noexcept {
+		return (n_allocated.load(std::memory_order_relaxed) & ~DISCARDING) == 0;
+	}
+
+	bool IsFull() const noexcept {
+		return (n_allocated.load(std::memory_order_relaxed) & ~DISCARDING) == n_slices;
+	}
+
+	void SetName(const char *name) noexcept {
+		buffer.SetName(name);
+	}
+
+	template<typename... Args>
+	T *Allocate(Args&&... args) {
+		AcquireCount();
+
+		std::byte *slice = Pop();
+		if (slice == nullptr)
+			slice = InitializeNew();
+
+		if (slice == nullptr) {
+			/* out of (internal) memory, buffer is full */
+			ReleaseCount();
+			return nullptr;
+		}
+
+		/* construct the object */
+		return ::new((void *)slice) T(std::forward<Args>(args)...);
+	}
+
+	void Free(T *value) noexcept {
+		std::byte *slice = reinterpret_cast<std::byte *>(value);
+		assert(slice >= &buffer.front() && slice <= &buffer.back());
+		assert((slice - &buffer.front()) % slice_size == 0);
+		assert(!empty());
+
+		/* destruct the object */
+		value->~T();
+
+		Push(slice);
+		ReleaseCount();
+	}
+
+private:
+	static constexpr std::size_t AlignSize(std::size_t size) noexcept {
+		return (size + alignof(T) - 1) / alignof(T) * alignof(T);
+	}
+
+	static constexpr uint64_t MakeTop(uint64_t tag, uint32_t index) noexcept {
+		return (tag << 32) | index;
+	}
+
+	static constexpr uint64_t GetTag(uint64_t top) noexcept {
+		return top >> 32;
+	}
+
+	static constexpr uint32_t GetIndex(uint64_t top) noexcept {
+		return static_cast<uint32_t>(top);
+	}
+
+	uint32_t ToIndex(const std::byte *slice) const noexcept {
+		return static_cast<uint32_t>((slice - &buffer.front()) / slice_size) + 1;
+	}
+
+	std::byte *FromIndex(uint32_t index) noexcept {
+		return &buffer[(index - 1) * slice_size];
+	}
+
+	std::byte *Pop() noexcept {
+		uint64_t top = free_top.load(std::memory_order_acquire);
+
+		while (true) {
+			const uint32_t index = GetIndex(top);
+			if (index == 0)
+				return nullptr;
+
+			/* if another thread pops this slice
+			   concurrently, the value may be stale, but
+			   then the tag has changed and the CAS
+			   fails */
+			const uint32_t next =
+				next_free[index - 1].load(std::memory_order_relaxed);
+
+			if (free_top.compare_exchange_weak(top,
+							   MakeTop(GetTag(top) + 1, next),
+							   std::memory_order_acquire,
+							   std::memory_order_acquire))
+				return FromIndex(index);
+		}
+	}
+
+	void Push(std::byte *slice) noexcept {
+		const uint32_t index = ToIndex(slice);
+		uint64_t top = free_top.load(std::memory_order_relaxed);
+
+		do {
+			next_free[index - 1].store(GetIndex(top),
+						   std::memory_order_relaxed);
+		} while (!free_top.compare_exchange_weak(top,
+							 MakeTop(GetTag(top) + 1, index),
+							 std::memory_order_release,
+							 std::memory_order_relaxed));
+	}
+
+	/**
+	 * Take a slice which has never been used before.
+	 */
+	std::byte *InitializeNew() noexcept {
+		unsigned n = n_initialized.load(std::memory_order_relaxed);
+
+		do {
+			if (n >= n_slices)
+				return nullptr;
+		} while (!n_initialized.compare_exchange_weak(n, n + 1,
+							      std::memory_order_relaxed));
+
+		return FromIndex(n + 1);
+	}
+
+	/**
+	 * Increment #n_allocated, waiting while the memory is being
+	 * discarded.
+	 */
+	void AcquireCount() noexcept {
+		unsigned n = n_allocated.load(std::memory_order_relaxed);
+
+		while (true) {
+			if (n & DISCARDING) [[unlikely]] {
+				std::this_thread::yield();
+				n = n_allocated.load(std::memory_order_relaxed);
+				continue;
+			}
+
+			if (n_allocated.compare_exchange_weak(n, n + 1,
+							      std::memory_order_acquire,
+							      std::memory_order_relaxed))
+				return;
+		}
+	}
+
+	/**
+	 * Decrement #n_allocated, and give memory back to the kernel
+	 * when the last slice was freed.
+	 */
+	void ReleaseCount() noexcept {
+		if (n_allocated.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+
+		/* the counter has dropped to zero; try to get
+		   exclusive access */
+		unsigned expected = 0;
+		if (!n_allocated.compare_exchange_strong(expected, DISCARDING,
+							 std::memory_order_acquire,
+							 std::memory_order_relaxed))
+			/* another thread was faster */
+			return;
+
+		buffer.Discard();
+		n_initialized.store(0, std::memory_order_relaxed);
+		free_top.store(MakeTop(GetTag(free_top.load(std::memory_order_relaxed)) + 1, 0),
+			       std::memory_order_relaxed);
+
+		n_allocated.store(0, std::memory_order_release);
+	}
+};
+
+#endif
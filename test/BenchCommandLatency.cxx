@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * This program measures the round-trip time of a cheap command
+ * ("status") on one connection to a running MPD while another
+ * connection keeps sending an expensive one (e.g. a "search" on a
+ * large database).  Without the background thread pool, the
+ * expensive command blocks the main thread and shows up in the tail
+ * latency of the cheap one.
+ *
+ * Set "response_cache_size" to 0 in the MPD configuration, or else
+ * the expensive command is answered from the cache after its first
+ * run.  Wrapping it in a command list ("command_list_begin\n...\n
+ * command_list_end") runs it in the main thread, for comparison.
+ */
+
+#include "MpdConnection.hxx"
+#include "util/PrintException.hxx"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+
+int
+main(int argc, char **argv)
+try {
+	if (argc < 2 || argc > 4) {
+		fmt::print(stderr, "Usage: BenchCommandLatency HOST[:PORT] [EXPENSIVE_COMMAND] [N]\n");
+		return EXIT_FAILURE;
+	}
+
+	const char *const host = argv[1];
+	const std::string expensive = std::string{argc > 2 ? argv[2] : "search \"(any contains \\\"e\\\")\""} + "\n";
+	const unsigned n_requests = argc > 3 ? strtoul(argv[3], nullptr, 10) : 1000;
+	if (n_requests == 0)
+		throw std::invalid_argument("Invalid number of requests");
+
+	MpdConnection cheap(host), heavy(host);
+
+	std::atomic_bool quit{false};
+	unsigned n_heavy = 0;
+
+	std::thread heavy_thread([&]{
+		try {
+			while (!quit.load(std::memory_order_relaxed)) {
+				heavy.Command(expensive);
+				++n_heavy;
+			}
+		} catch (...) {
+			PrintException(std::current_exception());
+		}
+	});
+
+	using Clock = std::chrono::steady_clock;
+	std::vector<std::chrono::duration<double>> durations;
+	durations.reserve(n_requests);
+
+	for (unsigned i = 0; i < n_requests; ++i) {
+		const auto start = Clock::now();
+		cheap.Command("status\n");
+		durations.push_back(Clock::now() - start);
+	}
+
+	quit.store(true, std::memory_order_relaxed);
+	heavy_thread.join();
+
+	std::sort(durations.begin(), durations.end());
+
+	const auto percentile = [&durations](unsigned p){
+		return durations[(durations.size() - 1) * p / 100].count() * 1e3;
+	};
+
+	fmt::print("{} expensive requests; status: p50={:.3f}ms p99={:.3f}ms max={:.3f}ms\n",
+		   n_heavy, percentile(50), percentile(99),
+		   durations.back().count() * 1e3);
+
+	return EXIT_SUCCESS;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * This program measures how a large command list (e.g. 10k "addid"
+ * lines) is collected by the #CommandListBuilder and then tokenized
+ * the way command_process() does, and counts the memory allocations.
+ * For comparison, it does the same with a std::list<std::string>,
+ * which is how command lists used to be stored.
+ */
+
+#include "command/CommandListBuilder.hxx"
+#include "client/Config.hxx"
+#include "util/Tokenizer.hxx"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <new>
+#include <string>
+#include <vector>
+
+size_t client_max_command_list_size = 64 * 1024 * 1024;
+
+static std::size_t n_allocations;
+
+void *
+operator new(std::size_t size)
+{
+	++n_allocations;
+	if (void *p = std::malloc(size))
+		return p;
+
+	throw std::bad_alloc{};
+}
+
+void
+operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+
+void
+operator delete(void *p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+static unsigned
+Tokenize(char *line)
+{
+	Tokenizer tokenizer(line);
+	tokenizer.NextWord();
+
+	unsigned n = 0;
+	while (tokenizer.NextParam() != nullptr)
+		++n;
+	return n;
+}
+
+template<typename F>
+static void
+Measure(const char *label, unsigned n_lists, F &&f)
+{
+	using Clock = std::chrono::steady_clock;
+
+	const std::size_t start_allocations = n_allocations;
+	const auto start = Clock::now();
+
+	unsigned n_args = 0;
+	for (unsigned i = 0; i < n_lists; ++i)
+		n_args += f();
+
+	const std::chrono::duration<double> duration = Clock::now() - start;
+
+	fmt::print("{}: {} args, {:.3f} ms per list, {} allocations per list\n",
+		   label, n_args, duration.count() * 1e3 / n_lists,
+		   (n_allocations - start_allocations) / n_lists);
+}
+
+int
+main(int argc, char **argv)
+{
+	const unsigned n_lines = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000;
+	const unsigned n_lists = argc > 2 ? strtoul(argv[2], nullptr, 10) : 100;
+
+	/* the lines as they would appear in the client's input
+	   buffer */
+	std::vector<std::string> lines;
+	lines.reserve(n_lines);
+	for (unsigned i = 0; i < n_lines; ++i)
+		lines.emplace_back(fmt::format("addid \"Artist {}/Album {}/{:02} Title.flac\"",
+					       i / 100, i / 10, i % 10));
+
+	Measure("std::list<std::string>", n_lists, [&lines]{
+		std::list<std::string> list;
+		for (const auto &i : lines)
+			list.emplace_back(i.c_str());
+
+		unsigned n = 0;
+		for (auto &i : list)
+			n += Tokenize(&*i.begin());
+		return n;
+	});
+
+	CommandListBuilder builder;
+	Measure("CommandListBuilder", n_lists, [&lines, &builder]{
+		builder.Begin(false);
+		for (const auto &i : lines)
+			builder.Add(i);
+
+		auto list = builder.Commit();
+		builder.Reset();
+
+		unsigned n = 0;
+		for (char *p = list.data(), *const end = p + list.size();
+		     p != end;) {
+			char *cmd = p;
+			p += std::strlen(cmd) + 1;
+			n += Tokenize(cmd);
+		}
+		return n;
+	});
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * This program dumps the song database of a running MPD
+ * ("listallinfo") in the "text" and in the "compact" song format
+ * and measures the transferred bytes and the time it takes to
+ * receive and parse all songs.
+ */
+
+#include "MpdConnection.hxx"
+#include "CompactSongDecoder.hxx"
+#include "util/PrintException.hxx"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+#include <stdlib.h>
+
+struct DumpResult {
+	std::size_t n_songs = 0, n_fields = 0;
+};
+
+static DumpResult
+DumpText(MpdConnection &c, const std::string &command)
+{
+	c.Send(command);
+
+	DumpResult result;
+
+	while (true) {
+		const auto line = c.ReadLine();
+		if (line == "OK")
+			break;
+
+		if (line.starts_with("ACK "))
+			throw std::runtime_error(std::string{line});
+
+		const auto colon = line.find(": ");
+		if (colon == line.npos)
+			throw std::runtime_error("Malformed line");
+
+		if (line.substr(0, colon) == "file")
+			++result.n_songs;
+		else if (line.substr(0, colon) == "directory" ||
+			 line.substr(0, colon) == "playlist")
+			continue;
+
+		++result.n_fields;
+	}
+
+	return result;
+}
+
+static DumpResult
+DumpCompact(MpdConnection &c, CompactSongDecoder &decoder,
+	    const std::string &command)
+{
+	c.Send(command);
+
+	DumpResult result;
+
+	while (true) {
+		const auto line = c.ReadLine();
+		if (line == "OK")
+			break;
+
+		if (line.starts_with("ACK "))
+			throw std::runtime_error(std::string{line});
+
+		if (line.starts_with("binary: ")) {
+			const std::size_t size =
+				strtoul(std::string{line.substr(8)}.c_str(),
+					nullptr, 10);
+			decoder.Feed(c.ReadBinary(size),
+				     [&result](CompactSongDecoder::Song &&song){
+					     ++result.n_songs;
+					     result.n_fields += song.size();
+				     });
+		} else if (line.starts_with("file: ")) {
+			/* "compact" is not supported for this song */
+			++result.n_songs;
+			++result.n_fields;
+		} else if (!line.starts_with("directory: ") &&
+			   !line.starts_with("playlist: ")) {
+			++result.n_fields;
+		}
+	}
+
+	if (!decoder.IsEmpty())
+		throw std::runtime_error("Incomplete compact record");
+
+	return result;
+}
+
+template<typename F>
+static void
+Measure(const char *label, MpdConnection &c, F &&f)
+{
+	using Clock = std::chrono::steady_clock;
+
+	const std::size_t start_bytes = c.GetReceivedBytes();
+	const auto start = Clock::now();
+	const DumpResult result = f();
+	const std::chrono::duration<double> duration = Clock::now() - start;
+
+	fmt::print("{}: {} songs, {} fields, {} bytes, {:.3f} ms\n",
+		   label, result.n_songs, result.n_fields,
+		   c.GetReceivedBytes() - start_bytes,
+		   duration.count() * 1e3);
+}
+
+int
+main(int argc, char **argv)
+try {
+	if (argc < 2 || argc > 3) {
+		fmt::print(stderr, "Usage: BenchCompactSongs HOST[:PORT] [COMMAND]\n");
+		return EXIT_FAILURE;
+	}
+
+	const char *const host = argv[1];
+	const std::string command = std::string{argc > 2 ? argv[2] : "listallinfo"} + "\n";
+
+	MpdConnection c(host);
+
+	/* the default "binarylimit" is small; allow larger chunks */
+	c.Command("binarylimit 65536\n");
+
+	Measure("text", c, [&]{
+		return DumpText(c, command);
+	});
+
+	c.Command("songformat compact\n");
+
+	CompactSongDecoder decoder;
+	Measure("compact", c, [&]{
+		return DumpCompact(c, decoder, command);
+	});
+
+	/* a second dump with the string table already populated */
+	Measure("compact (warm)", c, [&]{
+		return DumpCompact(c, decoder, command);
+	});
+
+	return EXIT_SUCCESS;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
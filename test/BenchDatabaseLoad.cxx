@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * This program measures the startup cost of the "simple" database.
+ * It generates a synthetic library, saves it in all supported
+ * formats into the given directory and measures how long it takes to
+ * load and to free each file, and how much resident memory the loaded
+ * database occupies.
+ */
+
+#include "config.h"
+#include "db/plugins/simple/DatabaseSave.hxx"
+#include "db/plugins/simple/BinaryDatabase.hxx"
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "tag/Builder.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "fs/FileInfo.hxx"
+#include "fs/NarrowPath.hxx"
+#include "io/BufferedOutputStream.hxx"
+#include "io/FileOutputStream.hxx"
+#include "util/PrintException.hxx"
+
+#ifdef ENABLE_ZLIB
+#include "lib/zlib/GzipOutputStream.hxx"
+#endif
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+/**
+ * Returns the current resident set size of this process in bytes
+ * (or 0 if unknown).
+ */
+static std::size_t
+GetResidentMemory() noexcept
+{
+	FILE *file = fopen("/proc/self/statm", "r");
+	if (file == nullptr)
+		return 0;
+
+	unsigned long size, resident;
+	const bool success = fscanf(file, "%lu %lu", &size, &resident) == 2;
+	fclose(file);
+	if (!success)
+		return 0;
+
+	return std::size_t(resident) * sysconf(_SC_PAGESIZE);
+}
+
+static std::unique_ptr<Directory>
+MakeLibrary(unsigned n_songs)
+{
+	static constexpr unsigned SONGS_PER_ALBUM = 12, ALBUMS_PER_ARTIST = 4;
+
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	const ScopeDatabaseLock protect;
+
+	Directory *artist = nullptr, *album = nullptr;
+	unsigned artist_no = 0, album_no = 0;
+
+	for (unsigned i = 0; i < n_songs; ++i) {
+		const unsigned track = i % SONGS_PER_ALBUM;
+		if (track == 0) {
+			if (album_no % ALBUMS_PER_ARTIST == 0)
+				artist = root->CreateChild(fmt::format("Artist {}", ++artist_no));
+
+			album = artist->CreateChild(fmt::format("Album {}", ++album_no));
+			album->mtime = std::chrono::system_clock::from_time_t(1600000000 + album_no);
+		}
+
+		auto song = Song::New(fmt::format("{:02} Title {}.flac", track + 1, i),
+				      *album);
+		song->mtime = std::chrono::system_clock::from_time_t(1600000000 + i);
+		song->audio_format = AudioFormat(44100, SampleFormat::S16, 2);
+
+		TagBuilder tag;
+		tag.SetDuration(SignedSongTime::FromMS(180000 + i % 120000));
+		tag.AddItem(TAG_ARTIST, fmt::format("Artist {}", artist_no));
+		tag.AddItem(TAG_ALBUM_ARTIST, fmt::format("Artist {}", artist_no));
+		tag.AddItem(TAG_ALBUM, fmt::format("Album {}", album_no));
+		tag.AddItem(TAG_TITLE, fmt::format("Title {}", i));
+		tag.AddItem(TAG_TRACK, fmt::format("{}", track + 1));
+		tag.AddItem(TAG_DATE, fmt::format("{}", 1960 + album_no % 60));
+		tag.AddItem(TAG_GENRE, fmt::format("Genre {}", album_no % 20));
+		tag.Commit(song->tag);
+
+		album->AddSong(std::move(song));
+	}
+
+	return root;
+}
+
+static void
+Save(Path path, const Directory &root, bool binary,
+     [[maybe_unused]] bool compress)
+{
+	FileOutputStream fos(path);
+	OutputStream *os = &fos;
+
+#ifdef ENABLE_ZLIB
+	std::unique_ptr<GzipOutputStream> gzip;
+	if (compress) {
+		gzip = std::make_unique<GzipOutputStream>(*os);
+		os = gzip.get();
+	}
+#endif
+
+	BufferedOutputStream bos(*os);
+	if (binary)
+		db_save_binary(bos, root);
+	else
+		db_save_internal(bos, root);
+	bos.Flush();
+
+#ifdef ENABLE_ZLIB
+	if (gzip)
+		gzip->Finish();
+#endif
+
+	fos.Commit();
+}
+
+static void
+Measure(const char *label, Path path, unsigned n_runs)
+{
+	using Clock = std::chrono::steady_clock;
+	std::chrono::duration<double> best{}, best_free{};
+	std::size_t rss = 0;
+
+	for (unsigned i = 0; i < n_runs; ++i) {
+		const std::size_t rss_before = GetResidentMemory();
+
+		std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+		const auto start = Clock::now();
+		db_load_file(path, *root);
+		const std::chrono::duration<double> duration = Clock::now() - start;
+
+		const std::size_t rss_after = GetResidentMemory();
+		if (rss_after > rss_before)
+			rss = std::max(rss, rss_after - rss_before);
+
+		const auto start_free = Clock::now();
+		root.reset();
+		const std::chrono::duration<double> duration_free = Clock::now() - start_free;
+
+		if (i == 0 || duration < best)
+			best = duration;
+		if (i == 0 || duration_free < best_free)
+			best_free = duration_free;
+	}
+
+	fmt::print("{:12}: {:10} bytes, load {:.3f} s, free {:.3f} s, RSS +{} kB\n",
+		   label, FileInfo(path).GetSize(), best.count(),
+		   best_free.count(), rss / 1024);
+}
+
+int
+main(int argc, char **argv)
+try {
+	if (argc < 2 || argc > 4) {
+		fmt::print(stderr, "Usage: BenchDatabaseLoad DIRECTORY [SONGS [RUNS]]\n");
+		return EXIT_FAILURE;
+	}
+
+	const FromNarrowPath directory = argv[1];
+	const unsigned n_songs = argc > 2 ? strtoul(argv[2], nullptr, 10) : 100000;
+	const unsigned n_runs = argc > 3 ? strtoul(argv[3], nullptr, 10) : 3;
+
+	const auto text_path = directory / Path::FromFS("bench_db.txt");
+	const auto binary_path = directory / Path::FromFS("bench_db.bin");
+
+	{
+		const auto root = MakeLibrary(n_songs);
+		Save(text_path, *root, false, false);
+		Save(binary_path, *root, true, false);
+	}
+
+	Measure("text", text_path, n_runs);
+
+#ifdef ENABLE_ZLIB
+	const auto gzip_path = directory / Path::FromFS("bench_db.gz");
+	{
+		std::unique_ptr<Directory> root{Directory::NewRoot()};
+		db_load_file(text_path, *root);
+		Save(gzip_path, *root, false, true);
+	}
+
+	Measure("text+gzip", gzip_path, n_runs);
+#endif
+
+	Measure("binary", binary_path, n_runs);
+
+	return EXIT_SUCCESS;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * This program measures case-insensitive "search" requests on a
+ * synthetic "simple" database, evaluated by Directory::Walk() on one
+ * thread and by #SearchPool with the given number of threads.
+ */
+
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/SearchPool.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "song/Filter.hxx"
+#include "song/LightSong.hxx"
+#include "tag/Builder.hxx"
+#include "util/PrintException.hxx"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+
+#include <stdlib.h>
+
+static std::unique_ptr<Directory>
+MakeLibrary(unsigned n_songs)
+{
+	static constexpr unsigned SONGS_PER_ALBUM = 12, ALBUMS_PER_ARTIST = 4;
+	static constexpr std::array words{
+		"Love", "Night", "Heart", "Dream", "Fire", "Rain",
+		"Blue", "Road", "Light", "Song", "Time", "Home",
+	};
+
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	std::mt19937 rng;
+	std::uniform_int_distribution<std::size_t> dist(0, words.size() - 1);
+
+	Directory *artist = nullptr, *album = nullptr;
+	unsigned artist_no = 0, album_no = 0;
+
+	for (unsigned i = 0; i < n_songs; ++i) {
+		const unsigned track = i % SONGS_PER_ALBUM;
+		if (track == 0) {
+			if (album_no % ALBUMS_PER_ARTIST == 0)
+				artist = root->CreateChild(fmt::format("Artist {}", ++artist_no));
+
+			album = artist->CreateChild(fmt::format("Album {}", ++album_no));
+		}
+
+		auto song = Song::New(fmt::format("{:02}.flac", track + 1),
+				      *album);
+
+		TagBuilder tag;
+		tag.AddItem(TAG_ARTIST, fmt::format("Artist {}", artist_no));
+		tag.AddItem(TAG_ALBUM, fmt::format("{} of {} {}",
+						   words[dist(rng)], words[dist(rng)],
+						   album_no));
+		tag.AddItem(TAG_TITLE, fmt::format("{} {} {}",
+						   words[dist(rng)], words[dist(rng)],
+						   words[dist(rng)]));
+		tag.AddItem(TAG_TRACK, fmt::format("{}", track + 1));
+		tag.Commit(song->tag);
+
+		album->AddSong(std::move(song));
+	}
+
+	return root;
+}
+
+template<typename F>
+static void
+Measure(const char *label, F &&f)
+{
+	using Clock = std::chrono::steady_clock;
+	const auto start = Clock::now();
+
+	const unsigned n_results = f();
+
+	const std::chrono::duration<double> duration = Clock::now() - start;
+	fmt::print("{}: {} results, {:.3f} s\n",
+		   label, n_results, duration.count());
+}
+
+int
+main(int argc, char **argv)
+try {
+	if (argc < 2 || argc > 4) {
+		fmt::print(stderr, "Usage: BenchDatabaseSearch SONGS [THREADS [STRING]]\n");
+		return EXIT_FAILURE;
+	}
+
+	const unsigned n_songs = strtoul(argv[1], nullptr, 10);
+	const unsigned n_threads = argc > 2 ? strtoul(argv[2], nullptr, 10) : 4;
+	const char *const needle = argc > 3 ? argv[3] : "night heart";
+
+	const std::string expression = fmt::format("(any contains \"{}\")",
+						   needle);
+	const char *const args[] = {expression.c_str()};
+
+	SongFilter filter;
+	filter.Parse(args, true);
+	filter.Optimize();
+
+	SearchPool pool(std::max(n_threads, 1U));
+
+	const ScopeDatabaseLock protect;
+
+	const auto root = MakeLibrary(n_songs);
+
+	Measure("Directory::Walk", [&]{
+		unsigned n_results = 0;
+		root->Walk(true, &filter, false, {},
+			   [&n_results](const LightSong &){ ++n_results; },
+			   {});
+		return n_results;
+	});
+
+	Measure("SearchPool", [&]{
+		unsigned n_results = 0;
+		pool.Walk(*root, filter, false,
+			  [&n_results](const LightSong &){ ++n_results; });
+		return n_results;
+	});
+
+	return EXIT_SUCCESS;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * This program measures "find ... sort TAG window START:END" requests
+ * which are emulated by #DatabaseVisitorHelper.  It generates a
+ * synthetic "simple" database, runs one query and prints its latency
+ * and how much the peak memory usage of the process grew during the
+ * query.
+ */
+
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "db/Selection.hxx"
+#include "db/VHelper.hxx"
+#include "protocol/ArgParser.hxx"
+#include "protocol/RangeArg.hxx"
+#include "song/Filter.hxx"
+#include "song/LightSong.hxx"
+#include "tag/Builder.hxx"
+#include "tag/ParseName.hxx"
+#include "util/PrintException.hxx"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+#include <stdlib.h>
+#include <sys/resource.h>
+
+static std::unique_ptr<Directory>
+MakeLibrary(unsigned n_songs)
+{
+	static constexpr unsigned SONGS_PER_ALBUM = 12;
+
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	std::mt19937 rng;
+	std::uniform_int_distribution<unsigned> dist(0, n_songs);
+
+	Directory *album = nullptr;
+	unsigned album_no = 0;
+
+	for (unsigned i = 0; i < n_songs; ++i) {
+		const unsigned track = i % SONGS_PER_ALBUM;
+		if (track == 0)
+			album = root->CreateChild(fmt::format("Album {}", ++album_no));
+
+		auto song = Song::New(fmt::format("{:02}.flac", track + 1),
+				      *album);
+		song->mtime = std::chrono::system_clock::from_time_t(1600000000 + dist(rng));
+
+		TagBuilder tag;
+		tag.AddItem(TAG_ARTIST, fmt::format("Artist {}", album_no / 4));
+		tag.AddItem(TAG_ALBUM, fmt::format("Album {}", album_no));
+		tag.AddItem(TAG_TITLE, fmt::format("Title {}", dist(rng)));
+		tag.AddItem(TAG_TRACK, fmt::format("{}", track + 1));
+		tag.AddItem(TAG_DATE, fmt::format("{}", 1960 + album_no % 60));
+		tag.Commit(song->tag);
+
+		album->AddSong(std::move(song));
+	}
+
+	return root;
+}
+
+[[gnu::pure]]
+static long
+GetMaxRSS() noexcept
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) < 0)
+		return 0;
+
+	return usage.ru_maxrss;
+}
+
+int
+main(int argc, char **argv)
+try {
+	if (argc < 2 || argc > 4) {
+		fmt::print(stderr, "Usage: BenchDatabaseSort SONGS [START:END [TAG]]\n");
+		return EXIT_FAILURE;
+	}
+
+	const unsigned n_songs = strtoul(argv[1], nullptr, 10);
+
+	DatabaseSelection selection("", true);
+	selection.window = argc > 2
+		? ParseCommandArgRange(argv[2])
+		: RangeArg{0, 50};
+
+	selection.sort = TAG_TITLE;
+	if (argc > 3) {
+		if (std::string_view{argv[3]} == "Last-Modified")
+			selection.sort = TagType(SORT_TAG_LAST_MODIFIED);
+		else {
+			selection.sort = tag_name_parse_i(argv[3]);
+			if (selection.sort == TAG_NUM_OF_ITEM_TYPES)
+				throw std::runtime_error("Unknown tag type");
+		}
+	}
+
+	const ScopeDatabaseLock protect;
+
+	const auto root = MakeLibrary(n_songs);
+
+	const long rss_before = GetMaxRSS();
+
+	using Clock = std::chrono::steady_clock;
+	const auto start = Clock::now();
+
+	unsigned n_results = 0;
+	VisitSong visit_song = [&n_results](const LightSong &){
+		++n_results;
+	};
+
+	DatabaseVisitorHelper helper(selection, visit_song);
+	root->Walk(true, nullptr, false, {}, visit_song, {});
+	helper.Commit();
+
+	const std::chrono::duration<double> duration = Clock::now() - start;
+
+	fmt::print("{} songs, {} results, {:.3f} s, peak memory +{} kB\n",
+		   n_songs, n_results, duration.count(),
+		   GetMaxRSS() - rss_before);
+
+	return EXIT_SUCCESS;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * This program measures URI resolution in the "simple" database's
+ * #Directory tree.  It builds a synthetic tree with one flat
+ * "Artist" level and resolves random song URIs, both with
+ * Directory::LookupDirectory()/FindSong() and with a plain linear
+ * scan of the lists for comparison.
+ */
+
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "util/PrintException.hxx"
+#include "util/StringSplit.hxx"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+using std::string_view_literals::operator""sv;
+
+static std::unique_ptr<Directory>
+MakeTree(unsigned n_artists, unsigned n_albums, unsigned n_songs,
+	 std::vector<std::string> &uris)
+{
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	for (unsigned i = 0; i < n_artists; ++i) {
+		auto *artist = root->CreateChild(fmt::format("Artist {}", i));
+
+		for (unsigned j = 0; j < n_albums; ++j) {
+			auto *album = artist->CreateChild(fmt::format("Album {}", j));
+
+			for (unsigned k = 0; k < n_songs; ++k) {
+				auto name = fmt::format("{:02} Track.flac", k);
+				uris.emplace_back(fmt::format("{}/{}",
+							      album->GetPath(),
+							      name));
+				album->AddSong(Song::New(std::move(name),
+							 *album));
+			}
+		}
+	}
+
+	return root;
+}
+
+[[gnu::pure]]
+static const Song *
+LinearLookup(const Directory &root, std::string_view uri) noexcept
+{
+	const Directory *d = &root;
+
+	while (true) {
+		const auto [name, rest] = Split(uri, '/');
+		if (rest.data() == nullptr)
+			break;
+
+		const Directory *found = nullptr;
+		for (const auto &child : d->children) {
+			if (name == child.GetName()) {
+				found = &child;
+				break;
+			}
+		}
+
+		if (found == nullptr)
+			return nullptr;
+
+		d = found;
+		uri = rest;
+	}
+
+	for (const auto &song : d->songs)
+		if (song.filename == uri)
+			return &song;
+
+	return nullptr;
+}
+
+template<typename F>
+static void
+Measure(const char *label, const std::vector<const std::string *> &queries,
+	F &&f)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	unsigned found = 0;
+	for (const auto *uri : queries)
+		if (f(*uri) != nullptr)
+			++found;
+
+	const std::chrono::duration<double> duration =
+		std::chrono::steady_clock::now() - start;
+
+	fmt::print("{:8}: {} lookups, {} found, {:.3f} s, {:.0f} ns/lookup\n",
+		   label, queries.size(), found, duration.count(),
+		   duration.count() * 1e9 / queries.size());
+}
+
+int
+main(int argc, char **argv)
+try {
+	unsigned n_artists = 20000, n_queries = 10000;
+
+	if (argc > 3) {
+		fmt::print(stderr, "Usage: BenchDirectoryLookup [ARTISTS [QUERIES]]\n");
+		return EXIT_FAILURE;
+	}
+
+	if (argc > 1)
+		n_artists = strtoul(argv[1], nullptr, 10);
+	if (argc > 2)
+		n_queries = strtoul(argv[2], nullptr, 10);
+
+	/* 20000 artists * 5 albums * 10 songs = 1M songs */
+	std::vector<std::string> uris;
+
+	const ScopeDatabaseLock protect;
+
+	auto root = MakeTree(n_artists, 5, 10, uris);
+	fmt::print("{} songs in {} artist directories\n",
+		   uris.size(), n_artists);
+
+	std::mt19937 rng;
+	std::uniform_int_distribution<std::size_t> dist(0, uris.size() - 1);
+
+	std::vector<const std::string *> queries;
+	queries.reserve(n_queries);
+	for (unsigned i = 0; i < n_queries; ++i)
+		queries.push_back(&uris[dist(rng)]);
+
+	Measure("indexed", queries, [&root](std::string_view uri){
+		const auto lr = root->LookupDirectory(uri);
+		return lr.directory->FindSong(lr.rest);
+	});
+
+	Measure("linear", queries, [&root](std::string_view uri){
+		return LinearLookup(*root, uri);
+	});
+
+	return EXIT_SUCCESS;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * This program measures the speed of the DSD to PCM conversion
+ * engines, feeding them chunks like PcmConvert does.  Usage:
+ *
+ *  BenchDsd2Pcm [CHANNELS [CHUNK_SIZE [SECONDS]]]
+ */
+
+#include "pcm/PcmDsd.hxx"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <stdlib.h>
+
+static void
+Measure(const char *label, const PcmDsdConfig &config, bool s24,
+	unsigned dsd_rate, unsigned channels, std::size_t chunk_size,
+	unsigned seconds)
+{
+	using Clock = std::chrono::steady_clock;
+
+	/* the sample rate in bytes per channel */
+	const std::size_t sample_rate = 44100 * dsd_rate / 8;
+	const std::size_t total = sample_rate * channels * seconds;
+
+	std::vector<std::byte> src(chunk_size - chunk_size % channels);
+	std::mt19937 gen;
+	for (auto &i : src)
+		i = std::byte(gen());
+
+	PcmDsd dsd(config);
+
+	const auto start = Clock::now();
+	for (std::size_t done = 0; done < total; done += src.size()) {
+		if (s24)
+			dsd.ToS24(channels, src);
+		else
+			dsd.ToFloat(channels, src);
+	}
+	const std::chrono::duration<double> duration = Clock::now() - start;
+
+	fmt::print("DSD{:<3} {:5} {:12}: {:7.1f}x realtime\n",
+		   dsd_rate, s24 ? "s24" : "float", label,
+		   seconds / duration.count());
+}
+
+int
+main(int argc, char **argv)
+{
+	const unsigned channels = argc > 1
+		? strtoul(argv[1], nullptr, 10)
+		: 2;
+	const std::size_t chunk_size = argc > 2
+		? strtoul(argv[2], nullptr, 10)
+		: 4096;
+	const unsigned seconds = argc > 3
+		? strtoul(argv[3], nullptr, 10)
+		: 10;
+
+	if (channels < 1 || channels > MAX_CHANNELS ||
+	    chunk_size < channels) {
+		fmt::print(stderr, "Invalid parameters\n");
+		return EXIT_FAILURE;
+	}
+
+	const PcmDsdConfig classic{false, 1};
+	const PcmDsdConfig fast{true, 1};
+	const PcmDsdConfig threaded{true, channels};
+
+	for (unsigned dsd_rate : {64, 128, 256, 512}) {
+		for (bool s24 : {false, true}) {
+			Measure("classic", classic, s24,
+				dsd_rate, channels, chunk_size, seconds);
+			Measure("fast", fast, s24,
+				dsd_rate, channels, chunk_size, seconds);
+
+			if (channels > 2)
+				Measure("fast+threads", threaded, s24,
+					dsd_rate, channels, chunk_size,
+					seconds);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * This program creates an MPD #Instance with many clients connected
+ * over socketpairs, lets all of them wait in "idle options",
+ * triggers an "options" event from another client and measures how
+ * long it takes until all clients have received the "idle" response.
+ *
+ * The #EventLoop runs in the main thread, just like in MPD; the
+ * clients are driven by a second thread.  Each client needs two
+ * file descriptors; raise the limit for large numbers of clients.
+ */
+
+#include "MpdConnection.hxx"
+#include "Instance.hxx"
+#include "Partition.hxx"
+#include "Permission.hxx"
+#include "client/Client.hxx"
+#include "client/Config.hxx"
+#include "client/List.hxx"
+#include "config/Data.hxx"
+#include "config/PartitionConfig.hxx"
+#include "net/SocketError.hxx"
+#include "net/StaticSocketAddress.hxx"
+#include "net/UniqueSocketDescriptor.hxx"
+#include "util/PrintException.hxx"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <forward_list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <stdlib.h>
+#include <sys/socket.h>
+
+using Clock = std::chrono::steady_clock;
+
+/* this is normally defined in Main.cxx */
+Instance *global_instance;
+
+/**
+ * Create a new #Client in the given #Partition and return the other
+ * end of its socketpair.
+ */
+static UniqueSocketDescriptor
+NewClient(Partition &partition)
+{
+	UniqueSocketDescriptor server, client;
+	if (!UniqueSocketDescriptor::CreateSocketPairNonBlock(AF_LOCAL, SOCK_STREAM, 0,
+							      server, client))
+		throw MakeSocketError("Failed to create socket pair");
+
+	client.SetBlocking();
+
+	const auto address = server.GetLocalAddress();
+	client_new(partition.instance.event_loop, partition,
+		   std::move(server), address, -1,
+		   PERMISSION_READ|PERMISSION_PLAYER);
+	return client;
+}
+
+static void
+ReadIdleResponse(MpdConnection &c)
+{
+	while (true) {
+		const auto line = c.ReadLine();
+		if (line == "OK")
+			break;
+
+		if (!line.starts_with("changed: "))
+			throw std::runtime_error(std::string{line});
+	}
+}
+
+static void
+RunRounds(MpdConnection &control, std::forward_list<MpdConnection> &clients,
+	  unsigned n_rounds)
+{
+	std::chrono::duration<double> total{}, max{};
+
+	for (unsigned round = 0; round < n_rounds; ++round) {
+		for (auto &c : clients)
+			c.Send("idle options\n");
+
+		/* give the EventLoop a chance to process all "idle"
+		   commands before the event is triggered; a client
+		   which is late gets the event anyway */
+		control.Command("ping\n");
+
+		const auto start = Clock::now();
+		/* "random" is initially off; toggle it in each round */
+		control.Command(fmt::format("random {}\n", (round + 1) % 2));
+
+		for (auto &c : clients)
+			ReadIdleResponse(c);
+
+		const std::chrono::duration<double> duration = Clock::now() - start;
+		total += duration;
+		max = std::max(max, duration);
+	}
+
+	fmt::print("{:.3f} ms average, {:.3f} ms max\n",
+		   total.count() * 1e3 / n_rounds,
+		   max.count() * 1e3);
+}
+
+int
+main(int argc, char **argv)
+try {
+	if (argc > 3) {
+		fmt::print(stderr, "Usage: BenchIdleFanOut [CLIENTS] [ROUNDS]\n");
+		return EXIT_FAILURE;
+	}
+
+	const unsigned n_clients = argc > 1 ? strtoul(argv[1], nullptr, 10) : 256;
+	const unsigned n_rounds = argc > 2 ? strtoul(argv[2], nullptr, 10) : 100;
+	if (n_rounds == 0)
+		throw std::invalid_argument("Invalid number of rounds");
+
+	/* the default settings */
+	client_manager_init(ConfigData{});
+
+	Instance instance;
+	global_instance = &instance;
+	instance.client_list = std::make_unique<ClientList>(n_clients + 1);
+
+	auto &partition = instance.partitions.emplace_back(instance, "default",
+							   PartitionConfig{});
+
+	MpdConnection control(NewClient(partition));
+
+	std::forward_list<MpdConnection> clients;
+	for (unsigned i = 0; i < n_clients; ++i)
+		clients.emplace_front(NewClient(partition));
+
+	fmt::print("{} clients: ", n_clients);
+
+	std::exception_ptr error;
+	std::thread thread([&]{
+		try {
+			RunRounds(control, clients, n_rounds);
+		} catch (...) {
+			error = std::current_exception();
+		}
+
+		instance.event_loop.InjectBreak();
+	});
+
+	instance.event_loop.Run();
+	thread.join();
+
+	if (error)
+		std::rethrow_exception(error);
+
+	partition.BeginShutdown();
+	instance.client_list.reset();
+	return EXIT_SUCCESS;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
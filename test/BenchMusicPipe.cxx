@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * This program measures the throughput of #MusicPipe and
+ * #MusicBuffer with one producer thread (the decoder) which copies
+ * PCM data into chunks and one consumer thread (the player/output)
+ * which reads the data from the chunks, for various audio formats
+ * and chunk sizes.  Usage:
+ *
+ *  BenchMusicPipe [SECONDS]
+ */
+
+#include "MusicPipe.hxx"
+#include "MusicBuffer.hxx"
+#include "MusicChunk.hxx"
+#include "pcm/AudioFormat.hxx"
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+
+/**
+ * Prevent the compiler from optimizing away the computation.
+ */
+static void
+Consume(const void *p) noexcept
+{
+	asm volatile("" : : "r"(p) : "memory");
+}
+
+static void
+Measure(const AudioFormat af, const std::size_t chunk_size,
+	const unsigned seconds)
+{
+	/* the default buffer size */
+	MusicBuffer buffer(8 * 1024 * 1024 / chunk_size, chunk_size);
+	MusicPipe pipe;
+	std::atomic_bool stop{false};
+
+	/* the decoder delivers 4 kB pieces */
+	const std::size_t piece_size = 4096 - 4096 % af.GetFrameSize();
+	const std::vector<std::byte> src(piece_size, std::byte{0x55});
+
+	std::thread producer([&]{
+		MusicChunkPtr chunk;
+
+		while (!stop.load(std::memory_order_relaxed)) {
+			if (chunk == nullptr) {
+				chunk = buffer.Allocate();
+				if (chunk == nullptr) {
+					std::this_thread::yield();
+					continue;
+				}
+			}
+
+			std::span<const std::byte> data{src};
+			while (!data.empty()) {
+				auto w = chunk->Write(af, SongTime::zero(), 0);
+				const std::size_t n = std::min(w.size(), data.size());
+				std::memcpy(w.data(), data.data(), n);
+				data = data.subspan(n);
+
+				if (chunk->Expand(af, n)) {
+					pipe.Push(std::move(chunk));
+
+					while ((chunk = buffer.Allocate()) == nullptr) {
+						if (stop.load(std::memory_order_relaxed))
+							return;
+						std::this_thread::yield();
+					}
+				}
+			}
+		}
+	});
+
+	using Clock = std::chrono::steady_clock;
+	const auto start = Clock::now();
+	const auto end = start + std::chrono::seconds(seconds);
+
+	std::vector<std::byte> dest(buffer.GetChunkCapacity());
+	std::size_t n_chunks = 0, n_bytes = 0;
+
+	while (true) {
+		if (auto chunk = pipe.Shift()) {
+			const auto data = chunk->GetData();
+			std::memcpy(dest.data(), data.data(), data.size());
+			Consume(dest.data());
+
+			++n_chunks;
+			n_bytes += data.size();
+
+			if ((n_chunks & 0xff) == 0 && Clock::now() >= end)
+				break;
+		} else
+			std::this_thread::yield();
+	}
+
+	const std::chrono::duration<double> duration = Clock::now() - start;
+
+	stop = true;
+	producer.join();
+	pipe.Clear();
+
+	const double audio_seconds =
+		af.SizeToTime<std::chrono::duration<double>>(n_bytes).count();
+
+	fmt::print("{:>6}/{:>2}/{} {:4} kB: {:8.1f} k chunks/s {:8.1f} MB/s {:8.1f}x realtime\n",
+		   af.sample_rate, af.GetSampleSize() * 8, af.channels,
+		   chunk_size / 1024,
+		   n_chunks / duration.count() / 1e3,
+		   n_bytes / duration.count() / 1e6,
+		   audio_seconds / duration.count());
+}
+
+int
+main(int argc, char **argv)
+{
+	const unsigned seconds = argc > 1
+		? strtoul(argv[1], nullptr, 10)
+		: 2;
+
+	if (seconds < 1) {
+		fmt::print(stderr, "Invalid parameters\n");
+		return EXIT_FAILURE;
+	}
+
+	static constexpr AudioFormat formats[] = {
+		{44100, SampleFormat::S16, 2},
+		{96000, SampleFormat::S24_P32, 2},
+		{192000, SampleFormat::S32, 2},
+		{384000, SampleFormat::FLOAT, 8},
+	};
+
+	for (const auto &af : formats)
+		for (std::size_t chunk_size : {4096, 16384, 65536, 262144})
+			Measure(af, chunk_size, seconds);
+
+	return EXIT_SUCCESS;
+}
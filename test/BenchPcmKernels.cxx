@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * This program measures the throughput of the x86 PCM kernels
+ * compared with the portable code.
+ */
+
+#include "pcm/X86.hxx"
+#include "pcm/FloatConvert.hxx"
+#include "pcm/Clamp.hxx"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <random>
+
+#include <stdlib.h>
+
+static constexpr std::size_t N = 4096;
+
+static float float_src[N], float_dest[N];
+static int16_t s16_src[N], s16_dest[N];
+static int32_t s32_src[N], s32_dest[N];
+
+/**
+ * Prevent the compiler from optimizing away the computation.
+ */
+template<typename T>
+static void
+Consume(const T *p) noexcept
+{
+	asm volatile("" : : "r"(p) : "memory");
+}
+
+template<typename F>
+static void
+Measure(const char *label, unsigned n_iterations, F &&f)
+{
+	using Clock = std::chrono::steady_clock;
+
+	const auto start = Clock::now();
+	for (unsigned i = 0; i < n_iterations; ++i)
+		f();
+	const std::chrono::duration<double> duration = Clock::now() - start;
+
+	fmt::print("  {:8}: {:8.1f} Msamples/s\n", label,
+		   double(N) * n_iterations / duration.count() / 1e6);
+}
+
+/**
+ * Measure the portable version, the SSE2 kernel and the AVX2 kernel.
+ */
+template<typename P, typename S, typename A>
+static void
+MeasureKernel(const char *name, unsigned n_iterations,
+	      P &&portable, S &&sse2, A &&avx2)
+{
+	fmt::print("{}\n", name);
+	Measure("portable", n_iterations, portable);
+	Measure("sse2", n_iterations, sse2);
+	if (X86HaveAvx2())
+		Measure("avx2", n_iterations, avx2);
+}
+
+template<SampleFormat F>
+static void
+PortableFloatToInteger(typename SampleTraits<F>::pointer dest) noexcept
+{
+	for (std::size_t i = 0; i < N; ++i)
+		dest[i] = FloatToIntegerSampleConvert<F>::Convert(float_src[i]);
+	Consume(dest);
+}
+
+template<SampleFormat F, typename T>
+static void
+PortableIntegerToFloat(const T *src) noexcept
+{
+	for (std::size_t i = 0; i < N; ++i)
+		float_dest[i] = IntegerToFloatSampleConvert<F>::Convert(src[i]);
+	Consume(float_dest);
+}
+
+template<SampleFormat F, typename T>
+static void
+PortableAdd(T *a, const T *b) noexcept
+{
+	using Traits = SampleTraits<F>;
+	for (std::size_t i = 0; i < N; ++i)
+		a[i] = PcmClamp<F>(typename Traits::sum_type(a[i]) + b[i]);
+	Consume(a);
+}
+
+int
+main(int argc, char **argv)
+{
+	const unsigned n_iterations = argc > 1
+		? strtoul(argv[1], nullptr, 10)
+		: 20000;
+
+	std::mt19937 gen;
+	std::uniform_real_distribution<float> dis(-1.0, 1.0);
+	for (std::size_t i = 0; i < N; ++i) {
+		float_src[i] = dis(gen);
+		s16_src[i] = int16_t(gen());
+		s32_src[i] = int32_t(gen()) >> 8;
+	}
+
+	constexpr int volume = 700;
+	constexpr float volume_float = 0.7f;
+	constexpr auto s24_factor =
+		IntegerToFloatSampleConvert<SampleFormat::S24_P32>::factor;
+
+	MeasureKernel("float to S16", n_iterations,
+		      []{ PortableFloatToInteger<SampleFormat::S16>(s16_dest); },
+		      []{ Sse2FloatToS16(s16_dest, float_src, N); Consume(s16_dest); },
+		      []{ Avx2FloatToS16(s16_dest, float_src, N); Consume(s16_dest); });
+
+	MeasureKernel("float to S24_P32", n_iterations,
+		      []{ PortableFloatToInteger<SampleFormat::S24_P32>(s32_dest); },
+		      []{ Sse2FloatToS24(s32_dest, float_src, N); Consume(s32_dest); },
+		      []{ Avx2FloatToS24(s32_dest, float_src, N); Consume(s32_dest); });
+
+	MeasureKernel("float to S32", n_iterations,
+		      []{ PortableFloatToInteger<SampleFormat::S32>(s32_dest); },
+		      []{ Sse2FloatToS32(s32_dest, float_src, N); Consume(s32_dest); },
+		      []{ Avx2FloatToS32(s32_dest, float_src, N); Consume(s32_dest); });
+
+	MeasureKernel("S16 to float", n_iterations,
+		      []{ PortableIntegerToFloat<SampleFormat::S16>(s16_src); },
+		      []{ Sse2S16ToFloat(float_dest, s16_src, N); Consume(float_dest); },
+		      []{ Avx2S16ToFloat(float_dest, s16_src, N); Consume(float_dest); });
+
+	MeasureKernel("S24_P32 to float", n_iterations,
+		      []{ PortableIntegerToFloat<SampleFormat::S24_P32>(s32_src); },
+		      []{ Sse2S32ToFloat(float_dest, s32_src, N, s24_factor); Consume(float_dest); },
+		      []{ Avx2S32ToFloat(float_dest, s32_src, N, s24_factor); Consume(float_dest); });
+
+	MeasureKernel("volume S16 to S24_P32", n_iterations,
+		      []{
+			      for (std::size_t i = 0; i < N; ++i)
+				      s32_dest[i] = (int32_t(s16_src[i]) * volume) >> 2;
+			      Consume(s32_dest);
+		      },
+		      []{ Sse2Volume16To24(s32_dest, s16_src, N, volume); Consume(s32_dest); },
+		      []{ Avx2Volume16To24(s32_dest, s16_src, N, volume); Consume(s32_dest); });
+
+	MeasureKernel("volume float", n_iterations,
+		      []{
+			      for (std::size_t i = 0; i < N; ++i)
+				      float_dest[i] = float_src[i] * volume_float;
+			      Consume(float_dest);
+		      },
+		      []{ Sse2VolumeFloat(float_dest, float_src, N, volume_float); Consume(float_dest); },
+		      []{ Avx2VolumeFloat(float_dest, float_src, N, volume_float); Consume(float_dest); });
+
+	MeasureKernel("add S16", n_iterations,
+		      []{ PortableAdd<SampleFormat::S16>(s16_dest, s16_src); },
+		      []{ Sse2AddS16(s16_dest, s16_src, N); Consume(s16_dest); },
+		      []{ Avx2AddS16(s16_dest, s16_src, N); Consume(s16_dest); });
+
+	MeasureKernel("add S24_P32", n_iterations,
+		      []{ PortableAdd<SampleFormat::S24_P32>(s32_dest, s32_src); },
+		      []{ Sse2AddS24(s32_dest, s32_src, N); Consume(s32_dest); },
+		      []{ Avx2AddS24(s32_dest, s32_src, N); Consume(s32_dest); });
+
+	MeasureKernel("add S32", n_iterations,
+		      []{ PortableAdd<SampleFormat::S32>(s32_dest, s32_src); },
+		      []{ Sse2AddS32(s32_dest, s32_src, N); Consume(s32_dest); },
+		      []{ Avx2AddS32(s32_dest, s32_src, N); Consume(s32_dest); });
+
+	MeasureKernel("add float with volume", n_iterations,
+		      []{
+			      for (std::size_t i = 0; i < N; ++i)
+				      float_dest[i] = float_dest[i] * volume_float
+					      + float_src[i] * (1 - volume_float);
+			      Consume(float_dest);
+		      },
+		      []{ Sse2AddVolumeFloat(float_dest, float_src, N, volume_float, 1 - volume_float); Consume(float_dest); },
+		      []{ Avx2AddVolumeFloat(float_dest, float_src, N, volume_float, 1 - volume_float); Consume(float_dest); });
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * This program simulates "add /" on a large database in random mode,
+ * comparing appending one song at a time (reallocating and shuffling
+ * after each song, like playlist::AppendSong() does) with the batch
+ * path used by playlist::AppendSongs().
+ */
+
+#include "queue/Queue.hxx"
+#include "song/DetachedSong.hxx"
+#include "song/LightSong.hxx"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+Tag::Tag(const Tag &) noexcept {}
+void Tag::Clear() noexcept {}
+
+DetachedSong::operator LightSong() const noexcept
+{
+	return {uri.c_str(), tag};
+}
+
+static std::vector<DetachedSong>
+MakeSongs(unsigned n_songs)
+{
+	std::vector<DetachedSong> songs;
+	for (unsigned i = 0; i < n_songs; ++i)
+		songs.emplace_back(fmt::format("Artist {}/Album {}/{:02}.flac",
+					       i / 1000, i / 10, i % 10));
+	return songs;
+}
+
+template<typename F>
+static void
+Measure(const char *label, unsigned n_songs, F &&f)
+{
+	using Clock = std::chrono::steady_clock;
+
+	auto songs = MakeSongs(n_songs);
+
+	Queue queue(n_songs);
+	queue.random = true;
+
+	const auto start = Clock::now();
+	f(queue, songs);
+	queue.IncrementVersion();
+	const std::chrono::duration<double> duration = Clock::now() - start;
+
+	fmt::print("{}: {} songs, {:.3f} ms\n",
+		   label, queue.GetLength(), duration.count() * 1e3);
+}
+
+int
+main(int argc, char **argv)
+{
+	const unsigned n_songs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 500000;
+
+	Measure("single", n_songs, [](Queue &queue, std::vector<DetachedSong> &songs){
+		for (auto &song : songs) {
+			queue.Append(std::move(song), 0);
+			queue.ShuffleOrderLastWithPriority(0, queue.GetLength());
+		}
+	});
+
+	Measure("batch", n_songs, [](Queue &queue, std::vector<DetachedSong> &songs){
+		queue.Reserve(songs.size());
+		for (auto &song : songs)
+			queue.Append(std::move(song), 0);
+		queue.ShuffleOrderLastGroup(0, queue.GetLength());
+	});
+
+	return EXIT_SUCCESS;
+}
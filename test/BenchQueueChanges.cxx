@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * This program measures "plchanges" requests on a large queue which
+ * is modified slightly between two requests, comparing the
+ * #QueueJournal with a scan of all positions.
+ */
+
+#include "queue/Queue.hxx"
+#include "song/DetachedSong.hxx"
+#include "song/LightSong.hxx"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <random>
+#include <string>
+
+#include <stdlib.h>
+
+Tag::Tag(const Tag &) noexcept {}
+void Tag::Clear() noexcept {}
+
+DetachedSong::operator LightSong() const noexcept
+{
+	return {uri.c_str(), tag};
+}
+
+template<typename F>
+static void
+Measure(const char *label, Queue &queue, unsigned n_requests, F &&f)
+{
+	using Clock = std::chrono::steady_clock;
+	std::chrono::duration<double> total{};
+
+	std::mt19937 rng;
+	std::uniform_int_distribution<unsigned> dist(0, queue.GetLength() - 1);
+
+	unsigned n_results = 0;
+
+	for (unsigned i = 0; i < n_requests; ++i) {
+		/* a small edit: move one song and bump the priority
+		   of another one */
+		const uint32_t client_version = queue.version;
+		const unsigned from = dist(rng);
+		queue.MovePostion(from, std::min(from + 3, queue.GetLength() - 1));
+		queue.SetPriority(dist(rng), i % 256, -1);
+		queue.IncrementVersion();
+
+		const auto start = Clock::now();
+		n_results += f(queue, client_version);
+		total += Clock::now() - start;
+	}
+
+	fmt::print("{}: {} results, {:.3f} us per request\n",
+		   label, n_results, total.count() * 1e6 / n_requests);
+}
+
+int
+main(int argc, char **argv)
+{
+	const unsigned n_songs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+	const unsigned n_requests = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000;
+
+	Queue queue(n_songs);
+	for (unsigned i = 0; i < n_songs; ++i)
+		queue.Append(DetachedSong(std::to_string(i) + ".ogg"), 0);
+	queue.IncrementVersion();
+
+	Measure("scan", queue, n_requests, [](const Queue &q, uint32_t version){
+		unsigned n = 0;
+		for (unsigned i = 0; i < q.GetLength(); ++i)
+			if (q.IsNewerAtPosition(i, version))
+				++n;
+		return n;
+	});
+
+	Measure("journal", queue, n_requests, [](const Queue &q, uint32_t version){
+		unsigned n = 0;
+		q.ForEachNewerPosition(version, 0, q.GetLength(),
+				       [&n](unsigned){ ++n; });
+		return n;
+	});
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,208 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef COMPACT_SONG_DECODER_HXX
+#define COMPACT_SONG_DECODER_HXX
+
+#include "protocol/CompactSong.hxx"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * A client-side decoder for the "compact" song format.  Unsigned
+ * values are converted to decimal strings.
+ */
+class CompactSongDecoder {
+	struct KeyInfo {
+		std::string name;
+		CompactSong::ValueType type;
+		bool defined = false;
+	};
+
+	std::array<KeyInfo, 256> keys;
+
+	std::vector<std::string> strings;
+
+	/**
+	 * Payload data which has not yet been parsed, because it
+	 * ends with an incomplete record.
+	 */
+	std::string pending;
+
+	/**
+	 * Thrown by the #Reader if the record is incomplete.
+	 */
+	struct Incomplete {};
+
+	struct Reader {
+		std::string_view src;
+
+		uint8_t ReadByte() {
+			if (src.empty())
+				throw Incomplete{};
+
+			const uint8_t value = src.front();
+			src.remove_prefix(1);
+			return value;
+		}
+
+		uint_least64_t ReadVarint() {
+			uint_least64_t value = 0;
+			for (unsigned shift = 0;; shift += 7) {
+				if (shift >= 64)
+					throw std::runtime_error("Malformed varint");
+
+				const uint8_t b = ReadByte();
+				value |= uint_least64_t(b & 0x7f) << shift;
+				if ((b & 0x80) == 0)
+					return value;
+			}
+		}
+
+		std::string_view ReadString(std::size_t length) {
+			if (src.size() < length)
+				throw Incomplete{};
+
+			const auto value = src.substr(0, length);
+			src.remove_prefix(length);
+			return value;
+		}
+	};
+
+public:
+	using Song = std::vector<std::pair<std::string, std::string>>;
+
+	/**
+	 * Feed the payload of a "binary" chunk.  Invokes the callback
+	 * for each complete song.
+	 *
+	 * Throws on error.
+	 */
+	template<typename F>
+	void Feed(std::string_view payload, F &&f) {
+		pending.append(payload);
+
+		std::string_view src = pending;
+		while (!src.empty()) {
+			Reader reader{src};
+			Song song;
+			bool is_song;
+
+			try {
+				is_song = ParseRecord(reader, song);
+			} catch (Incomplete) {
+				break;
+			}
+
+			src = reader.src;
+
+			if (is_song)
+				f(std::move(song));
+		}
+
+		pending.erase(0, pending.size() - src.size());
+	}
+
+	bool IsEmpty() const noexcept {
+		return pending.empty();
+	}
+
+private:
+	/**
+	 * Parse one record.  Returns true if the record is a song.
+	 * Key definitions and string table changes are applied only
+	 * when the record is complete.
+	 */
+	bool ParseRecord(Reader &reader, Song &song) {
+		using namespace CompactSong;
+
+		switch (Record(reader.ReadByte())) {
+		case Record::DEFINE_KEY:
+			{
+				const uint8_t key = reader.ReadByte();
+				const auto type = ValueType(reader.ReadByte());
+				const auto name =
+					reader.ReadString(reader.ReadVarint());
+
+				if (type != ValueType::STRING &&
+				    type != ValueType::UNSIGNED)
+					throw std::runtime_error("Unknown value type");
+
+				keys[key] = {std::string{name}, type, true};
+				return false;
+			}
+
+		case Record::SONG:
+			return ParseSong(reader, song);
+
+		case Record::RESET_STRINGS:
+			strings.clear();
+			return false;
+		}
+
+		throw std::runtime_error("Unknown record");
+	}
+
+	bool ParseSong(Reader &reader, Song &song) {
+		using namespace CompactSong;
+
+		/* new strings are committed only after the whole
+		   record has been parsed */
+		std::vector<std::string> new_strings;
+
+		for (auto n = reader.ReadVarint(); n > 0; --n) {
+			const auto &key = keys[reader.ReadByte()];
+			if (!key.defined)
+				throw std::runtime_error("Undefined key");
+
+			const auto value = reader.ReadVarint();
+			if (key.type == ValueType::UNSIGNED) {
+				song.emplace_back(key.name,
+						  std::to_string(value));
+				continue;
+			}
+
+			const auto length = value >> 2;
+			switch (StringMode(value & 3)) {
+			case StringMode::LITERAL:
+				song.emplace_back(key.name,
+						  reader.ReadString(length));
+				break;
+
+			case StringMode::STORE:
+				new_strings.emplace_back(reader.ReadString(length));
+				song.emplace_back(key.name,
+						  new_strings.back());
+				break;
+
+			case StringMode::REFERENCE:
+				if (length < strings.size())
+					song.emplace_back(key.name,
+							  strings[length]);
+				else if (length < strings.size() + new_strings.size())
+					song.emplace_back(key.name,
+							  new_strings[length - strings.size()]);
+				else
+					throw std::runtime_error("Bad string reference");
+				break;
+
+			default:
+				throw std::runtime_error("Unknown string mode");
+			}
+		}
+
+		for (auto &i : new_strings)
+			strings.emplace_back(std::move(i));
+
+		return true;
+	}
+};
+
+#endif
@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * This program converts a "simple" database file between the text
+ * and the binary format.  The input format is detected
+ * automatically.
+ */
+
+#include "config.h"
+#include "ConfigGlue.hxx"
+#include "db/plugins/simple/DatabaseSave.hxx"
+#include "db/plugins/simple/BinaryDatabase.hxx"
+#include "db/plugins/simple/Directory.hxx"
+#include "tag/Config.hxx"
+#include "fs/Path.hxx"
+#include "fs/NarrowPath.hxx"
+#include "io/BufferedOutputStream.hxx"
+#include "io/FileOutputStream.hxx"
+#include "cmdline/OptionDef.hxx"
+#include "cmdline/OptionParser.hxx"
+#include "util/PrintException.hxx"
+#include "util/StringAPI.hxx"
+
+#ifdef ENABLE_ZLIB
+#include "lib/zlib/GzipOutputStream.hxx"
+#endif
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+#include <stdlib.h>
+
+struct CommandLine {
+	FromNarrowPath config_path;
+
+	FromNarrowPath in_path, out_path;
+
+	bool binary;
+
+	bool compress = false;
+};
+
+enum Option {
+	OPTION_CONFIG,
+	OPTION_COMPRESS,
+};
+
+static constexpr OptionDef option_defs[] = {
+	{"config", 0, true, "Load a MPD configuration file"},
+	{"compress", 'z', false, "Compress the text format with gzip"},
+};
+
+static CommandLine
+ParseCommandLine(int argc, char **argv)
+{
+	CommandLine c;
+
+	OptionParser option_parser(option_defs, argc, argv);
+	while (auto o = option_parser.Next()) {
+		switch (Option(o.index)) {
+		case OPTION_CONFIG:
+			c.config_path = o.value;
+			break;
+
+		case OPTION_COMPRESS:
+			c.compress = true;
+			break;
+		}
+	}
+
+	auto args = option_parser.GetRemaining();
+	if (args.size() != 3)
+		throw std::runtime_error("Usage: ConvertDatabase [--config=FILE] [--compress] IN OUT text|binary");
+
+	c.in_path = args[0];
+	c.out_path = args[1];
+
+	if (StringIsEqual(args[2], "text"))
+		c.binary = false;
+	else if (StringIsEqual(args[2], "binary"))
+		c.binary = true;
+	else
+		throw std::runtime_error("Unrecognized database format");
+
+	return c;
+}
+
+static void
+SaveText(OutputStream &os, const Directory &root, [[maybe_unused]] bool compress)
+{
+#ifdef ENABLE_ZLIB
+	if (compress) {
+		GzipOutputStream gzip(os);
+		BufferedOutputStream bos(gzip);
+		db_save_internal(bos, root);
+		bos.Flush();
+		gzip.Finish();
+		return;
+	}
+#endif
+
+	BufferedOutputStream bos(os);
+	db_save_internal(bos, root);
+	bos.Flush();
+}
+
+int
+main(int argc, char **argv)
+try {
+	const auto c = ParseCommandLine(argc, argv);
+
+	const auto config = AutoLoadConfigFile(c.config_path);
+	TagLoadConfig(config);
+
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	using Clock = std::chrono::steady_clock;
+	auto start = Clock::now();
+
+	db_load_file(c.in_path, *root);
+
+	const std::chrono::duration<double> load_duration = Clock::now() - start;
+	start = Clock::now();
+
+	FileOutputStream fos(c.out_path);
+
+	if (c.binary) {
+		BufferedOutputStream bos(fos);
+		db_save_binary(bos, *root);
+		bos.Flush();
+	} else
+		SaveText(fos, *root, c.compress);
+
+	fos.Commit();
+
+	const std::chrono::duration<double> save_duration = Clock::now() - start;
+
+	fmt::print(stderr, "loaded in {:.3f} s, saved in {:.3f} s\n",
+		   load_duration.count(), save_duration.count());
+
+	return EXIT_SUCCESS;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
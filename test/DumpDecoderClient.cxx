@@ -22,6 +22,7 @@ DumpDecoderClient::Ready(const AudioFormat audio_format,
 		ToString(audio_format).c_str(),
 		duration.ToDoubleS(), seekable);
 
+	frame_size = audio_format.GetFrameSize();
 	initialized = true;
 }
 
@@ -89,6 +90,25 @@ DumpDecoderClient::SubmitAudio([[maybe_unused]] InputStream *is,
 	return GetCommand();
 }
 
+std::span<std::byte>
+DumpDecoderClient::GetAudioBuffer([[maybe_unused]] InputStream *is) noexcept
+{
+	assert(initialized);
+
+	return std::span{audio_buffer}.first(sizeof(audio_buffer) -
+					     sizeof(audio_buffer) % frame_size);
+}
+
+DecoderCommand
+DumpDecoderClient::SubmitAudioBuffer(std::size_t nbytes,
+				     uint16_t kbit_rate) noexcept
+{
+	assert(nbytes <= sizeof(audio_buffer));
+
+	return SubmitAudio(nullptr, std::span{audio_buffer}.first(nbytes),
+			   kbit_rate);
+}
+
 DecoderCommand
 DumpDecoderClient::SubmitTag([[maybe_unused]] InputStream *is,
 			     Tag &&tag) noexcept
@@ -16,6 +16,16 @@ class DumpDecoderClient : public DecoderClient {
 
 	uint16_t prev_kbit_rate = 0;
 
+	/**
+	 * The frame size of the audio format passed to Ready().
+	 */
+	std::size_t frame_size;
+
+	/**
+	 * The buffer returned by GetAudioBuffer().
+	 */
+	std::byte audio_buffer[16384];
+
 public:
 	Mutex mutex;
 
@@ -38,6 +48,9 @@ public:
 	DecoderCommand SubmitAudio(InputStream *is,
 				   std::span<const std::byte> audio,
 				   uint16_t kbit_rate) noexcept override;
+	std::span<std::byte> GetAudioBuffer(InputStream *is) noexcept override;
+	DecoderCommand SubmitAudioBuffer(std::size_t nbytes,
+					 uint16_t kbit_rate) noexcept override;
 	DecoderCommand SubmitTag(InputStream *is, Tag &&tag) noexcept override;
 	void SubmitReplayGain(const ReplayGainInfo *replay_gain_info) noexcept override;
 	void SubmitMixRamp(MixRampInfo &&mix_ramp) noexcept override;
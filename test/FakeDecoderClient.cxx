@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "FakeDecoderClient.hxx"
+#include "input/InputStream.hxx"
+#include "tag/Tag.hxx"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+void
+FakeDecoderClient::Ready(const AudioFormat _audio_format,
+			 bool, SignedSongTime) noexcept
+{
+	assert(!audio_format.IsDefined());
+	assert(_audio_format.IsValid());
+
+	audio_format = _audio_format;
+}
+
+DecoderCommand
+FakeDecoderClient::GetCommand() noexcept
+{
+	return CheckStop(command);
+}
+
+void
+FakeDecoderClient::CommandFinished() noexcept
+{
+	assert(command != DecoderCommand::NONE);
+
+	command = DecoderCommand::NONE;
+}
+
+SongTime
+FakeDecoderClient::GetSeekTime() noexcept
+{
+	assert(command == DecoderCommand::SEEK);
+
+	return SongTime::FromScale<uint64_t>(seek_frame,
+					     audio_format.sample_rate);
+}
+
+uint64_t
+FakeDecoderClient::GetSeekFrame() noexcept
+{
+	assert(command == DecoderCommand::SEEK);
+
+	return seek_frame;
+}
+
+void
+FakeDecoderClient::SeekError() noexcept
+{
+	assert(command == DecoderCommand::SEEK);
+
+	command = DecoderCommand::NONE;
+}
+
+InputStreamPtr
+FakeDecoderClient::OpenUri(const char *)
+{
+	throw std::runtime_error("Not implemented");
+}
+
+size_t
+FakeDecoderClient::Read(InputStream &is, void *buffer, size_t length) noexcept
+{
+	if (stopped)
+		++calls_after_stop;
+
+	try {
+		return is.LockRead(buffer, std::min(length, max_read_size));
+	} catch (...) {
+		return 0;
+	}
+}
+
+void
+FakeDecoderClient::SubmitTimestamp(FloatDuration) noexcept
+{
+}
+
+DecoderCommand
+FakeDecoderClient::SubmitAudio(InputStream *,
+			       std::span<const std::byte> audio,
+			       uint16_t) noexcept
+{
+	assert(!buffer_pending);
+	assert(audio.size() % audio_format.GetFrameSize() == 0);
+
+	if (stopped)
+		++calls_after_stop;
+
+	if (command != DecoderCommand::NONE)
+		return CheckStop(command);
+
+	output.insert(output.end(), audio.begin(), audio.end());
+	return CheckStop(command);
+}
+
+std::span<std::byte>
+FakeDecoderClient::GetAudioBuffer(InputStream *) noexcept
+{
+	assert(!buffer_pending);
+
+	if (stopped)
+		++calls_after_stop;
+
+	if (command != DecoderCommand::NONE)
+		return {};
+
+	const std::size_t frame_size = audio_format.GetFrameSize();
+	audio_buffer.resize(max_buffer_size - max_buffer_size % frame_size);
+	if (audio_buffer.empty())
+		return {};
+
+	buffer_pending = true;
+	return audio_buffer;
+}
+
+DecoderCommand
+FakeDecoderClient::SubmitAudioBuffer(std::size_t nbytes, uint16_t) noexcept
+{
+	assert(buffer_pending);
+	assert(nbytes <= audio_buffer.size());
+	assert(nbytes % audio_format.GetFrameSize() == 0);
+
+	buffer_pending = false;
+
+	output.insert(output.end(), audio_buffer.begin(),
+		      std::next(audio_buffer.begin(), nbytes));
+	direct_bytes += nbytes;
+
+	/* simulate a command which has arrived after
+	   GetAudioBuffer() */
+	if (direct_bytes >= command_after) {
+		command = pending_command;
+		command_after = SIZE_MAX;
+	}
+
+	return CheckStop(command);
+}
+
+DecoderCommand
+FakeDecoderClient::SubmitTag(InputStream *, Tag &&) noexcept
+{
+	return CheckStop(command);
+}
+
+void
+FakeDecoderClient::SubmitReplayGain(const ReplayGainInfo *) noexcept
+{
+}
+
+void
+FakeDecoderClient::SubmitMixRamp(MixRampInfo &&) noexcept
+{
+}
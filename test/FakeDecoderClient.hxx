@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef FAKE_DECODER_CLIENT_HXX
+#define FAKE_DECODER_CLIENT_HXX
+
+#include "decoder/Client.hxx"
+#include "pcm/AudioFormat.hxx"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * A #DecoderClient implementation for unit tests.  It collects all
+ * decoded data, and it can simulate a command which arrives while
+ * the decoder plugin writes to the buffer returned by
+ * GetAudioBuffer().
+ */
+class FakeDecoderClient final : public DecoderClient {
+	/**
+	 * The buffer returned by GetAudioBuffer().
+	 */
+	std::vector<std::byte> audio_buffer;
+
+	bool buffer_pending = false;
+
+	bool stopped = false;
+
+public:
+	/**
+	 * The maximum size of the buffer returned by GetAudioBuffer()
+	 * (rounded down to the frame size); 0 disables it.
+	 */
+	std::size_t max_buffer_size = 4096;
+
+	/**
+	 * The maximum number of bytes returned by one Read() call.
+	 */
+	std::size_t max_read_size = SIZE_MAX;
+
+	/**
+	 * After this many bytes have been committed by
+	 * SubmitAudioBuffer(), it sets #command to #pending_command.
+	 */
+	std::size_t command_after = SIZE_MAX;
+	DecoderCommand pending_command = DecoderCommand::NONE;
+
+	DecoderCommand command = DecoderCommand::NONE;
+	uint64_t seek_frame = 0;
+
+	AudioFormat audio_format = AudioFormat::Undefined();
+
+	/**
+	 * All data submitted so far, with SubmitAudio() or
+	 * SubmitAudioBuffer().
+	 */
+	std::vector<std::byte> output;
+
+	/**
+	 * The number of bytes committed by SubmitAudioBuffer().
+	 */
+	std::size_t direct_bytes = 0;
+
+	/**
+	 * The number of calls after DecoderCommand::STOP was
+	 * returned; must be zero.
+	 */
+	unsigned calls_after_stop = 0;
+
+	/* virtual methods from DecoderClient */
+	void Ready(AudioFormat audio_format,
+		   bool seekable, SignedSongTime duration) noexcept override;
+	DecoderCommand GetCommand() noexcept override;
+	void CommandFinished() noexcept override;
+	SongTime GetSeekTime() noexcept override;
+	uint64_t GetSeekFrame() noexcept override;
+	void SeekError() noexcept override;
+	InputStreamPtr OpenUri(const char *uri) override;
+	size_t Read(InputStream &is,
+		    void *buffer, size_t length) noexcept override;
+	void SubmitTimestamp(FloatDuration t) noexcept override;
+	DecoderCommand SubmitAudio(InputStream *is,
+				   std::span<const std::byte> audio,
+				   uint16_t kbit_rate) noexcept override;
+	std::span<std::byte> GetAudioBuffer(InputStream *is) noexcept override;
+	DecoderCommand SubmitAudioBuffer(std::size_t nbytes,
+					 uint16_t kbit_rate) noexcept override;
+	DecoderCommand SubmitTag(InputStream *is, Tag &&tag) noexcept override;
+	void SubmitReplayGain(const ReplayGainInfo *replay_gain_info) noexcept override;
+	void SubmitMixRamp(MixRampInfo &&mix_ramp) noexcept override;
+
+private:
+	DecoderCommand CheckStop(DecoderCommand cmd) noexcept {
+		if (cmd == DecoderCommand::STOP)
+			stopped = true;
+		return cmd;
+	}
+};
+
+#endif
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#ifndef MPD_CONNECTION_HXX
+#define MPD_CONNECTION_HXX
+
+#include "net/Resolver.hxx"
+#include "net/AddressInfo.hxx"
+#include "net/SocketAddress.hxx"
+#include "net/SocketError.hxx"
+#include "net/UniqueSocketDescriptor.hxx"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * A minimal blocking MPD protocol client for benchmarks.
+ */
+class MpdConnection {
+	UniqueSocketDescriptor fd;
+
+	/**
+	 * Received data; everything before #position has already
+	 * been consumed.
+	 */
+	std::string input;
+	std::size_t position = 0;
+
+	/**
+	 * The total number of bytes received.
+	 */
+	std::size_t n_received = 0;
+
+public:
+	explicit MpdConnection(const char *host) {
+		const auto ai = Resolve(host, 6600, 0, SOCK_STREAM);
+		const auto &address = ai.front();
+
+		if (!fd.Create(address.GetFamily(), address.GetType(),
+			       address.GetProtocol()))
+			throw MakeSocketError("Failed to create socket");
+
+		if (!fd.Connect(address))
+			throw MakeSocketError("Failed to connect");
+
+		/* skip the greeting */
+		ReadLine();
+	}
+
+	/**
+	 * Use a socket which is already connected to MPD (e.g. one
+	 * end of a socketpair).
+	 */
+	explicit MpdConnection(UniqueSocketDescriptor &&_fd)
+		:fd(std::move(_fd))
+	{
+		/* skip the greeting */
+		ReadLine();
+	}
+
+	std::size_t GetReceivedBytes() const noexcept {
+		return n_received;
+	}
+
+	void Send(std::string_view command) {
+		while (!command.empty()) {
+			const auto nbytes = fd.Write(command.data(),
+						     command.size());
+			if (nbytes <= 0)
+				throw MakeSocketError("Failed to send");
+
+			command.remove_prefix(nbytes);
+		}
+	}
+
+	/**
+	 * Send the command and discard the response.  Returns the
+	 * number of response lines.
+	 */
+	unsigned Command(std::string_view command) {
+		Send(command);
+
+		for (unsigned n = 0;; ++n) {
+			const auto line = ReadLine();
+			if (line == "OK")
+				return n;
+
+			if (line.starts_with("ACK "))
+				throw std::runtime_error(std::string{line});
+		}
+	}
+
+	/**
+	 * Read the next line (without the newline character).  The
+	 * return value is valid until the next call.
+	 */
+	std::string_view ReadLine() {
+		while (true) {
+			const auto newline = input.find('\n', position);
+			if (newline != input.npos) {
+				std::string_view line{input.data() + position,
+						      newline - position};
+				position = newline + 1;
+				return line;
+			}
+
+			Fill();
+		}
+	}
+
+	/**
+	 * Read the payload of a "binary" chunk (including the
+	 * trailing newline, which is not returned).  The return
+	 * value is valid until the next call.
+	 */
+	std::string_view ReadBinary(std::size_t size) {
+		while (input.size() - position < size + 1)
+			Fill();
+
+		std::string_view payload{input.data() + position, size};
+		position += size + 1;
+		return payload;
+	}
+
+private:
+	void Fill() {
+		if (position > 0) {
+			input.erase(0, position);
+			position = 0;
+		}
+
+		/* SocketDescriptor::Read() does not block */
+		if (fd.WaitReadable(-1) < 0)
+			throw MakeSocketError("Failed to wait for data");
+
+		char buffer[65536];
+		const auto nbytes = fd.Read(buffer, sizeof(buffer));
+		if (nbytes < 0)
+			throw MakeSocketError("Failed to receive");
+		if (nbytes == 0)
+			throw std::runtime_error("Connection closed");
+
+		input.append(buffer, nbytes);
+		n_received += nbytes;
+	}
+};
+
+#endif
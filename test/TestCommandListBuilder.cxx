@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "command/CommandListBuilder.hxx"
+#include "client/Config.hxx"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+size_t client_max_command_list_size = 32;
+
+static std::vector<std::string>
+Split(std::string &&list)
+{
+	std::vector<std::string> result;
+	for (const char *p = list.data(), *const end = p + list.size();
+	     p != end; p += std::strlen(p) + 1)
+		result.emplace_back(p);
+	return result;
+}
+
+TEST(CommandListBuilder, Basic)
+{
+	CommandListBuilder builder;
+	EXPECT_FALSE(builder.IsActive());
+
+	builder.Begin(true);
+	EXPECT_TRUE(builder.IsActive());
+	EXPECT_TRUE(builder.IsOKMode());
+
+	EXPECT_TRUE(builder.Add("status"));
+	EXPECT_TRUE(builder.Add(""));
+	EXPECT_TRUE(builder.Add("addid \"foo\""));
+
+	EXPECT_EQ(Split(builder.Commit()),
+		  (std::vector<std::string>{"status", "", "addid \"foo\""}));
+
+	builder.Reset();
+	EXPECT_FALSE(builder.IsActive());
+
+	builder.Begin(false);
+	EXPECT_FALSE(builder.IsOKMode());
+	EXPECT_TRUE(Split(builder.Commit()).empty());
+	builder.Reset();
+}
+
+TEST(CommandListBuilder, Full)
+{
+	CommandListBuilder builder;
+	builder.Begin(false);
+
+	/* each command occupies its length plus the null
+	   terminator */
+	EXPECT_TRUE(builder.Add("0123456789abcde"));
+	EXPECT_TRUE(builder.Add("0123456789abcde"));
+	EXPECT_FALSE(builder.Add(""));
+
+	builder.Reset();
+}
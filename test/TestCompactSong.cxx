@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "CompactSongDecoder.hxx"
+#include "MakeTag.hxx"
+#include "CompactSongEncoder.hxx"
+#include "song/LightSong.hxx"
+#include "tag/Mask.hxx"
+
+#include <gtest/gtest.h>
+
+using Song = CompactSongDecoder::Song;
+
+static std::vector<Song>
+Decode(CompactSongDecoder &decoder, std::string_view payload)
+{
+	std::vector<Song> result;
+	decoder.Feed(payload, [&result](Song &&song){
+		result.emplace_back(std::move(song));
+	});
+	return result;
+}
+
+TEST(CompactSong, Basic)
+{
+	const Tag tag1 = MakeTag(TAG_ARTIST, "Artist", TAG_ALBUM, "Album",
+				 TAG_TITLE, "One");
+	const Tag tag2 = MakeTag(TAG_ARTIST, "Artist", TAG_ALBUM, "Album",
+				 TAG_TITLE, "Two");
+
+	LightSong song1("one.flac", tag1);
+	song1.directory = "a/b";
+	song1.mtime = std::chrono::system_clock::from_time_t(1234567890);
+
+	LightSong song2("two.flac", tag2);
+	song2.start_time = SongTime::FromMS(1500);
+	song2.end_time = SongTime::FromMS(61000);
+
+	CompactSongEncoder encoder;
+	CompactSongDecoder decoder;
+
+	const std::string data1{encoder.Encode(song1, false, TagMask::All())};
+	const auto result1 = Decode(decoder, data1);
+	ASSERT_EQ(result1.size(), 1U);
+	EXPECT_EQ(result1.front(), (Song{
+		{"file", "a/b/one.flac"},
+		{"Last-Modified", "1234567890"},
+		{"Artist", "Artist"},
+		{"Album", "Album"},
+		{"Title", "One"},
+	}));
+
+	const std::string data2{encoder.Encode(song2, true, TagMask::All())};
+
+	/* the second song refers to the strings of the first one, so
+	   it is smaller */
+	EXPECT_LT(data2.size(), data1.size());
+
+	const auto result2 = Decode(decoder, data2);
+	ASSERT_EQ(result2.size(), 1U);
+	EXPECT_EQ(result2.front(), (Song{
+		{"file", "two.flac"},
+		{"Range", "1.500-61.000"},
+		{"Artist", "Artist"},
+		{"Album", "Album"},
+		{"Title", "Two"},
+		{"duration", "59500"},
+	}));
+
+	EXPECT_TRUE(decoder.IsEmpty());
+}
+
+TEST(CompactSong, TagMask)
+{
+	const Tag tag = MakeTag(TAG_ARTIST, "Artist", TAG_TITLE, "Title");
+	const LightSong song("x.ogg", tag);
+
+	CompactSongEncoder encoder;
+	CompactSongDecoder decoder;
+
+	const auto result = Decode(decoder,
+				   encoder.Encode(song, false,
+						  TagMask{TAG_TITLE}));
+	ASSERT_EQ(result.size(), 1U);
+	EXPECT_EQ(result.front(), (Song{
+		{"file", "x.ogg"},
+		{"Title", "Title"},
+	}));
+}
+
+/**
+ * Feed the encoded data byte by byte, which simulates a response
+ * split into many "binary" chunks.
+ */
+TEST(CompactSong, Split)
+{
+	const Tag tag = MakeTag(TAG_ARTIST, "Artist", TAG_ALBUM_ARTIST, "Artist",
+				TAG_GENRE, "Genre");
+	const LightSong song("x.ogg", tag);
+
+	CompactSongEncoder encoder;
+	CompactSongDecoder decoder;
+
+	std::string data{encoder.Encode(song, false, TagMask::All())};
+	data += encoder.Encode(song, false, TagMask::All());
+
+	std::vector<Song> result;
+	for (char ch : data) {
+		auto songs = Decode(decoder, {&ch, 1});
+		for (auto &i : songs)
+			result.emplace_back(std::move(i));
+	}
+
+	const Song expected{
+		{"file", "x.ogg"},
+		{"Artist", "Artist"},
+		{"AlbumArtist", "Artist"},
+		{"Genre", "Genre"},
+	};
+
+	ASSERT_EQ(result.size(), 2U);
+	EXPECT_EQ(result[0], expected);
+	EXPECT_EQ(result[1], expected);
+	EXPECT_TRUE(decoder.IsEmpty());
+}
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "db/plugins/simple/Arena.hxx"
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/DatabaseLock.hxx"
+
+#include <fmt/core.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+static constexpr unsigned N_DIRECTORIES = 20;
+static constexpr unsigned N_SONGS = 500;
+
+/**
+ * Generate a song file name whose length depends on both
+ * parameters, to exercise many size classes.
+ */
+static std::string
+MakeName(unsigned round, unsigned i)
+{
+	return fmt::format("{:0{}}-{}.flac", i,
+			   1 + (round * 7 + i * 13) % 40,
+			   round);
+}
+
+static void
+Populate(Directory &root, unsigned round)
+{
+	const ScopeDatabaseLock protect;
+
+	for (unsigned d = 0; d < N_DIRECTORIES; ++d) {
+		auto *directory = root.MakeChild(fmt::format("dir{}", d));
+		for (unsigned i = 0; i < N_SONGS; ++i)
+			directory->AddSong(Song::New(MakeName(round, i),
+						     *directory));
+	}
+}
+
+/**
+ * Simulate an update: replace every other song in all directories
+ * with a new one (with a different file name), while the rest stays.
+ */
+static void
+Update(Directory &root, unsigned round)
+{
+	const ScopeDatabaseLock protect;
+
+	for (auto &directory : root.children) {
+		unsigned i = 0;
+		directory.ForEachSongSafe([&](Song &song){
+			if (i++ % 2 == round % 2)
+				directory.RemoveSong(&song);
+		});
+
+		for (unsigned j = 0; j < N_SONGS / 2; ++j)
+			directory.AddSong(Song::New(MakeName(round, j),
+						    directory));
+	}
+}
+
+static void
+DeleteRoot(Directory *root)
+{
+	const ScopeDatabaseLock protect;
+	delete root;
+}
+
+TEST(DatabaseArena, Intern)
+{
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	const ScopeDatabaseLock protect;
+	auto *a = root->CreateChild("a");
+	auto *b = root->CreateChild("b");
+
+	a->AddSong(Song::New("01.flac", *a));
+	b->AddSong(Song::New("01.flac", *b));
+	b->AddSong(Song::New("02.flac", *b));
+
+	const auto &song_a = *a->FindSong("01.flac");
+	const auto &song_b = *b->FindSong("01.flac");
+	EXPECT_EQ(song_a.filename.c_str(), song_b.filename.c_str());
+	EXPECT_NE(song_b.filename.c_str(), b->FindSong("02.flac")->filename.c_str());
+
+	/* the other reference stays valid */
+	a->RemoveSong(a->FindSong("01.flac"));
+	EXPECT_STREQ(song_b.filename.c_str(), "01.flac");
+
+	ArenaString s{root->arena, "01.flac"};
+	EXPECT_EQ(s.c_str(), song_b.filename.c_str());
+	s.Set(root->arena, "03.flac");
+	EXPECT_STREQ(s.c_str(), "03.flac");
+	EXPECT_EQ(s.size(), 7U);
+
+	root.reset();
+}
+
+/**
+ * Memory which is freed by an update is reused by the next one, so
+ * the arena does not grow even though no chunk ever becomes
+ * completely empty.
+ */
+TEST(DatabaseArena, RepeatedUpdates)
+{
+	const std::size_t initial_size = db_arena_size();
+
+	auto *root = Directory::NewRoot();
+	Populate(*root, 0);
+
+	/* the file name lengths repeat after 40 rounds; after that,
+	   every size class has seen its maximum */
+	for (unsigned round = 1; round <= 40; ++round)
+		Update(*root, round);
+
+	const std::size_t size = db_arena_size();
+
+	for (unsigned round = 41; round <= 160; ++round) {
+		Update(*root, round);
+		ASSERT_LE(db_arena_size(), size) << "round " << round;
+	}
+
+	DeleteRoot(root);
+
+	/* the first chunk is kept */
+	EXPECT_LE(db_arena_size(), initial_size + 1024 * 1024);
+}
+
+/**
+ * Each root gets a generation of its own; when the old database is
+ * freed, all of its memory is given back, even though a new
+ * database has been allocated in the meantime.
+ */
+TEST(DatabaseArena, Generation)
+{
+	const std::size_t initial_size = db_arena_size();
+
+	auto *old_root = Directory::NewRoot();
+	Populate(*old_root, 0);
+	Update(*old_root, 1);
+	const std::size_t old_size = db_arena_size() - initial_size;
+
+	auto *new_root = Directory::NewRoot();
+	Populate(*new_root, 2);
+	const std::size_t new_size = db_arena_size() - initial_size - old_size;
+
+	/* the first chunk of the old generation may have been part of
+	   "initial_size" already */
+	DeleteRoot(old_root);
+	EXPECT_LE(db_arena_size(), initial_size + new_size);
+
+	DeleteRoot(new_root);
+	EXPECT_LE(db_arena_size(), initial_size + 1024 * 1024);
+}
+
+/**
+ * Creating another root (e.g. for a mounted database) does not
+ * affect the existing one: it keeps reusing its freed memory.
+ */
+TEST(DatabaseArena, IndependentRoots)
+{
+	auto *root = Directory::NewRoot();
+	Populate(*root, 0);
+
+	for (unsigned round = 1; round <= 40; ++round)
+		Update(*root, round);
+
+	auto *mounted = Directory::NewRoot();
+	Populate(*mounted, 0);
+
+	const std::size_t size = db_arena_size();
+
+	for (unsigned round = 41; round <= 80; ++round) {
+		Update(*root, round);
+		ASSERT_LE(db_arena_size(), size) << "round " << round;
+	}
+
+	DeleteRoot(mounted);
+	DeleteRoot(root);
+}
@@ -0,0 +1,449 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "MakeTag.hxx"
+#include "db/plugins/simple/DatabaseJournal.hxx"
+#include "db/plugins/simple/DatabaseSave.hxx"
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/plugins/simple/SimpleDatabasePlugin.hxx"
+#include "db/DatabaseLock.hxx"
+#include "db/DatabaseListener.hxx"
+#include "config/Block.hxx"
+#include "event/Loop.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "fs/FileInfo.hxx"
+#include "fs/FileSystem.hxx"
+#include "fs/io/TextFile.hxx"
+#include "io/BufferedOutputStream.hxx"
+#include "io/FileOutputStream.hxx"
+
+#include <fmt/core.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+class NullDatabaseListener final : public DatabaseListener {
+public:
+	void OnDatabaseModified() noexcept override {}
+	void OnDatabaseSongRemoved(const char *) noexcept override {}
+};
+
+class DatabaseJournalTest : public ::testing::Test {
+protected:
+	const AllocatedPath base_path =
+		AllocatedPath::FromFS(fmt::format("{}mpd_journal_{}.db",
+						  ::testing::TempDir(),
+						  getpid()));
+	const AllocatedPath journal_path =
+		AllocatedPath::FromFS(fmt::format("{}mpd_journal_{}.db.journal",
+						  ::testing::TempDir(),
+						  getpid()));
+
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	void SetUp() override {
+		const ScopeDatabaseLock protect;
+
+		root->mtime = std::chrono::system_clock::from_time_t(1600000000);
+
+		for (unsigned i = 0; i < 3; ++i) {
+			auto *artist = root->CreateChild(fmt::format("Artist {}", i));
+			artist->mtime = std::chrono::system_clock::from_time_t(1600000001 + i);
+
+			for (unsigned j = 0; j < 2; ++j) {
+				auto *album = artist->CreateChild(fmt::format("Album {}", j));
+				album->mtime = std::chrono::system_clock::from_time_t(1600000010 + j);
+
+				for (unsigned k = 0; k < 3; ++k)
+					AddSong(*album, fmt::format("{}.flac", k),
+						fmt::format("Title {}/{}/{}", i, j, k));
+			}
+		}
+
+		SaveBase();
+		root->ClearDirty();
+	}
+
+	void TearDown() override {
+		unlink(base_path.c_str());
+		unlink(journal_path.c_str());
+	}
+
+	static void AddSong(Directory &directory, std::string_view name,
+			    const std::string &title) {
+		auto song = Song::New(name, directory);
+		song->tag = MakeTag(TAG_TITLE, title.c_str());
+		directory.AddSong(std::move(song));
+	}
+
+	static std::string Dump(const Directory &directory) {
+		const auto path = AllocatedPath::FromFS(fmt::format("{}mpd_journal_{}.dump",
+								    ::testing::TempDir(),
+								    getpid()));
+
+		{
+			FileOutputStream fos(path);
+			BufferedOutputStream bos(fos);
+			db_save_internal(bos, directory);
+			bos.Flush();
+			fos.Commit();
+		}
+
+		std::string result;
+		TextFile file(path);
+		const char *line;
+		while ((line = file.ReadLine()) != nullptr) {
+			/* skip the header which contains the MPD
+			   version */
+			if (result.empty() &&
+			    std::string_view{line}.starts_with("mpd_version: "))
+				continue;
+
+			result.append(line);
+			result.push_back('\n');
+		}
+
+		unlink(path.c_str());
+		return result;
+	}
+
+	void SaveBase() {
+		FileOutputStream fos(base_path);
+		BufferedOutputStream bos(fos);
+		db_save_internal(bos, *root);
+		bos.Flush();
+		fos.Commit();
+	}
+
+	void AppendJournal() {
+		const FileInfo base(base_path);
+		const bool create = !PathExists(journal_path);
+
+		FileOutputStream fos(journal_path,
+				     FileOutputStream::Mode::APPEND_OR_CREATE);
+		BufferedOutputStream bos(fos);
+		if (create)
+			db_journal_save_header(bos, base);
+
+		{
+			const ScopeDatabaseLock protect;
+			db_journal_save(bos, *root);
+		}
+
+		bos.Flush();
+		fos.Commit();
+	}
+
+	static std::string ReadFile(Path path) {
+		std::string result;
+		TextFile file(path);
+		const char *line;
+		while ((line = file.ReadLine()) != nullptr) {
+			result.append(line);
+			result.push_back('\n');
+		}
+
+		return result;
+	}
+
+	/**
+	 * Open and close a #SimpleDatabase on #base_path, like MPD
+	 * does on startup and shutdown.
+	 */
+	void OpenClose() {
+		SimpleDatabase db(AllocatedPath{base_path}, false,
+				  SimpleDatabase::Format::TEXT);
+		db.Open();
+		db.Close();
+	}
+
+	/**
+	 * Append two records to the journal, cut off the given number
+	 * of bytes and check that the next save replaces the
+	 * database file and deletes the journal instead of appending
+	 * to it.
+	 *
+	 * @param complete is the second record still complete?
+	 */
+	void SaveAfterIncomplete(std::size_t cut, bool complete) {
+		{
+			const ScopeDatabaseLock protect;
+			auto *album = root->LookupDirectory("Artist 0/Album 0").directory;
+			AddSong(*album, "3.flac", "New Title");
+			root->Sort();
+		}
+
+		AppendJournal();
+
+		const std::string first = Dump(*root);
+
+		{
+			const ScopeDatabaseLock protect;
+			auto *album = root->LookupDirectory("Artist 1/Album 0").directory;
+			AddSong(*album, "3.flac", "Another Title");
+			root->Sort();
+		}
+
+		AppendJournal();
+
+		const FileInfo journal_info(journal_path);
+		ASSERT_EQ(truncate(journal_path.c_str(), journal_info.GetSize() - cut), 0);
+
+		{
+			ConfigBlock block;
+			block.AddBlockParam("path", base_path.c_str());
+			block.AddBlockParam("compress", "no");
+			block.AddBlockParam("journal", "yes");
+
+			EventLoop event_loop;
+			NullDatabaseListener listener;
+			auto db = SimpleDatabase::Create(event_loop, event_loop,
+							 listener, block);
+			db->Open();
+			static_cast<SimpleDatabase &>(*db).Save();
+			EXPECT_FALSE(PathExists(journal_path));
+			db->Close();
+		}
+
+		std::unique_ptr<Directory> result{Directory::NewRoot()};
+		db_load_file(base_path, *result);
+		EXPECT_EQ(Dump(*result), complete ? Dump(*root) : first);
+	}
+
+	std::unique_ptr<Directory> Load() {
+		std::unique_ptr<Directory> result{Directory::NewRoot()};
+		db_load_file(base_path, *result);
+
+		TextFile file(journal_path);
+		EXPECT_EQ(db_journal_load(file, *result, FileInfo(base_path)),
+			  JournalLoadResult::COMPLETE);
+
+		const ScopeDatabaseLock protect;
+		result->Sort();
+		return result;
+	}
+};
+
+TEST_F(DatabaseJournalTest, Replay)
+{
+	{
+		const ScopeDatabaseLock protect;
+
+		/* add a song */
+		auto *album = root->LookupDirectory("Artist 0/Album 1").directory;
+		AddSong(*album, "3.flac", "New Title");
+
+		/* remove a song */
+		album = root->LookupDirectory("Artist 1/Album 0").directory;
+		album->RemoveSong(album->FindSong("1.flac"));
+
+		/* change a song's tag */
+		album = root->LookupDirectory("Artist 1/Album 1").directory;
+		auto *song = album->FindSong("2.flac");
+		const Tag old_tag = std::exchange(song->tag,
+						  MakeTag(TAG_TITLE, "Changed"));
+		album->SongTagChanged(*song, old_tag);
+
+		/* change a directory attribute */
+		root->mtime = std::chrono::system_clock::from_time_t(1700000000);
+		root->MarkDirty();
+
+		/* delete a directory */
+		root->FindChild("Artist 2")->Delete();
+	}
+
+	AppendJournal();
+
+	{
+		const ScopeDatabaseLock protect;
+
+		/* create a directory tree */
+		auto *album = root->MakeChild("Artist 3")->MakeChild("Album 0");
+		AddSong(*album, "0.flac", "Title 3/0/0");
+
+		/* modify a directory which was modified before */
+		album = root->LookupDirectory("Artist 0/Album 1").directory;
+		AddSong(*album, "4.flac", "Another Title");
+	}
+
+	AppendJournal();
+
+	{
+		const ScopeDatabaseLock protect;
+		root->Sort();
+	}
+
+	EXPECT_EQ(Dump(*Load()), Dump(*root));
+}
+
+TEST_F(DatabaseJournalTest, IncompleteRecord)
+{
+	{
+		const ScopeDatabaseLock protect;
+		auto *album = root->LookupDirectory("Artist 0/Album 0").directory;
+		AddSong(*album, "3.flac", "New Title");
+	}
+
+	AppendJournal();
+
+	const std::string expected = Dump(*root);
+	const auto complete_size = FileInfo(journal_path).GetSize();
+
+	{
+		const ScopeDatabaseLock protect;
+		auto *album = root->LookupDirectory("Artist 1/Album 0").directory;
+		AddSong(*album, "3.flac", "Lost Title");
+	}
+
+	AppendJournal();
+
+	/* simulate a crash at every position of the second record,
+	   cutting off the "end" line, a line in the middle and the
+	   "record" line (a missing final newline is checked by
+	   SimpleDatabase, see SaveAfterIncomplete) */
+	for (auto size = FileInfo(journal_path).GetSize() - 2;
+	     size > complete_size; --size) {
+		ASSERT_EQ(truncate(journal_path.c_str(), size), 0);
+
+		std::unique_ptr<Directory> result{Directory::NewRoot()};
+		db_load_file(base_path, *result);
+
+		TextFile file(journal_path);
+		ASSERT_EQ(db_journal_load(file, *result, FileInfo(base_path)),
+			  JournalLoadResult::TRUNCATED)
+			<< "size=" << size;
+
+		{
+			const ScopeDatabaseLock protect;
+			result->Sort();
+		}
+
+		ASSERT_EQ(Dump(*result), expected) << "size=" << size;
+	}
+}
+
+/**
+ * Only the final newline is missing: the record is complete, but
+ * nothing may be appended to it.
+ */
+TEST_F(DatabaseJournalTest, SaveAfterMissingNewline)
+{
+	SaveAfterIncomplete(1, true);
+}
+
+/**
+ * The "end" line is incomplete: the record is ignored.
+ */
+TEST_F(DatabaseJournalTest, SaveAfterIncompleteRecord)
+{
+	SaveAfterIncomplete(10, false);
+}
+
+TEST_F(DatabaseJournalTest, Stale)
+{
+	{
+		const ScopeDatabaseLock protect;
+		auto *album = root->LookupDirectory("Artist 0/Album 0").directory;
+		AddSong(*album, "3.flac", "New Title");
+	}
+
+	AppendJournal();
+
+	/* the database file is rewritten, but the journal is not
+	   deleted */
+	{
+		const ScopeDatabaseLock protect;
+		root->FindChild("Artist 2")->Delete();
+	}
+	SaveBase();
+
+	std::unique_ptr<Directory> result{Directory::NewRoot()};
+	db_load_file(base_path, *result);
+
+	TextFile file(journal_path);
+	EXPECT_EQ(db_journal_load(file, *result, FileInfo(base_path)),
+		  JournalLoadResult::STALE);
+}
+
+TEST_F(DatabaseJournalTest, CloseMerges)
+{
+	{
+		const ScopeDatabaseLock protect;
+		auto *album = root->LookupDirectory("Artist 0/Album 0").directory;
+		AddSong(*album, "3.flac", "New Title");
+		root->Sort();
+	}
+
+	AppendJournal();
+
+	OpenClose();
+
+	EXPECT_FALSE(PathExists(journal_path));
+
+	std::unique_ptr<Directory> result{Directory::NewRoot()};
+	db_load_file(base_path, *result);
+	EXPECT_EQ(Dump(*result), Dump(*root));
+}
+
+TEST_F(DatabaseJournalTest, CloseKeepsCorruptJournal)
+{
+	for (unsigned i = 0; i < 3; ++i) {
+		{
+			const ScopeDatabaseLock protect;
+			auto *album = root->LookupDirectory(fmt::format("Artist {}/Album 0", i)).directory;
+			AddSong(*album, "3.flac", "New Title");
+		}
+
+		AppendJournal();
+	}
+
+	/* overwrite a part in the middle of the journal */
+	const FileInfo journal_info(journal_path);
+	{
+		const int fd = open(journal_path.c_str(), O_WRONLY);
+		ASSERT_GE(fd, 0);
+		static constexpr char garbage[] = "\ngarbage\n";
+		ASSERT_EQ(pwrite(fd, garbage, sizeof(garbage) - 1,
+				 journal_info.GetSize() / 2),
+			  ssize_t(sizeof(garbage) - 1));
+		close(fd);
+	}
+
+	const std::string base = ReadFile(base_path);
+	const std::string journal = ReadFile(journal_path);
+
+	OpenClose();
+
+	/* the database in memory was incomplete, therefore neither
+	   file has been touched */
+	EXPECT_EQ(ReadFile(base_path), base);
+	ASSERT_TRUE(PathExists(journal_path));
+	EXPECT_EQ(ReadFile(journal_path), journal);
+}
+
+TEST_F(DatabaseJournalTest, CloseKeepsCorruptBase)
+{
+	AppendJournal();
+
+	/* a database file which cannot be loaded */
+	{
+		const int fd = open(base_path.c_str(), O_WRONLY|O_TRUNC);
+		ASSERT_GE(fd, 0);
+		static constexpr char garbage[] = "garbage\n";
+		ASSERT_EQ(write(fd, garbage, sizeof(garbage) - 1),
+			  ssize_t(sizeof(garbage) - 1));
+		close(fd);
+	}
+
+	OpenClose();
+
+	EXPECT_EQ(ReadFile(base_path), "garbage\n");
+	EXPECT_TRUE(PathExists(journal_path));
+}
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "MakeTag.hxx"
+#include "db/VHelper.hxx"
+#include "db/Selection.hxx"
+#include "song/LightSong.hxx"
+
+#include <fmt/core.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+struct TestSong {
+	std::string uri;
+	Tag tag;
+};
+
+static std::vector<TestSong>
+MakeSongs()
+{
+	std::vector<TestSong> songs;
+
+	/* lots of duplicate titles to check that the sort is
+	   stable */
+	for (unsigned i = 0; i < 200; ++i) {
+		const auto title = fmt::format("Title {}", (i * 7) % 23);
+		songs.push_back({
+			fmt::format("song{}.flac", i),
+			MakeTag(TAG_TITLE, title.c_str()),
+		});
+	}
+
+	return songs;
+}
+
+static std::vector<std::string>
+Query(const std::vector<TestSong> &songs, RangeArg window, bool descending)
+{
+	DatabaseSelection selection("", true);
+	selection.sort = TAG_TITLE;
+	selection.descending = descending;
+	selection.window = window;
+
+	std::vector<std::string> result;
+	VisitSong visit_song = [&result](const LightSong &song){
+		result.emplace_back(song.uri);
+	};
+
+	DatabaseVisitorHelper helper(selection, visit_song);
+	for (const auto &i : songs)
+		visit_song(LightSong{i.uri.c_str(), i.tag});
+	helper.Commit();
+
+	return result;
+}
+
+TEST(DatabaseVisitorHelper, SortWindow)
+{
+	const auto songs = MakeSongs();
+
+	for (const bool descending : {false, true}) {
+		const auto all = Query(songs, RangeArg::All(), descending);
+		ASSERT_EQ(all.size(), songs.size());
+
+		for (const RangeArg window : {RangeArg{0, 0}, RangeArg{0, 1},
+					      RangeArg{0, 50}, RangeArg{17, 42},
+					      RangeArg{150, 250}, RangeArg{300, 400},
+					      RangeArg::OpenEnded(190)}) {
+			const std::vector<std::string> expected{
+				std::next(all.begin(), std::min<std::size_t>(window.start, all.size())),
+				std::next(all.begin(), std::min<std::size_t>(window.end, all.size())),
+			};
+
+			EXPECT_EQ(Query(songs, window, descending), expected);
+		}
+	}
+}
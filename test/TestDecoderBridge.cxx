@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * Unit tests for DecoderBridge::GetAudioBuffer() and
+ * DecoderBridge::SubmitAudioBuffer().
+ */
+
+#include "decoder/Bridge.hxx"
+#include "decoder/Control.hxx"
+#include "song/DetachedSong.hxx"
+#include "tag/Tag.hxx"
+#include "MusicPipe.hxx"
+#include "MusicBuffer.hxx"
+#include "MusicChunk.hxx"
+#include "config/ReplayGainConfig.hxx"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+
+/* the decoder thread is never started by this test */
+void
+DecoderControl::RunThread() noexcept
+{
+}
+
+static constexpr AudioFormat audio_format{1000, SampleFormat::S16, 1};
+static constexpr std::size_t frame_size = 2;
+
+class DecoderBridgeTest : public ::testing::Test {
+protected:
+	Mutex mutex;
+	Cond client_cond;
+
+	MusicBuffer buffer{16};
+
+	DecoderControl dc{mutex, client_cond, nullptr,
+			  AudioFormat::Undefined(), ReplayGainConfig{}};
+
+	std::unique_ptr<DecoderBridge> bridge;
+
+	void SetUp() override {
+		dc.song = std::make_unique<DetachedSong>("foo.raw");
+		dc.pipe = std::make_shared<MusicPipe>();
+		dc.buffer = &buffer;
+		dc.state = DecoderState::START;
+
+		bridge = std::make_unique<DecoderBridge>(dc, false, false,
+							 nullptr);
+	}
+
+	void TearDown() override {
+		bridge->CheckFlushChunk();
+		bridge.reset();
+		dc.pipe->Clear();
+	}
+
+	void SetCommand(DecoderCommand command) noexcept {
+		const std::scoped_lock lock{mutex};
+		dc.command = command;
+	}
+
+	/**
+	 * Fill the given buffer with a frame counter.
+	 */
+	static void Fill(std::span<std::byte> dest, unsigned &counter) noexcept {
+		for (std::size_t i = 0; i < dest.size(); i += frame_size) {
+			const uint16_t value = counter++;
+			std::memcpy(dest.data() + i, &value, sizeof(value));
+		}
+	}
+
+	/**
+	 * Flush the current chunk and check and remove the contents
+	 * of the #MusicPipe.
+	 *
+	 * @return the number of frames in the pipe
+	 */
+	std::size_t CheckPipe() noexcept {
+		bridge->CheckFlushChunk();
+
+		std::size_t n_frames = 0;
+		MusicChunkPtr chunk;
+		while ((chunk = dc.pipe->Shift()) != nullptr) {
+			const auto data = chunk->GetData();
+			EXPECT_EQ(data.size() % frame_size, 0U);
+
+			for (std::size_t i = 0; i < data.size(); i += frame_size) {
+				uint16_t value;
+				std::memcpy(&value, data.data() + i, sizeof(value));
+				EXPECT_EQ(value, n_frames);
+				++n_frames;
+			}
+		}
+
+		return n_frames;
+	}
+};
+
+TEST_F(DecoderBridgeTest, Basic)
+{
+	bridge->Ready(audio_format, true, SignedSongTime::Negative());
+
+	unsigned counter = 0;
+	for (unsigned i = 0; i < 10; ++i) {
+		auto dest = bridge->GetAudioBuffer(nullptr);
+		ASSERT_FALSE(dest.empty());
+		ASSERT_EQ(dest.size() % frame_size, 0U);
+
+		/* use only part of the buffer */
+		dest = dest.first(std::min<std::size_t>(dest.size(), 1000));
+		Fill(dest, counter);
+		EXPECT_EQ(bridge->SubmitAudioBuffer(dest.size(), 128),
+			  DecoderCommand::NONE);
+	}
+
+	EXPECT_EQ(CheckPipe(), counter);
+}
+
+/**
+ * The buffer returned by GetAudioBuffer() ends at the song's end
+ * time, even though there is more room in the current chunk.
+ */
+TEST_F(DecoderBridgeTest, EndTimeTruncation)
+{
+	/* 1234 frames */
+	dc.end_time = SongTime::FromMS(1234);
+
+	bridge->Ready(audio_format, true, SignedSongTime::Negative());
+
+	unsigned counter = 0;
+	DecoderCommand cmd;
+	do {
+		auto dest = bridge->GetAudioBuffer(nullptr);
+		ASSERT_FALSE(dest.empty());
+		Fill(dest, counter);
+		cmd = bridge->SubmitAudioBuffer(dest.size(), 128);
+	} while (cmd == DecoderCommand::NONE);
+
+	/* each buffer was filled completely, and the last one ended
+	   exactly at the end time */
+	EXPECT_EQ(cmd, DecoderCommand::STOP);
+	EXPECT_EQ(counter, 1234U);
+
+	/* nothing more is accepted */
+	EXPECT_TRUE(bridge->GetAudioBuffer(nullptr).empty());
+	const std::byte more[frame_size]{};
+	EXPECT_EQ(bridge->SubmitAudio(nullptr, std::span{more}, 128),
+		  DecoderCommand::STOP);
+
+	EXPECT_EQ(CheckPipe(), 1234U);
+}
+
+/**
+ * A command which arrives between GetAudioBuffer() and
+ * SubmitAudioBuffer() is returned by SubmitAudioBuffer(), and the
+ * data written before is not lost.
+ */
+TEST_F(DecoderBridgeTest, CommandBetweenGetAndSubmit)
+{
+	bridge->Ready(audio_format, true, SignedSongTime::Negative());
+
+	unsigned counter = 0;
+	auto dest = bridge->GetAudioBuffer(nullptr);
+	ASSERT_FALSE(dest.empty());
+	dest = dest.first(100 * frame_size);
+	Fill(dest, counter);
+
+	SetCommand(DecoderCommand::STOP);
+
+	EXPECT_EQ(bridge->SubmitAudioBuffer(dest.size(), 128),
+		  DecoderCommand::STOP);
+
+	/* no buffer is handed out while a command is pending */
+	EXPECT_TRUE(bridge->GetAudioBuffer(nullptr).empty());
+
+	EXPECT_EQ(CheckPipe(), 100U);
+}
+
+TEST_F(DecoderBridgeTest, SeekBetweenGetAndSubmit)
+{
+	bridge->Ready(audio_format, true, SignedSongTime::Negative());
+
+	unsigned counter = 0;
+	auto dest = bridge->GetAudioBuffer(nullptr);
+	ASSERT_FALSE(dest.empty());
+	dest = dest.first(100 * frame_size);
+	Fill(dest, counter);
+
+	{
+		const std::scoped_lock lock{mutex};
+		dc.command = DecoderCommand::SEEK;
+		dc.seek_time = SongTime::FromS(2U);
+		dc.seek_error = false;
+	}
+
+	EXPECT_EQ(bridge->SubmitAudioBuffer(dest.size(), 128),
+		  DecoderCommand::SEEK);
+	EXPECT_TRUE(bridge->GetAudioBuffer(nullptr).empty());
+
+	EXPECT_EQ(bridge->GetSeekFrame(), 2000U);
+	bridge->CommandFinished();
+
+	/* the pipe has been cleared by the seek; decoding goes on
+	   at the new position */
+	EXPECT_TRUE(dc.pipe->IsEmpty());
+
+	dest = bridge->GetAudioBuffer(nullptr);
+	ASSERT_FALSE(dest.empty());
+	dest = dest.first(10 * frame_size);
+	counter = 0;
+	Fill(dest, counter);
+	EXPECT_EQ(bridge->SubmitAudioBuffer(dest.size(), 128),
+		  DecoderCommand::NONE);
+
+	EXPECT_EQ(CheckPipe(), 10U);
+}
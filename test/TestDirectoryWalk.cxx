@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * Stress test for Directory::Walk() running concurrently with a
+ * thread which modifies the tree, like the update thread does.
+ */
+
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/plugins/simple/ExportedSong.hxx"
+#include "db/DatabaseLock.hxx"
+#include "db/LightDirectory.hxx"
+#include "song/LightSong.hxx"
+
+#include <fmt/core.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+static constexpr unsigned N_SONGS = 8;
+
+/**
+ * Create a directory with #N_SONGS songs and a sub directory with
+ * #N_SONGS songs.  All of this is done while holding the lock, so a
+ * consistent walk must always see all of them.
+ */
+static void
+AddDirectory(Directory &root, unsigned i)
+{
+	const ScopeDatabaseLock protect;
+
+	auto *directory = root.CreateChild(fmt::format("dir{}", i));
+	auto *sub = directory->CreateChild("sub");
+
+	for (unsigned j = 0; j < N_SONGS; ++j) {
+		directory->AddSong(Song::New(fmt::format("{}.flac", j),
+					     *directory));
+		sub->AddSong(Song::New(fmt::format("{}.flac", j), *sub));
+	}
+}
+
+static void
+DeleteDirectory(Directory &root, unsigned i)
+{
+	const ScopeDatabaseLock protect;
+
+	auto *directory = root.FindChild(fmt::format("dir{}", i));
+	if (directory != nullptr)
+		directory->Delete();
+}
+
+TEST(DirectoryWalk, ConcurrentModification)
+{
+	static constexpr unsigned N_DIRECTORIES = 64;
+	static constexpr unsigned N_WALKS = 200;
+
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	for (unsigned i = 0; i < N_DIRECTORIES; ++i)
+		AddDirectory(*root, i);
+
+	std::atomic_bool stop{false};
+
+	std::thread updater([&root, &stop]{
+		for (unsigned i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+			DeleteDirectory(*root, i % N_DIRECTORIES);
+			AddDirectory(*root, i % N_DIRECTORIES);
+		}
+	});
+
+	for (unsigned n = 0; n < N_WALKS; ++n) {
+		/* number of songs per directory path */
+		std::map<std::string, unsigned> songs;
+		std::string current_directory;
+
+		const ScopeDatabaseLock protect;
+		root->Walk(true, nullptr, false,
+			   [&](const LightDirectory &directory){
+				   current_directory = directory.GetPath();
+				   EXPECT_EQ(songs.count(current_directory), 0U);
+				   songs[current_directory] = 0;
+			   },
+			   [&](const LightSong &song){
+				   ASSERT_NE(song.directory, nullptr);
+				   EXPECT_EQ(current_directory, song.directory);
+				   ++songs[song.directory];
+			   },
+			   {});
+
+		for (const auto &[path, count] : songs)
+			EXPECT_EQ(count, N_SONGS) << path;
+	}
+
+	stop = true;
+	updater.join();
+}
+
+TEST(DirectoryWalk, Yield)
+{
+	static constexpr unsigned N_DIRECTORIES = 16;
+
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	for (unsigned i = 0; i < N_DIRECTORIES; ++i)
+		AddDirectory(*root, i);
+
+	unsigned n_yields = 0, n_songs = 0;
+
+	{
+		const ScopeDatabaseLock protect;
+		root->Walk(true, nullptr, false, {},
+			   [&n_songs](const LightSong &){ ++n_songs; },
+			   {},
+			   [&root, &n_yields]{
+				   /* the lock is released, so the
+				      tree may be modified meanwhile */
+				   ASSERT_FALSE(holding_db_lock());
+				   if (n_yields++ == 0)
+					   DeleteDirectory(*root, N_DIRECTORIES - 1);
+			   });
+	}
+
+	/* once before each directory and its sub directory; the
+	   deleted directory is visited in its old state */
+	EXPECT_EQ(n_yields, N_DIRECTORIES * 2);
+	EXPECT_EQ(n_songs, N_DIRECTORIES * 2 * N_SONGS);
+
+	/* throwing from the yield function aborts the walk */
+	n_yields = 0;
+
+	{
+		const ScopeDatabaseLock protect;
+		EXPECT_THROW(root->Walk(true, nullptr, false, {}, {}, {},
+					[&n_yields]{
+						if (++n_yields == 3)
+							throw std::runtime_error("Cancelled");
+					}),
+			     std::runtime_error);
+	}
+
+	EXPECT_EQ(n_yields, 3U);
+
+	/* the tree can still be modified */
+	DeleteDirectory(*root, 0);
+}
+
+/**
+ * A directory which gets deleted during a Walk() is kept only while
+ * that Walk() may still access it.
+ */
+TEST(DirectoryWalk, Reclaim)
+{
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	for (unsigned i = 0; i < 4; ++i)
+		AddDirectory(*root, i);
+
+	unsigned n_yields = 0;
+
+	{
+		const ScopeDatabaseLock protect;
+		root->Walk(true, nullptr, false, {}, {}, {}, [&root, &n_yields]{
+			const ScopeDatabaseLock protect2;
+
+			/* before "dir0", "dir0/sub", "dir1", "dir1/sub" */
+			if (++n_yields != 4)
+				return;
+
+			/* "dir0" has been walked completely, so its
+			   sub directory is not pinned anymore, and
+			   deleting it frees it immediately */
+			auto *dir0 = root->FindChild("dir0");
+			auto *sub = dir0->FindChild("sub");
+			EXPECT_EQ(sub->pin_count, 0U);
+			sub->Delete();
+
+			/* "dir0" itself is still in the root's list
+			   of children to be walked */
+			EXPECT_EQ(dir0->pin_count, 1U);
+			dir0->Delete();
+			EXPECT_TRUE(dir0->deleted);
+		});
+	}
+
+	EXPECT_EQ(n_yields, 8U);
+
+	const ScopeDatabaseLock protect;
+	EXPECT_EQ(root->pin_count, 0U);
+	EXPECT_EQ(root->FindChild("dir0"), nullptr);
+}
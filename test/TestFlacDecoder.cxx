@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * Unit tests for the libFLAC write callback of the "flac" decoder
+ * plugin importing into the buffer provided by
+ * DecoderClient::GetAudioBuffer().
+ */
+
+#include "FakeDecoderClient.hxx"
+#include "decoder/plugins/FlacCommon.hxx"
+#include "input/InputStream.hxx"
+#include "thread/Mutex.hxx"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+static constexpr unsigned BLOCK_SIZE = 1000;
+
+/**
+ * 16 bit stereo.
+ */
+static constexpr std::size_t FRAME_SIZE = 4;
+
+class NullInputStream final : public InputStream {
+public:
+	explicit NullInputStream(Mutex &_mutex)
+		:InputStream("test.flac", _mutex) {
+		SetReady();
+	}
+
+	/* virtual methods from InputStream */
+	bool IsEOF() const noexcept override {
+		return true;
+	}
+
+	size_t Read(std::unique_lock<Mutex> &, void *, size_t) override {
+		return 0;
+	}
+};
+
+class FlacDecoderTest : public ::testing::Test {
+protected:
+	Mutex mutex;
+	NullInputStream is{mutex};
+	FakeDecoderClient client;
+	FlacDecoder decoder{client, is};
+
+	/**
+	 * The sample counter of the next frame.
+	 */
+	unsigned counter = 0;
+
+	/**
+	 * Pass a FLAC frame of #BLOCK_SIZE samples per channel to
+	 * the write callback.  The left channel counts up, the
+	 * right channel counts down.
+	 */
+	FLAC__StreamDecoderWriteStatus Write() noexcept {
+		FLAC__Frame frame{};
+		frame.header.blocksize = BLOCK_SIZE;
+		frame.header.sample_rate = 44100;
+		frame.header.channels = 2;
+		frame.header.bits_per_sample = 16;
+
+		std::vector<FLAC__int32> left(BLOCK_SIZE), right(BLOCK_SIZE);
+		for (unsigned i = 0; i < BLOCK_SIZE; ++i) {
+			left[i] = counter + i;
+			right[i] = -FLAC__int32(counter + i);
+		}
+
+		counter += BLOCK_SIZE;
+
+		const FLAC__int32 *const buf[] = {left.data(), right.data()};
+		return decoder.OnWrite(frame, buf, 4096);
+	}
+
+	/**
+	 * Submit the data which the write callback could not write
+	 * directly, just like the decoder loop does.
+	 */
+	void SubmitChunk() noexcept {
+		if (!decoder.chunk.empty()) {
+			client.SubmitAudio(nullptr, decoder.chunk, 0);
+			decoder.chunk = {};
+		}
+	}
+
+	/**
+	 * Check the decoder output.
+	 *
+	 * @return the number of frames
+	 */
+	std::size_t CheckOutput() const noexcept {
+		EXPECT_EQ(client.output.size() % FRAME_SIZE, 0U);
+
+		const std::size_t n = client.output.size() / FRAME_SIZE;
+		for (std::size_t i = 0; i < n; ++i) {
+			int16_t frame[2];
+			std::memcpy(frame, client.output.data() + i * FRAME_SIZE,
+				    FRAME_SIZE);
+			EXPECT_EQ(frame[0], int16_t(i));
+			EXPECT_EQ(frame[1], int16_t(-int16_t(i)));
+		}
+
+		return n;
+	}
+};
+
+TEST_F(FlacDecoderTest, Direct)
+{
+	ASSERT_EQ(Write(), FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE);
+	ASSERT_EQ(Write(), FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE);
+
+	EXPECT_TRUE(decoder.chunk.empty());
+	EXPECT_EQ(client.direct_bytes, 2 * BLOCK_SIZE * FRAME_SIZE);
+	EXPECT_EQ(CheckOutput(), 2 * BLOCK_SIZE);
+}
+
+/**
+ * The buffer returned by GetAudioBuffer() is smaller than a FLAC
+ * frame, so each frame is split across several buffers.
+ */
+TEST_F(FlacDecoderTest, FrameSplit)
+{
+	client.max_buffer_size = 300 * FRAME_SIZE;
+
+	ASSERT_EQ(Write(), FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE);
+	ASSERT_EQ(Write(), FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE);
+
+	EXPECT_TRUE(decoder.chunk.empty());
+	EXPECT_EQ(client.direct_bytes, 2 * BLOCK_SIZE * FRAME_SIZE);
+	EXPECT_EQ(CheckOutput(), 2 * BLOCK_SIZE);
+}
+
+/**
+ * No buffer is available: the whole frame is imported into the
+ * decoder's own buffer and submitted by the decoder loop.
+ */
+TEST_F(FlacDecoderTest, Fallback)
+{
+	client.max_buffer_size = 0;
+
+	ASSERT_EQ(Write(), FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE);
+	SubmitChunk();
+	ASSERT_EQ(Write(), FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE);
+	SubmitChunk();
+
+	EXPECT_EQ(client.direct_bytes, 0U);
+	EXPECT_EQ(CheckOutput(), 2 * BLOCK_SIZE);
+}
+
+/**
+ * A command which arrives in the middle of a frame: the rest of the
+ * frame is discarded, and the command is left for the decoder loop.
+ */
+TEST_F(FlacDecoderTest, CommandInFrame)
+{
+	client.max_buffer_size = 300 * FRAME_SIZE;
+	client.command_after = 1;
+	client.pending_command = DecoderCommand::SEEK;
+
+	ASSERT_EQ(Write(), FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE);
+
+	EXPECT_EQ(decoder.command, DecoderCommand::SEEK);
+	EXPECT_TRUE(decoder.chunk.empty());
+	EXPECT_EQ(CheckOutput(), 300U);
+}
@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "db/update/InotifyUpdate.hxx"
+#include "db/update/InotifyListener.hxx"
+#include "db/plugins/simple/Directory.hxx"
+#include "db/DatabaseLock.hxx"
+#include "event/CoarseTimerEvent.hxx"
+#include "event/FineTimerEvent.hxx"
+#include "event/Loop.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "fs/FileInfo.hxx"
+
+#include <fmt/core.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class InotifyUpdateTest : public ::testing::Test, protected InotifyListener {
+protected:
+	const AllocatedPath music_path =
+		AllocatedPath::FromFS(fmt::format("{}mpd_inotify_{}",
+						  ::testing::TempDir(),
+						  getpid()));
+
+	EventLoop event_loop;
+
+	/**
+	 * Makes the test fail instead of hanging if the expected
+	 * calls never arrive.
+	 */
+	CoarseTimerEvent timeout_event{event_loop, BIND_THIS_METHOD(OnTimeout)};
+
+	FineTimerEvent unlock_event{event_loop, BIND_THIS_METHOD(OnUnlock)};
+
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	std::vector<std::string> modified;
+
+	/**
+	 * The value of #modified at the time the database lock was
+	 * released by OnUnlock().
+	 */
+	std::vector<std::string> modified_while_locked;
+
+	bool timed_out = false;
+
+	void SetUp() override {
+		ASSERT_EQ(mkdir(music_path.c_str(), 0700), 0);
+
+		for (const char *name : {"a", "b", "b/c", "new"})
+			ASSERT_EQ(mkdir(GetPath(name).c_str(), 0700), 0);
+
+		const int fd = open(GetPath("x").c_str(), O_CREAT|O_WRONLY, 0600);
+		ASSERT_GE(fd, 0);
+		close(fd);
+
+		/* "new" is not in the database, all others are
+		   up to date */
+		const ScopeDatabaseLock protect;
+		root->mtime = GetMtime("");
+		for (const char *name : {"a", "b"}) {
+			auto *directory = root->CreateChild(name);
+			directory->mtime = GetMtime(name);
+		}
+
+		root->FindChild("b")->CreateChild("c")->mtime = GetMtime("b/c");
+	}
+
+	void TearDown() override {
+		unlink(GetPath("x").c_str());
+
+		for (const char *name : {"new", "b/c", "b", "a"})
+			rmdir(GetPath(name).c_str());
+
+		rmdir(music_path.c_str());
+
+		const ScopeDatabaseLock protect;
+		root.reset();
+	}
+
+	AllocatedPath GetPath(const char *name) const noexcept {
+		return music_path / Path::FromFS(name);
+	}
+
+	std::chrono::system_clock::time_point GetMtime(const char *name) const {
+		return FileInfo{*name == 0 ? music_path : GetPath(name)}.GetModificationTime();
+	}
+
+	void Run(InotifyUpdate &update) noexcept {
+		timeout_event.Schedule(std::chrono::seconds(10));
+		update.Start(music_path);
+		event_loop.Run();
+	}
+
+	void OnTimeout() noexcept {
+		timed_out = true;
+		event_loop.Break();
+	}
+
+	void OnUnlock() noexcept {
+		modified_while_locked = modified;
+		db_unlock();
+	}
+
+	/* virtual methods from class InotifyListener */
+	void OnInotifyModified(const char *uri_utf8) noexcept override {
+		modified.emplace_back(uri_utf8);
+		event_loop.Break();
+	}
+};
+
+/**
+ * The initial scan compares the directory modification times with
+ * the database and reports the directories which were modified while
+ * MPD was not running.
+ */
+TEST_F(InotifyUpdateTest, StartupRescan)
+{
+	{
+		const ScopeDatabaseLock protect;
+		root->FindChild("b")->mtime -= std::chrono::seconds(1);
+		root->LookupDirectory("b/c").directory->mtime -= std::chrono::seconds(1);
+	}
+
+	InotifyUpdate update(event_loop, *this, 16, root.get());
+	Run(update);
+
+	EXPECT_FALSE(timed_out);
+
+	/* "b/c" is not reported because "b" gets updated with its
+	   whole subtree; "new" is not in the database, but its
+	   parent is up to date */
+	EXPECT_EQ(modified, std::vector<std::string>{"b"});
+}
+
+TEST_F(InotifyUpdateTest, NotModified)
+{
+	/* nothing is reported, therefore the loop only quits after
+	   the timeout; shorten it */
+	timeout_event.Schedule(std::chrono::milliseconds(500));
+
+	InotifyUpdate update(event_loop, *this, 16, root.get());
+	update.Start(music_path);
+	event_loop.Run();
+
+	EXPECT_TRUE(modified.empty());
+}
+
+/**
+ * Events which arrive while the initial scan is running are
+ * postponed and handled after the scan has finished.
+ */
+TEST_F(InotifyUpdateTest, PendingEvents)
+{
+	/* this blocks the scan thread in its first CheckModified()
+	   call, after the watch on the music directory has been
+	   registered */
+	db_lock();
+
+	InotifyUpdate update(event_loop, *this, 16, root.get());
+	timeout_event.Schedule(std::chrono::seconds(10));
+	update.Start(music_path);
+
+	/* this generates IN_CLOSE_WRITE on the music directory
+	   without modifying it */
+	const int fd = open(GetPath("x").c_str(), O_WRONLY);
+	ASSERT_GE(fd, 0);
+	close(fd);
+
+	/* let the EventLoop receive the events before the scan may
+	   continue */
+	unlock_event.Schedule(std::chrono::milliseconds(100));
+	event_loop.Run();
+
+	EXPECT_FALSE(timed_out);
+	EXPECT_TRUE(modified_while_locked.empty());
+	EXPECT_EQ(modified, std::vector<std::string>{""});
+}
@@ -0,0 +1,304 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * Unit and stress tests for the lock-free #MusicPipe and
+ * #MusicBuffer.  The stress tests are most useful with
+ * ThreadSanitizer (meson -Db_sanitize=thread).
+ */
+
+#include "MusicPipe.hxx"
+#include "MusicBuffer.hxx"
+#include "MusicChunk.hxx"
+#include "pcm/AudioFormat.hxx"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static constexpr AudioFormat audio_format{44100, SampleFormat::S16, 2};
+
+static MusicChunkPtr
+MakeChunk(MusicBuffer &buffer, uint32_t value) noexcept
+{
+	MusicChunkPtr chunk;
+	while ((chunk = buffer.Allocate()) == nullptr)
+		/* the buffer is full; wait for the consumer */
+		std::this_thread::yield();
+
+	auto w = chunk->Write(audio_format, SongTime::zero(), 0);
+	std::memcpy(w.data(), &value, sizeof(value));
+	chunk->Expand(audio_format, sizeof(value));
+	return chunk;
+}
+
+static uint32_t
+GetValue(const MusicChunk &chunk) noexcept
+{
+	uint32_t value;
+	assert(chunk.length >= sizeof(value));
+	std::memcpy(&value, chunk.GetData().data(), sizeof(value));
+	return value;
+}
+
+TEST(MusicPipe, Basic)
+{
+	MusicBuffer buffer(8);
+	MusicPipe pipe;
+
+	EXPECT_TRUE(pipe.IsEmpty());
+	EXPECT_EQ(pipe.Peek(), nullptr);
+	EXPECT_EQ(pipe.Shift(), nullptr);
+
+	for (uint32_t i = 0; i < 8; ++i)
+		pipe.Push(MakeChunk(buffer, i));
+
+	EXPECT_TRUE(buffer.IsFull());
+	EXPECT_EQ(buffer.Allocate(), nullptr);
+	EXPECT_EQ(pipe.GetSize(), 8U);
+
+	/* walk the list like an output does */
+	uint32_t expected = 0;
+	for (const auto *i = pipe.Peek(); i != nullptr; i = i->GetNext())
+		EXPECT_EQ(GetValue(*i), expected++);
+	EXPECT_EQ(expected, 8U);
+
+	for (uint32_t i = 0; i < 5; ++i) {
+		auto chunk = pipe.Shift();
+		ASSERT_NE(chunk, nullptr);
+		EXPECT_EQ(GetValue(*chunk), i);
+		EXPECT_EQ(chunk->GetNext(), nullptr);
+	}
+
+	EXPECT_EQ(pipe.GetSize(), 3U);
+	EXPECT_FALSE(buffer.IsFull());
+
+	/* refill after the tail has been reset */
+	pipe.Clear();
+	EXPECT_TRUE(pipe.IsEmpty());
+	EXPECT_EQ(pipe.Peek(), nullptr);
+
+	pipe.Push(MakeChunk(buffer, 42));
+	EXPECT_EQ(pipe.GetSize(), 1U);
+	EXPECT_EQ(GetValue(*pipe.Peek()), 42U);
+	EXPECT_EQ(GetValue(*pipe.Shift()), 42U);
+	EXPECT_TRUE(pipe.IsEmpty());
+
+	pipe.Push(MakeChunk(buffer, 43));
+	pipe.Push(MakeChunk(buffer, 44));
+	EXPECT_EQ(GetValue(*pipe.Shift()), 43U);
+	EXPECT_EQ(GetValue(*pipe.Shift()), 44U);
+	EXPECT_EQ(pipe.Shift(), nullptr);
+}
+
+/**
+ * One thread pushes, another one shifts; the buffer is small, so
+ * the producer often runs into a full buffer and the consumer often
+ * finds an empty pipe.
+ */
+TEST(MusicPipe, ProducerConsumer)
+{
+	constexpr uint32_t N = 200000;
+
+	MusicBuffer buffer(4);
+	MusicPipe pipe;
+
+	std::thread producer([&buffer, &pipe]{
+		for (uint32_t i = 0; i < N; ++i)
+			pipe.Push(MakeChunk(buffer, i));
+	});
+
+	for (uint32_t i = 0; i < N;) {
+		auto chunk = pipe.Shift();
+		if (chunk == nullptr) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		ASSERT_EQ(GetValue(*chunk), i);
+		++i;
+	}
+
+	producer.join();
+
+	EXPECT_TRUE(pipe.IsEmpty());
+	EXPECT_EQ(pipe.Shift(), nullptr);
+	EXPECT_TRUE(buffer.IsEmpty());
+}
+
+/**
+ * Like #AudioOutputSource, several reader threads follow the chunk
+ * list while the producer appends to it; the consumer removes only
+ * chunks which all readers have passed.
+ */
+TEST(MusicPipe, Readers)
+{
+	constexpr uint32_t N = 50000;
+	constexpr unsigned N_READERS = 3;
+
+	MusicBuffer buffer(16);
+	MusicPipe pipe;
+
+	/* the value of the chunk each reader is currently looking
+	   at plus one */
+	std::atomic<uint32_t> positions[N_READERS]{};
+
+	std::vector<std::thread> readers;
+	for (auto &position : positions) {
+		readers.emplace_back([&pipe, &position]{
+			const MusicChunk *chunk = nullptr;
+			while (true) {
+				const MusicChunk *next = chunk == nullptr
+					? pipe.Peek()
+					: chunk->GetNext();
+				if (next == nullptr) {
+					std::this_thread::yield();
+					continue;
+				}
+
+				const uint32_t value = GetValue(*next);
+				ASSERT_EQ(value, chunk == nullptr
+					  ? 0U
+					  : GetValue(*chunk) + 1);
+
+				chunk = next;
+				position.store(value + 1,
+					       std::memory_order_release);
+
+				if (value == N - 1)
+					break;
+			}
+		});
+	}
+
+	std::thread producer([&buffer, &pipe]{
+		for (uint32_t i = 0; i < N; ++i)
+			pipe.Push(MakeChunk(buffer, i));
+	});
+
+	/* the consumer: remove all chunks the readers are done
+	   with */
+	for (uint32_t shifted = 0; shifted < N - 1;) {
+		uint32_t min = N;
+		for (const auto &position : positions)
+			min = std::min(min,
+				       position.load(std::memory_order_acquire));
+
+		/* each reader still holds a pointer to chunk
+		   "position-1" */
+		if (min <= shifted + 1) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		auto chunk = pipe.Shift();
+		ASSERT_NE(chunk, nullptr);
+		ASSERT_EQ(GetValue(*chunk), shifted);
+		++shifted;
+	}
+
+	producer.join();
+	for (auto &i : readers)
+		i.join();
+
+	EXPECT_EQ(pipe.GetSize(), 1U);
+	pipe.Clear();
+	EXPECT_TRUE(buffer.IsEmpty());
+}
+
+/**
+ * Several threads allocate and free chunks concurrently, often
+ * draining the buffer completely (which discards its memory).
+ */
+TEST(MusicBuffer, Concurrent)
+{
+	constexpr unsigned N_THREADS = 4;
+	constexpr unsigned N = 20000;
+
+	MusicBuffer buffer(8);
+
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t < N_THREADS; ++t) {
+		threads.emplace_back([&buffer, t]{
+			MusicChunkPtr chunks[3];
+
+			for (unsigned i = 0; i < N; ++i) {
+				auto &chunk = chunks[i % std::size(chunks)];
+				chunk.reset();
+
+				chunk = buffer.Allocate();
+				if (chunk == nullptr)
+					continue;
+
+				/* nobody else may use this chunk */
+				const uint32_t value = (t << 24) | i;
+				auto w = chunk->Write(audio_format,
+						      SongTime::zero(), 0);
+				std::memcpy(w.data(), &value, sizeof(value));
+				chunk->Expand(audio_format, sizeof(value));
+				std::this_thread::yield();
+				ASSERT_EQ(GetValue(*chunk), value);
+			}
+		});
+	}
+
+	for (auto &i : threads)
+		i.join();
+
+	EXPECT_TRUE(buffer.IsEmpty());
+}
+
+/**
+ * Chunks larger than the default are filled according to the audio
+ * format.
+ */
+TEST(MusicBuffer, ChunkSize)
+{
+	MusicBuffer buffer(4, 64 * 1024);
+	EXPECT_EQ(buffer.GetChunkCapacity(), 64 * 1024 - sizeof(MusicChunk));
+
+	/* low-rate formats fill no more than a default chunk */
+	const std::size_t default_size =
+		DEFAULT_CHUNK_SIZE - sizeof(MusicChunk);
+	EXPECT_EQ(buffer.GetChunkFillSize(audio_format), default_size);
+
+	/* 20 ms of 192 kHz 32 bit stereo */
+	constexpr AudioFormat hires{192000, SampleFormat::S32, 2};
+	EXPECT_EQ(buffer.GetChunkFillSize(hires), 3840U * 8);
+
+	/* this one is limited by the chunk capacity */
+	constexpr AudioFormat big{384000, SampleFormat::FLOAT, 8};
+	EXPECT_EQ(buffer.GetChunkFillSize(big), buffer.GetChunkCapacity());
+
+	for (const auto af : {audio_format, hires, big}) {
+		auto chunk = buffer.Allocate();
+		ASSERT_NE(chunk, nullptr);
+
+		std::size_t total = 0;
+		while (true) {
+			auto w = chunk->Write(af, SongTime::zero(), 0);
+			if (w.empty())
+				break;
+
+			/* write in small pieces, like a decoder */
+			const std::size_t n =
+				std::min<std::size_t>(w.size(),
+						      af.GetFrameSize() * 100);
+			std::memset(w.data(), 0, n);
+			total += n;
+
+			if (chunk->Expand(af, n))
+				break;
+		}
+
+		EXPECT_EQ(chunk->GetData().size(), total);
+		EXPECT_LE(total, buffer.GetChunkFillSize(af));
+		EXPECT_GT(total + af.GetFrameSize(),
+			  buffer.GetChunkFillSize(af));
+		EXPECT_EQ(total % af.GetFrameSize(), 0U);
+	}
+}
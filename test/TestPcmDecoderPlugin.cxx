@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * Unit tests for the "pcm" decoder plugin writing into the buffer
+ * provided by DecoderClient::GetAudioBuffer().
+ */
+
+#include "FakeDecoderClient.hxx"
+#include "decoder/plugins/PcmDecoderPlugin.hxx"
+#include "decoder/DecoderPlugin.hxx"
+#include "input/InputStream.hxx"
+#include "thread/Mutex.hxx"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * The number of frames in the test stream.
+ */
+static constexpr unsigned N_FRAMES = 1000;
+
+/**
+ * "audio/x-mpd-cdda-pcm" is 16 bit stereo in host byte order.
+ */
+static constexpr std::size_t FRAME_SIZE = 4;
+
+/**
+ * A seekable stream of 16 bit stereo frames which contain their own
+ * index in both channels.
+ */
+class FrameInputStream final : public InputStream {
+	std::vector<std::byte> data;
+
+public:
+	explicit FrameInputStream(Mutex &_mutex)
+		:InputStream("test.raw", _mutex),
+		 data(N_FRAMES * FRAME_SIZE) {
+		for (unsigned i = 0; i < N_FRAMES; ++i) {
+			const uint16_t frame[2] = {uint16_t(i), uint16_t(i)};
+			std::memcpy(data.data() + i * FRAME_SIZE, frame, FRAME_SIZE);
+		}
+
+		SetMimeType("audio/x-mpd-cdda-pcm");
+		seekable = true;
+		size = data.size();
+		SetReady();
+	}
+
+	/* virtual methods from InputStream */
+	void Seek(std::unique_lock<Mutex> &, offset_type new_offset) override {
+		offset = new_offset;
+	}
+
+	bool IsEOF() const noexcept override {
+		return offset >= data.size();
+	}
+
+	size_t Read(std::unique_lock<Mutex> &,
+		    void *ptr, size_t read_size) override {
+		const size_t nbytes = std::min<size_t>(data.size() - offset,
+						       read_size);
+		std::memcpy(ptr, data.data() + offset, nbytes);
+		offset += nbytes;
+		return nbytes;
+	}
+};
+
+/**
+ * Convert the decoder output back to frame indexes.
+ */
+static std::vector<unsigned>
+ToFrames(const std::vector<std::byte> &output)
+{
+	EXPECT_EQ(output.size() % FRAME_SIZE, 0U);
+
+	std::vector<unsigned> frames;
+	for (std::size_t i = 0; i + FRAME_SIZE <= output.size(); i += FRAME_SIZE) {
+		uint16_t frame[2];
+		std::memcpy(frame, output.data() + i, FRAME_SIZE);
+		EXPECT_EQ(frame[0], frame[1]);
+		frames.push_back(frame[0]);
+	}
+
+	return frames;
+}
+
+static std::vector<unsigned>
+Range(unsigned begin, unsigned end)
+{
+	std::vector<unsigned> result;
+	for (unsigned i = begin; i < end; ++i)
+		result.push_back(i);
+	return result;
+}
+
+class PcmDecoderPluginTest : public ::testing::Test {
+protected:
+	Mutex mutex;
+	FrameInputStream is{mutex};
+	FakeDecoderClient client;
+
+	void Decode() {
+		pcm_decoder_plugin.StreamDecode(client, is);
+		EXPECT_EQ(client.calls_after_stop, 0U);
+	}
+};
+
+TEST_F(PcmDecoderPluginTest, Direct)
+{
+	Decode();
+
+	EXPECT_EQ(client.direct_bytes, N_FRAMES * FRAME_SIZE);
+	EXPECT_EQ(ToFrames(client.output), Range(0, N_FRAMES));
+}
+
+/**
+ * Reads which end in the middle of a frame: the partial frame is
+ * kept and completed by the next read, nothing is lost or
+ * duplicated.
+ */
+TEST_F(PcmDecoderPluginTest, PartialFrame)
+{
+	client.max_read_size = 7;
+
+	Decode();
+
+	EXPECT_GT(client.direct_bytes, 0U);
+	EXPECT_LT(client.direct_bytes, N_FRAMES * FRAME_SIZE);
+	EXPECT_EQ(ToFrames(client.output), Range(0, N_FRAMES));
+}
+
+/**
+ * A SEEK command which arrives between GetAudioBuffer() and
+ * SubmitAudioBuffer(): the data written before is kept, and
+ * decoding continues at the new position.
+ */
+TEST_F(PcmDecoderPluginTest, SeekBetweenGetAndSubmit)
+{
+	client.max_buffer_size = 100 * FRAME_SIZE;
+	client.command_after = 200 * FRAME_SIZE;
+	client.pending_command = DecoderCommand::SEEK;
+	client.seek_frame = 700;
+
+	Decode();
+
+	auto expected = Range(0, 200);
+	const auto tail = Range(700, N_FRAMES);
+	expected.insert(expected.end(), tail.begin(), tail.end());
+	EXPECT_EQ(ToFrames(client.output), expected);
+}
+
+/**
+ * The same with a partial frame in the decoder's own buffer when the
+ * SEEK arrives; it must be discarded.
+ */
+TEST_F(PcmDecoderPluginTest, SeekWithPartialFrame)
+{
+	client.max_buffer_size = 100 * FRAME_SIZE;
+	client.max_read_size = 100 * FRAME_SIZE - 1;
+	client.command_after = 1;
+	client.pending_command = DecoderCommand::SEEK;
+	client.seek_frame = 700;
+
+	Decode();
+
+	auto expected = Range(0, 99);
+	const auto tail = Range(700, N_FRAMES);
+	expected.insert(expected.end(), tail.begin(), tail.end());
+	EXPECT_EQ(ToFrames(client.output), expected);
+}
+
+TEST_F(PcmDecoderPluginTest, StopBetweenGetAndSubmit)
+{
+	client.max_buffer_size = 100 * FRAME_SIZE;
+	client.command_after = 200 * FRAME_SIZE;
+	client.pending_command = DecoderCommand::STOP;
+
+	Decode();
+
+	EXPECT_EQ(ToFrames(client.output), Range(0, 200));
+}
@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "queue/Queue.hxx"
+#include "queue/Journal.hxx"
+#include "song/DetachedSong.hxx"
+#include "song/LightSong.hxx"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+Tag::Tag(const Tag &) noexcept {}
+void Tag::Clear() noexcept {}
+
+DetachedSong::operator LightSong() const noexcept
+{
+	return {uri.c_str(), tag};
+}
+
+static std::vector<unsigned>
+NewerPositions(const Queue &queue, uint32_t version)
+{
+	std::vector<unsigned> result;
+	queue.ForEachNewerPosition(version, 0, queue.GetLength(),
+				   [&result](unsigned i){
+					   result.push_back(i);
+				   });
+	return result;
+}
+
+static std::vector<unsigned>
+NewerPositionsScan(const Queue &queue, uint32_t version)
+{
+	std::vector<unsigned> result;
+	for (unsigned i = 0; i < queue.GetLength(); ++i)
+		if (queue.IsNewerAtPosition(i, version))
+			result.push_back(i);
+	return result;
+}
+
+static void
+CheckAllVersions(const Queue &queue)
+{
+	for (uint32_t version = 0; version <= queue.version + 1; ++version)
+		ASSERT_EQ(NewerPositions(queue, version),
+			  NewerPositionsScan(queue, version))
+			<< "version=" << version;
+}
+
+static void
+Append(Queue &queue, unsigned n)
+{
+	for (unsigned i = 0; i < n; ++i)
+		queue.Append(DetachedSong(std::to_string(i) + ".ogg"), 0);
+	queue.IncrementVersion();
+}
+
+TEST(QueueJournal, Operations)
+{
+	Queue queue(1024);
+	Append(queue, 200);
+	CheckAllVersions(queue);
+
+	std::mt19937 rng;
+
+	for (unsigned n = 0; n < 300; ++n) {
+		const unsigned length = queue.GetLength();
+		std::uniform_int_distribution<unsigned> dist(0, length - 1);
+
+		switch (n % 7) {
+		case 0:
+			queue.ModifyAtPosition(dist(rng));
+			break;
+
+		case 1:
+			queue.MovePostion(dist(rng), dist(rng));
+			break;
+
+		case 2: {
+			unsigned start = dist(rng), end = dist(rng);
+			if (start > end)
+				std::swap(start, end);
+			std::uniform_int_distribution<unsigned> to(0, length - (end - start));
+			queue.MoveRange(start, end, to(rng));
+			break;
+		}
+
+		case 3:
+			queue.DeletePosition(dist(rng));
+			break;
+
+		case 4:
+			queue.SwapPositions(dist(rng), dist(rng));
+			break;
+
+		case 5: {
+			unsigned start = dist(rng);
+			queue.ShuffleRange(start, std::min(start + 10, length));
+			break;
+		}
+
+		case 6:
+			queue.SetPriority(dist(rng), n % 256, -1);
+			queue.Append(DetachedSong("new.ogg"), 0);
+			break;
+		}
+
+		queue.IncrementVersion();
+	}
+
+	CheckAllVersions(queue);
+}
+
+TEST(QueueJournal, Overrun)
+{
+	Queue queue(4096);
+	Append(queue, 4096);
+
+	/* more single-position modifications than the journal can
+	   hold; old versions must fall back to a full scan */
+	for (unsigned i = 0; i < 3000; ++i) {
+		queue.ModifyAtPosition((i * 7919) % 4096);
+		queue.IncrementVersion();
+	}
+
+	CheckAllVersions(queue);
+
+	queue.Clear();
+	Append(queue, 10);
+	CheckAllVersions(queue);
+}
+
+/**
+ * An invalidated journal stays unusable even after it has wrapped
+ * around, until Clear() is called.
+ */
+TEST(QueueJournal, InvalidateWrap)
+{
+	QueueJournal journal;
+	journal.Invalidate();
+
+	for (unsigned i = 0; i < 3000; ++i)
+		journal.Add(i, i % 100);
+
+	std::vector<QueueJournal::Range> ranges;
+	EXPECT_FALSE(journal.Collect(2999, ranges));
+
+	journal.Clear();
+	journal.Add(5, 42);
+	EXPECT_TRUE(journal.Collect(5, ranges));
+	ASSERT_EQ(ranges.size(), 1U);
+	EXPECT_EQ(ranges.front().start, 42U);
+}
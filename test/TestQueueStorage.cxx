@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "queue/Queue.hxx"
+#include "song/DetachedSong.hxx"
+#include "song/LightSong.hxx"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+Tag::Tag(const Tag &) noexcept {}
+void Tag::Clear() noexcept {}
+
+DetachedSong::operator LightSong() const noexcept
+{
+	return {uri.c_str(), tag};
+}
+
+static void
+CheckIds(const Queue &queue)
+{
+	for (unsigned i = 0; i < queue.GetLength(); ++i)
+		ASSERT_EQ(queue.IdToPosition(queue.PositionToId(i)), int(i));
+}
+
+TEST(QueueStorage, Grow)
+{
+	Queue queue(100000);
+	const std::size_t initial_size = queue.GetMemorySize();
+
+	for (unsigned i = 0; i < 50000; ++i) {
+		ASSERT_FALSE(queue.IsFull());
+		queue.Append(DetachedSong(std::to_string(i) + ".ogg"), 0);
+	}
+
+	EXPECT_EQ(queue.GetLength(), 50000U);
+	EXPECT_GT(queue.GetMemorySize(), initial_size);
+	EXPECT_STREQ(queue.Get(12345).GetURI(), "12345.ogg");
+	CheckIds(queue);
+
+	for (unsigned i = 0; i < 1000; ++i)
+		queue.DeletePosition(i * 7);
+
+	queue.MoveRange(100, 200, 40000);
+	CheckIds(queue);
+
+	const int first_id = queue.PositionToId(0);
+	const std::size_t full_size = queue.GetMemorySize();
+
+	queue.Clear();
+	EXPECT_LT(queue.GetMemorySize(), full_size / 2);
+
+	/* ids are not reused right after clearing the queue */
+	const unsigned id = queue.Append(DetachedSong("new.ogg"), 0);
+	EXPECT_NE(int(id), first_id);
+	EXPECT_EQ(queue.IdToPosition(id), 0);
+	EXPECT_EQ(queue.IdToPosition(first_id), -1);
+}
+
+TEST(QueueStorage, Full)
+{
+	Queue queue(100);
+
+	for (unsigned i = 0; i < 100; ++i)
+		queue.Append(DetachedSong(std::to_string(i) + ".ogg"), 0);
+
+	EXPECT_TRUE(queue.IsFull());
+	CheckIds(queue);
+
+	/* recycle ids many times */
+	for (unsigned i = 0; i < 5000; ++i) {
+		queue.DeletePosition(i % 100);
+		queue.Append(DetachedSong(std::to_string(i) + ".ogg"), 0);
+	}
+
+	CheckIds(queue);
+}
+
+TEST(QueueStorage, Reserve)
+{
+	Queue queue(1000);
+	queue.Append(DetachedSong("first.ogg"), 0);
+
+	queue.Reserve(500);
+	const unsigned reserved_capacity = queue.capacity;
+	EXPECT_GE(reserved_capacity, 501U);
+
+	for (unsigned i = 0; i < 500; ++i)
+		queue.Append(DetachedSong(std::to_string(i) + ".ogg"), 0);
+
+	/* no reallocation while appending */
+	EXPECT_EQ(queue.capacity, reserved_capacity);
+	CheckIds(queue);
+
+	/* reserving more than the maximum is clamped */
+	queue.Reserve(100000);
+	for (unsigned i = 0; !queue.IsFull(); ++i)
+		queue.Append(DetachedSong(std::to_string(i) + ".ogg"), 0);
+	EXPECT_EQ(queue.GetLength(), 1000U);
+	CheckIds(queue);
+}
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "client/ResponseCache.hxx"
+
+#include <gtest/gtest.h>
+
+#include <array>
+
+static std::string
+MakeKey(const char *command, auto... args)
+{
+	const std::array<std::string_view, sizeof...(args)> a{args...};
+	return ResponseCache::MakeKey(command, a);
+}
+
+TEST(ResponseCache, Basic)
+{
+	ResponseCache cache(64 * 1024);
+
+	EXPECT_EQ(cache.Get(MakeKey("list", "album")), nullptr);
+	EXPECT_EQ(cache.GetMisses(), 1U);
+
+	cache.Put(cache.GetGeneration(), MakeKey("list", "album"), "Album: a\n");
+	cache.Put(cache.GetGeneration(), MakeKey("list", "albumartist"), "AlbumArtist: b\n");
+
+	const auto *value = cache.Get(MakeKey("list", "album"));
+	ASSERT_NE(value, nullptr);
+	EXPECT_EQ(*value, "Album: a\n");
+
+	value = cache.Get(MakeKey("list", "albumartist"));
+	ASSERT_NE(value, nullptr);
+	EXPECT_EQ(*value, "AlbumArtist: b\n");
+
+	/* the argument boundaries are part of the key */
+	EXPECT_EQ(cache.Get(MakeKey("list", "al", "bum")), nullptr);
+	EXPECT_EQ(cache.Get(MakeKey("listalbum")), nullptr);
+
+	EXPECT_EQ(cache.GetHits(), 2U);
+	EXPECT_EQ(cache.GetMisses(), 3U);
+
+	cache.Clear();
+	EXPECT_EQ(cache.Get(MakeKey("list", "album")), nullptr);
+}
+
+/**
+ * A response which was generated before Clear() must not be added.
+ */
+TEST(ResponseCache, Generation)
+{
+	ResponseCache cache(64 * 1024);
+
+	const unsigned generation = cache.GetGeneration();
+	cache.Clear();
+	cache.Put(generation, MakeKey("count"), "songs: 1\n");
+	EXPECT_EQ(cache.Get(MakeKey("count")), nullptr);
+
+	cache.Put(cache.GetGeneration(), MakeKey("count"), "songs: 2\n");
+	ASSERT_NE(cache.Get(MakeKey("count")), nullptr);
+	EXPECT_EQ(*cache.Get(MakeKey("count")), "songs: 2\n");
+
+	/* replace an existing item */
+	cache.Put(cache.GetGeneration(), MakeKey("count"), "songs: 3\n");
+	ASSERT_NE(cache.Get(MakeKey("count")), nullptr);
+	EXPECT_EQ(*cache.Get(MakeKey("count")), "songs: 3\n");
+}
+
+TEST(ResponseCache, Evict)
+{
+	ResponseCache cache(16 * 1024);
+
+	const std::string value(1024, 'x');
+	for (unsigned i = 0; i < 32; ++i)
+		cache.Put(cache.GetGeneration(),
+			  MakeKey("list", std::to_string(i).c_str()), value);
+
+	/* the oldest items have been evicted */
+	EXPECT_EQ(cache.Get(MakeKey("list", "0")), nullptr);
+	EXPECT_NE(cache.Get(MakeKey("list", "31")), nullptr);
+
+	/* refresh "20", then add more items */
+	EXPECT_NE(cache.Get(MakeKey("list", "20")), nullptr);
+	for (unsigned i = 32; i < 40; ++i)
+		cache.Put(cache.GetGeneration(),
+			  MakeKey("list", std::to_string(i).c_str()), value);
+
+	EXPECT_NE(cache.Get(MakeKey("list", "20")), nullptr);
+	EXPECT_EQ(cache.Get(MakeKey("list", "21")), nullptr);
+
+	/* too large to be cached */
+	cache.Put(cache.GetGeneration(), MakeKey("huge"),
+		  std::string(8 * 1024, 'x'));
+	EXPECT_EQ(cache.Get(MakeKey("huge")), nullptr);
+}
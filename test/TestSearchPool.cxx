@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "MakeTag.hxx"
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/SearchPool.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "song/Filter.hxx"
+#include "song/LightSong.hxx"
+
+#include <fmt/core.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class SearchPoolTest : public ::testing::Test {
+protected:
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	SongFilter filter;
+
+	void SetUp() override {
+		const ScopeDatabaseLock protect;
+
+		/* enough songs for many shards, distributed unevenly
+		   over nested directories */
+		for (unsigned i = 0; i < 40; ++i) {
+			auto *artist = root->CreateChild(fmt::format("Artist {}", i));
+			AddSongs(*artist, i, 3);
+
+			for (unsigned j = 0; j < i % 5; ++j) {
+				auto *album = artist->CreateChild(fmt::format("Album {}", j));
+				AddSongs(*album, i * 10 + j, 100 * (i % 7) + 1);
+			}
+		}
+
+		const char *const args[] = {"(title contains \"7\")"};
+		filter.Parse(args, true);
+		filter.Optimize();
+	}
+
+	static void AddSongs(Directory &directory, unsigned seed, unsigned n) {
+		for (unsigned k = 0; k < n; ++k) {
+			auto song = Song::New(fmt::format("{}.flac", k),
+					      directory);
+			song->tag = MakeTag(TAG_TITLE,
+					    fmt::format("Title {}", seed * 1000 + k).c_str());
+			song->in_playlist = (seed + k) % 13 == 0;
+			directory.AddSong(std::move(song));
+		}
+	}
+
+	std::vector<std::string> Walk(bool hide_playlist_targets) {
+		std::vector<std::string> result;
+		root->Walk(true, &filter, hide_playlist_targets, {},
+			   [&result](const LightSong &song){
+				   result.emplace_back(song.GetURI());
+			   },
+			   {});
+		return result;
+	}
+
+	std::vector<std::string> Walk(SearchPool &pool,
+				      bool hide_playlist_targets) {
+		std::vector<std::string> result;
+		pool.Walk(*root, filter, hide_playlist_targets,
+			  [&result](const LightSong &song){
+				  result.emplace_back(song.GetURI());
+			  });
+		return result;
+	}
+};
+
+TEST_F(SearchPoolTest, SameOrder)
+{
+	SearchPool pool(4);
+
+	const ScopeDatabaseLock protect;
+
+	const auto expected = Walk(false);
+	EXPECT_GT(expected.size(), 1000U);
+	EXPECT_EQ(Walk(pool, false), expected);
+
+	const auto expected_hidden = Walk(true);
+	EXPECT_LT(expected_hidden.size(), expected.size());
+	EXPECT_EQ(Walk(pool, true), expected_hidden);
+}
+
+TEST_F(SearchPoolTest, VisitorThrows)
+{
+	SearchPool pool(4);
+
+	const ScopeDatabaseLock protect;
+
+	unsigned n = 0;
+	EXPECT_THROW(pool.Walk(*root, filter, false,
+			       [&n](const LightSong &){
+				       if (++n == 3000)
+					       throw std::runtime_error("Full");
+			       }),
+		     std::runtime_error);
+
+	/* the pool must be usable again */
+	EXPECT_EQ(Walk(pool, false), Walk(false));
+}
+
+TEST_F(SearchPoolTest, Empty)
+{
+	SearchPool pool(2);
+
+	std::unique_ptr<Directory> empty{Directory::NewRoot()};
+	unsigned n = 0;
+
+	const ScopeDatabaseLock protect;
+	pool.Walk(*empty, filter, false, [&n](const LightSong &){ ++n; });
+	EXPECT_EQ(n, 0U);
+}
+
+/**
+ * The database lock is released between two waves; directories
+ * which are deleted meanwhile are still visited.
+ */
+TEST_F(SearchPoolTest, Yield)
+{
+	SearchPool pool(2);
+
+	const ScopeDatabaseLock protect;
+	const auto expected = Walk(false);
+
+	unsigned n_yield = 0;
+	std::vector<std::string> result;
+	EXPECT_TRUE(pool.Walk(*root, filter, false,
+			      [&result](const LightSong &song){
+				      result.emplace_back(song.GetURI());
+			      },
+			      [this, &pool, &n_yield]{
+				      const ScopeDatabaseLock protect2;
+
+				      /* another Walk() must not
+					 interfere with this one */
+				      EXPECT_FALSE(pool.Walk(*root, filter, false,
+							     [](const LightSong &){}));
+
+				      if (++n_yield == 1)
+					      root->FindChild("Artist 39")->Delete();
+			      }));
+
+	EXPECT_GT(n_yield, 1U);
+	EXPECT_EQ(result, expected);
+	EXPECT_EQ(root->FindChild("Artist 39"), nullptr);
+
+	/* the pool must be usable again */
+	EXPECT_EQ(Walk(pool, false), Walk(false));
+}
@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "StateFileWriter.hxx"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+class StateFileWriterTest : public ::testing::Test, protected StateFileWriterHandler {
+protected:
+	Mutex mutex;
+	Cond cond;
+
+	/**
+	 * While this is false, WriteStateFile() blocks.
+	 */
+	bool open = true;
+
+	/**
+	 * Is WriteStateFile() currently running?
+	 */
+	bool writing = false;
+
+	/**
+	 * Was WriteStateFile() ever called while another call was
+	 * still running?
+	 */
+	bool overlapped = false;
+
+	/**
+	 * The heads of all snapshots written so far, in the order
+	 * in which they were finished.
+	 */
+	std::vector<std::string> written;
+
+	static StateFileSnapshot MakeSnapshot(const char *head) {
+		return {head, std::make_shared<const std::string>("queue")};
+	}
+
+	void Close() noexcept {
+		const std::scoped_lock lock{mutex};
+		open = false;
+	}
+
+	void Open() noexcept {
+		const std::scoped_lock lock{mutex};
+		open = true;
+		cond.notify_all();
+	}
+
+	void WaitWriting() noexcept {
+		std::unique_lock lock{mutex};
+		cond.wait(lock, [this]{ return writing; });
+	}
+
+	/* virtual methods from class StateFileWriterHandler */
+	void WriteStateFile(const StateFileSnapshot &snapshot) noexcept override {
+		std::unique_lock lock{mutex};
+		if (writing)
+			overlapped = true;
+		writing = true;
+		cond.notify_all();
+
+		cond.wait(lock, [this]{ return open; });
+
+		written.emplace_back(snapshot.head);
+		writing = false;
+	}
+};
+
+/**
+ * A snapshot which is submitted while an older one is still pending
+ * replaces it; the older one is never written.
+ */
+TEST_F(StateFileWriterTest, PendingReplaced)
+{
+	{
+		StateFileWriter writer(*this);
+
+		Close();
+		writer.Submit(MakeSnapshot("a"));
+		WaitWriting();
+
+		writer.Submit(MakeSnapshot("b"));
+		writer.Submit(MakeSnapshot("c"));
+		Open();
+
+		/* the destructor writes the pending snapshot */
+	}
+
+	EXPECT_EQ(written, (std::vector<std::string>{"a", "c"}));
+}
+
+/**
+ * The synchronous Write() (during shutdown) discards the pending
+ * snapshot and waits for the one which is currently being written,
+ * so the file is not overwritten with older data afterwards.
+ */
+TEST_F(StateFileWriterTest, WriteNotOverwritten)
+{
+	{
+		StateFileWriter writer(*this);
+
+		Close();
+		writer.Submit(MakeSnapshot("a"));
+		WaitWriting();
+
+		writer.Submit(MakeSnapshot("b"));
+
+		/* finish "a" only after Write() has been called */
+		std::thread opener([this]{
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			Open();
+		});
+
+		writer.Write(MakeSnapshot("shutdown"));
+		opener.join();
+	}
+
+	EXPECT_FALSE(overlapped);
+	EXPECT_EQ(written, (std::vector<std::string>{"a", "shutdown"}));
+}
+
+TEST_F(StateFileWriterTest, WriteWithoutThread)
+{
+	{
+		StateFileWriter writer(*this);
+		writer.Write(MakeSnapshot("shutdown"));
+	}
+
+	EXPECT_EQ(written, std::vector<std::string>{"shutdown"});
+}
+
+/**
+ * If only the head has changed (e.g. the elapsed time), the queue is
+ * not serialized again, and the snapshots share its text.
+ */
+TEST(StateFileQueueCache, HeadOnlyChange)
+{
+	StateFileQueueCache cache;
+	unsigned n_serialized = 0;
+	const auto serialize = [&n_serialized]{
+		++n_serialized;
+		return std::string{"song_begin: x\n"};
+	};
+
+	StateFileSnapshot first{"elapsed: 1\n", cache.Get(42, serialize)};
+	StateFileSnapshot second{"elapsed: 2\n", cache.Get(42, serialize)};
+
+	EXPECT_EQ(n_serialized, 1U);
+	EXPECT_EQ(first.queue, second.queue);
+	EXPECT_EQ(*second.queue, "song_begin: x\n");
+
+	/* the queue was modified */
+	StateFileSnapshot third{"elapsed: 3\n", cache.Get(43, serialize)};
+	EXPECT_EQ(n_serialized, 2U);
+	EXPECT_NE(third.queue, second.queue);
+
+	/* the old snapshots are unaffected */
+	EXPECT_EQ(*first.queue, "song_begin: x\n");
+}
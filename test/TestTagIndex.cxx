@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "MakeTag.hxx"
+#include "db/plugins/simple/TagIndex.hxx"
+#include "db/plugins/simple/Directory.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "db/plugins/simple/ExportedSong.hxx"
+#include "db/DatabaseLock.hxx"
+#include "db/UniqueTags.hxx"
+#include "song/Filter.hxx"
+#include "song/LightSong.hxx"
+#include "util/RecursiveMap.hxx"
+
+#include <fmt/core.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+class TagIndexTest : public ::testing::Test {
+protected:
+	const ScopeDatabaseLock protect;
+
+	std::unique_ptr<Directory> root{Directory::NewRoot()};
+
+	void SetUp() override {
+		root->tag_index = std::make_unique<TagIndex>();
+
+		unsigned n = 0;
+		for (unsigned i = 0; i < 20; ++i) {
+			const auto artist_name = fmt::format("Artist {}", i);
+			auto *artist = root->CreateChild(artist_name);
+
+			for (unsigned j = 0; j < 3; ++j) {
+				const auto album_name = fmt::format("Album {}", i * 3 + j);
+				auto *album = artist->CreateChild(album_name);
+
+				for (unsigned k = 0; k < 5; ++k, ++n) {
+					TagBuilder tag;
+					tag.AddItem(TAG_ARTIST, artist_name);
+					tag.AddItem(TAG_ALBUM, album_name);
+					tag.AddItem(TAG_TITLE, fmt::format("Title {}", n));
+
+					/* some songs fall back to
+					   "Artist" */
+					if (j != 1)
+						tag.AddItem(TAG_ALBUM_ARTIST,
+							    fmt::format("Album Artist {}", i % 4));
+
+					/* some songs have no genre */
+					if (k != 4)
+						tag.AddItem(TAG_GENRE,
+							    fmt::format("Genre {}", n % 3));
+
+					tag.AddItem(TAG_DATE,
+						    fmt::format("{}", 1970 + j * 15));
+
+					auto song = Song::New(fmt::format("{}.flac", k),
+							      *album);
+					tag.Commit(song->tag);
+					song->in_playlist = n % 17 == 0;
+					album->AddSong(std::move(song));
+				}
+			}
+		}
+	}
+
+	static SongFilter ParseFilter(const char *expression) {
+		SongFilter filter;
+		const std::array<const char *, 1> args{expression};
+		filter.Parse(args);
+		filter.Optimize();
+		return filter;
+	}
+
+	static std::vector<std::string> Walk(const Directory &base,
+					     const SongFilter &filter) {
+		std::vector<std::string> result;
+		base.Walk(true, &filter, true, {},
+			  [&result](const LightSong &song){
+				  result.emplace_back(song.GetURI());
+			  }, {});
+		return result;
+	}
+
+	std::vector<std::string> Visit(const Directory &base,
+				       const SongFilter &filter) const {
+		std::vector<std::string> result;
+		EXPECT_TRUE(root->tag_index->Visit(base, true, filter, true,
+						   [&result](const LightSong &song){
+							   result.emplace_back(song.GetURI());
+						   }));
+		return result;
+	}
+
+	void ExpectSame(const char *expression) const {
+		const auto filter = ParseFilter(expression);
+		const auto expected = Walk(*root, filter);
+		EXPECT_FALSE(expected.empty()) << expression;
+		EXPECT_EQ(Visit(*root, filter), expected) << expression;
+	}
+
+	static RecursiveMap<std::string> CollectUniqueTags(const Directory &base,
+							   std::span<const TagType> tag_types) {
+		RecursiveMap<std::string> result;
+		base.Walk(true, nullptr, true, {},
+			  [&result, tag_types](const LightSong &song){
+				  ::CollectUniqueTags(result, song.tag, tag_types);
+			  }, {});
+		return result;
+	}
+
+	void ExpectSameUniqueTags(std::span<const TagType> tag_types) const {
+		RecursiveMap<std::string> result;
+		EXPECT_TRUE(root->tag_index->CollectUniqueTags(*root, result,
+							       tag_types, true));
+		EXPECT_EQ(result, CollectUniqueTags(*root, tag_types));
+	}
+};
+
+TEST_F(TagIndexTest, Find)
+{
+	ExpectSame("(Artist == \"Artist 3\")");
+	ExpectSame("(AlbumArtist == \"Album Artist 2\")");
+	ExpectSame("(AlbumArtist == \"Artist 7\")");
+	ExpectSame("(AlbumArtistSort == \"Artist 7\")");
+	ExpectSame("(Album starts_with \"Album 1\")");
+	ExpectSame("((Genre == \"Genre 1\") AND (Date starts_with \"19\"))");
+	ExpectSame("((Date == \"2000\") AND (Genre == \"Genre 2\"))");
+	ExpectSame("((Artist == \"Artist 5\") AND (Title contains \"7\"))");
+
+	const auto filter = ParseFilter("(Artist == \"nonexistent\")");
+	EXPECT_TRUE(Visit(*root, filter).empty());
+}
+
+TEST_F(TagIndexTest, Base)
+{
+	const auto filter = ParseFilter("(Genre == \"Genre 0\")");
+	const auto *base = root->FindChild("Artist 4");
+	ASSERT_NE(base, nullptr);
+	EXPECT_EQ(Visit(*base, filter), Walk(*base, filter));
+}
+
+TEST_F(TagIndexTest, Fallback)
+{
+	const auto is_usable = [this](const char *expression){
+		return root->tag_index->Visit(*root, true,
+					      ParseFilter(expression),
+					      true, [](const LightSong &){});
+	};
+
+	EXPECT_FALSE(is_usable("(Artist != \"Artist 3\")"));
+	EXPECT_FALSE(is_usable("(Artist contains \"Artist 3\")"));
+	EXPECT_FALSE(is_usable("(Title == \"Title 3\")"));
+	EXPECT_FALSE(is_usable("(Genre == \"\")"));
+
+	/* not selective enough */
+	EXPECT_FALSE(is_usable("(Artist starts_with \"Artist\")"));
+}
+
+TEST_F(TagIndexTest, Modify)
+{
+	auto *artist = root->FindChild("Artist 3");
+	ASSERT_NE(artist, nullptr);
+	auto *album = artist->FindChild("Album 10");
+	ASSERT_NE(album, nullptr);
+
+	/* remove a song */
+	auto *song = album->FindSong("2.flac");
+	ASSERT_NE(song, nullptr);
+	album->RemoveSong(song);
+
+	/* change a tag */
+	song = album->FindSong("3.flac");
+	ASSERT_NE(song, nullptr);
+	const Tag old_tag = song->tag;
+	song->tag = MakeTag(TAG_ARTIST, "Artist 5", TAG_ALBUM, "Album 10",
+			    TAG_GENRE, "Genre 1");
+	album->SongTagChanged(*song, old_tag);
+
+	/* delete a directory */
+	auto *other = root->FindChild("Artist 5");
+	ASSERT_NE(other, nullptr);
+	other->FindChild("Album 16")->Delete();
+
+	ExpectSame("(Artist == \"Artist 3\")");
+	ExpectSame("(Artist == \"Artist 5\")");
+	ExpectSame("(Album == \"Album 10\")");
+	ExpectSame("(Genre == \"Genre 1\")");
+
+	const auto filter = ParseFilter("(Album == \"Album 16\")");
+	EXPECT_TRUE(Visit(*root, filter).empty());
+}
+
+TEST_F(TagIndexTest, UniqueTags)
+{
+	static constexpr TagType artist[] = {TAG_ARTIST};
+	ExpectSameUniqueTags(artist);
+
+	static constexpr TagType album_artist[] = {TAG_ALBUM_ARTIST};
+	ExpectSameUniqueTags(album_artist);
+
+	static constexpr TagType album_group[] = {TAG_ALBUM, TAG_ALBUM_ARTIST, TAG_DATE};
+	ExpectSameUniqueTags(album_group);
+
+	static constexpr TagType artist_genre[] = {TAG_ARTIST, TAG_GENRE};
+	ExpectSameUniqueTags(artist_genre);
+
+	/* some songs have no "Genre"; they are reported as an empty
+	   string */
+	static constexpr TagType genre[] = {TAG_GENRE};
+	ExpectSameUniqueTags(genre);
+
+	static constexpr TagType genre_album[] = {TAG_GENRE, TAG_ALBUM};
+	ExpectSameUniqueTags(genre_album);
+
+	static constexpr TagType album_genre[] = {TAG_ALBUM, TAG_GENRE};
+	ExpectSameUniqueTags(album_genre);
+
+	/* not indexed */
+	static constexpr TagType title[] = {TAG_TITLE};
+	RecursiveMap<std::string> result;
+	EXPECT_FALSE(root->tag_index->CollectUniqueTags(*root, result,
+							title, true));
+}
+
+/**
+ * The list of songs without a value must be kept up to date after it
+ * has been built.
+ */
+TEST_F(TagIndexTest, UniqueTagsModify)
+{
+	static constexpr TagType genre_album[] = {TAG_GENRE, TAG_ALBUM};
+	ExpectSameUniqueTags(genre_album);
+
+	auto *album = root->FindChild("Artist 3")->FindChild("Album 10");
+	ASSERT_NE(album, nullptr);
+
+	/* remove a song without "Genre" */
+	auto *song = album->FindSong("4.flac");
+	ASSERT_NE(song, nullptr);
+	album->RemoveSong(song);
+
+	/* remove the "Genre" from a song */
+	song = album->FindSong("3.flac");
+	ASSERT_NE(song, nullptr);
+	const Tag old_tag = song->tag;
+	song->tag = MakeTag(TAG_ARTIST, "Artist 3", TAG_ALBUM, "Album 10");
+	album->SongTagChanged(*song, old_tag);
+
+	/* add a new song without "Genre" */
+	auto new_song = Song::New("5.flac", *album);
+	new_song->tag = MakeTag(TAG_ARTIST, "Artist 3", TAG_ALBUM, "New");
+	album->AddSong(std::move(new_song));
+
+	/* delete a directory with songs without "Genre" */
+	root->FindChild("Artist 5")->FindChild("Album 16")->Delete();
+
+	ExpectSameUniqueTags(genre_album);
+
+	/* remove all songs without "Genre" */
+	for (auto &artist : root->children)
+		for (auto &i : artist.children)
+			for (const char *name : {"3.flac", "4.flac", "5.flac"})
+				if (auto *s = i.FindSong(name);
+				    s != nullptr && s->tag.GetValue(TAG_GENRE) == nullptr)
+					i.RemoveSong(s);
+
+	RecursiveMap<std::string> result;
+	static constexpr TagType genre[] = {TAG_GENRE};
+	ASSERT_TRUE(root->tag_index->CollectUniqueTags(*root, result,
+						       genre, true));
+	EXPECT_FALSE(result.contains(""));
+	ExpectSameUniqueTags(genre_album);
+}
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+#include "test_pcm_util.hxx"
+#include "pcm/Dsd2Pcm.hxx"
+#include "pcm/PcmDsd.hxx"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+static std::vector<std::byte>
+RandomDsd(std::size_t size)
+{
+	RandomInt<uint8_t> g;
+	std::vector<std::byte> result(size);
+	for (auto &i : result)
+		i = std::byte{g()};
+	return result;
+}
+
+/**
+ * Feed the same input to #Dsd2Pcm and #FastDsd2Pcm in pieces of
+ * varying sizes and compare the output bit by bit.
+ */
+template<typename T, typename F>
+static void
+TestFastDsd2Pcm(F translate)
+{
+	constexpr std::size_t N = 3 * FastDsd2Pcm::BLOCK_SIZE + 77;
+	const auto src = RandomDsd(N);
+
+	Dsd2Pcm classic;
+	FastDsd2Pcm fast;
+
+	std::vector<T> expected(N), actual(N);
+
+	for (std::size_t position = 0, size = 1; position < N;
+	     position += size, size = size * 3 + 1) {
+		size = std::min(size, N - position);
+		translate(classic, size, src.data() + position,
+			  expected.data() + position);
+		translate(fast, size, src.data() + position,
+			  actual.data() + position);
+	}
+
+	for (std::size_t i = 0; i < N; ++i)
+		EXPECT_EQ(0, std::memcmp(&expected[i], &actual[i], sizeof(T)))
+			<< "at " << i;
+
+	/* after Reset(), both must start from the same state */
+	classic.Reset();
+	fast.Reset();
+	translate(classic, N, src.data(), expected.data());
+	translate(fast, N, src.data(), actual.data());
+	EXPECT_EQ(0, std::memcmp(expected.data(), actual.data(),
+				 N * sizeof(T)));
+}
+
+TEST(PcmTest, FastDsd2PcmFloat)
+{
+	TestFastDsd2Pcm<float>([](auto &engine, std::size_t n,
+				  const std::byte *src, float *dest){
+		engine.Translate(n, src, 1, dest, 1);
+	});
+}
+
+TEST(PcmTest, FastDsd2PcmS24)
+{
+	TestFastDsd2Pcm<int32_t>([](auto &engine, std::size_t n,
+				    const std::byte *src, int32_t *dest){
+		engine.TranslateS24(n, src, 1, dest, 1);
+	});
+}
+
+/**
+ * Compare #PcmDsd with the given configuration against the classic
+ * engine.
+ */
+static void
+TestPcmDsd(const PcmDsdConfig &config, unsigned channels)
+{
+	const PcmDsdConfig classic_config{false, 1};
+	PcmDsd classic(classic_config), other(config);
+
+	for (std::size_t n_frames : {1, 700, 4096, 13}) {
+		const auto src = RandomDsd(n_frames * channels);
+
+		const auto expected_float = classic.ToFloat(channels, src);
+		const auto actual_float = other.ToFloat(channels, src);
+		ASSERT_EQ(expected_float.size(), actual_float.size());
+		EXPECT_EQ(0, std::memcmp(expected_float.data(),
+					 actual_float.data(),
+					 expected_float.size_bytes()));
+	}
+
+	classic.Reset();
+	other.Reset();
+
+	for (std::size_t n_frames : {4096, 1, 700}) {
+		const auto src = RandomDsd(n_frames * channels);
+
+		const auto expected_s24 = classic.ToS24(channels, src);
+		const auto actual_s24 = other.ToS24(channels, src);
+		ASSERT_EQ(expected_s24.size(), actual_s24.size());
+		EXPECT_EQ(0, std::memcmp(expected_s24.data(),
+					 actual_s24.data(),
+					 expected_s24.size_bytes()));
+	}
+}
+
+TEST(PcmTest, PcmDsdFast)
+{
+	const PcmDsdConfig config{true, 1};
+
+	for (unsigned channels : {1, 2, 3, 6, 8})
+		TestPcmDsd(config, channels);
+}
+
+TEST(PcmTest, PcmDsdThreads)
+{
+	for (unsigned threads : {2, 3, 8}) {
+		const PcmDsdConfig config{true, threads};
+
+		for (unsigned channels : {2, 3, 6, 8})
+			TestPcmDsd(config, channels);
+	}
+}
@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// Copyright The Music Player Daemon Project
+
+/*
+ * Verify that the x86 kernels are bit-exact with the portable code.
+ */
+
+#include "test_pcm_util.hxx"
+#include "pcm/X86.hxx"
+#include "pcm/FloatConvert.hxx"
+#include "pcm/Volume.hxx"
+#include "pcm/Clamp.hxx"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+static constexpr std::size_t N = 509;
+static constexpr std::size_t N_DONE = N - N % X86_BLOCK_SIZE;
+
+/**
+ * Generates float samples in the range [-2, 2] to check clamping.
+ */
+struct RandomFloat2 : RandomFloat {
+	float operator()() {
+		return RandomFloat::operator()() * 2;
+	}
+};
+
+/**
+ * Invoke the function with the SSE2 kernel and (if the CPU supports
+ * it) with the AVX2 kernel.
+ */
+template<typename K, typename F>
+static void
+ForEachKernel(K sse2, K avx2, F &&f)
+{
+	f(sse2);
+
+	if (X86HaveAvx2())
+		f(avx2);
+}
+
+template<SampleFormat F, typename K>
+static void
+TestFloatToInteger(K sse2, K avx2)
+{
+	using value_type = typename SampleTraits<F>::value_type;
+	using C = FloatToIntegerSampleConvert<F>;
+
+	auto src = TestDataBuffer<float, N>(RandomFloat2());
+
+	/* a few special values */
+	src[0] = 1.0f;
+	src[1] = -1.0f;
+	src[2] = 0.0f;
+	src[3] = -0.0f;
+	src[4] = 0.99999994f;
+	src[5] = -0.99999994f;
+
+	ForEachKernel(sse2, avx2, [&src](K kernel){
+		value_type dest[N];
+		ASSERT_EQ(kernel(dest, src, N), N_DONE);
+
+		for (std::size_t i = 0; i < N_DONE; ++i)
+			EXPECT_EQ(dest[i], C::Convert(src[i]));
+	});
+}
+
+TEST(PcmX86Test, FloatToS16)
+{
+	TestFloatToInteger<SampleFormat::S16>(Sse2FloatToS16, Avx2FloatToS16);
+}
+
+TEST(PcmX86Test, FloatToS24)
+{
+	TestFloatToInteger<SampleFormat::S24_P32>(Sse2FloatToS24,
+						  Avx2FloatToS24);
+}
+
+TEST(PcmX86Test, FloatToS32)
+{
+	TestFloatToInteger<SampleFormat::S32>(Sse2FloatToS32, Avx2FloatToS32);
+}
+
+TEST(PcmX86Test, S16ToFloat)
+{
+	using C = IntegerToFloatSampleConvert<SampleFormat::S16>;
+	const auto src = TestDataBuffer<int16_t, N>();
+
+	ForEachKernel(Sse2S16ToFloat, Avx2S16ToFloat, [&src](auto kernel){
+		float dest[N];
+		ASSERT_EQ(kernel(dest, src, N), N_DONE);
+
+		for (std::size_t i = 0; i < N_DONE; ++i)
+			EXPECT_EQ(dest[i], C::Convert(src[i]));
+	});
+}
+
+template<SampleFormat F, typename G>
+static void
+TestS32ToFloat(G g)
+{
+	using C = IntegerToFloatSampleConvert<F>;
+	const auto src = TestDataBuffer<int32_t, N>(g);
+
+	ForEachKernel(Sse2S32ToFloat, Avx2S32ToFloat, [&src](auto kernel){
+		float dest[N];
+		ASSERT_EQ(kernel(dest, src, N, C::factor), N_DONE);
+
+		for (std::size_t i = 0; i < N_DONE; ++i)
+			EXPECT_EQ(dest[i], C::Convert(src[i]));
+	});
+}
+
+TEST(PcmX86Test, S24ToFloat)
+{
+	TestS32ToFloat<SampleFormat::S24_P32>(RandomInt24());
+}
+
+TEST(PcmX86Test, S32ToFloat)
+{
+	TestS32ToFloat<SampleFormat::S32>(RandomInt<int32_t>());
+}
+
+TEST(PcmX86Test, Volume16To24)
+{
+	const auto src = TestDataBuffer<int16_t, N>();
+
+	for (int volume : {1, 341, 1023, 1024}) {
+		ForEachKernel(Sse2Volume16To24, Avx2Volume16To24,
+			      [&src, volume](auto kernel){
+			int32_t dest[N];
+			ASSERT_EQ(kernel(dest, src, N, volume), N_DONE);
+
+			for (std::size_t i = 0; i < N_DONE; ++i)
+				EXPECT_EQ(dest[i], (int32_t(src[i]) * volume) >> 2);
+		});
+	}
+}
+
+TEST(PcmX86Test, VolumeFloat)
+{
+	const auto src = TestDataBuffer<float, N>(RandomFloat());
+	const float volume = pcm_volume_to_float(PCM_VOLUME_1 / 3);
+
+	ForEachKernel(Sse2VolumeFloat, Avx2VolumeFloat,
+		      [&src, volume](auto kernel){
+		float dest[N];
+		ASSERT_EQ(kernel(dest, src, N, volume), N_DONE);
+
+		for (std::size_t i = 0; i < N_DONE; ++i)
+			EXPECT_EQ(dest[i], src[i] * volume);
+	});
+}
+
+template<SampleFormat F, typename K, typename G>
+static void
+TestAdd(K sse2, K avx2, G g)
+{
+	using Traits = SampleTraits<F>;
+	using value_type = typename Traits::value_type;
+
+	auto a = TestDataBuffer<value_type, N>(g);
+	const auto b = TestDataBuffer<value_type, N>(g);
+
+	/* make sure the limits get hit */
+	a[0] = Traits::MAX;
+	a[1] = Traits::MIN;
+	a[2] = Traits::MAX;
+	a[3] = Traits::MIN;
+
+	ForEachKernel(sse2, avx2, [&a, &b](K kernel){
+		value_type dest[N];
+		std::memcpy(dest, a.begin(), sizeof(dest));
+		ASSERT_EQ(kernel(dest, b, N), N_DONE);
+
+		for (std::size_t i = 0; i < N_DONE; ++i) {
+			const typename Traits::long_type sum =
+				typename Traits::long_type(a[i]) + b[i];
+			EXPECT_EQ(dest[i], PcmClamp<F>(sum));
+		}
+	});
+}
+
+TEST(PcmX86Test, AddS16)
+{
+	TestAdd<SampleFormat::S16>(Sse2AddS16, Avx2AddS16,
+				   RandomInt<int16_t>());
+}
+
+TEST(PcmX86Test, AddS24)
+{
+	TestAdd<SampleFormat::S24_P32>(Sse2AddS24, Avx2AddS24, RandomInt24());
+}
+
+TEST(PcmX86Test, AddS32)
+{
+	TestAdd<SampleFormat::S32>(Sse2AddS32, Avx2AddS32,
+				   RandomInt<int32_t>());
+}
+
+TEST(PcmX86Test, AddVolumeFloat)
+{
+	const auto a = TestDataBuffer<float, N>(RandomFloat());
+	const auto b = TestDataBuffer<float, N>(RandomFloat());
+	const float volume1 = 0.3f, volume2 = 0.7f;
+
+	ForEachKernel(Sse2AddVolumeFloat, Avx2AddVolumeFloat,
+		      [&a, &b, volume1, volume2](auto kernel){
+		float dest[N];
+		std::memcpy(dest, a.begin(), sizeof(dest));
+		ASSERT_EQ(kernel(dest, b, N, volume1, volume2), N_DONE);
+
+		for (std::size_t i = 0; i < N_DONE; ++i) {
+			/* use "volatile" to prevent the compiler from
+			   contracting this to a fused multiply-add */
+			volatile float x = a[i] * volume1;
+			volatile float y = b[i] * volume2;
+			EXPECT_EQ(dest[i], x + y);
+		}
+	});
+}
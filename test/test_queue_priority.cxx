@@ -5,6 +5,8 @@
 #include <gtest/gtest.h>
 
 #include <iterator>
+#include <string>
+#include <vector>
 
 Tag::Tag(const Tag &) noexcept {}
 void Tag::Clear() noexcept {}
@@ -170,3 +172,33 @@ TEST(QueuePriority, Priority)
 	a_order = queue.PositionToOrder(a_position);
 	EXPECT_EQ(6u, a_order);
 }
+
+TEST(QueuePriority, ShuffleOrderLastGroup)
+{
+	Queue queue(64);
+	queue.random = true;
+
+	for (unsigned i = 0; i < 8; ++i)
+		queue.Append(DetachedSong(std::to_string(i) + ".ogg"), 0);
+	queue.SetPriority(2, 10, -1);
+	queue.SetPriority(5, 20, -1);
+
+	for (unsigned i = 8; i < 48; ++i)
+		queue.Append(DetachedSong(std::to_string(i) + ".ogg"), 0);
+
+	queue.ShuffleOrderLastGroup(0, queue.GetLength());
+
+	/* the prioritized songs stay in front */
+	check_descending_priority(&queue, 0);
+	EXPECT_EQ(queue.OrderToPosition(0), 5U);
+	EXPECT_EQ(queue.OrderToPosition(1), 2U);
+
+	/* the order is still a permutation */
+	std::vector<bool> seen(queue.GetLength());
+	for (unsigned i = 0; i < queue.GetLength(); ++i) {
+		const unsigned position = queue.OrderToPosition(i);
+		ASSERT_LT(position, queue.GetLength());
+		EXPECT_FALSE(seen[position]);
+		seen[position] = true;
+	}
+}